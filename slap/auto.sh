@@ -8,7 +8,9 @@ Help() {
     echo "-e : Run the project as an executable"
     echo "-s : Run the project as a script"
     echo "-t : Type check the project"
+    echo "-u : Run the unit tests"
     echo "-g : Compile the grammar into a parser"
+    echo "-o : Generate the opcodes from the machine's opcode table"
     echo "-c : Clean the project"
 }
 
@@ -34,6 +36,11 @@ Typecheck() {
     mypy source
 }
 
+Test() {
+    echo "Running Slap tests..."
+    python3 -m unittest discover -s test -p "*Test.py"
+}
+
 Grammar() {
     echo "Compiling the Slap grammar..."
     java -jar antlr4.12.0-complete.jar -Dlanguage=Python3 source/grammar/Slap.g4
@@ -45,6 +52,11 @@ Grammar() {
     find . -name "*.tokens" -type f -delete
 }
 
+Opcodes() {
+    echo "Generating the Slap opcodes..."
+    python3 source/assembler/SlapOpcodeGenerator.py
+}
+
 Clean() {
     echo "Cleaning Slap..."
     rm -r bin
@@ -53,7 +65,7 @@ Clean() {
 
 # Parse the command line arguments
 echo "From build.sh"
-while getopts "hbesgtc" opt; do
+while getopts "hbesgtuoc" opt; do
     case $opt in
         h)
             Help
@@ -75,10 +87,18 @@ while getopts "hbesgtc" opt; do
             Typecheck
             exit 0
             ;;
+        u)
+            Test
+            exit 0
+            ;;
         g)
             Grammar
             exit 0
             ;;
+        o)
+            Opcodes
+            exit 0
+            ;;
         c)
             Clean
             exit 0
@@ -1,8 +1,13 @@
+import codecs
+
 from parsing.SlapParser import SlapParser
 from parsing.SlapListener import SlapListener
 
 from symbol.SlapSymbol import SlapSymbolTable
-from .SlapByteWriter import SlapByteWriter
+from .SlapByteWriter import SlapByteWriter, SlapOperandFormat, parse_number
+from .SlapOpcode import SlapOpcode
+from .SlapInstructionSet import SlapCastType, cast_operand, lookup_mnemonic, operand_format
+from .SlapPool import SlapConstantPool, SlapStringTable
 from log.SlapLog import info, error
 
 # ----------------------------------------------------------------------------------------------------------------------
@@ -13,86 +18,89 @@ class SlapAssembler(SlapListener):
         self.symbol_table = symbol_table
         self.byte_array = bytearray()
         self.writer = SlapByteWriter(self.byte_array, "big")
-
-    def enterInstructionNoop(self, ctx: SlapParser.InstructionNoopContext):
-        self.writer.write_argless_opcode(0x00)
+        # Width of the literal operand belonging to the instruction currently being assembled
+        self.operand_format = SlapOperandFormat.NONE
+        self.constant_pool = SlapConstantPool()
+        self.string_table = SlapStringTable()
+        self.section_start = 0
+
+    def _write_opcode(self, opcode: SlapOpcode):
+        # The operand is then written either from the instruction's literal or by _write_operand
+        self.writer.write_opcode(opcode)
+        self.operand_format = operand_format(opcode)
+
+    def _write_operand(self, value: int):
+        # The operand is computed here, so a literal in the instruction must not be written again
+        self.writer.write_operand(value, self.operand_format)
+        self.operand_format = SlapOperandFormat.NONE
+
+    def enterSectionDeclaration(self, ctx: SlapParser.SectionDeclarationContext):
+        self.section_start = len(self.byte_array)
+        # The argument count is a literal of the declaration, not an operand of the previous section's last instruction
+        self.operand_format = SlapOperandFormat.NONE
+
+    def exitSectionDeclaration(self, ctx: SlapParser.SectionDeclarationContext):
+        # Record where the body landed so the image can index it for lazy loading
+        name = ctx.sectionSpecifier().LABEL().getText()
+        for section in self.symbol_table.section_symbols:
+            if section.name == name:
+                section.byte_offset = self.section_start
+                section.byte_size = len(self.byte_array) - self.section_start
+                break
 
     def enterInstructionHalt(self, ctx: SlapParser.InstructionHaltContext):
-        self.writer.write_argless_opcode(0x01)
-
-    def enterInstructionLoadi(self, ctx: SlapParser.InstructionLoadiContext):
-        self.writer.write_byte(0x10)
-
-    def enterInstructionLoadr(self, ctx: SlapParser.InstructionLoadrContext):
-        # TODO: There might be register validation I forgot about
-        self.writer.write_byte(0x11)
-
-    def enterInstructionLoadm(self, ctx: SlapParser.InstructionLoadmContext):
-        self.writer.write_byte(0x12)
+        self._write_opcode(SlapOpcode.HALT)
+        # The exit code is optional in the grammar but the operand is always present in the encoding
+        if ctx.wholeNumber() is None:
+            self._write_operand(0)
 
-    def enterInstructionDrop(self, ctx: SlapParser.InstructionDropContext):
-        self.writer.write_argless_opcode(0x13)
+    # Immediates which would take more than this many bytes as a varint are moved into the constant pool
+    LOADI_MAX_INLINE_BYTES = 3
 
-    def enterInstructionStorer(self, ctx: SlapParser.InstructionStorerContext):
+    def enterInstructionLoadi(self, ctx: SlapParser.InstructionLoadiContext):
+        # Floats and large integers are cheaper as a shared 8 byte constant plus a small index, so they are promoted to
+        # LOADK.  The operand is written here, and the literal itself is skipped by enterWholeNumber/FloatingNumber.
+        value = parse_number(ctx.anyNumber().getText())
+        if ctx.anyNumber().floatingNumber() is not None or value >= 1 << (7 * self.LOADI_MAX_INLINE_BYTES):
+            self._write_opcode(SlapOpcode.LOADK)
+            self._write_operand(self.constant_pool.intern(value))
+        else:
+            self._write_opcode(SlapOpcode.LOADI)
+            self._write_operand(value)
+
+    def enterInstructionLoadk(self, ctx: SlapParser.InstructionLoadkContext):
+        value = parse_number(ctx.anyNumber().getText())
+        self._write_opcode(SlapOpcode.LOADK)
+        self._write_operand(self.constant_pool.intern(value))
+
+    def enterInstructionLoads(self, ctx: SlapParser.InstructionLoadsContext):
+        # Strip the quotes and resolve escape sequences before interning
+        string = codecs.decode(ctx.STRING().getText()[1:-1], "unicode_escape")
+        self._write_opcode(SlapOpcode.LOADS)
+        self._write_operand(self.string_table.intern(string))
+
+    def enterInstructionPlain(self, ctx: SlapParser.InstructionPlainContext):
+        opcode, _ = lookup_mnemonic(ctx.LABEL().getText())
+        self._write_opcode(opcode)
+
+    def enterInstructionBranch(self, ctx: SlapParser.InstructionBranchContext):
+        opcode, _ = lookup_mnemonic(ctx.LABEL().getText())
+        self._write_opcode(opcode)
+        self._write_operand(ctx.sectionSpecifier().resolved_address)
+
+    def enterInstructionImmediate(self, ctx: SlapParser.InstructionImmediateContext):
         # TODO: There might be register validation I forgot about
-        self.writer.write_byte(0x14)
-
-    def enterInstructionStorem(self, ctx: SlapParser.InstructionStoremContext):
-        self.writer.write_byte(0x15)
-
-    def enterInstructionDup(self, ctx: SlapParser.InstructionDupContext):
-        self.writer.write_argless_opcode(0x20)
-
-    def enterInstructionSwap(self, ctx: SlapParser.InstructionSwapContext):
-        self.writer.write_argless_opcode(0x21)
-
-    def enterInstructionRot(self, ctx: SlapParser.InstructionRotContext):
-        self.writer.write_argless_opcode(0x22)
-
-    def enterInstructionAdd(self, ctx: SlapParser.InstructionAddContext):
-        self.writer.write_argless_opcode(0x30)
-
-    def enterInstructionSub(self, ctx: SlapParser.InstructionSubContext):
-        self.writer.write_argless_opcode(0x31)
-
-    def enterInstructionMul(self, ctx: SlapParser.InstructionMulContext):
-        self.writer.write_argless_opcode(0x32)
-
-    def enterInstructionDiv(self, ctx: SlapParser.InstructionDivContext):
-        self.writer.write_argless_opcode(0x33)
-
-    def enterInstructionMod(self, ctx: SlapParser.InstructionModContext):
-        self.writer.write_argless_opcode(0x34)
-
-    def enterInstructionAddf(self, ctx: SlapParser.InstructionAddfContext):
-        self.writer.write_argless_opcode(0x35)
-
-    def enterInstructionSubf(self, ctx: SlapParser.InstructionSubfContext):
-        self.writer.write_argless_opcode(0x36)
-
-    def enterInstructionMulf(self, ctx: SlapParser.InstructionMulfContext):
-        self.writer.write_argless_opcode(0x37)
-
-    def enterInstructionDivf(self, ctx: SlapParser.InstructionDivfContext):
-        self.writer.write_argless_opcode(0x38)
-
-    def enterInstructionModf(self, ctx: SlapParser.InstructionModfContext):
-        self.writer.write_argless_opcode(0x39)
-
-    def enterInstructionAlloc(self, ctx: SlapParser.InstructionAllocContext):
-        self.writer.write_byte(0x40)
-
-    def enterInstructionFree(self, ctx: SlapParser.InstructionFreeContext):
-        self.writer.write_argless_opcode(0x41)
-
-    def enterInstructionJmp(self, ctx: SlapParser.InstructionJmpContext):
-        self.writer.write_byte(0x50)
-
-    def enterInstructionJne(self, ctx: SlapParser.InstructionJneContext):
-        self.writer.write_byte(0x51)
-
-    def enterInstructionJeq(self, ctx: SlapParser.InstructionJeqContext):
-        self.writer.write_byte(0x52)
+        opcode, _ = lookup_mnemonic(ctx.LABEL().getText())
+        self._write_opcode(opcode)
+
+    def enterInstructionDjnz(self, ctx: SlapParser.InstructionDjnzContext):
+        # Slot and target share one varint, the target above a 16-bit slot.  The slot literal is skipped by
+        # enterWholeNumber since the operand is already written here.
+        slot = parse_number(ctx.wholeNumber().getText())
+        if slot > 0xFFFF:
+            error(f"Local slot {slot} does not fit in djnz")
+        self._write_opcode(SlapOpcode.DJNZ)
+        self._write_operand(ctx.sectionSpecifier().resolved_address << 16 | slot)
 
     def enterInstructionCall(self, ctx: SlapParser.InstructionContext):
         # Make sure the section specifer is not native
@@ -104,11 +112,29 @@ class SlapAssembler(SlapListener):
         ):
             error("Cannot call native section as non-native")
 
-        self.writer.write_byte(0x50)
-        self.writer.write_number(specifier.resolved_address)
-
-    def enterInstructionRet(self, ctx: SlapParser.InstructionContext):
-        self.writer.write_argless_opcode(0x62)
+        # A call directly followed by a return becomes a tail call, which reuses the current frame instead of growing
+        # the call stack.  The ret is still emitted so instruction addresses match the symbol tabulator's count.
+        if self._is_followed_by_ret(ctx):
+            self._write_opcode(SlapOpcode.TAILCALL)
+        else:
+            self._write_opcode(SlapOpcode.CALL)
+        self._write_operand(specifier.resolved_address)
+
+    def _is_followed_by_ret(self, ctx: SlapParser.InstructionCallContext) -> bool:
+        instruction = ctx.parentCtx.parentCtx
+        section = instruction.parentCtx
+        if not isinstance(section, SlapParser.SectionDeclarationContext):
+            return False
+
+        instructions = section.instruction()
+        position = instructions.index(instruction)
+        if position + 1 >= len(instructions):
+            return False
+        following = instructions[position + 1].instruction_body().instructionPlain()
+        if following is None:
+            return False
+        entry = lookup_mnemonic(following.LABEL().getText())
+        return entry is not None and entry[0] == SlapOpcode.RET
 
     def enterInstructionCalln(self, ctx: SlapParser.InstructionCallnContext):
         # Make sure the section specifer is native
@@ -119,27 +145,44 @@ class SlapAssembler(SlapListener):
         ):
             error("Cannot call non-native section as native")
         
-        self.writer.write_byte(0x62)
-        self.writer.write_number(specifier.resolved_address)
+        self._write_opcode(SlapOpcode.CALLN)
+        self._write_operand(specifier.resolved_address)
+
+    def enterInstructionParfor(self, ctx: SlapParser.InstructionParforContext):
+        specifier = ctx.sectionSpecifier()
+
+        if any(
+            native.name == specifier.LABEL().getText()
+            for native in self.symbol_table.native_symbols
+        ):
+            error("Cannot run native section in parfor")
+
+        self._write_opcode(SlapOpcode.PARFOR)
+        self._write_operand(specifier.resolved_address)
+
+    # The conversions are all CAST, with the two types packed into its operand
+    def _write_cast(self, source: SlapCastType, target: SlapCastType):
+        self._write_opcode(SlapOpcode.CAST)
+        self._write_operand(cast_operand(source, target))
 
     def enterInstructionFtoi(self, ctx: SlapParser.InstructionContext):
-        self.writer.write_argless_opcode(0x71)
+        self._write_cast(SlapCastType.FLOAT, SlapCastType.INTEGER)
 
     def enterInstructionItof(self, ctx: SlapParser.InstructionContext):
-        self.writer.write_argless_opcode(0x71)
+        self._write_cast(SlapCastType.INTEGER, SlapCastType.FLOAT)
 
     def enterInstructionItoc(self, ctx: SlapParser.InstructionContext):
-        self.writer.write_argless_opcode(0x72)
+        self._write_cast(SlapCastType.INTEGER, SlapCastType.STRING)
 
     def enterWholeNumber(self, ctx: SlapParser.WholeNumberContext):
         if ctx.HEX_NUMBER() is not None:
-            self.writer.write_hex(ctx.HEX_NUMBER().getText())
+            self.writer.write_hex(ctx.HEX_NUMBER().getText(), self.operand_format)
         elif ctx.BIN_NUMBER() is not None:
-            self.writer.write_bin(ctx.BIN_NUMBER().getText())
+            self.writer.write_bin(ctx.BIN_NUMBER().getText(), self.operand_format)
         elif ctx.INT_NUMBER() is not None:
-            self.writer.write_int(ctx.INT_NUMBER().getText())
+            self.writer.write_int(ctx.INT_NUMBER().getText(), self.operand_format)
         else:
             error("Unknown number type")
 
     def enterFloatingNumber(self, ctx: SlapParser.FloatingNumberContext):
-        self.writer.write_float(ctx.FLOAT_NUMBER().getText())
+        self.writer.write_float(ctx.FLOAT_NUMBER().getText(), self.operand_format)
@@ -1,4 +1,31 @@
 import struct
+from enum import IntEnum
+
+
+class SlapOperandFormat(IntEnum):
+    """Width of the operand following an opcode, must mirror SlimBytecodeOperandFormat in SlimBytecode.h"""
+
+    NONE = 0  # No operand follows the opcode
+    U8 = 1  # 1 byte immediate
+    U16 = 2  # 2 byte immediate
+    U32 = 3  # 4 byte immediate
+    VARINT = 4  # Unsigned LEB128, 1 to 10 bytes
+
+
+def parse_number(text: str) -> int:
+    """Converts a number literal (0x, 0b, 0i or 0f prefixed) into the raw 64-bit value the machine operates on"""
+    if text.startswith("0x"):
+        return int(text[2:], 16)
+    elif text.startswith("0b"):
+        return int(text[2:], 2)
+    elif text.startswith("0i"):
+        return int(text[2:], 10)
+    elif text.startswith("0f"):
+        # Floats are stored as ieee 754 doubles
+        return struct.unpack("Q", struct.pack("d", float(text[2:])))[0]
+    else:
+        raise Exception(f"Unknown number literal '{text}'")
+
 
 class SlapByteWriter:
     """Used by the assembler to write various contructs such as numbers, floats, and strings in bytes"""
@@ -10,53 +37,74 @@ class SlapByteWriter:
     def write_byte(self, byte: int):
         self.byte_array.append(byte)
 
-    def write_number_little_endian(self, value: int):
-        self.write_byte(value & 0xFF)
-        self.write_byte((value >> 8) & 0xFF)
-        self.write_byte((value >> 16) & 0xFF)
-        self.write_byte((value >> 24) & 0xFF)
-        self.write_byte((value >> 32) & 0xFF)
-        self.write_byte((value >> 40) & 0xFF)
-        self.write_byte((value >> 48) & 0xFF)
-        self.write_byte((value >> 56) & 0xFF)
-        
-    def write_number_big_endian(self, value: int):
-        self.write_byte((value >> 56) & 0xFF)
-        self.write_byte((value >> 48) & 0xFF)
-        self.write_byte((value >> 40) & 0xFF)
-        self.write_byte((value >> 32) & 0xFF)
-        self.write_byte((value >> 24) & 0xFF)
-        self.write_byte((value >> 16) & 0xFF)
-        self.write_byte((value >> 8) & 0xFF)
-        self.write_byte(value & 0xFF)
-
-    def write_number(self, value: int):
+    def write_number_little_endian(self, value: int, size: int = 8):
+        for i in range(size):
+            self.write_byte((value >> (i * 8)) & 0xFF)
+
+    def write_number_big_endian(self, value: int, size: int = 8):
+        for i in reversed(range(size)):
+            self.write_byte((value >> (i * 8)) & 0xFF)
+
+    def write_number(self, value: int, size: int = 8):
         if self.endianness == "little":
-            self.write_number_little_endian(value)
+            self.write_number_little_endian(value, size)
         elif self.endianness == "big":
-            self.write_number_big_endian(value)
+            self.write_number_big_endian(value, size)
         else:
             raise Exception(f"Unknown endianness '{self.endianness}'")
 
-    def write_argless_opcode(self, opcode: int):
+    def write_varint(self, value: int):
+        # Unsigned LEB128, 7 bits per byte with the high bit marking continuation
+        value &= 0xFFFFFFFFFFFFFFFF
+        while True:
+            byte = value & 0x7F
+            value >>= 7
+            if value == 0:
+                self.write_byte(byte)
+                return
+            self.write_byte(byte | 0x80)
+
+    def write_operand(self, value: int, operand_format: SlapOperandFormat):
+        if operand_format == SlapOperandFormat.NONE:
+            return
+        elif operand_format == SlapOperandFormat.U8:
+            self.write_number(value, 1)
+        elif operand_format == SlapOperandFormat.U16:
+            self.write_number(value, 2)
+        elif operand_format == SlapOperandFormat.U32:
+            self.write_number(value, 4)
+        elif operand_format == SlapOperandFormat.VARINT:
+            self.write_varint(value)
+        else:
+            raise Exception(f"Unknown operand format '{operand_format}'")
+
+    def write_opcode(self, opcode: int):
         self.write_byte(opcode)
-        self.write_number(0)
 
-    def write_bin(self, binary: str):
+    def write_argless_opcode(self, opcode: int):
+        self.write_opcode(opcode)
+
+    def write_bin(self, binary: str, operand_format: SlapOperandFormat):
         value: int = int(binary[2:], 2)
-        self.write_number(value)
+        self.write_operand(value, operand_format)
 
-    def write_hex(self, hex: str):
+    def write_hex(self, hex: str, operand_format: SlapOperandFormat):
         value: int = int(hex[2:], 16)
-        self.write_number(value)        
+        self.write_operand(value, operand_format)
 
-    def write_int(self, integer: int):
+    def write_int(self, integer: str, operand_format: SlapOperandFormat):
         value: int = int(integer[2:], 10)
-        self.write_number(value)
+        self.write_operand(value, operand_format)
 
-    def write_float(self, string: str):
+    def write_float(self, string: str, operand_format: SlapOperandFormat):
         # Writes float as ieee 754 double
         as_float = float(string[2:])
         value: int = struct.unpack("Q", struct.pack("d", as_float))[0]
-        self.write_number(value)      
-        
\ No newline at end of file
+        self.write_operand(value, operand_format)
+
+    def write_string(self, string: str):
+        # Writes a 2 byte length followed by the raw characters (no null terminator)
+        encoded = string.encode("utf-8")
+        self.write_number(len(encoded), 2)
+        for byte in encoded:
+            self.write_byte(byte)
@@ -0,0 +1,132 @@
+from symbol.SlapSymbol import SlapSymbolTable
+from .SlapByteWriter import SlapByteWriter
+from .SlapPerfectHash import SlapPerfectHashBuilder
+from .SlapPool import SlapConstantPool, SlapStringTable
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapImageWriter:
+    """Lays out the final image as the set of tables expected by the SLIM loader (see SlimBytecode.h):
+    1. The Header Table - The size of every table as a big-endian u32 (section, symbol last), padded to HEADER_SIZE
+    2. The Native Table - A 2 byte length followed by the name of each native, ordered by identifier
+    3. The String Table - A 2 byte length followed by the characters of each interned string
+    4. The Constant Table - Each deduplicated constant as a big-endian u64
+    5. The Section Table - Address, instruction count, byte offset, byte size, local count and argument count of each
+       section as big-endian u32
+    6. The Symbol Table - A minimal perfect hash over the names of every native and exported section
+    7. The Instruction Table - The compact instruction stream produced by the SlapAssembler
+    """
+
+    HEADER_SIZE = 32
+    SYMBOL_NATIVE = 0
+    SYMBOL_SECTION = 1
+
+    def __init__(
+        self,
+        symbol_table: SlapSymbolTable,
+        instructions: bytearray,
+        constant_pool: SlapConstantPool,
+        string_table: SlapStringTable,
+    ):
+        self.symbol_table = symbol_table
+        self.instructions = instructions
+        self.constant_pool = constant_pool
+        self.string_table = string_table
+
+    def _write_natives(self) -> bytearray:
+        natives = bytearray()
+        writer = SlapByteWriter(natives, "big")
+        for native in sorted(self.symbol_table.native_symbols, key=lambda n: n.identifier):
+            writer.write_string(native.name)
+        return natives
+
+    def _write_strings(self) -> bytearray:
+        strings = bytearray()
+        writer = SlapByteWriter(strings, "big")
+        for string in self.string_table.strings:
+            writer.write_string(string)
+        return strings
+
+    def _write_constants(self) -> bytearray:
+        constants = bytearray()
+        writer = SlapByteWriter(constants, "big")
+        for constant in self.constant_pool.constants:
+            writer.write_number(constant, 8)
+        return constants
+
+    def _write_sections(self) -> bytearray:
+        sections = bytearray()
+        writer = SlapByteWriter(sections, "big")
+        for section in sorted(self.symbol_table.section_symbols, key=lambda s: s.address):
+            writer.write_number(section.address, 4)
+            writer.write_number(section.instruction_count, 4)
+            writer.write_number(section.byte_offset, 4)
+            writer.write_number(section.byte_size, 4)
+            writer.write_number(section.local_count, 4)
+            writer.write_number(section.argument_count, 4)
+        return sections
+
+    def _write_symbols(self) -> bytearray:
+        # (name, kind, index), natives are indexed by identifier and sections by their position in the section table
+        symbols = [(native.name, self.SYMBOL_NATIVE, native.identifier) for native in self.symbol_table.native_symbols]
+        ordered_sections = sorted(self.symbol_table.section_symbols, key=lambda s: s.address)
+        for index, section in enumerate(ordered_sections):
+            if section.exported:
+                symbols.append((section.name, self.SYMBOL_SECTION, index))
+
+        symbol_table = bytearray()
+        if len(symbols) == 0:
+            return symbol_table
+
+        encoded_names = [name.encode("utf-8") for name, _, _ in symbols]
+        perfect_hash = SlapPerfectHashBuilder(encoded_names).build()
+
+        # Seed, bucket count and symbol count, then one displacement per bucket, one entry per slot and the names
+        writer = SlapByteWriter(symbol_table, "big")
+        writer.write_number(perfect_hash.seed, 4)
+        writer.write_number(len(perfect_hash.displacements), 4)
+        writer.write_number(len(symbols), 4)
+        for displacement in perfect_hash.displacements:
+            writer.write_number(displacement, 4)
+
+        name_offset = 0
+        names = bytearray()
+        for key in perfect_hash.order:
+            _, kind, index = symbols[key]
+            writer.write_number(name_offset, 4)
+            writer.write_number(len(encoded_names[key]), 2)
+            writer.write_number(kind, 1)
+            writer.write_number(0, 1)
+            writer.write_number(index, 4)
+            names += encoded_names[key]
+            name_offset += len(encoded_names[key])
+
+        symbol_table += names
+        return symbol_table
+
+    def write(self) -> bytearray:
+        natives = self._write_natives()
+        strings = self._write_strings()
+        constants = self._write_constants()
+        sections = self._write_sections()
+        symbols = self._write_symbols()
+
+        image = bytearray()
+        writer = SlapByteWriter(image, "big")
+        writer.write_number(self.HEADER_SIZE, 4)
+        writer.write_number(len(natives), 4)
+        writer.write_number(len(strings), 4)
+        writer.write_number(len(constants), 4)
+        writer.write_number(len(self.instructions), 4)
+        writer.write_number(len(sections), 4)
+        writer.write_number(len(symbols), 4)
+        while len(image) < self.HEADER_SIZE:
+            writer.write_byte(0)
+
+        image += natives
+        image += strings
+        image += constants
+        image += sections
+        image += symbols
+        image += self.instructions
+        return image
@@ -0,0 +1,46 @@
+from enum import IntEnum
+from typing import Optional
+
+from .SlapByteWriter import SlapOperandFormat
+from .SlapOpcode import SlapOpcode, SLAP_OPCODES
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+# Mnemonics are the lowercase opcode names, except for these which replace the name of their opcode
+MNEMONIC_ALIASES = {"jeq": "JE"}
+
+# Opcodes the assembler only ever writes in place of another instruction, so they have no mnemonic of their own
+UNNAMED_OPCODES = (SlapOpcode.TAILCALL, SlapOpcode.CAST)
+
+# The operand formats each of the generic instruction forms in the grammar can supply
+PLAIN_FORMATS = (SlapOperandFormat.NONE,)
+BRANCH_FORMATS = (SlapOperandFormat.U32,)
+IMMEDIATE_FORMATS = (SlapOperandFormat.U8, SlapOperandFormat.U16, SlapOperandFormat.VARINT)
+
+
+def lookup_mnemonic(mnemonic: str) -> Optional[tuple[SlapOpcode, SlapOperandFormat]]:
+    """The opcode a mnemonic of the generic instruction forms assembles to and its operand format, None if unknown"""
+    if mnemonic != mnemonic.lower() or mnemonic.upper() in MNEMONIC_ALIASES.values():
+        return None
+    entry = SLAP_OPCODES.get(MNEMONIC_ALIASES.get(mnemonic, mnemonic.upper()))
+    if entry is None or entry[0] in UNNAMED_OPCODES:
+        return None
+    return entry
+
+
+def operand_format(opcode: SlapOpcode) -> SlapOperandFormat:
+    return SLAP_OPCODES[opcode.name][1]
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapCastType(IntEnum):
+    """Operand halves of CAST, must mirror SlimRuntimeCastArg in SlimMachine.h"""
+
+    INTEGER = 0
+    FLOAT = 1
+    STRING = 2
+
+
+def cast_operand(source: SlapCastType, target: SlapCastType) -> int:
+    """CAST packs the type it casts from in the high byte of its operand and the type it casts to in the low byte"""
+    return source << 8 | target
@@ -0,0 +1,159 @@
+# Generated from SlimOpcodeTable.h by SlapOpcodeGenerator.py, run ./auto.sh -o after changing the table
+from enum import IntEnum
+
+from .SlapByteWriter import SlapOperandFormat
+
+
+class SlapOpcode(IntEnum):
+    """The machine's opcodes"""
+
+    NOOP = 0x00
+    HALT = 0x01
+
+    LOADI = 0x10
+    LOADR = 0x11
+    LOADM = 0x12
+    DROP = 0x13
+    STORER = 0x14
+    STOREM = 0x15
+    LOADK = 0x16
+    LOADS = 0x17
+    LOADL = 0x18
+    STOREL = 0x19
+
+    DUP = 0x20
+    SWAP = 0x21
+    ROT = 0x22
+
+    ADD = 0x30
+    SUB = 0x31
+    MUL = 0x32
+    DIV = 0x33
+    MOD = 0x34
+
+    ADDF = 0x35
+    SUBF = 0x36
+    MULF = 0x37
+    DIVF = 0x38
+    MODF = 0x39
+
+    ALLOC = 0x40
+    FREE = 0x41
+    MEMCOPY = 0x42
+    MEMFILL = 0x43
+    MEMCMP = 0x44
+
+    JMP = 0x50
+    JNE = 0x51
+    JE = 0x52
+    JLT = 0x53
+    JLE = 0x54
+    JGT = 0x55
+    JGE = 0x56
+    JLTU = 0x57
+    JLEU = 0x58
+    JGTU = 0x59
+    JGEU = 0x5A
+    JLTF = 0x5B
+    JLEF = 0x5C
+    JGTF = 0x5D
+    JGEF = 0x5E
+    DJNZ = 0x5F
+
+    CALL = 0x60
+    RET = 0x61
+    CALLN = 0x62
+    TAILCALL = 0x63
+    PARFOR = 0x64
+
+    CAST = 0x70
+
+    VADD = 0x80
+    VSUB = 0x81
+    VMUL = 0x82
+    VFMA = 0x83
+    VDOT = 0x84
+    VSUM = 0x85
+    VMIN = 0x86
+    VMAX = 0x87
+    VADDF = 0x88
+    VSUBF = 0x89
+    VMULF = 0x8A
+    VFMAF = 0x8B
+    VDOTF = 0x8C
+    VSUMF = 0x8D
+    VMINF = 0x8E
+    VMAXF = 0x8F
+
+
+# Every opcode by name with the format the assembler encodes its operand in
+SLAP_OPCODES: dict[str, tuple[SlapOpcode, SlapOperandFormat]] = {
+    "NOOP": (SlapOpcode.NOOP, SlapOperandFormat.NONE),
+    "HALT": (SlapOpcode.HALT, SlapOperandFormat.U8),
+    "LOADI": (SlapOpcode.LOADI, SlapOperandFormat.VARINT),
+    "LOADR": (SlapOpcode.LOADR, SlapOperandFormat.U8),
+    "LOADM": (SlapOpcode.LOADM, SlapOperandFormat.U16),
+    "DROP": (SlapOpcode.DROP, SlapOperandFormat.NONE),
+    "STORER": (SlapOpcode.STORER, SlapOperandFormat.U8),
+    "STOREM": (SlapOpcode.STOREM, SlapOperandFormat.U16),
+    "LOADK": (SlapOpcode.LOADK, SlapOperandFormat.VARINT),
+    "LOADS": (SlapOpcode.LOADS, SlapOperandFormat.VARINT),
+    "LOADL": (SlapOpcode.LOADL, SlapOperandFormat.U16),
+    "STOREL": (SlapOpcode.STOREL, SlapOperandFormat.U16),
+    "DUP": (SlapOpcode.DUP, SlapOperandFormat.NONE),
+    "SWAP": (SlapOpcode.SWAP, SlapOperandFormat.NONE),
+    "ROT": (SlapOpcode.ROT, SlapOperandFormat.NONE),
+    "ADD": (SlapOpcode.ADD, SlapOperandFormat.NONE),
+    "SUB": (SlapOpcode.SUB, SlapOperandFormat.NONE),
+    "MUL": (SlapOpcode.MUL, SlapOperandFormat.NONE),
+    "DIV": (SlapOpcode.DIV, SlapOperandFormat.NONE),
+    "MOD": (SlapOpcode.MOD, SlapOperandFormat.NONE),
+    "ADDF": (SlapOpcode.ADDF, SlapOperandFormat.NONE),
+    "SUBF": (SlapOpcode.SUBF, SlapOperandFormat.NONE),
+    "MULF": (SlapOpcode.MULF, SlapOperandFormat.NONE),
+    "DIVF": (SlapOpcode.DIVF, SlapOperandFormat.NONE),
+    "MODF": (SlapOpcode.MODF, SlapOperandFormat.NONE),
+    "ALLOC": (SlapOpcode.ALLOC, SlapOperandFormat.VARINT),
+    "FREE": (SlapOpcode.FREE, SlapOperandFormat.NONE),
+    "MEMCOPY": (SlapOpcode.MEMCOPY, SlapOperandFormat.NONE),
+    "MEMFILL": (SlapOpcode.MEMFILL, SlapOperandFormat.NONE),
+    "MEMCMP": (SlapOpcode.MEMCMP, SlapOperandFormat.NONE),
+    "JMP": (SlapOpcode.JMP, SlapOperandFormat.U32),
+    "JNE": (SlapOpcode.JNE, SlapOperandFormat.U32),
+    "JE": (SlapOpcode.JE, SlapOperandFormat.U32),
+    "JLT": (SlapOpcode.JLT, SlapOperandFormat.U32),
+    "JLE": (SlapOpcode.JLE, SlapOperandFormat.U32),
+    "JGT": (SlapOpcode.JGT, SlapOperandFormat.U32),
+    "JGE": (SlapOpcode.JGE, SlapOperandFormat.U32),
+    "JLTU": (SlapOpcode.JLTU, SlapOperandFormat.U32),
+    "JLEU": (SlapOpcode.JLEU, SlapOperandFormat.U32),
+    "JGTU": (SlapOpcode.JGTU, SlapOperandFormat.U32),
+    "JGEU": (SlapOpcode.JGEU, SlapOperandFormat.U32),
+    "JLTF": (SlapOpcode.JLTF, SlapOperandFormat.U32),
+    "JLEF": (SlapOpcode.JLEF, SlapOperandFormat.U32),
+    "JGTF": (SlapOpcode.JGTF, SlapOperandFormat.U32),
+    "JGEF": (SlapOpcode.JGEF, SlapOperandFormat.U32),
+    "DJNZ": (SlapOpcode.DJNZ, SlapOperandFormat.VARINT),
+    "CALL": (SlapOpcode.CALL, SlapOperandFormat.U32),
+    "RET": (SlapOpcode.RET, SlapOperandFormat.NONE),
+    "CALLN": (SlapOpcode.CALLN, SlapOperandFormat.U16),
+    "TAILCALL": (SlapOpcode.TAILCALL, SlapOperandFormat.U32),
+    "PARFOR": (SlapOpcode.PARFOR, SlapOperandFormat.U32),
+    "CAST": (SlapOpcode.CAST, SlapOperandFormat.U16),
+    "VADD": (SlapOpcode.VADD, SlapOperandFormat.NONE),
+    "VSUB": (SlapOpcode.VSUB, SlapOperandFormat.NONE),
+    "VMUL": (SlapOpcode.VMUL, SlapOperandFormat.NONE),
+    "VFMA": (SlapOpcode.VFMA, SlapOperandFormat.NONE),
+    "VDOT": (SlapOpcode.VDOT, SlapOperandFormat.NONE),
+    "VSUM": (SlapOpcode.VSUM, SlapOperandFormat.NONE),
+    "VMIN": (SlapOpcode.VMIN, SlapOperandFormat.NONE),
+    "VMAX": (SlapOpcode.VMAX, SlapOperandFormat.NONE),
+    "VADDF": (SlapOpcode.VADDF, SlapOperandFormat.NONE),
+    "VSUBF": (SlapOpcode.VSUBF, SlapOperandFormat.NONE),
+    "VMULF": (SlapOpcode.VMULF, SlapOperandFormat.NONE),
+    "VFMAF": (SlapOpcode.VFMAF, SlapOperandFormat.NONE),
+    "VDOTF": (SlapOpcode.VDOTF, SlapOperandFormat.NONE),
+    "VSUMF": (SlapOpcode.VSUMF, SlapOperandFormat.NONE),
+    "VMINF": (SlapOpcode.VMINF, SlapOperandFormat.NONE),
+    "VMAXF": (SlapOpcode.VMAXF, SlapOperandFormat.NONE),
+}
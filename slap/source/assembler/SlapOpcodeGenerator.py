@@ -0,0 +1,69 @@
+import os
+import re
+import sys
+
+# ----------------------------------------------------------------------------------------------------------------------
+SLIM_OPCODE_TABLE = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "slim", "include", "SlimOpcodeTable.h"
+)
+SLAP_OPCODE_MODULE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "SlapOpcode.py")
+
+# SLIM_OPCODE(name, value, routine, operand), see SlimOpcodeTable.h
+ROW = re.compile(r"^SLIM_OPCODE\(\s*(\w+),\s*(0x[0-9A-Fa-f]+),\s*(\w+),\s*(\w+)\s*\)")
+
+HEADER = '''# Generated from SlimOpcodeTable.h by SlapOpcodeGenerator.py, run ./auto.sh -o after changing the table
+from enum import IntEnum
+
+from .SlapByteWriter import SlapOperandFormat
+
+
+class SlapOpcode(IntEnum):
+    """The machine's opcodes"""
+'''
+
+TABLE = '''
+
+# Every opcode by name with the format the assembler encodes its operand in
+SLAP_OPCODES: dict[str, tuple[SlapOpcode, SlapOperandFormat]] = {
+'''
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+def generate(table: str) -> str:
+    """Turns the rows of the opcode table into the SlapOpcode module, keeping the blank lines that group them"""
+    rows: list[tuple[str, int, str]] = []
+    entries = ""
+    pending_blank = False
+    for line in table.splitlines():
+        match = ROW.match(line.strip())
+        if match is None:
+            pending_blank = pending_blank or (line.strip() == "" and len(rows) > 0)
+            continue
+
+        name, value, _, operand = match.groups()
+        if pending_blank:
+            entries += "\n"
+            pending_blank = False
+        entries += f"    {name} = 0x{int(value, 16):02X}\n"
+        rows.append((name, int(value, 16), operand))
+
+    if len(rows) == 0:
+        raise Exception("No SLIM_OPCODE rows found in the opcode table")
+
+    table_entries = "".join(
+        f'    "{name}": (SlapOpcode.{name}, SlapOperandFormat.{operand}),\n' for name, _, operand in rows
+    )
+    return HEADER + "\n" + entries + TABLE + table_entries + "}\n"
+
+
+def main():
+    with open(SLIM_OPCODE_TABLE) as file:
+        module = generate(file.read())
+    with open(SLAP_OPCODE_MODULE, "w") as file:
+        file.write(module)
+    print(f"Generated {SLAP_OPCODE_MODULE}")
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+if __name__ == "__main__":
+    sys.exit(main())
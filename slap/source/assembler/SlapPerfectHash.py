@@ -0,0 +1,93 @@
+from typing import Optional
+from dataclasses import dataclass
+
+
+MASK_32 = 0xFFFFFFFF
+MASK_64 = 0xFFFFFFFFFFFFFFFF
+
+
+def symbol_hash(seed: int, name: bytes) -> int:
+    """Seeded 64-bit FNV-1a followed by the splitmix64 finalizer, must mirror ___slim_bytecode_symbol_hash in
+    SlimBytecode.c"""
+    value = 0xCBF29CE484222325 ^ seed
+    for byte in name:
+        value ^= byte
+        value = (value * 0x100000001B3) & MASK_64
+    value ^= value >> 30
+    value = (value * 0xBF58476D1CE4E5B9) & MASK_64
+    value ^= value >> 27
+    value = (value * 0x94D049BB133111EB) & MASK_64
+    value ^= value >> 31
+    return value
+
+
+def symbol_slot(value: int, displacement: int, slot_count: int) -> int:
+    """Slot of a key under its bucket's displacement, must mirror ___slim_bytecode_symbol_slot in SlimBytecode.c"""
+    f1 = (value & MASK_32) % slot_count
+    f2 = (((value * 0x9E3779B97F4A7C15) & MASK_64) >> 32) % slot_count
+    d0 = displacement // slot_count
+    d1 = displacement % slot_count
+    return (f1 + d0 * f2 + d1) % slot_count
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+@dataclass
+class SlapPerfectHash:
+    seed: int
+    displacements: list[int]  # One displacement per bucket
+    order: list[int]  # order[slot] is the index of the key stored in that slot
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapPerfectHashBuilder:
+    """Builds a minimal perfect hash over a set of distinct names using CHD (compress, hash, displace).  Keys are split
+    into buckets of about KEYS_PER_BUCKET keys, and the largest buckets are placed first by searching for the smallest
+    displacement that sends all of their keys into free slots.  If a bucket cannot be placed the seed is changed and
+    the build starts over."""
+
+    KEYS_PER_BUCKET = 4
+    MAX_SEEDS = 256
+    MAX_DISPLACEMENT_TRIES = 1 << 16
+
+    def __init__(self, names: list[bytes]):
+        self.names = names
+
+    def _try_seed(self, seed: int) -> Optional[SlapPerfectHash]:
+        slot_count = len(self.names)
+        bucket_count = max(1, (slot_count + self.KEYS_PER_BUCKET - 1) // self.KEYS_PER_BUCKET)
+
+        hashes = [symbol_hash(seed, name) for name in self.names]
+        buckets: list[list[int]] = [[] for _ in range(bucket_count)]
+        for key, value in enumerate(hashes):
+            buckets[(value >> 32) % bucket_count].append(key)
+
+        displacements = [0] * bucket_count
+        order = [-1] * slot_count
+
+        for bucket in sorted(range(bucket_count), key=lambda b: len(buckets[b]), reverse=True):
+            keys = buckets[bucket]
+            if len(keys) == 0:
+                break
+
+            for displacement in range(min(slot_count * slot_count, self.MAX_DISPLACEMENT_TRIES)):
+                slots = [symbol_slot(hashes[key], displacement, slot_count) for key in keys]
+                if len(set(slots)) == len(slots) and all(order[slot] == -1 for slot in slots):
+                    for key, slot in zip(keys, slots):
+                        order[slot] = key
+                    displacements[bucket] = displacement
+                    break
+            else:
+                return None
+
+        return SlapPerfectHash(seed, displacements, order)
+
+    def build(self) -> SlapPerfectHash:
+        if len(self.names) == 0:
+            return SlapPerfectHash(0, [], [])
+
+        for seed in range(self.MAX_SEEDS):
+            result = self._try_seed(seed)
+            if result is not None:
+                return result
+
+        raise Exception(f"Failed to build a perfect hash over {len(self.names)} symbols")
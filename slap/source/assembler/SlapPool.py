@@ -0,0 +1,29 @@
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapConstantPool:
+    """Deduplicated table of 64-bit constants, addressed by index through LOADK"""
+
+    def __init__(self):
+        self.constants: list[int] = []
+        self.indices: dict[int, int] = {}
+
+    def intern(self, value: int) -> int:
+        value &= 0xFFFFFFFFFFFFFFFF
+        if value not in self.indices:
+            self.indices[value] = len(self.constants)
+            self.constants.append(value)
+        return self.indices[value]
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapStringTable:
+    """Interned table of strings, every distinct string is stored exactly once and addressed by index through LOADS"""
+
+    def __init__(self):
+        self.strings: list[str] = []
+        self.indices: dict[str, int] = {}
+
+    def intern(self, string: str) -> int:
+        if string not in self.indices:
+            self.indices[string] = len(self.strings)
+            self.strings.append(string)
+        return self.indices[string]
@@ -13,6 +13,7 @@ from parsing.SlapListener import SlapListener
 from log.SlapLog import *
 from assembler.SlapAssembler import SlapAssembler
 from assembler.SlapByteWriter import SlapByteWriter
+from assembler.SlapImageWriter import SlapImageWriter
 
 from symbol.SlapSymbol import *
 from symbol.SlapSymbolResolver import *
@@ -75,7 +76,11 @@ class SlapProgram:
 
         assembler = SlapAssembler(symbol_table)
         walker.walk(assembler, self.tree)
-        self.byte_array = assembler.byte_array
+
+        image_writer = SlapImageWriter(
+            symbol_table, assembler.byte_array, assembler.constant_pool, assembler.string_table
+        )
+        self.byte_array = image_writer.write()
         return True
 
     # ------------------------------------------------------------------------------------------------------------------
@@ -2,7 +2,7 @@ grammar Slap;
 
 // Grammar Rules
 program: (sectionDeclaration | nativeDeclaration)* EOF;
-sectionDeclaration: sectionSpecifier '{' (instruction)* '}';
+sectionDeclaration: 'export'? sectionSpecifier ('(' wholeNumber ')')? '{' (instruction)* '}';
 nativeDeclaration: 'native' sectionSpecifier HEX_NUMBER ';';
 sectionSpecifier: '@' '(' LABEL ')';
 
@@ -10,72 +10,40 @@ sectionSpecifier: '@' '(' LABEL ')';
 instruction: instruction_body ';';
 instruction_body
     : instructionHalt
-    | instructionNoop
     | instructionLoadi
-    | instructionLoadr
-    | instructionLoadm
-    | instructionDrop
-    | instructionStorer
-    | instructionStorem
-    | instructionDup
-    | instructionSwap
-    | instructionRot
-    | instructionAdd
-    | instructionSub
-    | instructionMul
-    | instructionDiv
-    | instructionMod
-    | instructionAddf
-    | instructionSubf
-    | instructionMulf
-    | instructionDivf
-    | instructionModf
-    | instructionAlloc
-    | instructionFree
-    | instructionJmp
-    | instructionJne
-    | instructionJeq
+    | instructionLoadk
+    | instructionLoads
+    | instructionDjnz
     | instructionCall
-    | instructionRet
     | instructionCalln
+    | instructionParfor
     | instructionFtoi
     | instructionItof
     | instructionItoc
+    | instructionPlain
+    | instructionBranch
+    | instructionImmediate
     ;
 
+// Instructions the assembler encodes specially
 instructionHalt: 'halt' wholeNumber?;
-instructionNoop: 'noop';
 instructionLoadi: 'loadi' anyNumber;
-instructionLoadr: 'loadr' wholeNumber;
-instructionLoadm: 'loadm' wholeNumber;
-instructionDrop: 'drop';
-instructionStorer: 'storer' wholeNumber;
-instructionStorem: 'storem' wholeNumber;
-instructionDup: 'dup';
-instructionSwap: 'swap';
-instructionRot: 'rot';
-instructionAdd: 'add';
-instructionSub: 'sub';
-instructionMul: 'mul';
-instructionDiv: 'div';
-instructionMod: 'mod';
-instructionAddf: 'addf';
-instructionSubf: 'subf';
-instructionMulf: 'mulf';
-instructionDivf: 'divf';
-instructionModf: 'modf';
-instructionAlloc: 'alloc' wholeNumber;
-instructionFree: 'free';
-instructionJmp: 'jmp' sectionSpecifier;
-instructionJne: 'jne' sectionSpecifier;
-instructionJeq: 'jeq' sectionSpecifier;
+instructionLoadk: 'loadk' anyNumber;
+instructionLoads: 'loads' STRING;
+instructionDjnz: 'djnz' wholeNumber sectionSpecifier;
 instructionCall: 'call' sectionSpecifier;
-instructionRet: 'ret';
 instructionCalln: 'calln' sectionSpecifier;
+instructionParfor: 'parfor' sectionSpecifier;
 instructionFtoi: 'ftoi';
 instructionItof: 'itof';
 instructionItoc: 'itoc';
 
+// Every other instruction is its mnemonic followed by at most one operand, the mnemonic is looked up in the opcode
+// table by the validator and the assembler (see SlapInstructionSet.py)
+instructionPlain: LABEL;
+instructionBranch: LABEL sectionSpecifier;
+instructionImmediate: LABEL wholeNumber;
+
 anyNumber: floatingNumber | wholeNumber;
 wholeNumber: INT_NUMBER | BIN_NUMBER | HEX_NUMBER;
 floatingNumber: FLOAT_NUMBER;
@@ -86,6 +54,7 @@ HEX_NUMBER: '0x' [0-9a-fA-F]+;
 BIN_NUMBER: '0b' [01]+;
 FLOAT_NUMBER: '0f' [0-9]+ '.' [0-9]+;
 INT_NUMBER: '0i' [0-9]+;
+STRING: '"' (~["\\\r\n] | '\\' .)* '"';
 
 BLOCK_COMMENT : '/*' .*? '*/' -> channel(HIDDEN);
 LINE_COMMENT : '//' ~[\r\n]* -> channel(HIDDEN);
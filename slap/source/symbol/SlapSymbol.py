@@ -8,7 +8,12 @@ class SlapSectionSymbol:
     name: str  # Name of the symbol (e.g. "main")
     global_index: int  # Index of this symbol in the global symbol table (technically redundant)
     instruction_count: int  # How many instructions are in this section
-    address: int = 0  # Address of this section in the final binary
+    address: int = 0  # Address (instruction index) of this section in the final binary
+    byte_offset: int = 0  # Offset of the encoded body from the start of the instruction table
+    byte_size: int = 0  # Size of the encoded body in bytes
+    exported: bool = False  # Whether the section can be looked up by name through the symbol table
+    local_count: int = 0  # Number of frame slots reserved on entry, one past the highest slot used by loadl/storel
+    argument_count: int = 0  # Number of those slots filled from the caller's stack, declared as @(name)(count)
 
 
 # ----------------------------------------------------------------------------------------------------------------------
@@ -26,12 +31,14 @@ class SlapSymbolTable:
     native_symbols: list[SlapNativeSymbol]
 
     def calculate_addresses(self):
-        """Calculates the addresses of all symbols in the symbol table"""
+        """Calculates the addresses of all symbols in the symbol table.  Instructions are variable length on disk but
+        are expanded by the loader, so an address is the index of the section's first instruction rather than a byte
+        offset."""
         current_address = 0
         print(self.section_symbols)
         for section in self.section_symbols:
             section.address = current_address
-            current_address += section.instruction_count * 9
+            current_address += section.instruction_count
 
 
 
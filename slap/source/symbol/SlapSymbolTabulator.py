@@ -1,6 +1,9 @@
 from parsing.SlapListener import SlapListener
 from parsing.SlapParser import SlapParser
 
+from assembler.SlapByteWriter import parse_number
+from assembler.SlapInstructionSet import lookup_mnemonic
+from assembler.SlapOpcode import SlapOpcode
 from .SlapSymbol import *
 
 
@@ -12,13 +15,20 @@ class SlapSymbolTabulator(SlapListener):
         self.symbol_table = SlapSymbolTable([], [])
         self.global_index = 0
         self.current_section_size = 0
+        self.current_local_count = 0
 
     def exitSectionDeclaration(self, ctx: SlapParser.SectionDeclarationContext):
         name = ctx.sectionSpecifier().LABEL().getText()
-        section = SlapSectionSymbol(name, self.global_index, self.current_section_size)
+        exported = ctx.getChild(0).getText() == "export"
+        section = SlapSectionSymbol(name, self.global_index, self.current_section_size, exported=exported)
+        # Arguments are the first locals, so a section that never touches them still reserves their slots
+        if ctx.wholeNumber() is not None:
+            section.argument_count = parse_number(ctx.wholeNumber().getText())
+        section.local_count = max(self.current_local_count, section.argument_count)
         self.symbol_table.section_symbols.append(section)
         self.global_index += 1
-        self.current_section_size += 1
+        self.current_section_size = 0
+        self.current_local_count = 0
 
     def exitNativeDeclaration(self, ctx: SlapParser.NativeDeclarationContext):
         name = ctx.sectionSpecifier().LABEL().getText()
@@ -27,4 +37,16 @@ class SlapSymbolTabulator(SlapListener):
         self.symbol_table.native_symbols.append(native)
 
     def exitInstruction(self, ctx: SlapParser.InstructionContext):
-        self.current_section_size += 1
\ No newline at end of file
+        self.current_section_size += 1
+
+    def _use_local(self, slot: str):
+        self.current_local_count = max(self.current_local_count, parse_number(slot) + 1)
+
+    def exitInstructionImmediate(self, ctx: SlapParser.InstructionImmediateContext):
+        # Unknown mnemonics are reported by the validator, which runs on the complete table
+        entry = lookup_mnemonic(ctx.LABEL().getText())
+        if entry is not None and entry[0] in (SlapOpcode.LOADL, SlapOpcode.STOREL):
+            self._use_local(ctx.wholeNumber().getText())
+
+    def exitInstructionDjnz(self, ctx: SlapParser.InstructionDjnzContext):
+        self._use_local(ctx.wholeNumber().getText())
@@ -1,6 +1,8 @@
 from parsing.SlapListener import SlapListener
 from parsing.SlapParser import SlapParser
 
+from assembler.SlapByteWriter import SlapOperandFormat
+from assembler.SlapInstructionSet import BRANCH_FORMATS, IMMEDIATE_FORMATS, PLAIN_FORMATS, lookup_mnemonic
 from .SlapSymbol import SlapSymbolTable
 from log.SlapLog import *
 
@@ -12,8 +14,12 @@ class SlapSymbolValidator(SlapListener):
     - That there are no naming conflicts between sections and/or native symbols
     - That every reference to a symbol points to a valid symbol
     - That every reference to a symbol is of the correct type (e.g jump can't jump to a native symbol)
+    - That every mnemonic names an opcode which takes the kind of operand it is given
     """
 
+    # Every instruction which branches within the program
+    BRANCH_CONTEXTS = (SlapParser.InstructionBranchContext, SlapParser.InstructionDjnzContext)
+
     def __init__(self, symbol_table: SlapSymbolTable):
         self.symbol_table = symbol_table
         self.isValid = True
@@ -89,20 +95,33 @@ class SlapSymbolValidator(SlapListener):
         if not isNative:
             return True
 
-        if isinstance(ctx.parentCtx, SlapParser.InstructionJmpContext):
+        if isinstance(ctx.parentCtx, self.BRANCH_CONTEXTS):
             error(f"Cannot jump to native symbol '{name}'")
             return False
 
-        if isinstance(ctx.parentCtx, SlapParser.InstructionJeqContext):
-            error(f"Cannot jump to native symbol '{name}'")
+        return True
+
+    def _validate_mnemonic(self, mnemonic: str, formats: tuple[SlapOperandFormat, ...]) -> bool:
+        entry = lookup_mnemonic(mnemonic)
+        if entry is None:
+            error(f"Unknown instruction '{mnemonic}'")
             return False
 
-        if isinstance(ctx.parentCtx, SlapParser.InstructionJneContext):
-            error(f"Cannot jump to native symbol '{name}'")
+        if entry[1] not in formats:
+            error(f"Wrong kind of operand for instruction '{mnemonic}'")
             return False
 
         return True
 
+    def enterInstructionPlain(self, ctx: SlapParser.InstructionPlainContext):
+        self.isValid = self.isValid and self._validate_mnemonic(ctx.LABEL().getText(), PLAIN_FORMATS)
+
+    def enterInstructionBranch(self, ctx: SlapParser.InstructionBranchContext):
+        self.isValid = self.isValid and self._validate_mnemonic(ctx.LABEL().getText(), BRANCH_FORMATS)
+
+    def enterInstructionImmediate(self, ctx: SlapParser.InstructionImmediateContext):
+        self.isValid = self.isValid and self._validate_mnemonic(ctx.LABEL().getText(), IMMEDIATE_FORMATS)
+
     def enterSectionSpecifier(self, ctx: SlapParser.SectionSpecifierContext):
         self.isValid = self.isValid and self._validate_reference_name(ctx)
         self.isValid = self.isValid and self._validate_reference_type(ctx)
@@ -0,0 +1,69 @@
+import os
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "source"))
+
+from assembler.SlapProgram import SlapProgram
+from log import SlapLog as log
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+def assemble(source: str) -> bytearray:
+    """Assembles source through the whole pipeline and returns the image it would write"""
+    with tempfile.NamedTemporaryFile("w", suffix=".slap", delete=False) as file:
+        file.write(source)
+    try:
+        program = SlapProgram(file.name)
+        assert program.parse() and program.assemble()
+        return program.byte_array
+    finally:
+        os.unlink(file.name)
+
+
+def read_u32(image: bytearray, offset: int) -> int:
+    return int.from_bytes(image[offset : offset + 4], "big")
+
+
+def read_tables(image: bytearray) -> tuple[list[tuple[int, ...]], bytearray]:
+    """Splits an image into its section entries and its instruction table, see SlapImageWriter"""
+    sizes = [read_u32(image, offset) for offset in range(0, 28, 4)]
+    header_size, native_size, string_size, constant_size, instruction_size, section_size, symbol_size = sizes
+
+    section_offset = header_size + native_size + string_size + constant_size
+    sections = []
+    for entry in range(section_offset, section_offset + section_size, 24):
+        sections.append(tuple(read_u32(image, entry + field * 4) for field in range(6)))
+
+    instruction_offset = section_offset + section_size + symbol_size
+    return sections, image[instruction_offset : instruction_offset + instruction_size]
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapAssemblerTest(unittest.TestCase):
+    def setUp(self):
+        log.init(os.path.join(tempfile.gettempdir(), "slap-test.log"), False)
+
+    def test_argument_count_after_halt(self):
+        # halt leaves a one byte operand format behind, the argument count of the next section must not be written
+        # with it into that section's body
+        sections, instructions = read_tables(
+            assemble(
+                """
+                @(main) { loadi 0i2; loadi 0i3; call @(f); halt; }
+                @(f)(0i2) { add; ret; }
+                """
+            )
+        )
+
+        self.assertEqual(sections, [(0, 4, 0, 11, 0, 0), (4, 2, 11, 2, 2, 2)])
+        self.assertEqual(
+            instructions,
+            bytes([0x10, 0x02, 0x10, 0x03, 0x60, 0x00, 0x00, 0x00, 0x04, 0x01, 0x00, 0x30, 0x61]),
+        )
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+if __name__ == "__main__":
+    unittest.main()
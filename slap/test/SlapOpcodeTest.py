@@ -0,0 +1,34 @@
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "source"))
+
+from assembler.SlapOpcodeGenerator import SLAP_OPCODE_MODULE, SLIM_OPCODE_TABLE, generate
+from assembler.SlapInstructionSet import lookup_mnemonic
+from assembler.SlapByteWriter import SlapOperandFormat
+from assembler.SlapOpcode import SlapOpcode
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+class SlapOpcodeTest(unittest.TestCase):
+    def test_generated_module_is_current(self):
+        # A table change without ./auto.sh -o would make the assembler emit opcodes the machine no longer has
+        with open(SLIM_OPCODE_TABLE) as file:
+            expected = generate(file.read())
+        with open(SLAP_OPCODE_MODULE) as file:
+            self.assertEqual(file.read(), expected)
+
+    def test_mnemonics(self):
+        self.assertEqual(lookup_mnemonic("loadl"), (SlapOpcode.LOADL, SlapOperandFormat.U16))
+        self.assertEqual(lookup_mnemonic("jeq"), (SlapOpcode.JE, SlapOperandFormat.U32))
+        self.assertEqual(lookup_mnemonic("ret"), (SlapOpcode.RET, SlapOperandFormat.NONE))
+        self.assertIsNone(lookup_mnemonic("je"))
+        self.assertIsNone(lookup_mnemonic("ADD"))
+        self.assertIsNone(lookup_mnemonic("tailcall"))
+        self.assertIsNone(lookup_mnemonic("cast"))
+
+
+# ----------------------------------------------------------------------------------------------------------------------
+if __name__ == "__main__":
+    unittest.main()
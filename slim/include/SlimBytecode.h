@@ -8,9 +8,23 @@
 // tables, as well information on each table. The header table always starts at the beginning of the bytecode, and is
 // always a fixed size of 256 bytes.
 // 2. The Native Table - NumId -> StringQualifier
-// 3. The String Table - NumId -> String
-// 4. The Constant Table - NumId -> Constant
-// 5. The Instruction Table - SSA Instruction
+// 3. The String Table - NumId -> String, deduplicated by the assembler and loaded into one contiguous buffer
+// 4. The Constant Table - NumId -> Constant, deduplicated by the assembler and addressed by LOADK
+// 5. The Section Table - NumId -> Section, the index of every function body within the instruction table
+// 6. The Symbol Table - Name -> Native or exported Section, a minimal perfect hash built by the assembler
+// 7. The Instruction Table - SSA Instruction
+//
+// Instructions are stored using a compact, variable-length encoding: a single opcode byte followed by an operand whose
+// width is fixed per opcode (see SlimBytecodeOperandFormat).  The loader expands the encoded stream exactly once into a
+// contiguous array of SlimBytecodeInstruction, so instruction addresses are indices into that array, not byte offsets.
+//
+// When the image carries a section table, only the index is read at load time.  Each function body is decoded and
+// verified the first time an instruction inside it is looked up, so startup cost does not scale with the image size.
+// The table keeps a reference to the image for that instead of a copy of the instruction table.
+// Images without a section table are decoded eagerly.  Decoding a CALL, TAILCALL or PARFOR places the local count of
+// the callee in bits 32 to 47 of its operand and its argument count in bits 48 to 63, so the machine can set up the
+// frame without looking the callee up.  DJNZ is encoded as a varint of the target address over a 16-bit slot and
+// decoded the same way, slot in the upper half.
 
 typedef struct SlimBytecodeData* SlimBytecodeData;
 
@@ -19,11 +33,66 @@ typedef struct SlimBytecodeTable* SlimBytecodeTable;
 // TODO: Unify with SlimMachineInstruction, they are essentially redundant
 typedef struct SlimBytecodeInstruction {
     u8_t opcode;
+    u8_t loaded; // Set by decoding, so the zeroed slots of sections that were not decoded yet read as unloaded
     u64_t operand;
 } SlimBytecodeInstruction;
 
+typedef struct SlimBytecodeSection {
+    u32_t address;           // Index of the first instruction of the section
+    u32_t instruction_count; // Number of instructions in the section
+    u32_t byte_offset;       // Offset of the encoded body from the start of the instruction table
+    u32_t byte_size;         // Size of the encoded body
+    u32_t local_count;       // Number of frame slots reserved when the section is called
+    u32_t argument_count;    // Number of those slots the caller fills with the values on top of its stack
+    u8_t loaded;             // Whether the body has been decoded into the instruction array
+} SlimBytecodeSection;
+
+typedef enum SlimBytecodeOperandFormat {
+    SLIM_BYTECODE_OPERAND_NONE = 0,   // No operand follows the opcode
+    SLIM_BYTECODE_OPERAND_U8 = 1,     // 1 byte immediate
+    SLIM_BYTECODE_OPERAND_U16 = 2,    // 2 byte big-endian immediate
+    SLIM_BYTECODE_OPERAND_U32 = 3,    // 4 byte big-endian immediate
+    SLIM_BYTECODE_OPERAND_VARINT = 4, // Unsigned LEB128, 1 to 10 bytes
+} SlimBytecodeOperandFormat;
+
+SlimError slim_bytecode_operand_format(u8_t opcode, SlimBytecodeOperandFormat* format);
+
+// Strings are interned per image, so two entries from the same table are equal exactly when their indices are equal.
+// The length and hash are computed once at load so that comparing against foreign strings rarely needs a memcmp.
+typedef struct SlimBytecodeString {
+    const char* data; // Null-terminated, owned by the table
+    u32_t length;
+    u32_t hash;
+} SlimBytecodeString;
+
+u32_t slim_bytecode_hash(const char* data, u32_t length);
+
+// Symbols name the natives and exported sections of an image.  The symbol table is a CHD minimal perfect hash, so a
+// lookup by name costs one hash, one displacement and one comparison, and never allocates.
+typedef enum SlimBytecodeSymbolKind {
+    SLIM_BYTECODE_SYMBOL_NATIVE = 0,  // index is the native identifier, as used by CALLN
+    SLIM_BYTECODE_SYMBOL_SECTION = 1, // index is the position in the section table
+} SlimBytecodeSymbolKind;
+
+typedef struct SlimBytecodeSymbol {
+    const char* name; // Not null-terminated, owned by the table
+    u32_t length;
+    u32_t index;
+    u8_t kind;
+} SlimBytecodeSymbol;
+u8_t slim_bytecode_string_equal(const SlimBytecodeString* a, const SlimBytecodeString* b);
+
 SlimError slim_bytecode_file_load(const char* path, SlimBytecodeTable *dest);
 
+// Prepared tables are persisted in a content-addressed cache directory, keyed by a hash of the image bytes and an id of
+// the instruction set and table layout the VM was built with, which stays the same across rebuilds.  An entry is a
+// flat snapshot of the table, so a hit is mapped and copied back without decoding or verifying anything.  Any
+// mismatch returns SLIM_ERROR and leaves the table untouched, so callers can fall back.
+const char* slim_bytecode_cache_directory();
+SlimError slim_bytecode_cache_load(const char* directory, SlimBytecodeData data, SlimBytecodeTable table);
+SlimError slim_bytecode_cache_store(const char* directory, SlimBytecodeTable table);
+
+// Lazy tables hold on to the image they were loaded from, so destroying the data only releases the caller's reference
 SlimBytecodeData slim_bytecode_data_create(u8_t* data, u32_t size);
 void slim_bytecode_data_destroy(SlimBytecodeData bytecode);
 
@@ -35,24 +104,50 @@ SlimError slim_bytecode_table_load_data_header(SlimBytecodeTable table, SlimByte
 SlimError slim_bytecode_table_load_data_native(SlimBytecodeTable table, SlimBytecodeData data);
 SlimError slim_bytecode_table_load_data_string(SlimBytecodeTable table, SlimBytecodeData data);
 SlimError slim_bytecode_table_load_data_constant(SlimBytecodeTable table, SlimBytecodeData data);
+SlimError slim_bytecode_table_load_data_section(SlimBytecodeTable table, SlimBytecodeData data);
+SlimError slim_bytecode_table_load_data_symbol(SlimBytecodeTable table, SlimBytecodeData data);
 SlimError slim_bytecode_table_load_data_instruction(SlimBytecodeTable table, SlimBytecodeData data);
 SlimError slim_bytecode_table_load_data(SlimBytecodeTable table, SlimBytecodeData data);
 
+// The parallel loader parses the native, string, constant and section tables concurrently, then decodes every section
+// of the instruction table in chunks spread over thread_count threads (0 uses every online core).  Prepare decodes
+// whatever sections are still lazy the same way, and returns at once when there are none.  Both are no faster than
+// the lazy path for small images.
+SlimError slim_bytecode_table_load_data_parallel(SlimBytecodeTable table, SlimBytecodeData data, u32_t thread_count);
+SlimError slim_bytecode_table_prepare(SlimBytecodeTable table, u32_t thread_count);
+
 // Accessors
 u32_t slim_bytecode_table_get_size_header(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_size_natives(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_size_strings(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_size_constants(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_size_sections(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_size_symbols(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_size_instrs(SlimBytecodeTable table);
 
 u32_t slim_bytecode_table_get_offset_header(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_offset_natives(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_offset_strings(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_offset_constants(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_offset_sections(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_offset_symbols(SlimBytecodeTable table);
 u32_t slim_bytecode_table_get_offset_instrs(SlimBytecodeTable table);
 
+u32_t slim_bytecode_table_get_count_natives(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_count_strings(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_count_constants(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_count_sections(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_count_symbols(SlimBytecodeTable table);
+u32_t slim_bytecode_table_get_count_instrs(SlimBytecodeTable table);
+
 // Lookup
 SlimError slim_bytecode_table_lookup_native(SlimBytecodeTable table, u64_t index, char** string);
 SlimError slim_bytecode_table_lookup_string(SlimBytecodeTable table, u64_t index, char** string);
+SlimError slim_bytecode_table_lookup_string_entry(SlimBytecodeTable table, u64_t index, SlimBytecodeString* string);
 SlimError slim_bytecode_table_lookup_constant(SlimBytecodeTable table, u64_t index, u64_t* constant);
+SlimError slim_bytecode_table_lookup_section(SlimBytecodeTable table, u64_t index, SlimBytecodeSection* section);
+SlimError slim_bytecode_table_lookup_symbol(
+    SlimBytecodeTable table, const char* name, u32_t length, SlimBytecodeSymbol* symbol);
+// Walks the symbols in slot order, for going from a native or section back to its name
+SlimError slim_bytecode_table_lookup_symbol_slot(SlimBytecodeTable table, u32_t slot, SlimBytecodeSymbol* symbol);
 SlimError slim_bytecode_table_lookup_instruction(SlimBytecodeTable table, u64_t index, SlimBytecodeInstruction* instr);
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SlimType.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  Channels carry u64_t words between machines of the same process.  A channel is a bounded ring in host memory, and
+ *  sending or receiving is a handful of atomic operations with no locks and no system calls.  SPSC channels may only
+ *  ever have one sending and one receiving thread, MPMC channels take any number of both at a small extra cost.
+ *
+ *  try_send and try_recv never block.  A thread that has to wait for room or for a value calls wait_send or wait_recv,
+ *  which sleep on a futex until the other side makes progress, and then tries again.  The other side only pays for the
+ *  wake-up while somebody is actually asleep.
+ *
+ *  Machines refer to channels by handle.  Handles are process-wide, so any machine can use a channel created by
+ *  another, and handle 0 is never valid.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+typedef struct SlimChannel* SlimChannel;
+
+typedef enum SlimChannelKind {
+    SLIM_CHANNEL_SPSC = 0,
+    SLIM_CHANNEL_MPMC = 1
+} SlimChannelKind;
+
+// The capacity is rounded up to a power of two, and to at least 2
+SlimError slim_channel_create(SlimChannelKind kind, u32_t capacity, SlimChannel* channel);
+void slim_channel_destroy(SlimChannel channel);
+
+// Return 1 if the word was sent or received and 0 if the channel was full or empty
+u8_t slim_channel_try_send(SlimChannel channel, u64_t value);
+u8_t slim_channel_try_recv(SlimChannel channel, u64_t* value);
+
+// Block until the channel has room or has a value, which another thread may take first
+void slim_channel_wait_send(SlimChannel channel);
+void slim_channel_wait_recv(SlimChannel channel);
+
+u32_t slim_channel_get_capacity(SlimChannel channel);
+
+// Channel Handles -----------------------------------------------------------------------------------------------------
+SlimError slim_channel_table_insert(SlimChannel channel, u64_t* handle);
+SlimError slim_channel_table_lookup(u64_t handle, SlimChannel* channel);
+
+// Destroys every channel in the table, nothing may be using them
+void slim_channel_table_clear();
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SlimType.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  The console behind the std* natives.  Every machine writes into its own large buffer, and a buffer only reaches the
+ *  output descriptor in one piece, under a process-wide lock.  Output of different machines is therefore never mixed
+ *  within a flush, and each machine's output comes out in the order it was written.
+ *
+ *  A buffer is flushed when it fills up, when its machine goes away, and before its machine reads input.  In interactive
+ *  mode, the default when stdout is a terminal, it is also flushed at every newline.  Input is read in large chunks
+ *  into a buffer shared by every machine.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+#define SLIM_CONSOLE_BUFFER_SIZE 65536
+#define SLIM_CONSOLE_INPUT_SIZE 4096
+
+typedef struct SlimConsoleBuffer* SlimConsoleBuffer;
+
+// Points the console at other descriptors, -1 keeps the current one.  Interactive mode follows isatty on the output
+// unless SLIM_CONSOLE_INTERACTIVE is set, and the input buffer is dropped.
+void slim_console_redirect(s32_t output, s32_t input);
+s32_t slim_console_get_input();
+u8_t slim_console_get_interactive();
+void slim_console_set_interactive(u8_t interactive);
+
+SlimError slim_console_buffer_create(SlimConsoleBuffer* buffer);
+// Flushes whatever is left
+void slim_console_buffer_destroy(SlimConsoleBuffer buffer);
+
+SlimError slim_console_write(SlimConsoleBuffer buffer, const void* data, u32_t size);
+SlimError slim_console_flush(SlimConsoleBuffer buffer);
+
+// Takes one byte of input and returns 1, or returns 0 if the input buffer is empty.  Refilling it may block, so natives
+// only refill once the input descriptor is ready.  The byte is -1 at the end of the input.
+u8_t slim_console_try_read(s32_t* byte);
+SlimError slim_console_fill();
@@ -13,7 +13,128 @@ void slim_vector_append(SlimVector vector, void* element);
 void slim_vector_insert(SlimVector vector, u32_t index, void* element);
 void slim_vector_remove(SlimVector vector, u32_t index, void* element);
 void slim_vector_access(SlimVector vector, u32_t index, void* element);
+void slim_vector_assign(SlimVector vector, u32_t index, void* element);
 u32_t slim_vector_size(SlimVector vector);
-
-// TODO: Implement me and then use for bytecode loading (remove some reallocs and dynamic shenanigans)
 void slim_vector_resize(SlimVector vector, u32_t size);
+
+// Arenas --------------------------------------------------------------------------------------------------------------
+// Bump allocator for data that lives exactly as long as its owner.  Allocations are carved out of large chunks, are
+// never freed individually, and all go away with slim_arena_destroy.  An arena is not safe to share between threads.
+typedef struct SlimArena* SlimArena;
+SlimArena slim_arena_create(u32_t chunk_size);
+void slim_arena_destroy(SlimArena arena);
+void* slim_arena_allocate(SlimArena arena, u32_t size);
+char* slim_arena_copy_string(SlimArena arena, const char* data, u32_t length);
+
+// Typed Vectors -------------------------------------------------------------------------------------------------------
+// SLIM_VECTOR_DECLARE(name, type, inline_capacity) declares a vector of type along with static inline operations
+// prefixed with name.  The first inline_capacity elements are stored inside the vector itself, so small tables never
+// touch the heap.  Elements are accessed in place through pointers, which stay valid until the vector next grows.
+// Because data may point into the vector itself, a vector must be passed by pointer and never copied by value.
+#define SLIM_VECTOR_DECLARE(name, type, inline_capacity)                                                               \
+    typedef struct name {                                                                                              \
+        type* data;                                                                                                    \
+        u32_t size;                                                                                                    \
+        u32_t capacity;                                                                                                \
+        type inline_data[(inline_capacity) > 0 ? (inline_capacity) : 1];                                               \
+    } name;                                                                                                            \
+                                                                                                                       \
+    static inline void name##_init(name* vector)                                                                       \
+    {                                                                                                                  \
+        vector->data = vector->inline_data;                                                                            \
+        vector->size = 0;                                                                                              \
+        vector->capacity = sizeof(vector->inline_data) / sizeof(type);                                                 \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline void name##_free(name* vector)                                                                       \
+    {                                                                                                                  \
+        if (vector->data != vector->inline_data) free(vector->data);                                                   \
+        name##_init(vector);                                                                                           \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline SlimError name##_reserve(name* vector, u32_t capacity)                                               \
+    {                                                                                                                  \
+        if (capacity <= vector->capacity) return SL_ERROR_NONE;                                                        \
+                                                                                                                       \
+        u8_t on_heap = vector->data != vector->inline_data;                                                            \
+        type* data = realloc(on_heap ? vector->data : NULL, (size_t)capacity * sizeof(type));                          \
+        if (data == NULL) return SLIM_ERROR;                                                                           \
+        if (!on_heap) {                                                                                                \
+            /* size never exceeds the inline buffer here, bounding it lets the compiler see that as well */            \
+            size_t inline_size = sizeof(vector->inline_data) / sizeof(type);                                           \
+            if (vector->size < inline_size) inline_size = vector->size;                                                \
+            memcpy(data, vector->inline_data, inline_size * sizeof(type));                                             \
+        }                                                                                                              \
+                                                                                                                       \
+        vector->data = data;                                                                                           \
+        vector->capacity = capacity;                                                                                   \
+        return SL_ERROR_NONE;                                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline SlimError name##_grow(name* vector, u32_t count)                                                     \
+    {                                                                                                                  \
+        u64_t needed = (u64_t)vector->size + count;                                                                    \
+        if (needed <= vector->capacity) return SL_ERROR_NONE;                                                          \
+        if (needed > 0xFFFFFFFF) return SLIM_ERROR;                                                                    \
+                                                                                                                       \
+        u64_t capacity = vector->capacity < 8 ? 16 : (u64_t)vector->capacity * 2;                                      \
+        while (capacity < needed) capacity *= 2;                                                                       \
+        return name##_reserve(vector, capacity > 0xFFFFFFFF ? (u32_t)needed : (u32_t)capacity);                        \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline SlimError name##_resize(name* vector, u32_t size)                                                    \
+    {                                                                                                                  \
+        if (size > vector->size) {                                                                                     \
+            if (name##_grow(vector, size - vector->size) != SL_ERROR_NONE) return SLIM_ERROR;                          \
+            memset(vector->data + vector->size, 0, (size_t)(size - vector->size) * sizeof(type));                      \
+        }                                                                                                              \
+        vector->size = size;                                                                                           \
+        return SL_ERROR_NONE;                                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Like resize, but an empty vector gets its zeroed elements straight from calloc, which leaves untouched pages */ \
+    /* unwritten instead of clearing every element */                                                                  \
+    static inline SlimError name##_resize_zeroed(name* vector, u32_t size)                                             \
+    {                                                                                                                  \
+        if (vector->size != 0 || size <= vector->capacity) return name##_resize(vector, size);                         \
+                                                                                                                       \
+        type* data = calloc(size, sizeof(type));                                                                       \
+        if (data == NULL) return SLIM_ERROR;                                                                           \
+        if (vector->data != vector->inline_data) free(vector->data);                                                   \
+                                                                                                                       \
+        vector->data = data;                                                                                           \
+        vector->size = size;                                                                                           \
+        vector->capacity = size;                                                                                       \
+        return SL_ERROR_NONE;                                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline type* name##_at(name* vector, u32_t index)                                                           \
+    {                                                                                                                  \
+        assert(index < vector->size);                                                                                  \
+        return &vector->data[index];                                                                                   \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline type* name##_push(name* vector)                                                                      \
+    {                                                                                                                  \
+        if (name##_grow(vector, 1) != SL_ERROR_NONE) return NULL;                                                      \
+        return &vector->data[vector->size++];                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline SlimError name##_append(name* vector, type element)                                                  \
+    {                                                                                                                  \
+        type* slot = name##_push(vector);                                                                              \
+        if (slot == NULL) return SLIM_ERROR;                                                                           \
+        *slot = element;                                                                                               \
+        return SL_ERROR_NONE;                                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline SlimError name##_append_many(name* vector, const type* elements, u32_t count)                        \
+    {                                                                                                                  \
+        if (count == 0) return SL_ERROR_NONE;                                                                          \
+        if (name##_grow(vector, count) != SL_ERROR_NONE) return SLIM_ERROR;                                            \
+        memcpy(vector->data + vector->size, elements, (size_t)count * sizeof(type));                                   \
+        vector->size += count;                                                                                         \
+        return SL_ERROR_NONE;                                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline u32_t name##_size(const name* vector) { return vector->size; }
@@ -2,4 +2,11 @@
 
 #include <SlimType.h>
 
-SlimError slim_file_read(const char* filename, u8_t **data, u32_t *size);
\ No newline at end of file
+SlimError slim_file_read(const char* filename, u8_t **data, u32_t *size);
+
+// Writes to a temporary file first and renames it over the destination, so readers never observe a partial file
+SlimError slim_file_write(const char* filename, const u8_t* data, u32_t size);
+
+// Maps the file read-only into memory, the mapping must be released with slim_file_unmap
+SlimError slim_file_map(const char* filename, u8_t** data, u32_t* size);
+void slim_file_unmap(u8_t* data, u32_t size);
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <SlimType.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  An asynchronous file I/O engine.  Requests are queued by slim_io_submit and handed over in batches by slim_io_flush,
+ *  so a platform with many machines waiting on files makes one system call per round instead of one per request.
+ *  Completed requests are collected with slim_io_reap on the thread that submitted them, and the engine's descriptor
+ *  turns readable whenever there is something to reap, so it can sit in an epoll set next to everything else.
+ *
+ *  The engine runs on io_uring where the kernel has it.  Elsewhere, or when asked to, a few worker threads run the
+ *  requests as blocking system calls instead.  Either way the buffers and paths of a request have to stay put until
+ *  the request has been reaped.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+typedef struct SlimIo* SlimIo;
+typedef struct SlimIoRequest SlimIoRequest;
+
+typedef enum SlimIoBackend {
+    SLIM_IO_BACKEND_AUTO = 0,
+    SLIM_IO_BACKEND_URING = 1,
+    SLIM_IO_BACKEND_THREADS = 2
+} SlimIoBackend;
+
+typedef enum SlimIoOperation {
+    SLIM_IO_OPEN = 0,
+    SLIM_IO_READ = 1,
+    SLIM_IO_WRITE = 2,
+    SLIM_IO_CLOSE = 3
+} SlimIoOperation;
+
+struct SlimIoRequest {
+    SlimIoOperation operation;
+    s32_t descriptor; // READ, WRITE and CLOSE
+    const char* path; // OPEN, relative paths resolve against the working directory
+    s32_t flags;      // OPEN, as for open(2)
+    u32_t mode;       // OPEN
+    void* buffer;     // READ and WRITE
+    u32_t size;       // READ and WRITE, in bytes
+    u64_t offset;     // READ and WRITE, (u64_t)-1 to use and advance the file position
+
+    s64_t result;     // What the system call returned, or -errno, once the request has been reaped
+    void* user;       // Left alone by the engine
+
+    SlimIoRequest* next; // Owned by the engine while the request is in flight
+};
+
+// AUTO picks io_uring if the kernel supports it, and SLIM_IO_BACKEND=threads forces the fallback
+SlimError slim_io_create(SlimIoBackend backend, SlimIo* io);
+// Waits for every request still in flight, they are never reaped
+void slim_io_destroy(SlimIo io);
+
+SlimIoBackend slim_io_get_backend(SlimIo io);
+s32_t slim_io_get_descriptor(SlimIo io);
+u32_t slim_io_get_count_pending(SlimIo io); // Submitted and not yet reaped
+
+void slim_io_submit(SlimIo io, SlimIoRequest* request);
+SlimError slim_io_flush(SlimIo io);
+// Returns up to capacity completed requests and flushes whatever the completions made room for
+u32_t slim_io_reap(SlimIo io, SlimIoRequest** completed, u32_t capacity);
@@ -3,6 +3,8 @@
 #include <SlimLog.h>
 #include <SlimType.h>
 #include <SlimBytecode.h>
+#include <SlimConsole.h>
+#include <SlimIo.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,7 +20,6 @@
  * ------------------------------------------------------------------------------------------------------------------ */
 
 typedef struct SlimMachineState* SlimMachineState;
-typedef struct SlimMachineFlags SlimMachineFlags;
 typedef struct SlimMachineStackFrame SlimMachineStackFrame;
 typedef struct SlimMachineInstruction SlimMachineInstruction;
 struct SlimMachineInstruction {
@@ -29,19 +30,115 @@ struct SlimMachineInstruction {
 typedef enum SlimOpcode SlimOpcode;
 typedef enum SlimRuntimeCastArg SlimRuntimeCastArg;
 typedef struct SlimMachineBlock SlimMachineBlock;
+typedef struct SlimRegisterProgram* SlimRegisterProgram;
+typedef struct SlimProfile* SlimProfile;
 typedef void (*SlimMachineRoutine)(SlimMachineState machine, SlimMachineInstruction instruction);
-
+typedef void (*SlimMachineWait)(void* argument);
+
+// Every machine runs on one of several interpreters generated from the same dispatch loop.  FAST carries no
+// instrumentation at all, CHECKED verifies the machine's invariants after every instruction and traps on the first one
+// broken, TRACING logs every instruction before it runs and PROFILING counts the instructions run by opcode and
+// times the functions called, see SlimProfile.h.
+#define SLIM_MACHINE_VARIANTS(X)                                                                                       \
+    X(FAST, fast)                                                                                                      \
+    X(CHECKED, checked)                                                                                                \
+    X(TRACING, tracing)                                                                                                \
+    X(PROFILING, profiling)
+
+typedef enum SlimMachineVariant {
+#define ___SLIM_MACHINE_VARIANT_ENUM(variant, name) SLIM_MACHINE_VARIANT_##variant,
+    SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_ENUM)
+#undef ___SLIM_MACHINE_VARIANT_ENUM
+    SLIM_MACHINE_VARIANT_COUNT
+} SlimMachineVariant;
+
+// Traces when there is a log to trace to and runs FAST otherwise
 SlimMachineState slim_machine_create(SlimLogContext* log_context);
+SlimMachineState slim_machine_create_variant(SlimLogContext* log_context, SlimMachineVariant variant);
+SlimMachineVariant slim_machine_get_variant(SlimMachineState machine);
+// Looks a variant up by its lower case name, as SLIM_INTERPRETER gives it to the platform
+SlimError slim_machine_variant_parse(const char* name, SlimMachineVariant* variant);
 void slim_machine_reset(SlimMachineState machine);
 void slim_machine_destroy(SlimMachineState machine);
 
+// A machine runs until it traps.  Whatever stops it, an error, HALT, CALLN, a native parking it or running out of
+// fuel, leaves the dispatch loop through the same out-of-line path, which records why and where.  The trap is cleared
+// when the machine is run again, so the loop itself never touches it.
+typedef enum SlimMachineTrapKind {
+    SLIM_MACHINE_TRAP_NONE = 0,
+    SLIM_MACHINE_TRAP_ERROR,
+    SLIM_MACHINE_TRAP_HALT,
+    SLIM_MACHINE_TRAP_INTERRUPT, // CALLN, the index of the native is on top of the operand stack
+    SLIM_MACHINE_TRAP_PARK,      // raised by a native while the platform handles the interrupt
+    SLIM_MACHINE_TRAP_YIELD
+} SlimMachineTrapKind;
+
+typedef struct SlimMachineTrap {
+    SlimMachineTrapKind kind;
+    SlimError error;           // ERROR only
+    u32_t instruction_pointer; // of the instruction that trapped
+    u8_t opcode;               // of the instruction that trapped, a register opcode in register mode
+} SlimMachineTrap;
+
+void slim_machine_run(SlimMachineState machine, SlimBytecodeTable bytecode_table);
+void slim_machine_register_run(SlimMachineState machine, SlimRegisterProgram program);
+// Executes a single instruction, the trap is NONE afterwards unless it trapped
 void slim_machine_step(SlimMachineState machine, SlimBytecodeTable bytecode_table);
+void slim_machine_register_step(SlimMachineState machine, SlimRegisterProgram program);
 void slim_machine_load(SlimMachineState machine, u8_t* data, u32_t size);
 
+void slim_machine_get_trap(SlimMachineState machine, SlimMachineTrap* trap);
+// The mnemonic of an opcode, NULL for bytes that are no opcode
+const char* slim_machine_opcode_name(u8_t opcode);
+// How often each opcode has run on a PROFILING machine, 256 counters indexed by opcode, NULL for other variants.  In
+// register mode the counters are indexed by register opcode.
+const u64_t* slim_machine_get_opcode_counts(SlimMachineState machine);
+// The profile of a PROFILING machine, owned by the machine, NULL for other variants.  slim_machine_enter starts a new
+// root frame, so the functions a machine enters that way all appear at the top of its calling context tree.
+SlimProfile slim_machine_get_profile(SlimMachineState machine);
+// How many instructions the machine has run since it was created or reset, on every variant.  The count is kept in a
+// register while the machine runs, so it is only up to date between runs.
+u64_t slim_machine_get_retired(SlimMachineState machine);
 u8_t slim_machine_flag_get_error(SlimMachineState machine);
 u8_t slim_machine_flag_get_interrupt(SlimMachineState machine);
 u8_t slim_machine_flag_get_halt(SlimMachineState machine);
-
+u8_t slim_machine_flag_get_park(SlimMachineState machine);
+u8_t slim_machine_flag_get_yield(SlimMachineState machine);
+
+// Fuel bounds how long a machine runs before it yields.  It is charged at backward jumps, by the number of
+// instructions the jump repeats, and by one at every call, so straight-line code runs free.  Once the fuel is gone the
+// machine traps with YIELD after the charging instruction has finished, and the machine can be resumed as it is after a
+// refuel.  A budget of 0, the default, never runs dry.
+void slim_machine_set_fuel(SlimMachineState machine, u64_t budget);
+void slim_machine_refuel(SlimMachineState machine);
+s64_t slim_machine_get_fuel(SlimMachineState machine);
+
+// A native that cannot finish yet parks the machine instead of blocking the host.  The machine keeps its state and the
+// platform runs its other machines until the reason for parking is gone.  With retry set the CALLN is rewound and runs
+// the native again, so the native must leave the operand stack as it found it.  Otherwise the native counts as done,
+// and its results are either already on the stack or pushed by whatever wakes the machine.
+typedef struct SlimMachineParking {
+    u8_t retry;
+    SlimMachineWait wait;   // blocks the host until the machine is worth running again, NULL for none
+    void* argument;
+    s32_t descriptor;       // file descriptor the platform watches, -1 for none
+    u32_t events;           // epoll events the descriptor is watched for
+    u64_t deadline;         // CLOCK_MONOTONIC nanoseconds the machine sleeps until, 0 for none
+    SlimIoRequest* request; // file I/O the platform submits, its result is pushed once it completes, NULL for none
+} SlimMachineParking;
+
+void slim_machine_park(SlimMachineState machine, SlimMachineParking parking);
+void slim_machine_get_parking(SlimMachineState machine, SlimMachineParking* parking);
+
+// Native access to length words of heap memory from address, writable also checks the machine may store there.  The
+// pointer stays valid until the machine is destroyed.
+SlimError slim_machine_memory(SlimMachineState machine, u64_t address, u64_t length, u8_t writable, u64_t** words);
+// The machine's console output buffer, flushed when the machine is destroyed
+SlimError slim_machine_console(SlimMachineState machine, SlimConsoleBuffer* console);
+// Resolves a handle pushed by LOADS, the string lives as long as the bytecode table
+SlimError slim_machine_lookup_string(SlimMachineState machine, u64_t handle, const char** string);
+
+SlimError slim_machine_enter(SlimMachineState machine, u32_t address, u32_t local_count);
 SlimError slim_machine_push(SlimMachineState machine, u64_t value);
 SlimError slim_machine_pop(SlimMachineState machine, u64_t* value);
 
@@ -54,46 +151,9 @@ enum SlimRuntimeCastArg {
 };
 
 enum SlimOpcode {
-    // clang-format off
-    SL_OPCODE_NOOP      = 0x00,     // No operation                                             NOOP                                     
-    SL_OPCODE_HALT      = 0x01,     // Halt the machine                                         HALT 
-
-    SL_OPCODE_LOADI     = 0x10,     // Load onto stack using Immediate Mode                     LOADI VALUE
-    SL_OPCODE_LOADR     = 0x11,     // Load onto stack using Register Mode                      LOADR REG
-    SL_OPCODE_LOADM     = 0x12,     // Load onto stack using Memory Mode                        LOADM ADDR FIELD_OFFSET
-    SL_OPCODE_DROP      = 0x13,     // Drop the top of the stack                                DROP
-    SL_OPCODE_STORER    = 0x14,     // Store the 2nd of the stack in the register from 1st      STORER [0] [1]
-    SL_OPCODE_STOREM    = 0x15,     // Store the 2nd of the stack in the address from 1st       STOREM [0] [1] FIELD_OFFSET
-
-    SL_OPCODE_DUP       = 0x20,     // Duplicate the top of the stack                           DUP
-    SL_OPCODE_SWAP      = 0x21,     // Swap the top two values on the stack                     SWAP
-    SL_OPCODE_ROT       = 0x22,     // Rotate the top three values on the stack                 ROT3
-
-    SL_OPCODE_ADD       = 0x30,     // Add the top two values on the stack as integers          ADD
-    SL_OPCODE_SUB       = 0x31,     // Subtract the top two values on the stack as integers     SUBI
-    SL_OPCODE_MUL       = 0x32,     // Multiply the top two values on the stack as integers     MULI
-    SL_OPCODE_DIV       = 0x33,     // Divide the top two values on the stack as integers       DIVI
-    SL_OPCODE_MOD       = 0x34,     // Modulo the top two values on the stack as integers       MODI
-    
-    SL_OPCODE_ADDF      = 0x35,     // Add the top two values on the stack as floats            ADDF
-    SL_OPCODE_SUBF      = 0x36,     // Subtract the top two values on the stack as floats       SUBF
-    SL_OPCODE_MULF      = 0x37,     // Multiply the top two values on the stack as floats       MULF
-    SL_OPCODE_DIVF      = 0x38,     // Divide the top two values on the stack as floats         DIVF
-    SL_OPCODE_MODF      = 0x39,     // Modulo the top two values on the stack as floats         MODF
-
-    SL_OPCODE_ALLOC     = 0x40,     // Allocate memory, return address to top of stack          ALLOC SIZE
-    SL_OPCODE_FREE      = 0x41,     // Free memory at address on top of stack                   FREE 
-
-    SL_OPCODE_JMP       = 0x50,     // Jump to specified address                                JMP ADDR
-    SL_OPCODE_JNE       = 0x51,     // Jump to specified address if stack top not equal to zero JNE ADDR
-    SL_OPCODE_JE        = 0x52,     // Jump to specified address if stack top equal to zero     JE ADDR
-
-    SL_OPCODE_CALL      = 0x60,     // Call a function at the address from the top of stack     CALL 
-    SL_OPCODE_RET       = 0x61,     // Return from a function                                   RET
-    SL_OPCODE_CALLN     = 0x62,     // Call a native function from the native function table    CALLN NATIVE_FUNCTION_INDEX
-
-    SL_OPCODE_CAST      = 0x70,     // Cast the top of the stack to the specified type          CAST TO FROM (SEE SLIM_RUNTIME_TYPE_*)
-    // clang-format on
+#define SLIM_OPCODE(name, value, routine, operand) SL_OPCODE_##name = value,
+#include <SlimOpcodeTable.h>
+#undef SLIM_OPCODE
 };
 
 /** --------------------------------------------------------------------------------------------------------------------
@@ -106,7 +166,7 @@ SlimMachineInstruction ___slim_machine_fetch(SlimMachineState machine, SlimBytec
 SlimMachineRoutine ___slim_machine_decode(SlimMachineState machine, SlimMachineInstruction instruction);
 void ___slim_machine_execute(SlimMachineState machine, SlimMachineRoutine routine, SlimMachineInstruction instruction);
 
-void ___slim_machine_flag_error_raise(SlimMachineState machine);
+void ___slim_machine_trap(SlimMachineState machine, SlimMachineTrapKind kind, SlimError error);
 SlimError ___slim_machine_bytecode_jump(SlimMachineState machine, u32_t address);
 SlimError ___slim_machine_operand_push(SlimMachineState machine, u64_t value);
 SlimError ___slim_machine_operand_pop(SlimMachineState machine, u64_t* value);
@@ -116,43 +176,38 @@ SlimError ___slim_machine_memory_read(SlimMachineState machine, u32_t address, u
 SlimError ___slim_machine_memory_write(SlimMachineState machine, u32_t address, u32_t offset);
 SlimError ___slim_machine_memory_alloc(SlimMachineState machine, u32_t size, u32_t* address);
 SlimError ___slim_machine_memory_free(SlimMachineState machine, u32_t address);
-SlimError ___slim_machine_function_call(SlimMachineState machine, u32_t address);
+SlimError ___slim_machine_memory_range(u64_t address, u64_t length);
+SlimError ___slim_machine_memory_writable(SlimMachineState machine, u64_t address, u64_t length);
+SlimError ___slim_machine_memory_copy(SlimMachineState machine, u64_t destination, u64_t source, u64_t length);
+SlimError ___slim_machine_memory_fill(SlimMachineState machine, u64_t destination, u64_t value, u64_t length);
+SlimError ___slim_machine_memory_compare(SlimMachineState machine, u64_t a, u64_t b, u64_t length, s64_t* result);
+SlimError ___slim_machine_memory_vector(SlimMachineState machine, u8_t opcode);
+
+// Vector opcodes run on the best kernels the CPU supports, picked on first use.  Selecting them by name ("scalar",
+// "sse2" or "avx2") fails if the CPU cannot run them.
+SlimError ___slim_machine_vector_select(const char* name);
+const char* ___slim_machine_vector_selected();
+
+SlimError ___slim_machine_local_load(SlimMachineState machine, u32_t slot);
+SlimError ___slim_machine_local_store(SlimMachineState machine, u32_t slot);
+SlimError ___slim_machine_local_decrement(SlimMachineState machine, u32_t slot, u64_t* value);
+SlimError ___slim_machine_function_call(
+    SlimMachineState machine, u32_t address, u32_t local_count, u32_t argument_count);
+SlimError ___slim_machine_function_tailcall(
+    SlimMachineState machine, u32_t address, u32_t local_count, u32_t argument_count);
 SlimError ___slim_machine_function_ret(SlimMachineState machine);
+SlimError ___slim_machine_parallel_for(
+    SlimMachineState machine, u32_t address, u32_t local_count, u64_t output, u64_t begin, u64_t end);
 
 /** --------------------------------------------------------------------------------------------------------------------
  * @brief A routine is a function that is called when a specific opcode is encountered.
  * Defined in SlimRoutine.c
  * ------------------------------------------------------------------------------------------------------------------ */
-void slim_machine_routine_nop(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_halt(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_loadi(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_loadr(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_loadm(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_drop(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_storer(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_storem(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_dup(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_swap(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_rot(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_add(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_sub(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_mul(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_div(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_mod(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_addf(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_subf(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_mulf(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_divf(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_modf(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_alloc(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_free(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_jmp(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_jne(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_je(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_call(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_ret(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_calln(SlimMachineState machine, SlimMachineInstruction instruction);
-void slim_machine_routine_cast(SlimMachineState machine, SlimMachineInstruction instruction);
+// Opcodes sharing a routine declare it more than once, which C allows
+#define SLIM_OPCODE(name, value, routine, operand)                                                                     \
+    void slim_machine_routine_##routine(SlimMachineState machine, SlimMachineInstruction instruction);
+#include <SlimOpcodeTable.h>
+#undef SLIM_OPCODE
 
 // Block and Memory Management -----------------------------------------------------------------------------------------
 
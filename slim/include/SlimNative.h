@@ -12,13 +12,31 @@
  *  by the user using the SlimNative interface.  This means that
  *  during SlimVM runtime, SlimNative functions will interact with
  *  the SlimVM through the SlimNative interface.
+ *
+ *  The table is shared by every platform in the process.  Each platform opens it with slim_native_init, which registers
+ *  the built-in natives the first time, and the last slim_native_close empties it again along with the channels.
+ *
+ *  Built-in natives, arguments listed in the order they are pushed:
+ *  channel_create      KIND CAPACITY -> HANDLE     KIND is 0 for SPSC and 1 for MPMC
+ *  channel_send        HANDLE VALUE ->             parks the machine while the channel is full
+ *  channel_recv        HANDLE -> VALUE             parks the machine while the channel is empty
+ *  channel_try_recv    HANDLE -> VALUE OK          OK is 1 if a value was received, VALUE is 0 otherwise
+ *  sleep               MILLISECONDS ->             parks the machine until the time has passed
+ *  file_open           PATH MODE -> DESCRIPTOR     PATH is a string handle, MODE is 0 read, 1 write, 2 read-write, 3
+ *                                                  append, everything but read creates the file
+ *  file_read           DESCRIPTOR ADDRESS SIZE -> COUNT   reads SIZE bytes into heap words from ADDRESS, 8 per word
+ *  file_write          DESCRIPTOR ADDRESS SIZE -> COUNT   writes SIZE bytes from heap words from ADDRESS
+ *  file_close          DESCRIPTOR -> RESULT
+ *
+ *  stdputch            CHARACTER ->
+ *  stdputstr           ADDRESS LENGTH ->           writes LENGTH heap words from ADDRESS, one character per word
+ *  stdputbuf           ADDRESS SIZE ->             writes SIZE bytes packed in heap words from ADDRESS, 8 per word
+ *  stdflush            ->                          pushes the machine's console output out now
+ *  stdgetch            -> CHARACTER                parks the machine until input arrives, -1 at the end of the input
+ *
+ *  The file natives park their machine until the platform's I/O engine completes them, and push -errno on failure.
+ *  The std natives go through the machine's console buffer, see SlimConsole.h.
  */
 
-typedef SlimError (*SlimNativeFunction)();
-
-// The implication... slim native is static, and slim machine state isn't technically but it in virtue of
-// slim platform... some smelly shit going on here with *implicit* globalization of SlimMachineState
-SlimError slim_native_init(SlimMachineState state);
-
-// Statically close the submodule... (little whack don't like but hey it's simpleq)
-void slim_native_close();
\ No newline at end of file
+SlimError slim_native_init();
+void slim_native_close();
@@ -1,11 +1,25 @@
 #pragma once
 
+#include <SlimMachine.h>
 #include <SlimType.h>
 
-typedef SlimError (*SlimNativeFunction)();
+// A native takes its arguments from the calling machine's operand stack with slim_machine_pop and leaves its results
+// there with slim_machine_push.  Returning an error stops the platform.
+typedef SlimError (*SlimNativeFunction)(SlimMachineState machine);
 
-// // TODO: Implement these
-// SlimError slim_native_lookup(const char* identifier, SlimNativeFunction* function) { return SL_ERROR_NONE; }
-// SlimError slim_native_register(const char* identifier, SlimNativeFunction function) { return SL_ERROR_NONE; }
-// SlimError slim_native_push(u64_t operand) { return SL_ERROR_NONE; }
-// SlimError slim_native_pop(u64_t* operand) { return SL_ERROR_NONE; }
\ No newline at end of file
+// Natives are bound by the name the image declares them with.  Registering a name again replaces the function.
+SlimError slim_native_register(const char* identifier, SlimNativeFunction function);
+SlimError slim_native_lookup(const char* identifier, SlimNativeFunction* function);
+
+// Pending natives.  A native that would block parks its machine through one of these and returns SL_ERROR_NONE, the
+// platform keeps running its other machines meanwhile.  The retry forms run the native again once the descriptor is
+// ready or wait has returned, so the native has to put back whatever it popped.
+void slim_native_retry_when_ready(SlimMachineState machine, s32_t descriptor, u32_t events);
+void slim_native_retry_after(SlimMachineState machine, SlimMachineWait wait, void* argument);
+void slim_native_resume_at(SlimMachineState machine, u64_t deadline);
+// Hands a malloc'd request to the platform's I/O engine.  Once it completes its result is pushed, as the native's
+// result, and the request is freed.
+void slim_native_await_io(SlimMachineState machine, SlimIoRequest* request);
+
+// CLOCK_MONOTONIC in nanoseconds, the clock deadlines are measured on
+u64_t slim_native_clock();
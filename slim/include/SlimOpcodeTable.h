@@ -0,0 +1,96 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// The one description of the instruction set.  Every place that needs to know about each opcode defines SLIM_OPCODE,
+// includes this table and undefines it again, so the opcode enum, the operand formats of the loader, the routine
+// prototypes and the dispatch tables of the machine cannot drift apart.  It has no include guard for that reason.  The
+// bytecode cache keys its entries on it, and the assembler's SlapOpcode.py is generated from it.
+//
+//     SLIM_OPCODE(name, value, routine, operand)
+//
+// name     SL_OPCODE_<name> and the mnemonic in traces and profiles
+// value    the byte in the image
+// routine  slim_machine_routine_<routine> executes it, several opcodes may share one
+// operand  SLIM_BYTECODE_OPERAND_<operand> is the encoding of its operand
+// ---------------------------------------------------------------------------------------------------------------------
+#ifndef SLIM_OPCODE
+#error "SLIM_OPCODE must be defined before including SlimOpcodeTable.h"
+#endif
+
+// clang-format off
+SLIM_OPCODE(NOOP,     0x00, nop,      NONE)   // No operation                                             NOOP
+SLIM_OPCODE(HALT,     0x01, halt,     U8)     // Halt the machine                                         HALT
+
+SLIM_OPCODE(LOADI,    0x10, loadi,    VARINT) // Load onto stack using Immediate Mode                     LOADI VALUE
+SLIM_OPCODE(LOADR,    0x11, loadr,    U8)     // Load onto stack using Register Mode                      LOADR REG
+SLIM_OPCODE(LOADM,    0x12, loadm,    U16)    // Load onto stack using Memory Mode                        LOADM ADDR FIELD_OFFSET
+SLIM_OPCODE(DROP,     0x13, drop,     NONE)   // Drop the top of the stack                                DROP
+SLIM_OPCODE(STORER,   0x14, storer,   U8)     // Store the 2nd of the stack in the register from 1st      STORER [0] [1]
+SLIM_OPCODE(STOREM,   0x15, storem,   U16)    // Store the 2nd of the stack in the address from 1st       STOREM [0] [1] FIELD_OFFSET
+SLIM_OPCODE(LOADK,    0x16, loadk,    VARINT) // Load onto stack from the constant table                  LOADK CONSTANT_INDEX
+SLIM_OPCODE(LOADS,    0x17, loads,    VARINT) // Load the handle of an interned string onto the stack     LOADS STRING_INDEX
+SLIM_OPCODE(LOADL,    0x18, loadl,    U16)    // Load onto stack from a slot of the current frame         LOADL SLOT
+SLIM_OPCODE(STOREL,   0x19, storel,   U16)    // Store the top of the stack in a slot of the current frame STOREL SLOT
+
+SLIM_OPCODE(DUP,      0x20, dup,      NONE)   // Duplicate the top of the stack                           DUP
+SLIM_OPCODE(SWAP,     0x21, swap,     NONE)   // Swap the top two values on the stack                     SWAP
+SLIM_OPCODE(ROT,      0x22, rot,      NONE)   // Rotate the top three values on the stack                 ROT3
+
+SLIM_OPCODE(ADD,      0x30, add,      NONE)   // Add the top two values on the stack as integers          ADD
+SLIM_OPCODE(SUB,      0x31, sub,      NONE)   // Subtract the top two values on the stack as integers     SUBI
+SLIM_OPCODE(MUL,      0x32, mul,      NONE)   // Multiply the top two values on the stack as integers     MULI
+SLIM_OPCODE(DIV,      0x33, div,      NONE)   // Divide the top two values on the stack as integers       DIVI
+SLIM_OPCODE(MOD,      0x34, mod,      NONE)   // Modulo the top two values on the stack as integers       MODI
+
+SLIM_OPCODE(ADDF,     0x35, addf,     NONE)   // Add the top two values on the stack as floats            ADDF
+SLIM_OPCODE(SUBF,     0x36, subf,     NONE)   // Subtract the top two values on the stack as floats       SUBF
+SLIM_OPCODE(MULF,     0x37, mulf,     NONE)   // Multiply the top two values on the stack as floats       MULF
+SLIM_OPCODE(DIVF,     0x38, divf,     NONE)   // Divide the top two values on the stack as floats         DIVF
+SLIM_OPCODE(MODF,     0x39, modf,     NONE)   // Modulo the top two values on the stack as floats         MODF
+
+SLIM_OPCODE(ALLOC,    0x40, alloc,    VARINT) // Allocate memory, return address to top of stack          ALLOC SIZE
+SLIM_OPCODE(FREE,     0x41, free,     NONE)   // Free memory at address on top of stack                   FREE
+SLIM_OPCODE(MEMCOPY,  0x42, memcopy,  NONE)   // Pop length, src, dst and copy words, ranges may overlap  MEMCOPY
+SLIM_OPCODE(MEMFILL,  0x43, memfill,  NONE)   // Pop length, value, dst and set every word to value       MEMFILL
+SLIM_OPCODE(MEMCMP,   0x44, memcmp,   NONE)   // Pop length, b, a and push -1, 0 or 1 by unsigned words   MEMCMP
+
+SLIM_OPCODE(JMP,      0x50, jmp,      U32)    // Jump to specified address                                JMP ADDR
+SLIM_OPCODE(JNE,      0x51, jne,      U32)    // Jump to specified address if stack top not equal to zero JNE ADDR
+SLIM_OPCODE(JE,       0x52, je,       U32)    // Jump to specified address if stack top equal to zero     JE ADDR
+SLIM_OPCODE(JLT,      0x53, jlt,      U32)    // Pop b then a, jump if a < b as signed integers           JLT ADDR
+SLIM_OPCODE(JLE,      0x54, jle,      U32)    // Pop b then a, jump if a <= b as signed integers          JLE ADDR
+SLIM_OPCODE(JGT,      0x55, jgt,      U32)    // Pop b then a, jump if a > b as signed integers           JGT ADDR
+SLIM_OPCODE(JGE,      0x56, jge,      U32)    // Pop b then a, jump if a >= b as signed integers          JGE ADDR
+SLIM_OPCODE(JLTU,     0x57, jltu,     U32)    // Pop b then a, jump if a < b as unsigned integers         JLTU ADDR
+SLIM_OPCODE(JLEU,     0x58, jleu,     U32)    // Pop b then a, jump if a <= b as unsigned integers        JLEU ADDR
+SLIM_OPCODE(JGTU,     0x59, jgtu,     U32)    // Pop b then a, jump if a > b as unsigned integers         JGTU ADDR
+SLIM_OPCODE(JGEU,     0x5A, jgeu,     U32)    // Pop b then a, jump if a >= b as unsigned integers        JGEU ADDR
+SLIM_OPCODE(JLTF,     0x5B, jltf,     U32)    // Pop b then a, jump if a < b as floats                    JLTF ADDR
+SLIM_OPCODE(JLEF,     0x5C, jlef,     U32)    // Pop b then a, jump if a <= b as floats                   JLEF ADDR
+SLIM_OPCODE(JGTF,     0x5D, jgtf,     U32)    // Pop b then a, jump if a > b as floats                    JGTF ADDR
+SLIM_OPCODE(JGEF,     0x5E, jgef,     U32)    // Pop b then a, jump if a >= b as floats                   JGEF ADDR
+SLIM_OPCODE(DJNZ,     0x5F, djnz,     VARINT) // Decrement a local, jump if it did not reach zero         DJNZ SLOT ADDR
+
+SLIM_OPCODE(CALL,     0x60, call,     U32)    // Call a function at the address from the top of stack     CALL
+SLIM_OPCODE(RET,      0x61, ret,      NONE)   // Return from a function, keeping the top of stack         RET
+SLIM_OPCODE(CALLN,    0x62, calln,    U16)    // Call a native function from the native function table    CALLN NATIVE_FUNCTION_INDEX
+SLIM_OPCODE(TAILCALL, 0x63, tailcall, U32)    // Call a function in place of the current one              TAILCALL ADDR
+SLIM_OPCODE(PARFOR,   0x64, parfor,   U32)    // Pop end, begin, output and run a function over chunks    PARFOR ADDR
+
+SLIM_OPCODE(CAST,     0x70, cast,     U16)    // Cast the top of the stack to the specified type          CAST FROM:TO (SEE SLIM_RUNTIME_CAST_ARG_*)
+
+SLIM_OPCODE(VADD,     0x80, vector,   NONE)   // Pop length, b, a, dst and store a + b into dst as integers VADD
+SLIM_OPCODE(VSUB,     0x81, vector,   NONE)   // Pop length, b, a, dst and store a - b into dst as integers VSUB
+SLIM_OPCODE(VMUL,     0x82, vector,   NONE)   // Pop length, b, a, dst and store a * b into dst as integers VMUL
+SLIM_OPCODE(VFMA,     0x83, vector,   NONE)   // Pop length, b, a, dst and add a * b into dst as integers VFMA
+SLIM_OPCODE(VDOT,     0x84, vector,   NONE)   // Pop length, b, a and push the dot product as integers    VDOT
+SLIM_OPCODE(VSUM,     0x85, vector,   NONE)   // Pop length, a and push the sum as integers               VSUM
+SLIM_OPCODE(VMIN,     0x86, vector,   NONE)   // Pop length, a and push the minimum as signed integers    VMIN
+SLIM_OPCODE(VMAX,     0x87, vector,   NONE)   // Pop length, a and push the maximum as signed integers    VMAX
+SLIM_OPCODE(VADDF,    0x88, vector,   NONE)   // Pop length, b, a, dst and store a + b into dst as floats VADDF
+SLIM_OPCODE(VSUBF,    0x89, vector,   NONE)   // Pop length, b, a, dst and store a - b into dst as floats VSUBF
+SLIM_OPCODE(VMULF,    0x8A, vector,   NONE)   // Pop length, b, a, dst and store a * b into dst as floats VMULF
+SLIM_OPCODE(VFMAF,    0x8B, vector,   NONE)   // Pop length, b, a, dst and fuse a * b + dst into dst      VFMAF
+SLIM_OPCODE(VDOTF,    0x8C, vector,   NONE)   // Pop length, b, a and push the dot product as floats      VDOTF
+SLIM_OPCODE(VSUMF,    0x8D, vector,   NONE)   // Pop length, a and push the sum as floats                 VSUMF
+SLIM_OPCODE(VMINF,    0x8E, vector,   NONE)   // Pop length, a and push the minimum as floats             VMINF
+SLIM_OPCODE(VMAXF,    0x8F, vector,   NONE)   // Pop length, a and push the maximum as floats             VMAXF
+// clang-format on
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SlimType.h>
+
+#include <stdio.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  Hardware performance counters around the dispatch loop, read through perf_event_open.  The counters are opened for
+ *  the calling thread in three groups, each scheduled onto the PMU as a whole: the core events, the cache misses, and
+ *  the task clock, which is a software event and works wherever perf_event_open does at all.  They only count in user
+ *  space and only while started, so the platform starts them around every run of a machine.
+ *
+ *  Counters the kernel or the hypervisor does not offer, as is common in containers and VMs, are left out and reported
+ *  as unavailable.  When the PMU has to multiplex the groups, values are scaled by the share of time they counted.
+ *  Work done by PARFOR on the pool threads is not counted.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+typedef enum SlimPerfCounter {
+    SLIM_PERF_TASK_CLOCK,
+    SLIM_PERF_CYCLES,
+    SLIM_PERF_INSTRUCTIONS,
+    SLIM_PERF_BRANCHES,
+    SLIM_PERF_BRANCH_MISSES,
+    SLIM_PERF_L1D_MISSES,
+    SLIM_PERF_LLC_MISSES,
+    SLIM_PERF_COUNTER_COUNT
+} SlimPerfCounter;
+
+typedef struct SlimPerf* SlimPerf;
+
+// Fails when not a single counter can be opened
+SlimError slim_perf_create(SlimPerf* perf);
+void slim_perf_destroy(SlimPerf perf);
+
+const char* slim_perf_counter_name(SlimPerfCounter counter);
+u8_t slim_perf_get_available(SlimPerf perf, SlimPerfCounter counter);
+// The scaled count so far, 0 for counters that are not available
+u64_t slim_perf_get_value(SlimPerf perf, SlimPerfCounter counter);
+
+void slim_perf_start(SlimPerf perf);
+void slim_perf_stop(SlimPerf perf);
+
+// Lists every counter with its total and its count per VM instruction, followed by the ratios worth tuning for
+SlimError slim_perf_write_report(SlimPerf perf, u64_t vm_instructions, FILE* file);
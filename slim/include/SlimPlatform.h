@@ -5,8 +5,21 @@
 // ---------------------------------------------------------------------------------------------------------------------
 // The Slim Platform is the interface between the Slim API and the host platform. It manages the internal components
 // of the Slim Runtime such as the virtual machine, logging facilities, native interface, etc.
+//
+// A platform runs any number of machines over the same image on the calling thread.  A machine runs until it halts,
+// a native parks it or it has used up its fuel, and the next ready machine takes over.  Parked machines wait in an
+// epoll reactor for their file descriptor or deadline, so thousands of them can be waiting on I/O without a thread
+// each.  A descriptor can only be waited on by one machine at a time.  File natives go through the I/O engine instead,
+// which submits the requests of all machines parked on it in one batch.
+//
+// With SLIM_PROFILE=<prefix> every machine runs on the PROFILING interpreter and writes its profile to
+// <prefix>-<task>.txt and <prefix>-<task>.folded when it halts, the machines being numbered in the order they were
+// spawned.  SLIM_PERF=<path> counts hardware events around every run of a machine, see SlimPerf.h, and reports them to
+// path when the platform is destroyed, - reporting to stderr.  SLIM_TRACE=<path> exports a timeline of machine runs,
+// natives, loads and halts to path at exit, in builds with SLIM_TRACE_EVENTS, see SlimTrace.h.
 // ---------------------------------------------------------------------------------------------------------------------
 typedef struct SlimPlatform* SlimPlatform;
+typedef struct SlimPlatformTask SlimPlatformTask;
 
 typedef enum SlimPlatformReturnCode {
     SLIM_PLATFORM_EXIT,
@@ -15,9 +28,24 @@ typedef enum SlimPlatformReturnCode {
 } SlimPlatformReturnCode;
 
 SlimPlatform slim_platform_create(int argc, char** argv);
+// Starts another machine at the entry of the image, next to the one slim_platform_create starts
+SlimError slim_platform_spawn(SlimPlatform platform);
+// The fuel machines spawned from now on get, SLIM_FUEL sets it for the first.  0 lets a machine run until it parks.
+void slim_platform_set_fuel(SlimPlatform platform, u64_t budget);
 SlimPlatformReturnCode slim_platform_update(SlimPlatform platform);
 void slim_platform_destroy(SlimPlatform platform);
 // ---------------------------------------------------------------------------------------------------------------------
 SlimPlatformReturnCode ___slim_platform_handle_flags(SlimPlatform platform);
 SlimPlatformReturnCode ___slim_platform_handle_interrupts(SlimPlatform platform);
+SlimError ___slim_platform_bind_natives(SlimPlatform platform);
+void ___slim_platform_write_profile(SlimPlatform platform, SlimPlatformTask* task);
+void ___slim_platform_write_perf(SlimPlatform platform);
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_platform_ready(SlimPlatform platform, SlimPlatformTask* task);
+void ___slim_platform_retry_waiting(SlimPlatform platform);
+SlimError ___slim_platform_park(SlimPlatform platform, SlimPlatformTask* task);
+SlimError ___slim_platform_poll(SlimPlatform platform, s32_t timeout);
+SlimError ___slim_platform_reap_io(SlimPlatform platform);
+u8_t ___slim_platform_reactor_busy(SlimPlatform platform);
+SlimPlatformReturnCode ___slim_platform_schedule(SlimPlatform platform);
 // ---------------------------------------------------------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SlimBytecode.h>
+#include <SlimRegister.h>
+#include <SlimType.h>
+
+#include <stdio.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  The profile a PROFILING machine keeps of itself.  Every opcode the machine runs is counted exactly, and time is
+ *  attributed to functions through a calling context tree that follows the machine's call stack.  The clock only runs
+ *  while the machine does, so time spent in natives, parked or waiting for its turn is left out.  It counts TSC cycles
+ *  on x86-64 and nanoseconds elsewhere.
+ *
+ *  Functions are identified by the address of their first instruction.  The report names them after the exported
+ *  symbol of their section where there is one.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+#define SLIM_PROFILE_DEPTH 128 // Deeper frames are counted towards the deepest one that is tracked
+
+typedef struct SlimProfile* SlimProfile;
+
+SlimError slim_profile_create(SlimProfile* profile);
+void slim_profile_destroy(SlimProfile profile);
+
+// 256 counters indexed by opcode, the machine increments them itself
+u64_t* slim_profile_get_opcode_counts(SlimProfile profile);
+const char* slim_profile_get_unit(); // "cycles" or "ns"
+
+// The clock is stopped between runs of the machine
+void slim_profile_resume(SlimProfile profile);
+void slim_profile_pause(SlimProfile profile);
+
+// The machine entered the function at address, returned from the current one, or replaced it by a tail call
+void slim_profile_enter(SlimProfile profile, u32_t address);
+void slim_profile_leave(SlimProfile profile);
+void slim_profile_replace(SlimProfile profile, u32_t address);
+// Leaves every function still open, as when the machine halts or starts over
+void slim_profile_close(SlimProfile profile);
+
+// Both close the functions still open first.  The report lists the functions by exclusive time and the opcodes by
+// count, the folded stacks hold one line per calling context with the exclusive time spent in it, as flamegraph.pl and
+// speedscope read them.  program is the register program the machine ran, NULL in stack mode.
+SlimError slim_profile_write_report(
+    SlimProfile profile, SlimBytecodeTable table, SlimRegisterProgram program, FILE* file);
+SlimError slim_profile_write_folded(
+    SlimProfile profile, SlimBytecodeTable table, SlimRegisterProgram program, FILE* file);
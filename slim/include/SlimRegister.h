@@ -0,0 +1,86 @@
+#pragma once
+
+#include <SlimBytecode.h>
+#include <SlimMachine.h>
+#include <SlimType.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  The register module translates stack bytecode into three-address register code, the machine's second execution
+ *  mode.  The register file of a frame is the frame's own slice of the operand stack: register r is the slot r places
+ *  above the base pointer, so locals are registers 0 to local_count - 1 and the value the stack code would have left at
+ *  depth d lives in register d.  Registers are signed, negative ones reach the caller's values below the frame.
+ *
+ *  The translator keeps a virtual stack while it walks the code.  Immediates, constants and copies of locals are only
+ *  recorded, and are folded straight into the instruction that consumes them, so most pushes and pops never become an
+ *  instruction.  At jump targets, calls, returns and halts the virtual stack is flushed back to its canonical registers
+ *  and the stack pointer is synchronized, so frames, natives and the platform see exactly what the stack mode leaves.
+ *
+ *  Translation needs a consistent stack depth at every instruction and a fixed number of results for every function.
+ *  Images that do not have them, or that use an opcode the register mode does not implement, fail to translate and are
+ *  meant to keep running in stack mode.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+// Register instructions reuse SlimMachineInstruction.  Registers are signed 16-bit and packed in pairs into arg1, the
+// destination in the low half.  arg2 carries the second source register, a 32-bit immediate, or a jump target.
+enum SlimRegisterOpcode {
+    // clang-format off
+    SL_REGISTER_OPCODE_ENTER    = 0x00,     // Check the frame has room for registers MIN to MAX        ENTER MIN:MAX
+    SL_REGISTER_OPCODE_HALT     = 0x01,     // Halt the machine with the stack at DEPTH                 HALT DEPTH CODE
+
+    SL_REGISTER_OPCODE_MOV      = 0x10,     // Copy a register                                          MOV DST:SRC
+    SL_REGISTER_OPCODE_MOVI     = 0x11,     // Load a zero-extended 32-bit immediate                    MOVI DST IMM
+    SL_REGISTER_OPCODE_MOVIH    = 0x12,     // Replace the upper half of a register                     MOVIH DST IMM
+    SL_REGISTER_OPCODE_SWAP     = 0x13,     // Swap two registers                                       SWAP A:B
+    SL_REGISTER_OPCODE_ROT      = 0x14,     // Rotate three consecutive registers like the stack ROT    ROT BASE
+
+    SL_REGISTER_OPCODE_ADD      = 0x30,     // Integer arithmetic on two registers                      ADD DST:A B
+    SL_REGISTER_OPCODE_SUB      = 0x31,     //                                                          SUB DST:A B
+    SL_REGISTER_OPCODE_MUL      = 0x32,     //                                                          MUL DST:A B
+    SL_REGISTER_OPCODE_DIV      = 0x33,     //                                                          DIV DST:A B
+    SL_REGISTER_OPCODE_MOD      = 0x34,     //                                                          MOD DST:A B
+    SL_REGISTER_OPCODE_ADDF     = 0x35,     // Float arithmetic on two registers                        ADDF DST:A B
+    SL_REGISTER_OPCODE_SUBF     = 0x36,     //                                                          SUBF DST:A B
+    SL_REGISTER_OPCODE_MULF     = 0x37,     //                                                          MULF DST:A B
+    SL_REGISTER_OPCODE_DIVF     = 0x38,     //                                                          DIVF DST:A B
+    SL_REGISTER_OPCODE_MODF     = 0x39,     //                                                          MODF DST:A B
+    SL_REGISTER_OPCODE_ADDI     = 0x3A,     // Integer arithmetic with an immediate second operand      ADDI DST:A IMM
+    SL_REGISTER_OPCODE_SUBI     = 0x3B,     //                                                          SUBI DST:A IMM
+    SL_REGISTER_OPCODE_MULI     = 0x3C,     //                                                          MULI DST:A IMM
+
+    SL_REGISTER_OPCODE_JMP      = 0x50,     // Jump to specified address                                JMP ADDR
+    SL_REGISTER_OPCODE_JNE      = 0x51,     // Jump if the register is not zero                         JNE REG ADDR
+    SL_REGISTER_OPCODE_JE       = 0x52,     // Jump if the register is zero                             JE REG ADDR
+    SL_REGISTER_OPCODE_JLT      = 0x53,     // Compare two registers and branch like the stack opcodes  JLT A:B ADDR
+    SL_REGISTER_OPCODE_JLE      = 0x54,     //                                                          JLE A:B ADDR
+    SL_REGISTER_OPCODE_JGT      = 0x55,     //                                                          JGT A:B ADDR
+    SL_REGISTER_OPCODE_JGE      = 0x56,     //                                                          JGE A:B ADDR
+    SL_REGISTER_OPCODE_JLTU     = 0x57,     //                                                          JLTU A:B ADDR
+    SL_REGISTER_OPCODE_JLEU     = 0x58,     //                                                          JLEU A:B ADDR
+    SL_REGISTER_OPCODE_JGTU     = 0x59,     //                                                          JGTU A:B ADDR
+    SL_REGISTER_OPCODE_JGEU     = 0x5A,     //                                                          JGEU A:B ADDR
+    SL_REGISTER_OPCODE_JLTF     = 0x5B,     //                                                          JLTF A:B ADDR
+    SL_REGISTER_OPCODE_JLEF     = 0x5C,     //                                                          JLEF A:B ADDR
+    SL_REGISTER_OPCODE_JGTF     = 0x5D,     //                                                          JGTF A:B ADDR
+    SL_REGISTER_OPCODE_JGEF     = 0x5E,     //                                                          JGEF A:B ADDR
+    SL_REGISTER_OPCODE_DJNZ     = 0x5F,     // Decrement a register, jump if it did not reach zero      DJNZ REG ADDR
+
+    SL_REGISTER_OPCODE_CALL     = 0x60,     // Call with the callee's locals right below DEPTH          CALL DEPTH:LOCALS ADDR
+    SL_REGISTER_OPCODE_RET      = 0x61,     // Return with the stack at DEPTH                           RET DEPTH
+    SL_REGISTER_OPCODE_CALLN    = 0x62,     // Call a native with the stack at DEPTH                    CALLN DEPTH NATIVE
+    SL_REGISTER_OPCODE_TAILCALL = 0x63,     // Tail call with the callee's locals right below DEPTH     TAILCALL DEPTH:LOCALS ADDR
+    // clang-format on
+};
+
+// Translates every instruction reachable from address 0, which runs with entry_local_count locals like
+// slim_machine_enter.  Sections are decoded on demand, so a section that fails verification fails the translation.
+SlimError slim_register_program_translate(SlimBytecodeTable table, u32_t entry_local_count,
+                                          SlimRegisterProgram* program);
+void slim_register_program_destroy(SlimRegisterProgram program);
+
+u32_t slim_register_program_get_count_instrs(SlimRegisterProgram program);
+SlimBytecodeTable slim_register_program_get_table(SlimRegisterProgram program);
+SlimError slim_register_program_lookup_instruction(SlimRegisterProgram program, u32_t address,
+                                                   SlimMachineInstruction* instruction);
+
+// Maps a stack bytecode address to the register code address of the same point, valid for reachable addresses only
+SlimError slim_register_program_map_address(SlimRegisterProgram program, u32_t address, u32_t* register_address);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SlimType.h>
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  A fixed set of host threads that run fork-join jobs.  slim_thread_pool_run hands out the task indices of a job one
+ *  at a time to the workers and to the calling thread, and returns once every task has finished, so the tasks of a job
+ *  only need to be safe against each other.  Jobs from different threads queue up behind each other.  A task must not
+ *  run a job on the pool it runs on.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+typedef struct SlimThreadPool* SlimThreadPool;
+typedef void (*SlimThreadTask)(void* argument, u32_t index);
+
+// A pool of worker_count threads besides the caller's, 0 workers runs every task on the calling thread
+SlimThreadPool slim_thread_pool_create(u32_t worker_count);
+void slim_thread_pool_destroy(SlimThreadPool pool);
+void slim_thread_pool_run(SlimThreadPool pool, u32_t task_count, SlimThreadTask task, void* argument);
+u32_t slim_thread_pool_get_count_workers(SlimThreadPool pool);
+
+// The process-wide pool, created on first use with a worker for every online core but the caller's.  SLIM_THREADS
+// overrides the total thread count, caller included.
+SlimThreadPool slim_thread_pool_shared();
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <SlimType.h>
+
+#include <stdio.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/** --------------------------------------------------------------------------------------------------------------------
+ *  A timeline of what the platform and its machines do, exported in the Chrome trace event format that Perfetto and
+ *  chrome://tracing open.  Every thread records into a ring buffer of its own, which it creates on its first event,
+ *  so recording takes no lock and costs a timestamp and four stores.  Once a ring is full the oldest events are
+ *  overwritten.
+ *
+ *  Recording is compiled in with SLIM_TRACE_EVENTS=1, the SLIM_TRACE_EVENTS CMake option.  Without it the SLIM_TRACE_*
+ *  macros expand to nothing and slim_trace_open fails.  With it, nothing is recorded until the trace is opened, which
+ *  the platform does when SLIM_TRACE names a file.
+ * ------------------------------------------------------------------------------------------------------------------ */
+
+#ifndef SLIM_TRACE_EVENTS
+#define SLIM_TRACE_EVENTS 0
+#endif
+
+#define SLIM_TRACE_BUFFER_EVENTS 65536 // per thread, a power of two
+
+typedef struct SlimTraceEvent {
+    u64_t timestamp;
+    const char* name; // Has to live until the trace is exported, in practice a string literal
+    u64_t argument;
+    u8_t phase; // 'B' begins a slice, 'E' ends it and 'i' is an instant, as in the trace event format
+} SlimTraceEvent;
+
+typedef struct SlimTraceBuffer {
+    SlimTraceEvent events[SLIM_TRACE_BUFFER_EVENTS];
+    u64_t count; // Events ever recorded, the ring holds the last SLIM_TRACE_BUFFER_EVENTS of them
+    s32_t thread;
+    struct SlimTraceBuffer* next;
+} SlimTraceBuffer;
+
+// Starts recording and exports everything recorded to path when the process exits
+SlimError slim_trace_open(const char* path);
+void slim_trace_set_enabled(u8_t enabled);
+u8_t slim_trace_get_enabled();
+// Writes the events of every thread as a JSON trace, the threads must not be recording at the same time
+SlimError slim_trace_export(FILE* file);
+
+#if SLIM_TRACE_EVENTS
+#define SLIM_TRACE_BEGIN(name, argument) ___slim_trace_record('B', name, argument)
+#define SLIM_TRACE_END(name, argument) ___slim_trace_record('E', name, argument)
+#define SLIM_TRACE_INSTANT(name, argument) ___slim_trace_record('i', name, argument)
+#else
+#define SLIM_TRACE_BEGIN(name, argument) ((void)0)
+#define SLIM_TRACE_END(name, argument) ((void)0)
+#define SLIM_TRACE_INSTANT(name, argument) ((void)0)
+#endif
+// ---------------------------------------------------------------------------------------------------------------------
+extern u8_t ___slim_trace_enabled;
+extern __thread SlimTraceBuffer* ___slim_trace_buffer;
+SlimTraceBuffer* ___slim_trace_buffer_create();
+
+static inline u64_t ___slim_trace_clock()
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64_t)now.tv_sec * 1000000000ull + (u64_t)now.tv_nsec;
+#endif
+}
+
+static inline void ___slim_trace_record(u8_t phase, const char* name, u64_t argument)
+{
+    if (!__atomic_load_n(&___slim_trace_enabled, __ATOMIC_RELAXED)) return;
+
+    SlimTraceBuffer* buffer = ___slim_trace_buffer;
+    if (__builtin_expect(buffer == NULL, 0)) {
+        buffer = ___slim_trace_buffer_create();
+        if (buffer == NULL) return;
+    }
+
+    SlimTraceEvent* event = &buffer->events[buffer->count & (SLIM_TRACE_BUFFER_EVENTS - 1)];
+    event->timestamp = ___slim_trace_clock();
+    event->name = name;
+    event->argument = argument;
+    event->phase = phase;
+    __atomic_store_n(&buffer->count, buffer->count + 1, __ATOMIC_RELEASE);
+}
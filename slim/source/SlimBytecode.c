@@ -1,32 +1,72 @@
 #include <SlimBytecode.h>
 #include <SlimData.h>
+#include <SlimFile.h>
+#include <SlimMachine.h>
+#include <SlimThread.h>
+#include <SlimTrace.h>
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
+#define SLIM_BYTECODE_CACHE_MAGIC 0x434D4C53 // "SLMC"
+#define SLIM_BYTECODE_CACHE_VERSION 5
+// ---------------------------------------------------------------------------------------------------------------------
+SLIM_VECTOR_DECLARE(SlimBytecodeNativeVector, char*, 8)
+SLIM_VECTOR_DECLARE(SlimBytecodeStringVector, SlimBytecodeString, 8)
+SLIM_VECTOR_DECLARE(SlimBytecodeConstantVector, u64_t, 8)
+SLIM_VECTOR_DECLARE(SlimBytecodeSectionVector, SlimBytecodeSection, 4)
+SLIM_VECTOR_DECLARE(SlimBytecodeSymbolVector, SlimBytecodeSymbol, 8)
+SLIM_VECTOR_DECLARE(SlimBytecodeDisplacementVector, u32_t, 8)
+SLIM_VECTOR_DECLARE(SlimBytecodeInstructionVector, SlimBytecodeInstruction, 16)
 // ---------------------------------------------------------------------------------------------------------------------
 struct SlimBytecodeData {
     u8_t* data;
     u32_t size;
+    u32_t references; // The creator's, plus one for each table decoding sections out of the data
 };
 // ---------------------------------------------------------------------------------------------------------------------
 struct SlimBytecodeTable {
-    SlimVector natives;
-    SlimVector strings;
-    SlimVector constants;
-    SlimVector instructions;
+    SlimArena arena;   // Backing storage for native names and other load-time metadata, freed with the table
+    char* string_data; // Backing storage for every entry in strings
+    SlimBytecodeNativeVector natives;
+    SlimBytecodeStringVector strings;
+    SlimBytecodeConstantVector constants;
+    SlimBytecodeSectionVector sections;
+    SlimBytecodeInstructionVector instructions;
+
+    // Perfect hash over symbol names, symbols[slot] holds the only symbol that can hash to that slot
+    char* symbol_data; // Backing storage for every symbol name
+    u32_t symbol_seed;
+    SlimBytecodeDisplacementVector symbol_displacements;
+    SlimBytecodeSymbolVector symbols;
+
+    // The image the table was loaded from, referenced so that sections can be decoded out of it on first use
+    SlimBytecodeData source;
+    const u8_t* encoded_instructions;
+    u32_t unloaded_sections; // Sections not decoded yet, so a fully decoded table is recognised without a scan
 
     u32_t header_size;
     u32_t native_size;
     u32_t string_size;
     u32_t constant_size;
+    u32_t section_size;
+    u32_t symbol_size;
     u32_t instruction_size;
 
     u32_t header_offset;
     u32_t native_offset;
     u32_t string_offset;
     u32_t constant_offset;
+    u32_t section_offset;
+    u32_t symbol_offset;
     u32_t instruction_offset;
+
+    // Identity of the image the table was loaded from, and whether the table holds work not yet in the cache
+    u64_t source_hash;
+    u32_t source_size;
+    u8_t dirty;
 };
 // ---------------------------------------------------------------------------------------------------------------------
 SlimBytecodeData slim_bytecode_data_create(u8_t* data, u32_t size)
@@ -35,6 +75,7 @@ SlimBytecodeData slim_bytecode_data_create(u8_t* data, u32_t size)
 
     bytecode->data = malloc(size);
     bytecode->size = size;
+    bytecode->references = 1;
 
     for (u32_t i = 0; i < size; i++) {
         bytecode->data[i] = data[i];
@@ -46,6 +87,7 @@ SlimBytecodeData slim_bytecode_data_create(u8_t* data, u32_t size)
 void slim_bytecode_data_destroy(SlimBytecodeData bytecode)
 {
     if (bytecode == NULL) return;
+    if (__atomic_sub_fetch(&bytecode->references, 1, __ATOMIC_ACQ_REL) != 0) return;
 
     free(bytecode->data);
     free(bytecode);
@@ -56,29 +98,294 @@ SlimBytecodeTable slim_bytecode_table_create()
 {
     SlimBytecodeTable table = malloc(sizeof(struct SlimBytecodeTable));
 
-    table->natives = slim_vector_create(sizeof(char*));
-    table->strings = slim_vector_create(sizeof(char*));
-    table->constants = slim_vector_create(sizeof(u64_t));
-    table->instructions = slim_vector_create(sizeof(SlimBytecodeInstruction));
+    table->arena = slim_arena_create(0);
+    SlimBytecodeNativeVector_init(&table->natives);
+    table->string_data = NULL;
+    SlimBytecodeStringVector_init(&table->strings);
+    SlimBytecodeConstantVector_init(&table->constants);
+    SlimBytecodeSectionVector_init(&table->sections);
+    SlimBytecodeInstructionVector_init(&table->instructions);
+    table->symbol_data = NULL;
+    table->symbol_seed = 0;
+    SlimBytecodeDisplacementVector_init(&table->symbol_displacements);
+    SlimBytecodeSymbolVector_init(&table->symbols);
+    table->source = NULL;
+    table->encoded_instructions = NULL;
+    table->unloaded_sections = 0;
+    table->source_hash = 0;
+    table->source_size = 0;
+    table->dirty = 0;
 
     return table;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void __char_destroy(void* data) { free(*(char**)data); }
-
 void slim_bytecode_table_destroy(SlimBytecodeTable table)
 {
     if (table == NULL) return;
 
-    slim_vector_destroy(table->natives, __char_destroy);
-    slim_vector_destroy(table->strings, __char_destroy);
-    slim_vector_destroy(table->constants, NULL);
-    slim_vector_destroy(table->instructions, NULL);
+    SlimBytecodeNativeVector_free(&table->natives);
+    SlimBytecodeStringVector_free(&table->strings);
+    free(table->string_data);
+    SlimBytecodeConstantVector_free(&table->constants);
+    SlimBytecodeSectionVector_free(&table->sections);
+    SlimBytecodeInstructionVector_free(&table->instructions);
+    free(table->symbol_data);
+    SlimBytecodeDisplacementVector_free(&table->symbol_displacements);
+    SlimBytecodeSymbolVector_free(&table->symbols);
+    slim_bytecode_data_destroy(table->source);
+    slim_arena_destroy(table->arena);
 
     free(table);
     table = NULL;
 }
 
+// Instruction Encoding ------------------------------------------------------------------------------------------------
+// Generated from SlimOpcodeTable.h, the assembler writes the same formats (see SlapOpcode.py)
+SlimError slim_bytecode_operand_format(u8_t opcode, SlimBytecodeOperandFormat* format)
+{
+    switch (opcode) {
+#define SLIM_OPCODE(name, value, routine, operand)                                                                     \
+    case SL_OPCODE_##name: *format = SLIM_BYTECODE_OPERAND_##operand; break;
+#include <SlimOpcodeTable.h>
+#undef SLIM_OPCODE
+    default: return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_bytecode_operand_read(
+    const u8_t* bytes, u32_t* position, u32_t end, SlimBytecodeOperandFormat format, u64_t* operand)
+{
+    u32_t width = 0;
+    u64_t value = 0;
+
+    switch (format) {
+    case SLIM_BYTECODE_OPERAND_NONE: width = 0; break;
+    case SLIM_BYTECODE_OPERAND_U8: width = 1; break;
+    case SLIM_BYTECODE_OPERAND_U16: width = 2; break;
+    case SLIM_BYTECODE_OPERAND_U32: width = 4; break;
+    case SLIM_BYTECODE_OPERAND_VARINT: {
+        // Unsigned LEB128, 7 bits per byte with the high bit marking continuation
+        u32_t shift = 0;
+        while (1) {
+            if (*position >= end || shift > 63) return SLIM_ERROR;
+
+            u8_t byte = bytes[(*position)++];
+            value |= (u64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) break;
+            shift += 7;
+        }
+
+        *operand = value;
+        return SL_ERROR_NONE;
+    }
+    default: return SLIM_ERROR;
+    }
+
+    if (end - *position < width) return SLIM_ERROR;
+
+    // @Endianess
+    for (u32_t i = 0; i < width; i++) {
+        value = value << 8 | bytes[(*position)++];
+    }
+
+    *operand = value;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_bytecode_instruction_read(
+    const u8_t* bytes, u32_t* position, u32_t end, SlimBytecodeInstruction* instruction)
+{
+    SlimBytecodeOperandFormat format;
+    SlimError error;
+
+    instruction->opcode = bytes[(*position)++];
+
+    error = slim_bytecode_operand_format(instruction->opcode, &format);
+    if (error != SL_ERROR_NONE) return error;
+
+    return ___slim_bytecode_operand_read(bytes, position, end, format, &instruction->operand);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimBytecodeSection* ___slim_bytecode_table_find_section(SlimBytecodeTable table, u64_t address)
+{
+    // Binary search for the section containing the address, sections are ordered and contiguous
+    u32_t low = 0;
+    u32_t high = table->sections.size;
+
+    while (low < high) {
+        u32_t middle = low + (high - low) / 2;
+        SlimBytecodeSection* section = &table->sections.data[middle];
+
+        if (address < section->address) {
+            high = middle;
+        } else if (address >= section->address + section->instruction_count) {
+            low = middle + 1;
+        } else {
+            return section;
+        }
+    }
+
+    return NULL;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_bytecode_instruction_verify(SlimBytecodeTable table, SlimBytecodeInstruction* instruction)
+{
+    switch (instruction->opcode) {
+    case SL_OPCODE_LOADK:
+        if (instruction->operand >= table->constants.size) return SLIM_ERROR;
+        break;
+    case SL_OPCODE_LOADS:
+        if (instruction->operand >= table->strings.size) return SLIM_ERROR;
+        break;
+    case SL_OPCODE_JMP:
+    case SL_OPCODE_JNE:
+    case SL_OPCODE_JE:
+    case SL_OPCODE_JLT:
+    case SL_OPCODE_JLE:
+    case SL_OPCODE_JGT:
+    case SL_OPCODE_JGE:
+    case SL_OPCODE_JLTU:
+    case SL_OPCODE_JLEU:
+    case SL_OPCODE_JGTU:
+    case SL_OPCODE_JGEU:
+    case SL_OPCODE_JLTF:
+    case SL_OPCODE_JLEF:
+    case SL_OPCODE_JGTF:
+    case SL_OPCODE_JGEF:
+        if (instruction->operand >= table->instructions.size) return SLIM_ERROR;
+        break;
+    case SL_OPCODE_CALL:
+    case SL_OPCODE_TAILCALL:
+    case SL_OPCODE_PARFOR: {
+        if (instruction->operand >= table->instructions.size) return SLIM_ERROR;
+        if (table->sections.size == 0) break;
+
+        // The callee's frame shape is that of the section it enters, so it has to enter at the start of one
+        SlimBytecodeSection* callee = ___slim_bytecode_table_find_section(table, instruction->operand);
+        if (callee == NULL || callee->address != (u32_t)instruction->operand) return SLIM_ERROR;
+        break;
+    }
+    case SL_OPCODE_DJNZ:
+        // Split into SLOT ADDR here, so the fetch hands the slot over in arg1 like the callee local count of CALL
+        if ((instruction->operand >> 16) >= table->instructions.size) return SLIM_ERROR;
+        instruction->operand = (instruction->operand & 0xFFFF) << 32 | instruction->operand >> 16;
+        break;
+    default: break;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_bytecode_table_decode_section(SlimBytecodeTable table, SlimBytecodeSection* section)
+{
+    u32_t position = section->byte_offset;
+    u32_t end = section->byte_offset + section->byte_size;
+    u32_t index = section->address;
+    u32_t last = section->address + section->instruction_count;
+
+    while (position < end) {
+        SlimBytecodeInstruction instruction;
+
+        if (index >= last) goto rejected;
+
+        SlimError error = ___slim_bytecode_instruction_read(table->encoded_instructions, &position, end, &instruction);
+        if (error != SL_ERROR_NONE) goto rejected;
+
+        error = ___slim_bytecode_instruction_verify(table, &instruction);
+        if (error != SL_ERROR_NONE) goto rejected;
+
+        // The callee's frame shape rides along with the address, see SlimBytecode.h
+        if (instruction.opcode == SL_OPCODE_CALL || instruction.opcode == SL_OPCODE_TAILCALL ||
+            instruction.opcode == SL_OPCODE_PARFOR) {
+            SlimBytecodeSection* callee = ___slim_bytecode_table_find_section(table, instruction.operand);
+            if (callee == NULL) goto rejected;
+            instruction.operand |= (u64_t)(callee->local_count | callee->argument_count << 16) << 32;
+        }
+
+        instruction.loaded = 1;
+        table->instructions.data[index++] = instruction;
+    }
+
+    if (index != last) goto rejected;
+
+    // Prepare decodes disjoint sections on several threads, which only share this count
+    section->loaded = 1;
+    __atomic_sub_fetch(&table->unloaded_sections, 1, __ATOMIC_RELAXED);
+    return SL_ERROR_NONE;
+
+rejected:
+    // The instructions before the one that failed are already in place, a later lookup must not run them
+    u32_t written = index - section->address;
+    memset(&table->instructions.data[section->address], 0, written * sizeof(SlimBytecodeInstruction));
+    return SLIM_ERROR;
+}
+// Symbols -------------------------------------------------------------------------------------------------------------
+// Seeded 64-bit FNV-1a followed by the splitmix64 finalizer, must mirror symbol_hash in SlapPerfectHash.py
+u64_t ___slim_bytecode_symbol_hash(u32_t seed, const char* name, u32_t length)
+{
+    u64_t hash = 0xCBF29CE484222325ULL ^ seed;
+    for (u32_t i = 0; i < length; i++) {
+        hash ^= (u8_t)name[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// CHD slot of a name: the high half of the hash picks a bucket, whose displacement (d0, d1) combines the two
+// remaining hash functions.  Must mirror symbol_slot in SlapPerfectHash.py.
+u32_t ___slim_bytecode_symbol_slot(SlimBytecodeTable table, const char* name, u32_t length)
+{
+    u32_t slot_count = table->symbols.size;
+    u32_t bucket_count = table->symbol_displacements.size;
+
+    u64_t hash = ___slim_bytecode_symbol_hash(table->symbol_seed, name, length);
+    u32_t displacement = table->symbol_displacements.data[(u32_t)(hash >> 32) % bucket_count];
+
+    u64_t f1 = (u32_t)hash % slot_count;
+    u64_t f2 = (u32_t)((hash * 0x9E3779B97F4A7C15ULL) >> 32) % slot_count;
+    u64_t d0 = displacement / slot_count;
+    u64_t d1 = displacement % slot_count;
+
+    return (f1 + d0 * f2 + d1) % slot_count;
+}
+// Strings ---------------------------------------------------------------------------------------------------------------
+// 32-bit FNV-1a, the assembler uses the same function when it needs to hash names ahead of time
+u32_t slim_bytecode_hash(const char* data, u32_t length)
+{
+    u32_t hash = 0x811C9DC5;
+    for (u32_t i = 0; i < length; i++) {
+        hash ^= (u8_t)data[i];
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_bytecode_string_equal(const SlimBytecodeString* a, const SlimBytecodeString* b)
+{
+    if (a->data == b->data) return 1;
+    if (a->hash != b->hash || a->length != b->length) return 0;
+    return memcmp(a->data, b->data, a->length) == 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// 64-bit FNV-1a, used to key cache entries by the content of the image
+u64_t ___slim_bytecode_hash64(const u8_t* data, u32_t size)
+{
+    u64_t hash = 0xCBF29CE484222325;
+    for (u32_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x00000100000001B3;
+    }
+    return hash;
+}
+// ---------------------------------------------------------------------------------------------------------------------
 u16_t ___slim_u16_t_reverse(u16_t value) { return (value & 0x00FF) << 8 | (value & 0xFF00) >> 8; }
 
 u32_t ___slim_u32_t_reverse(u32_t value)
@@ -115,48 +422,270 @@ SlimError slim_bytecode_table_load_data_header(SlimBytecodeTable table, SlimByte
     position += sizeof(table->instruction_size);
     table->instruction_size = ___slim_u32_t_reverse(table->instruction_size);
 
+    // Older images leave this as padding, which reads as an empty section table
+    memcpy(&table->section_size, data->data + position, sizeof(table->section_size));
+    position += sizeof(table->section_size);
+    table->section_size = ___slim_u32_t_reverse(table->section_size);
+
+    memcpy(&table->symbol_size, data->data + position, sizeof(table->symbol_size));
+    position += sizeof(table->symbol_size);
+    table->symbol_size = ___slim_u32_t_reverse(table->symbol_size);
+
     table->header_offset = 0;
     table->native_offset = table->header_size;
     table->string_offset = table->native_offset + table->native_size;
     table->constant_offset = table->string_offset + table->string_size;
-    table->instruction_offset = table->constant_offset + table->constant_size;
+    table->section_offset = table->constant_offset + table->constant_size;
+    table->symbol_offset = table->section_offset + table->section_size;
+    table->instruction_offset = table->symbol_offset + table->symbol_size;
+
+    if (table->instruction_offset + table->instruction_size > data->size) return SLIM_ERROR;
 
     return SL_ERROR_NONE;
 }
 
 SlimError slim_bytecode_table_load_data_native(SlimBytecodeTable table, SlimBytecodeData data)
 {
-    // Each entry in the native table is composed of a 2 byte length followed by the null-terminated string.
+    // Each entry in the native table is composed of a 2 byte length followed by the null-terminated string.  Names are
+    // copied into the table arena, which is only ever touched by this loader while the table is being loaded.
 
     u32_t position = table->native_offset;
 
     while (position < table->string_offset) {
         u16_t length;
+        if (table->string_offset - position < sizeof(length)) return SLIM_ERROR;
         memcpy(&length, data->data + position, sizeof(length));
         position += sizeof(length);
         length = ___slim_u16_t_reverse(length);
 
-        char* native = malloc(length + 1);
-        memcpy(native, data->data + position, length);
-        native[length] = '\0';
+        if (table->string_offset - position < length) return SLIM_ERROR;
+
+        char* native = slim_arena_copy_string(table->arena, (const char*)(data->data + position), length);
+        if (native == NULL) return SLIM_ERROR;
         position += length;
 
-        // This simple stores the start of the string in memory
-        slim_vector_append(table->natives, &native);
+        if (SlimBytecodeNativeVector_append(&table->natives, native) != SL_ERROR_NONE) return SLIM_ERROR;
     }
 
     return SL_ERROR_NONE;
 }
 
-SlimError slim_bytecode_table_load_data_string(SlimBytecodeTable table, SlimBytecodeData data) { return SL_ERROR_NONE; }
+SlimError slim_bytecode_table_load_data_string(SlimBytecodeTable table, SlimBytecodeData data)
+{
+    // Each entry in the string table is composed of a 2 byte length followed by the characters.  Every length prefix
+    // is at least as large as the null terminator that replaces it, so the whole table fits in string_size bytes.
+
+    u32_t position = table->string_offset;
+    u32_t written = 0;
+
+    free(table->string_data);
+    table->string_data = malloc(table->string_size + 1);
+    if (table->string_data == NULL) return SLIM_ERROR;
+
+    while (position < table->constant_offset) {
+        u16_t length;
+        if (table->constant_offset - position < sizeof(length)) return SLIM_ERROR;
+        memcpy(&length, data->data + position, sizeof(length));
+        position += sizeof(length);
+        length = ___slim_u16_t_reverse(length);
+
+        if (table->constant_offset - position < length) return SLIM_ERROR;
+
+        SlimBytecodeString string;
+        string.data = table->string_data + written;
+        string.length = length;
+        string.hash = slim_bytecode_hash((const char*)(data->data + position), length);
+
+        memcpy(table->string_data + written, data->data + position, length);
+        table->string_data[written + length] = '\0';
+        written += length + 1;
+        position += length;
+
+        if (SlimBytecodeStringVector_append(&table->strings, string) != SL_ERROR_NONE) return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
 
 SlimError slim_bytecode_table_load_data_constant(SlimBytecodeTable table, SlimBytecodeData data)
 {
+    // Each entry in the constant table is a single big-endian u64
+
+    if (table->constant_size % sizeof(u64_t) != 0) return SLIM_ERROR;
+
+    u32_t position = table->constant_offset;
+
+    while (position < table->section_offset) {
+        u64_t constant = 0;
+
+        // @Endianess
+        for (u32_t i = 0; i < sizeof(u64_t); i++) {
+            constant = constant << 8 | data->data[position++];
+        }
+
+        if (SlimBytecodeConstantVector_append(&table->constants, constant) != SL_ERROR_NONE) return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+
+SlimError slim_bytecode_table_load_data_section(SlimBytecodeTable table, SlimBytecodeData data)
+{
+    // Each entry in the section table is six big-endian u32: address, instruction count, byte offset, byte size, local
+    // count and argument count.  The arguments are the first locals, so there are never more of them than locals.
+    // Entries must be ordered by address and describe consecutive runs of instructions.
+
+    const u32_t ENTRY_SIZE = 6 * sizeof(u32_t);
+    if (table->section_size % ENTRY_SIZE != 0) return SLIM_ERROR;
+
+    u32_t position = table->section_offset;
+    u32_t next_address = 0;
+
+    while (position < table->symbol_offset) {
+        u32_t fields[6];
+
+        // @Endianess
+        for (u32_t i = 0; i < 6; i++) {
+            memcpy(&fields[i], data->data + position, sizeof(u32_t));
+            position += sizeof(u32_t);
+            fields[i] = ___slim_u32_t_reverse(fields[i]);
+        }
+
+        SlimBytecodeSection section;
+        section.address = fields[0];
+        section.instruction_count = fields[1];
+        section.byte_offset = fields[2];
+        section.byte_size = fields[3];
+        section.local_count = fields[4];
+        section.argument_count = fields[5];
+        section.loaded = 0;
+
+        if (section.address != next_address) return SLIM_ERROR;
+        if (section.local_count > 0xFFFF || section.argument_count > section.local_count) return SLIM_ERROR;
+        if (section.byte_offset > table->instruction_size) return SLIM_ERROR;
+        if (section.byte_size > table->instruction_size - section.byte_offset) return SLIM_ERROR;
+
+        next_address = section.address + section.instruction_count;
+        if (SlimBytecodeSectionVector_append(&table->sections, section) != SL_ERROR_NONE) return SLIM_ERROR;
+    }
+
+    table->unloaded_sections = table->sections.size;
     return SL_ERROR_NONE;
 }
 
+u32_t ___slim_bytecode_read_u32(const u8_t* bytes)
+{
+    return (u32_t)bytes[0] << 24 | (u32_t)bytes[1] << 16 | (u32_t)bytes[2] << 8 | (u32_t)bytes[3];
+}
+
+SlimError slim_bytecode_table_load_data_symbol(SlimBytecodeTable table, SlimBytecodeData data)
+{
+    // The symbol table starts with the seed, bucket count and symbol count as big-endian u32, followed by one u32
+    // displacement per bucket and one 12 byte entry per slot (name offset u32, name length u16, kind u8, reserved u8,
+    // index u32).  The names follow without separators, offsets are relative to the start of the names.
+
+    if (table->symbol_size == 0) return SL_ERROR_NONE;
+    if (table->symbol_size < 3 * sizeof(u32_t)) return SLIM_ERROR;
+
+    const u8_t* bytes = data->data + table->symbol_offset;
+    const u32_t ENTRY_SIZE = 12;
+
+    u32_t seed = ___slim_bytecode_read_u32(bytes);
+    u32_t bucket_count = ___slim_bytecode_read_u32(bytes + 4);
+    u32_t symbol_count = ___slim_bytecode_read_u32(bytes + 8);
+
+    u64_t names_offset = 3 * sizeof(u32_t) + (u64_t)bucket_count * sizeof(u32_t) + (u64_t)symbol_count * ENTRY_SIZE;
+    if (bucket_count == 0 || symbol_count == 0 || names_offset > table->symbol_size) return SLIM_ERROR;
+    u32_t names_size = table->symbol_size - names_offset;
+
+    free(table->symbol_data);
+    table->symbol_data = malloc(names_size + 1);
+    if (table->symbol_data == NULL) return SLIM_ERROR;
+    memcpy(table->symbol_data, bytes + names_offset, names_size);
+
+    if (SlimBytecodeDisplacementVector_resize(&table->symbol_displacements, bucket_count) != SL_ERROR_NONE ||
+        SlimBytecodeSymbolVector_resize(&table->symbols, symbol_count) != SL_ERROR_NONE) {
+        return SLIM_ERROR;
+    }
+
+    table->symbol_seed = seed;
+    for (u32_t i = 0; i < bucket_count; i++) {
+        table->symbol_displacements.data[i] = ___slim_bytecode_read_u32(bytes + 12 + i * sizeof(u32_t));
+    }
+
+    for (u32_t i = 0; i < symbol_count; i++) {
+        const u8_t* entry = bytes + 12 + bucket_count * sizeof(u32_t) + i * ENTRY_SIZE;
+        SlimBytecodeSymbol* symbol = &table->symbols.data[i];
+
+        u32_t name_offset = ___slim_bytecode_read_u32(entry);
+        symbol->length = (u32_t)entry[4] << 8 | entry[5];
+        symbol->kind = entry[6];
+        symbol->index = ___slim_bytecode_read_u32(entry + 8);
+
+        if (name_offset > names_size || symbol->length > names_size - name_offset) return SLIM_ERROR;
+        if (symbol->kind != SLIM_BYTECODE_SYMBOL_NATIVE && symbol->kind != SLIM_BYTECODE_SYMBOL_SECTION) {
+            return SLIM_ERROR;
+        }
+        symbol->name = table->symbol_data + name_offset;
+    }
+
+    // Every symbol must hash to its own slot, otherwise lookups could miss names that are present
+    for (u32_t i = 0; i < symbol_count; i++) {
+        SlimBytecodeSymbol* symbol = &table->symbols.data[i];
+        if (___slim_bytecode_symbol_slot(table, symbol->name, symbol->length) != i) return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+
+void ___slim_bytecode_table_reference_source(SlimBytecodeTable table, SlimBytecodeData data)
+{
+    __atomic_add_fetch(&data->references, 1, __ATOMIC_RELAXED);
+    slim_bytecode_data_destroy(table->source);
+
+    table->source = data;
+    table->encoded_instructions = data->data + table->instruction_offset;
+}
+
 SlimError slim_bytecode_table_load_data_instruction(SlimBytecodeTable table, SlimBytecodeData data)
 {
+    // Each entry in the instruction table is composed of a 1 byte opcode followed by an operand whose width is decided
+    // by the opcode.  Entries are expanded exactly once so that the machine can fetch by index.  With a section table
+    // this only reserves the expanded slots, and each section is expanded by the first lookup that lands inside it.
+
+    u32_t section_count = table->sections.size;
+
+    if (section_count == 0) {
+        u32_t position = table->instruction_offset;
+        u32_t end = table->instruction_offset + table->instruction_size;
+
+        while (position < end) {
+            SlimBytecodeInstruction* instruction = SlimBytecodeInstructionVector_push(&table->instructions);
+            if (instruction == NULL) return SLIM_ERROR;
+
+            SlimError error = ___slim_bytecode_instruction_read(data->data, &position, end, instruction);
+            if (error != SL_ERROR_NONE) return error;
+            instruction->loaded = 1;
+        }
+
+        // Branch targets can only be verified once the total instruction count is known
+        for (u32_t i = 0; i < table->instructions.size; i++) {
+            SlimError error = ___slim_bytecode_instruction_verify(table, &table->instructions.data[i]);
+            if (error != SL_ERROR_NONE) return error;
+        }
+
+        return SL_ERROR_NONE;
+    }
+
+    // Neither step touches the encoded bytes or the slots, so this stays cheap however large the image is
+    SlimBytecodeSection* last = &table->sections.data[section_count - 1];
+    u32_t instruction_count = last->address + last->instruction_count;
+
+    if (SlimBytecodeInstructionVector_resize_zeroed(&table->instructions, instruction_count) != SL_ERROR_NONE) {
+        return SLIM_ERROR;
+    }
+
+    ___slim_bytecode_table_reference_source(table, data);
     return SL_ERROR_NONE;
 }
 
@@ -176,59 +705,641 @@ SlimError slim_bytecode_table_load_data(SlimBytecodeTable table, SlimBytecodeDat
     error = slim_bytecode_table_load_data_constant(table, data);
     if (error != SL_ERROR_NONE) return error;
 
+    error = slim_bytecode_table_load_data_section(table, data);
+    if (error != SL_ERROR_NONE) return error;
+
+    error = slim_bytecode_table_load_data_symbol(table, data);
+    if (error != SL_ERROR_NONE) return error;
+
     error = slim_bytecode_table_load_data_instruction(table, data);
     if (error != SL_ERROR_NONE) return error;
 
+    table->source_hash = ___slim_bytecode_hash64(data->data, data->size);
+    table->source_size = data->size;
+    table->dirty = 1;
+
+    return error;
+}
+
+// Parallel Loading ----------------------------------------------------------------------------------------------------
+// Every table lives in its own byte range and is parsed into its own vector, so the loaders only share the read-only
+// image and can run side by side.  Sections decode into disjoint slots of an already sized instruction vector, which
+// means chunks of the instruction table need no merging once the job has finished.  The tasks run on the shared thread
+// pool, so a load spawns no threads of its own.
+typedef SlimError (*SlimBytecodeTableLoader)(SlimBytecodeTable table, SlimBytecodeData data);
+
+typedef struct SlimBytecodeLoadTask {
+    SlimBytecodeTable table;
+    SlimBytecodeData data;
+    SlimBytecodeTableLoader loader;
+    u32_t first_section; // Chunk of the section table decoded by a prepare task, [first, last)
+    u32_t last_section;
+    SlimError error;
+} SlimBytecodeLoadTask;
+// ---------------------------------------------------------------------------------------------------------------------
+u32_t ___slim_bytecode_thread_count(u32_t requested)
+{
+    if (requested != 0) return requested;
+
+    SlimThreadPool pool = slim_thread_pool_shared();
+    return pool != NULL ? slim_thread_pool_get_count_workers(pool) + 1 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_bytecode_load_task_run(void* argument, u32_t index)
+{
+    SlimBytecodeLoadTask* task = (SlimBytecodeLoadTask*)argument + index;
+    task->error = task->loader(task->table, task->data);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_bytecode_prepare_task_run(void* argument, u32_t index)
+{
+    SlimBytecodeLoadTask* task = (SlimBytecodeLoadTask*)argument + index;
+    task->error = SL_ERROR_NONE;
+
+    for (u32_t i = task->first_section; i < task->last_section; i++) {
+        SlimBytecodeSection* section = &task->table->sections.data[i];
+        if (section->loaded) continue;
+
+        task->error = ___slim_bytecode_table_decode_section(task->table, section);
+        if (task->error != SL_ERROR_NONE) break;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_bytecode_tasks_run(SlimBytecodeLoadTask* tasks, u32_t count, SlimThreadTask run)
+{
+    // A single task is not worth a round trip through the pool, and without a pool every task runs inline
+    SlimThreadPool pool = count > 1 ? slim_thread_pool_shared() : NULL;
+    if (pool != NULL) {
+        slim_thread_pool_run(pool, count, run, tasks);
+    } else {
+        for (u32_t i = 0; i < count; i++) run(tasks, i);
+    }
+
+    SlimError error = SL_ERROR_NONE;
+    for (u32_t i = 0; i < count; i++) {
+        if (tasks[i].error != SL_ERROR_NONE) error = tasks[i].error;
+    }
+
     return error;
 }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_bytecode_table_prepare(SlimBytecodeTable table, u32_t thread_count)
+{
+    // Every PARFOR prepares the table, which after the first one has nothing left to decode
+    u32_t unloaded = __atomic_load_n(&table->unloaded_sections, __ATOMIC_RELAXED);
+    if (unloaded == 0) return SL_ERROR_NONE;
+
+    u32_t section_count = table->sections.size;
+    thread_count = ___slim_bytecode_thread_count(thread_count);
+    if (thread_count > section_count) thread_count = section_count;
+
+    // Chunks are balanced by encoded bytes rather than section count, function sizes vary wildly
+    u64_t remaining = 0;
+    for (u32_t i = 0; i < section_count; i++) {
+        SlimBytecodeSection* section = &table->sections.data[i];
+        if (!section->loaded) remaining += section->byte_size;
+    }
+
+    SlimBytecodeLoadTask* tasks = calloc(thread_count, sizeof(SlimBytecodeLoadTask));
+    if (tasks == NULL) return SLIM_ERROR;
+
+    u32_t next = 0;
+    for (u32_t t = 0; t < thread_count; t++) {
+        u64_t budget = remaining / (thread_count - t);
+        u64_t taken = 0;
+
+        tasks[t].table = table;
+        tasks[t].first_section = next;
+
+        while (next < section_count && (taken < budget || t == thread_count - 1)) {
+            SlimBytecodeSection* section = &table->sections.data[next++];
+            if (!section->loaded) taken += section->byte_size;
+        }
+
+        tasks[t].last_section = next;
+        remaining -= taken;
+    }
+
+    SlimError error = ___slim_bytecode_tasks_run(tasks, thread_count, ___slim_bytecode_prepare_task_run);
+    free(tasks);
+
+    // Even a failed prepare may have decoded some sections, which are worth caching
+    if (table->unloaded_sections != unloaded) table->dirty = 1;
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_bytecode_table_load_data_parallel(SlimBytecodeTable table, SlimBytecodeData data, u32_t thread_count)
+{
+    SlimError error = slim_bytecode_table_load_data_header(table, data);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimBytecodeTableLoader loaders[] = {
+        slim_bytecode_table_load_data_native,
+        slim_bytecode_table_load_data_string,
+        slim_bytecode_table_load_data_constant,
+        slim_bytecode_table_load_data_section,
+        slim_bytecode_table_load_data_symbol,
+    };
+    SlimBytecodeLoadTask tasks[sizeof(loaders) / sizeof(loaders[0])];
+    memset(tasks, 0, sizeof(tasks));
+
+    for (u32_t i = 0; i < sizeof(loaders) / sizeof(loaders[0]); i++) {
+        tasks[i].table = table;
+        tasks[i].data = data;
+        tasks[i].loader = loaders[i];
+    }
+
+    error = ___slim_bytecode_tasks_run(tasks, sizeof(loaders) / sizeof(loaders[0]), ___slim_bytecode_load_task_run);
+    if (error != SL_ERROR_NONE) return error;
+
+    // Verification needs the constant, string and section tables, so instructions are only expanded after the join
+    error = slim_bytecode_table_load_data_instruction(table, data);
+    if (error != SL_ERROR_NONE) return error;
+
+    error = slim_bytecode_table_prepare(table, thread_count);
+    if (error != SL_ERROR_NONE) return error;
+
+    table->source_hash = ___slim_bytecode_hash64(data->data, data->size);
+    table->source_size = data->size;
+    table->dirty = 1;
+
+    return SL_ERROR_NONE;
+}
 
 // Accessors
 u32_t slim_bytecode_table_get_size_header(SlimBytecodeTable table) { return table->header_size; }
 u32_t slim_bytecode_table_get_size_natives(SlimBytecodeTable table) { return table->native_size; }
 u32_t slim_bytecode_table_get_size_strings(SlimBytecodeTable table) { return table->string_size; }
 u32_t slim_bytecode_table_get_size_constants(SlimBytecodeTable table) { return table->constant_size; }
+u32_t slim_bytecode_table_get_size_sections(SlimBytecodeTable table) { return table->section_size; }
+u32_t slim_bytecode_table_get_size_symbols(SlimBytecodeTable table) { return table->symbol_size; }
 u32_t slim_bytecode_table_get_size_instrs(SlimBytecodeTable table) { return table->instruction_size; }
 
 u32_t slim_bytecode_table_get_offset_header(SlimBytecodeTable table) { return table->header_offset; }
 u32_t slim_bytecode_table_get_offset_natives(SlimBytecodeTable table) { return table->native_offset; }
 u32_t slim_bytecode_table_get_offset_strings(SlimBytecodeTable table) { return table->string_offset; }
 u32_t slim_bytecode_table_get_offset_constants(SlimBytecodeTable table) { return table->constant_offset; }
+u32_t slim_bytecode_table_get_offset_sections(SlimBytecodeTable table) { return table->section_offset; }
+u32_t slim_bytecode_table_get_offset_symbols(SlimBytecodeTable table) { return table->symbol_offset; }
 u32_t slim_bytecode_table_get_offset_instrs(SlimBytecodeTable table) { return table->instruction_offset; }
 
+u32_t slim_bytecode_table_get_count_natives(SlimBytecodeTable table) { return table->natives.size; }
+u32_t slim_bytecode_table_get_count_strings(SlimBytecodeTable table) { return table->strings.size; }
+u32_t slim_bytecode_table_get_count_constants(SlimBytecodeTable table) { return table->constants.size; }
+u32_t slim_bytecode_table_get_count_sections(SlimBytecodeTable table) { return table->sections.size; }
+u32_t slim_bytecode_table_get_count_symbols(SlimBytecodeTable table) { return table->symbols.size; }
+u32_t slim_bytecode_table_get_count_instrs(SlimBytecodeTable table) { return table->instructions.size; }
+
 SlimError slim_bytecode_table_lookup_native(SlimBytecodeTable table, u64_t index, char** string)
 {
-    if (index >= slim_vector_size(table->natives)) return SLIM_ERROR;
-
-    char* accessed;
-    slim_vector_access(table->natives, index, &accessed);
+    if (index >= table->natives.size) return SLIM_ERROR;
 
-    printf("Native: %s\n", accessed);
-
-    *string = accessed;
+    *string = table->natives.data[index];
 
     return SL_ERROR_NONE;
 }
 
 SlimError slim_bytecode_table_lookup_string(SlimBytecodeTable table, u64_t index, char** string)
 {
-    if (index >= slim_vector_size(table->strings)) return SLIM_ERROR;
+    SlimBytecodeString entry;
+    SlimError error = slim_bytecode_table_lookup_string_entry(table, index, &entry);
+    if (error != SL_ERROR_NONE) return error;
+
+    *string = (char*)entry.data;
 
-    char* accessed;
-    slim_vector_access(table->strings, index, &accessed);
+    return SL_ERROR_NONE;
+}
 
-    printf("Native: %s\n", accessed);
+SlimError slim_bytecode_table_lookup_string_entry(SlimBytecodeTable table, u64_t index, SlimBytecodeString* string)
+{
+    if (index >= table->strings.size) return SLIM_ERROR;
 
-    *string = accessed;
+    *string = table->strings.data[index];
 
     return SL_ERROR_NONE;
 }
 
 SlimError slim_bytecode_table_lookup_constant(SlimBytecodeTable table, u64_t index, u64_t* constant)
 {
+    if (index >= table->constants.size) return SLIM_ERROR;
+
+    *constant = table->constants.data[index];
+
+    return SL_ERROR_NONE;
+}
+
+SlimError slim_bytecode_table_lookup_section(SlimBytecodeTable table, u64_t index, SlimBytecodeSection* section)
+{
+    if (index >= table->sections.size) return SLIM_ERROR;
+
+    *section = table->sections.data[index];
+
+    return SL_ERROR_NONE;
+}
+
+SlimError slim_bytecode_table_lookup_symbol(
+    SlimBytecodeTable table, const char* name, u32_t length, SlimBytecodeSymbol* symbol)
+{
+    if (table->symbols.size == 0) return SLIM_ERROR;
+
+    // The perfect hash only guarantees distinct slots for known names, anything else has to be rejected by comparing
+    SlimBytecodeSymbol* candidate = &table->symbols.data[___slim_bytecode_symbol_slot(table, name, length)];
+    if (candidate->length != length || memcmp(candidate->name, name, length) != 0) return SLIM_ERROR;
+
+    *symbol = *candidate;
+
+    return SL_ERROR_NONE;
+}
+
+SlimError slim_bytecode_table_lookup_symbol_slot(SlimBytecodeTable table, u32_t slot, SlimBytecodeSymbol* symbol)
+{
+    if (slot >= table->symbols.size) return SLIM_ERROR;
+
+    *symbol = table->symbols.data[slot];
+    return SL_ERROR_NONE;
+}
+
+SlimError ___slim_bytecode_table_load_section(SlimBytecodeTable table, u64_t address)
+{
+    SlimBytecodeSection* section = ___slim_bytecode_table_find_section(table, address);
+    if (section == NULL || section->loaded) return SLIM_ERROR;
+
+    SLIM_TRACE_BEGIN("load section", section->address);
+    SlimError error = ___slim_bytecode_table_decode_section(table, section);
+    SLIM_TRACE_END("load section", section->address);
+    if (error != SL_ERROR_NONE) return error;
+
+    table->dirty = 1;
     return SL_ERROR_NONE;
 }
 
 SlimError slim_bytecode_table_lookup_instruction(SlimBytecodeTable table, u64_t index, SlimBytecodeInstruction* instr)
 {
+    if (index >= table->instructions.size) return SLIM_ERROR;
+
+    *instr = table->instructions.data[index];
+    if (instr->loaded) return SL_ERROR_NONE;
+
+    // First lookup inside this section, decode and verify the whole body now
+    SlimError error = ___slim_bytecode_table_load_section(table, index);
+    if (error != SL_ERROR_NONE) return error;
+
+    *instr = table->instructions.data[index];
+
     return SL_ERROR_NONE;
-}
\ No newline at end of file
+}
+// File Loading --------------------------------------------------------------------------------------------------------
+SlimError slim_bytecode_file_load(const char* path, SlimBytecodeTable* dest)
+{
+    u8_t* bytes;
+    u32_t size;
+
+    SLIM_TRACE_BEGIN("load", 0);
+    SlimError error = slim_file_read(path, &bytes, &size);
+    if (error != SL_ERROR_NONE) {
+        SLIM_TRACE_END("load", 0);
+        return error;
+    }
+
+    SlimBytecodeData data = slim_bytecode_data_create(bytes, size);
+    free(bytes);
+
+    SlimBytecodeTable table = slim_bytecode_table_create();
+
+    // A cache hit skips decoding and verification entirely, anything else falls back to a regular load
+    const char* directory = slim_bytecode_cache_directory();
+    if (directory == NULL || slim_bytecode_cache_load(directory, data, table) != SL_ERROR_NONE) {
+        // SLIM_LOAD_THREADS trades lazy sections for decoding the whole image up front on that many threads (0 = all
+        // cores), which pays off when most functions end up being executed anyway
+        const char* threads = getenv("SLIM_LOAD_THREADS");
+        if (threads != NULL && threads[0] != '\0') {
+            error = slim_bytecode_table_load_data_parallel(table, data, (u32_t)strtoul(threads, NULL, 10));
+        } else {
+            error = slim_bytecode_table_load_data(table, data);
+        }
+    }
+
+    slim_bytecode_data_destroy(data);
+    SLIM_TRACE_END("load", size);
+
+    if (error != SL_ERROR_NONE) {
+        slim_bytecode_table_destroy(table);
+        return error;
+    }
+
+    *dest = table;
+    return SL_ERROR_NONE;
+}
+
+// Cache ---------------------------------------------------------------------------------------------------------------
+// A cache entry is a flat snapshot of a table: a fixed header followed by the raw in-memory arrays.  Only sections that
+// were decoded at the time of the snapshot are stored expanded, the rest stay lazy and decode out of the image itself.
+typedef struct SlimBytecodeCacheHeader {
+    u32_t magic;
+    u32_t version;
+    u64_t build_id;
+    u64_t source_hash;
+    u32_t source_size;
+
+    u32_t sizes[7];   // header, native, string, constant, section, symbol, instruction
+    u32_t offsets[7]; // header, native, string, constant, section, symbol, instruction
+
+    u32_t native_count;
+    u32_t native_bytes;
+    u32_t string_count;
+    u32_t string_bytes;
+    u32_t constant_count;
+    u32_t section_count;
+    u32_t instruction_count;
+    u32_t lazy; // Whether sections still to be decoded read from the image, which is the same one the entry is for
+} SlimBytecodeCacheHeader;
+
+typedef struct SlimBytecodeCacheString {
+    u32_t offset;
+    u32_t length;
+    u32_t hash;
+} SlimBytecodeCacheString;
+// ---------------------------------------------------------------------------------------------------------------------
+// Entries hold raw in-memory structures, so they are only valid for builds that agree on the instruction set, the cache
+// version and the size of those structures.  The id is derived from exactly that rather than the build time, so a
+// rebuild keeps finding its entries instead of writing new ones next to them.
+#define SLIM_OPCODE(name, value, routine, operand) #name " " #value " " #operand "\n"
+static const char ___slim_bytecode_cache_opcodes[] =
+#include <SlimOpcodeTable.h>
+    "";
+#undef SLIM_OPCODE
+
+u64_t ___slim_bytecode_cache_build_id()
+{
+    u64_t layout[4] = {SLIM_BYTECODE_CACHE_VERSION, sizeof(SlimBytecodeInstruction), sizeof(SlimBytecodeSection),
+        sizeof(SlimBytecodeCacheHeader)};
+    const u8_t* opcodes = (const u8_t*)___slim_bytecode_cache_opcodes;
+    u64_t id = ___slim_bytecode_hash64(opcodes, sizeof(___slim_bytecode_cache_opcodes) - 1);
+    return id ^ ___slim_bytecode_hash64((const u8_t*)layout, sizeof(layout));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_bytecode_cache_path(const char* directory, u64_t source_hash, char* path, u32_t capacity)
+{
+    int length = snprintf(path, capacity, "%s/%016llx-%016llx.slimc", directory, source_hash,
+        ___slim_bytecode_cache_build_id());
+    return length > 0 && (u32_t)length < capacity ? SL_ERROR_NONE : SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u64_t ___slim_bytecode_cache_payload_size(const SlimBytecodeCacheHeader* header)
+{
+    return (u64_t)header->constant_count * sizeof(u64_t) +
+           (u64_t)header->instruction_count * sizeof(SlimBytecodeInstruction) +
+           (u64_t)header->section_count * sizeof(SlimBytecodeSection) +
+           (u64_t)header->string_count * sizeof(SlimBytecodeCacheString) + header->string_bytes + header->native_bytes;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+const char* slim_bytecode_cache_directory()
+{
+    static char directory[4096];
+
+    // SLIM_CACHE_DIR overrides the location, and an empty value disables caching
+    const char* configured = getenv("SLIM_CACHE_DIR");
+    if (configured != NULL) return configured[0] == '\0' ? NULL : configured;
+
+    const char* base = getenv("XDG_CACHE_HOME");
+    int length;
+    if (base != NULL && base[0] != '\0') {
+        length = snprintf(directory, sizeof(directory), "%s/slim", base);
+    } else if ((base = getenv("HOME")) != NULL) {
+        length = snprintf(directory, sizeof(directory), "%s/.cache/slim", base);
+    } else {
+        return NULL;
+    }
+
+    if (length <= 0 || (u32_t)length >= sizeof(directory)) return NULL;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) return NULL;
+
+    return directory;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_bytecode_cache_load(const char* directory, SlimBytecodeData data, SlimBytecodeTable table)
+{
+    char path[4096];
+    u64_t source_hash = ___slim_bytecode_hash64(data->data, data->size);
+
+    SlimError error = ___slim_bytecode_cache_path(directory, source_hash, path, sizeof(path));
+    if (error != SL_ERROR_NONE) return error;
+
+    u8_t* mapping;
+    u32_t size;
+    error = slim_file_map(path, &mapping, &size);
+    if (error != SL_ERROR_NONE) return error;
+
+    // Validate and allocate everything before touching the table, so a stale, truncated or corrupt entry leaves it
+    // untouched and the caller can fall back to a regular load into the same table
+    SlimBytecodeCacheHeader header;
+    if (size < sizeof(header)) goto mismatch;
+    memcpy(&header, mapping, sizeof(header));
+
+    if (header.magic != SLIM_BYTECODE_CACHE_MAGIC || header.version != SLIM_BYTECODE_CACHE_VERSION) goto mismatch;
+    if (header.build_id != ___slim_bytecode_cache_build_id()) goto mismatch;
+    if (header.source_hash != source_hash || header.source_size != data->size) goto mismatch;
+    if (sizeof(header) + ___slim_bytecode_cache_payload_size(&header) != size) goto mismatch;
+    if (header.string_bytes > header.sizes[2] + 1) goto mismatch;
+
+    u8_t* string_entries = mapping + sizeof(header) + header.constant_count * sizeof(u64_t) +
+                           header.instruction_count * sizeof(SlimBytecodeInstruction) +
+                           header.section_count * sizeof(SlimBytecodeSection);
+    for (u32_t i = 0; i < header.string_count; i++) {
+        SlimBytecodeCacheString cached;
+        memcpy(&cached, string_entries + i * sizeof(cached), sizeof(cached));
+        if (cached.offset > header.string_bytes || cached.length > header.string_bytes - cached.offset) goto mismatch;
+    }
+
+    // Reserving up front keeps an allocation failure from leaving a half restored table behind
+    if (SlimBytecodeConstantVector_reserve(&table->constants, header.constant_count) != SL_ERROR_NONE ||
+        SlimBytecodeInstructionVector_reserve(&table->instructions, header.instruction_count) != SL_ERROR_NONE ||
+        SlimBytecodeSectionVector_reserve(&table->sections, header.section_count) != SL_ERROR_NONE ||
+        SlimBytecodeStringVector_reserve(&table->strings, header.string_count) != SL_ERROR_NONE ||
+        SlimBytecodeNativeVector_reserve(&table->natives, header.native_count) != SL_ERROR_NONE) {
+        goto mismatch;
+    }
+
+    // Native names are copied into the arena as one block, with every name null-terminated inside it
+    char* native_names = NULL;
+    if (header.native_count > 0) {
+        native_names = slim_arena_allocate(table->arena, header.native_bytes);
+        if (native_names == NULL) goto mismatch;
+    }
+
+    char* string_data = malloc(header.sizes[2] + 1);
+    if (string_data == NULL) goto mismatch;
+
+    // The symbol table is cheap to read and points into its own buffer, so it is parsed again from the image.  It is
+    // the last thing that can fail, and a failure takes the symbols back out again.
+    table->symbol_size = header.sizes[5];
+    table->symbol_offset = header.offsets[5];
+    if (slim_bytecode_table_load_data_symbol(table, data) != SL_ERROR_NONE) {
+        free(table->symbol_data);
+        table->symbol_data = NULL;
+        table->symbol_displacements.size = 0;
+        table->symbols.size = 0;
+        table->symbol_size = 0;
+        table->symbol_offset = 0;
+        free(string_data);
+        goto mismatch;
+    }
+
+    u8_t* cursor = mapping + sizeof(header);
+
+    table->header_size = header.sizes[0];
+    table->native_size = header.sizes[1];
+    table->string_size = header.sizes[2];
+    table->constant_size = header.sizes[3];
+    table->section_size = header.sizes[4];
+    table->instruction_size = header.sizes[6];
+
+    table->header_offset = header.offsets[0];
+    table->native_offset = header.offsets[1];
+    table->string_offset = header.offsets[2];
+    table->constant_offset = header.offsets[3];
+    table->section_offset = header.offsets[4];
+    table->instruction_offset = header.offsets[6];
+
+    SlimBytecodeConstantVector_append_many(&table->constants, (const u64_t*)cursor, header.constant_count);
+    cursor += header.constant_count * sizeof(u64_t);
+
+    SlimBytecodeInstructionVector_append_many(
+        &table->instructions, (const SlimBytecodeInstruction*)cursor, header.instruction_count);
+    cursor += header.instruction_count * sizeof(SlimBytecodeInstruction);
+
+    SlimBytecodeSectionVector_append_many(&table->sections, (const SlimBytecodeSection*)cursor, header.section_count);
+    cursor += header.section_count * sizeof(SlimBytecodeSection);
+    table->unloaded_sections = 0;
+    for (u32_t i = 0; i < header.section_count; i++) {
+        if (!table->sections.data[i].loaded) table->unloaded_sections++;
+    }
+    cursor += header.string_count * sizeof(SlimBytecodeCacheString);
+
+    free(table->string_data);
+    table->string_data = string_data;
+    memcpy(table->string_data, cursor, header.string_bytes);
+    cursor += header.string_bytes;
+
+    for (u32_t i = 0; i < header.string_count; i++) {
+        SlimBytecodeCacheString cached;
+        memcpy(&cached, string_entries + i * sizeof(cached), sizeof(cached));
+
+        SlimBytecodeString string;
+        string.data = table->string_data + cached.offset;
+        string.length = cached.length;
+        string.hash = cached.hash;
+        SlimBytecodeStringVector_append(&table->strings, string);
+    }
+
+    if (header.native_count > 0) {
+        memcpy(native_names, cursor, header.native_bytes);
+        native_names[header.native_bytes - 1] = '\0';
+        cursor += header.native_bytes;
+    }
+
+    for (u32_t i = 0, offset = 0; i < header.native_count && offset < header.native_bytes; i++) {
+        char* native = native_names + offset;
+        offset += strlen(native) + 1;
+        SlimBytecodeNativeVector_append(&table->natives, native);
+    }
+
+    if (header.lazy) ___slim_bytecode_table_reference_source(table, data);
+
+    table->source_hash = source_hash;
+    table->source_size = data->size;
+    table->dirty = 0;
+
+    slim_file_unmap(mapping, size);
+    return SL_ERROR_NONE;
+
+mismatch:
+    slim_file_unmap(mapping, size);
+    return SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_bytecode_cache_store(const char* directory, SlimBytecodeTable table)
+{
+    if (!table->dirty) return SL_ERROR_NONE;
+
+    char path[4096];
+    SlimError error = ___slim_bytecode_cache_path(directory, table->source_hash, path, sizeof(path));
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimBytecodeCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SLIM_BYTECODE_CACHE_MAGIC;
+    header.version = SLIM_BYTECODE_CACHE_VERSION;
+    header.build_id = ___slim_bytecode_cache_build_id();
+    header.source_hash = table->source_hash;
+    header.source_size = table->source_size;
+
+    u32_t sizes[7] = {table->header_size, table->native_size, table->string_size, table->constant_size,
+        table->section_size, table->symbol_size, table->instruction_size};
+    u32_t offsets[7] = {table->header_offset, table->native_offset, table->string_offset, table->constant_offset,
+        table->section_offset, table->symbol_offset, table->instruction_offset};
+    memcpy(header.sizes, sizes, sizeof(sizes));
+    memcpy(header.offsets, offsets, sizeof(offsets));
+
+    header.native_count = table->natives.size;
+    header.string_count = table->strings.size;
+    header.constant_count = table->constants.size;
+    header.section_count = table->sections.size;
+    header.instruction_count = table->instructions.size;
+    header.lazy = table->source != NULL;
+
+    for (u32_t i = 0; i < header.native_count; i++) {
+        header.native_bytes += strlen(table->natives.data[i]) + 1;
+    }
+
+    for (u32_t i = 0; i < header.string_count; i++) {
+        header.string_bytes += table->strings.data[i].length + 1;
+    }
+
+    u64_t size = sizeof(header) + ___slim_bytecode_cache_payload_size(&header);
+    if (size > 0xFFFFFFFF) return SLIM_ERROR;
+
+    u8_t* buffer = malloc(size);
+    if (buffer == NULL) return SLIM_ERROR;
+
+    u8_t* cursor = buffer;
+    memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+
+    memcpy(cursor, table->constants.data, header.constant_count * sizeof(u64_t));
+    cursor += header.constant_count * sizeof(u64_t);
+
+    memcpy(cursor, table->instructions.data, header.instruction_count * sizeof(SlimBytecodeInstruction));
+    cursor += header.instruction_count * sizeof(SlimBytecodeInstruction);
+
+    memcpy(cursor, table->sections.data, header.section_count * sizeof(SlimBytecodeSection));
+    cursor += header.section_count * sizeof(SlimBytecodeSection);
+
+    for (u32_t i = 0; i < header.string_count; i++) {
+        SlimBytecodeString* string = &table->strings.data[i];
+
+        SlimBytecodeCacheString cached;
+        cached.offset = string->data - table->string_data;
+        cached.length = string->length;
+        cached.hash = string->hash;
+        memcpy(cursor, &cached, sizeof(cached));
+        cursor += sizeof(cached);
+    }
+
+    memcpy(cursor, table->string_data, header.string_bytes);
+    cursor += header.string_bytes;
+
+    for (u32_t i = 0; i < header.native_count; i++) {
+        char* native = table->natives.data[i];
+        u32_t length = strlen(native) + 1;
+        memcpy(cursor, native, length);
+        cursor += length;
+    }
+
+    error = slim_file_write(path, buffer, size);
+    free(buffer);
+
+    if (error == SL_ERROR_NONE) table->dirty = 0;
+
+    return error;
+}
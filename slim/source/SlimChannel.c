@@ -0,0 +1,295 @@
+#include <SlimChannel.h>
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+#define SLIM_CHANNEL_CACHE_LINE 64
+#define SLIM_CHANNEL_MAX_CAPACITY (1u << 24)
+#define SLIM_CHANNEL_TABLE_SIZE 1024
+// ---------------------------------------------------------------------------------------------------------------------
+// MPMC channels use Vyukov's bounded queue.  A cell's sequence says whose turn it is: position when it is free for the
+// sender that claimed position, position + 1 once it holds that sender's value.
+typedef struct SlimChannelCell {
+    u64_t sequence;
+    u64_t value;
+} SlimChannelCell;
+
+// head and tail count every value ever received and sent.  They live on separate cache lines so that the two sides
+// only share a line when one of them finds the channel empty or full and has to look at the other.
+struct SlimChannel {
+    _Alignas(SLIM_CHANNEL_CACHE_LINE) u64_t head;
+    u64_t cached_tail; // SPSC only, the receiver's last view of tail
+
+    _Alignas(SLIM_CHANNEL_CACHE_LINE) u64_t tail;
+    u64_t cached_head; // SPSC only, the sender's last view of head
+
+    // Futex words bumped when a value or a free slot shows up, and the number of threads asleep on each
+    _Alignas(SLIM_CHANNEL_CACHE_LINE) u32_t recv_event;
+    u32_t recv_waiters;
+    u32_t send_event;
+    u32_t send_waiters;
+
+    _Alignas(SLIM_CHANNEL_CACHE_LINE) SlimChannelKind kind;
+    u32_t capacity;
+    u64_t mask;
+    u64_t* slots;           // SPSC
+    SlimChannelCell* cells; // MPMC
+};
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimChannel ___slim_channel_table[SLIM_CHANNEL_TABLE_SIZE];
+static pthread_mutex_t ___slim_channel_table_lock = PTHREAD_MUTEX_INITIALIZER;
+// Internal Functions --------------------------------------------------------------------------------------------------
+static void ___slim_channel_futex_wait(u32_t* address, u32_t expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    (void)address;
+    (void)expected;
+    sched_yield();
+#endif
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_channel_futex_wake(u32_t* address)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)address;
+#endif
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// The waiter announces itself before it checks the channel, and the other side makes its change before it checks for
+// waiters, so at least one of them sees the other.  The event is read before the check, so a wake-up that lands between
+// the check and the sleep makes the futex return at once.
+static void ___slim_channel_wait(SlimChannel channel, u32_t* event, u32_t* waiters, u8_t (*ready)(SlimChannel))
+{
+    __atomic_fetch_add(waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    u32_t seen = __atomic_load_n(event, __ATOMIC_SEQ_CST);
+    if (!ready(channel)) ___slim_channel_futex_wait(event, seen);
+
+    __atomic_fetch_sub(waiters, 1, __ATOMIC_SEQ_CST);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_channel_notify(u32_t* event, u32_t* waiters)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiters, __ATOMIC_RELAXED) == 0) return;
+
+    __atomic_fetch_add(event, 1, __ATOMIC_SEQ_CST);
+    ___slim_channel_futex_wake(event);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static u8_t ___slim_channel_recv_ready(SlimChannel channel)
+{
+    u64_t head = __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE);
+    if (channel->kind == SLIM_CHANNEL_SPSC) return __atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE) != head;
+
+    u64_t sequence = __atomic_load_n(&channel->cells[head & channel->mask].sequence, __ATOMIC_ACQUIRE);
+    return (s64_t)(sequence - (head + 1)) >= 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static u8_t ___slim_channel_send_ready(SlimChannel channel)
+{
+    u64_t tail = __atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE);
+    if (channel->kind == SLIM_CHANNEL_SPSC) {
+        return tail - __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE) < channel->capacity;
+    }
+
+    u64_t sequence = __atomic_load_n(&channel->cells[tail & channel->mask].sequence, __ATOMIC_ACQUIRE);
+    return (s64_t)(sequence - tail) >= 0;
+}
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_channel_create(SlimChannelKind kind, u32_t capacity, SlimChannel* channel)
+{
+    if (kind != SLIM_CHANNEL_SPSC && kind != SLIM_CHANNEL_MPMC) return SLIM_ERROR;
+    if (capacity == 0 || capacity > SLIM_CHANNEL_MAX_CAPACITY) return SLIM_ERROR;
+
+    // The MPMC sequences cannot tell a full cell from a free one with fewer than two cells
+    u32_t rounded = 2;
+    while (rounded < capacity) rounded <<= 1;
+
+    SlimChannel created = aligned_alloc(SLIM_CHANNEL_CACHE_LINE, sizeof(struct SlimChannel));
+    if (created == NULL) return SLIM_ERROR;
+
+    created->head = 0;
+    created->cached_tail = 0;
+    created->tail = 0;
+    created->cached_head = 0;
+    created->recv_event = 0;
+    created->recv_waiters = 0;
+    created->send_event = 0;
+    created->send_waiters = 0;
+    created->kind = kind;
+    created->capacity = rounded;
+    created->mask = rounded - 1;
+    created->slots = NULL;
+    created->cells = NULL;
+
+    if (kind == SLIM_CHANNEL_SPSC) {
+        created->slots = malloc((size_t)rounded * sizeof(u64_t));
+    } else {
+        created->cells = malloc((size_t)rounded * sizeof(SlimChannelCell));
+        for (u32_t i = 0; created->cells != NULL && i < rounded; i++) {
+            created->cells[i].sequence = i;
+            created->cells[i].value = 0;
+        }
+    }
+
+    if (created->slots == NULL && created->cells == NULL) {
+        free(created);
+        return SLIM_ERROR;
+    }
+
+    *channel = created;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_channel_destroy(SlimChannel channel)
+{
+    if (channel == NULL) return;
+
+    free(channel->slots);
+    free(channel->cells);
+    free(channel);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_channel_try_send(SlimChannel channel, u64_t value)
+{
+    if (channel->kind == SLIM_CHANNEL_SPSC) {
+        u64_t tail = __atomic_load_n(&channel->tail, __ATOMIC_RELAXED);
+        if (tail - channel->cached_head >= channel->capacity) {
+            channel->cached_head = __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE);
+            if (tail - channel->cached_head >= channel->capacity) return 0;
+        }
+
+        channel->slots[tail & channel->mask] = value;
+        __atomic_store_n(&channel->tail, tail + 1, __ATOMIC_RELEASE);
+    } else {
+        u64_t position = __atomic_load_n(&channel->tail, __ATOMIC_RELAXED);
+        SlimChannelCell* cell;
+        for (;;) {
+            cell = &channel->cells[position & channel->mask];
+            s64_t difference = (s64_t)(__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - position);
+            if (difference == 0) {
+                if (__atomic_compare_exchange_n(&channel->tail, &position, position + 1, 1, __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return 0;
+            } else {
+                position = __atomic_load_n(&channel->tail, __ATOMIC_RELAXED);
+            }
+        }
+
+        cell->value = value;
+        __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+    }
+
+    ___slim_channel_notify(&channel->recv_event, &channel->recv_waiters);
+    return 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_channel_try_recv(SlimChannel channel, u64_t* value)
+{
+    if (channel->kind == SLIM_CHANNEL_SPSC) {
+        u64_t head = __atomic_load_n(&channel->head, __ATOMIC_RELAXED);
+        if (head == channel->cached_tail) {
+            channel->cached_tail = __atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE);
+            if (head == channel->cached_tail) return 0;
+        }
+
+        *value = channel->slots[head & channel->mask];
+        __atomic_store_n(&channel->head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        u64_t position = __atomic_load_n(&channel->head, __ATOMIC_RELAXED);
+        SlimChannelCell* cell;
+        for (;;) {
+            cell = &channel->cells[position & channel->mask];
+            s64_t difference = (s64_t)(__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - (position + 1));
+            if (difference == 0) {
+                if (__atomic_compare_exchange_n(&channel->head, &position, position + 1, 1, __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return 0;
+            } else {
+                position = __atomic_load_n(&channel->head, __ATOMIC_RELAXED);
+            }
+        }
+
+        *value = cell->value;
+        __atomic_store_n(&cell->sequence, position + channel->mask + 1, __ATOMIC_RELEASE);
+    }
+
+    ___slim_channel_notify(&channel->send_event, &channel->send_waiters);
+    return 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_channel_wait_send(SlimChannel channel)
+{
+    ___slim_channel_wait(channel, &channel->send_event, &channel->send_waiters, ___slim_channel_send_ready);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_channel_wait_recv(SlimChannel channel)
+{
+    ___slim_channel_wait(channel, &channel->recv_event, &channel->recv_waiters, ___slim_channel_recv_ready);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u32_t slim_channel_get_capacity(SlimChannel channel) { return channel->capacity; }
+// Channel Handles -----------------------------------------------------------------------------------------------------
+// Slots are only filled under the lock, and lookups read them without it.  A handle is its slot plus one.
+SlimError slim_channel_table_insert(SlimChannel channel, u64_t* handle)
+{
+    pthread_mutex_lock(&___slim_channel_table_lock);
+
+    SlimError error = SLIM_ERROR;
+    for (u32_t i = 0; i < SLIM_CHANNEL_TABLE_SIZE; i++) {
+        if (___slim_channel_table[i] == NULL) {
+            __atomic_store_n(&___slim_channel_table[i], channel, __ATOMIC_RELEASE);
+            *handle = (u64_t)i + 1;
+            error = SL_ERROR_NONE;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&___slim_channel_table_lock);
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_channel_table_lookup(u64_t handle, SlimChannel* channel)
+{
+    if (handle == 0 || handle > SLIM_CHANNEL_TABLE_SIZE) return SLIM_ERROR;
+
+    SlimChannel found = __atomic_load_n(&___slim_channel_table[handle - 1], __ATOMIC_ACQUIRE);
+    if (found == NULL) return SLIM_ERROR;
+
+    *channel = found;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_channel_table_clear()
+{
+    pthread_mutex_lock(&___slim_channel_table_lock);
+
+    for (u32_t i = 0; i < SLIM_CHANNEL_TABLE_SIZE; i++) {
+        slim_channel_destroy(___slim_channel_table[i]);
+        __atomic_store_n(&___slim_channel_table[i], NULL, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&___slim_channel_table_lock);
+}
+// ---------------------------------------------------------------------------------------------------------------------
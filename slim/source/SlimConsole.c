@@ -0,0 +1,176 @@
+#include <SlimConsole.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+struct SlimConsoleBuffer {
+    u32_t size;
+    u8_t data[SLIM_CONSOLE_BUFFER_SIZE];
+};
+
+// The console is process-wide.  The output lock is held for the whole of a flush so flushes never interleave, the
+// input lock guards the shared input buffer.
+static pthread_mutex_t ___slim_console_output_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t ___slim_console_input_lock = PTHREAD_MUTEX_INITIALIZER;
+static s32_t ___slim_console_output = STDOUT_FILENO;
+static s32_t ___slim_console_input = STDIN_FILENO;
+static s8_t ___slim_console_interactive = -1; // -1 until it is first asked for
+
+static u8_t ___slim_console_input_data[SLIM_CONSOLE_INPUT_SIZE];
+static u32_t ___slim_console_input_start = 0;
+static u32_t ___slim_console_input_end = 0;
+static u8_t ___slim_console_input_closed = 0;
+// Internal Functions --------------------------------------------------------------------------------------------------
+static SlimError ___slim_console_write_all(const u8_t* data, u32_t size)
+{
+    // Whatever stdio still holds goes first, the log and the host write through it
+    if (___slim_console_output == STDOUT_FILENO) fflush(stdout);
+
+    while (size > 0) {
+        ssize_t written = write(___slim_console_output, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return SLIM_ERROR;
+        }
+        data += written;
+        size -= (u32_t)written;
+    }
+
+    return SL_ERROR_NONE;
+}
+// External API --------------------------------------------------------------------------------------------------------
+void slim_console_redirect(s32_t output, s32_t input)
+{
+    pthread_mutex_lock(&___slim_console_output_lock);
+    if (output >= 0) {
+        ___slim_console_output = output;
+        ___slim_console_interactive = -1;
+    }
+    pthread_mutex_unlock(&___slim_console_output_lock);
+
+    pthread_mutex_lock(&___slim_console_input_lock);
+    if (input >= 0) ___slim_console_input = input;
+    ___slim_console_input_start = 0;
+    ___slim_console_input_end = 0;
+    ___slim_console_input_closed = 0;
+    pthread_mutex_unlock(&___slim_console_input_lock);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+s32_t slim_console_get_input() { return __atomic_load_n(&___slim_console_input, __ATOMIC_RELAXED); }
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_console_get_interactive()
+{
+    s8_t interactive = __atomic_load_n(&___slim_console_interactive, __ATOMIC_RELAXED);
+    if (interactive >= 0) return (u8_t)interactive;
+
+    const char* forced = getenv("SLIM_CONSOLE_INTERACTIVE");
+    interactive = forced != NULL ? strtoul(forced, NULL, 10) != 0 : isatty(___slim_console_output) == 1;
+    __atomic_store_n(&___slim_console_interactive, interactive, __ATOMIC_RELAXED);
+    return (u8_t)interactive;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_console_set_interactive(u8_t interactive)
+{
+    __atomic_store_n(&___slim_console_interactive, (s8_t)(interactive != 0), __ATOMIC_RELAXED);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_console_buffer_create(SlimConsoleBuffer* buffer)
+{
+    SlimConsoleBuffer created = malloc(sizeof(struct SlimConsoleBuffer));
+    if (created == NULL) return SLIM_ERROR;
+
+    created->size = 0;
+    *buffer = created;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_console_buffer_destroy(SlimConsoleBuffer buffer)
+{
+    if (buffer == NULL) return;
+
+    slim_console_flush(buffer);
+    free(buffer);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_console_write(SlimConsoleBuffer buffer, const void* data, u32_t size)
+{
+    const u8_t* bytes = data;
+
+    // Writes too large to ever fit go straight out behind what is already buffered
+    if (size >= SLIM_CONSOLE_BUFFER_SIZE) {
+        pthread_mutex_lock(&___slim_console_output_lock);
+        SlimError error = ___slim_console_write_all(buffer->data, buffer->size);
+        if (error == SL_ERROR_NONE) error = ___slim_console_write_all(bytes, size);
+        pthread_mutex_unlock(&___slim_console_output_lock);
+
+        buffer->size = 0;
+        return error;
+    }
+
+    if (buffer->size + size > SLIM_CONSOLE_BUFFER_SIZE) {
+        SlimError error = slim_console_flush(buffer);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    memcpy(buffer->data + buffer->size, bytes, size);
+    buffer->size += size;
+
+    if (slim_console_get_interactive() && memchr(bytes, '\n', size) != NULL) return slim_console_flush(buffer);
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_console_flush(SlimConsoleBuffer buffer)
+{
+    if (buffer->size == 0) return SL_ERROR_NONE;
+
+    pthread_mutex_lock(&___slim_console_output_lock);
+    SlimError error = ___slim_console_write_all(buffer->data, buffer->size);
+    pthread_mutex_unlock(&___slim_console_output_lock);
+
+    buffer->size = 0;
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_console_try_read(s32_t* byte)
+{
+    u8_t taken = 1;
+
+    pthread_mutex_lock(&___slim_console_input_lock);
+    if (___slim_console_input_start < ___slim_console_input_end) {
+        *byte = ___slim_console_input_data[___slim_console_input_start++];
+    } else if (___slim_console_input_closed) {
+        *byte = -1;
+    } else {
+        taken = 0;
+    }
+    pthread_mutex_unlock(&___slim_console_input_lock);
+
+    return taken;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_console_fill()
+{
+    SlimError error = SL_ERROR_NONE;
+
+    pthread_mutex_lock(&___slim_console_input_lock);
+    if (___slim_console_input_start == ___slim_console_input_end && !___slim_console_input_closed) {
+        ssize_t count = read(___slim_console_input, ___slim_console_input_data, SLIM_CONSOLE_INPUT_SIZE);
+        if (count > 0) {
+            ___slim_console_input_start = 0;
+            ___slim_console_input_end = (u32_t)count;
+        } else if (count == 0) {
+            ___slim_console_input_closed = 1;
+        } else if (errno != EINTR && errno != EAGAIN) {
+            error = SLIM_ERROR;
+        }
+    }
+    pthread_mutex_unlock(&___slim_console_input_lock);
+
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -9,7 +9,7 @@ struct SlimVector {
 
 SlimVector slim_vector_create(u32_t element_size)
 {
-    SlimVector vector = malloc(sizeof(SlimVector));
+    SlimVector vector = malloc(sizeof(struct SlimVector));
     vector->size = 0;
     vector->capacity = 0;
     vector->element_size = element_size;
@@ -27,14 +27,7 @@ void slim_vector_destroy(SlimVector vector, void (*destructor)(void*))
         }
     }
 
-
-    if (vector->data != NULL) {
-        printf("freeing vector data\n");
-        free(vector->data);
-    }
-    
-    printf("freeing vector\n");
-
+    free(vector->data);
     free(vector);
     vector = NULL;
 }
@@ -87,8 +80,114 @@ void slim_vector_access(SlimVector vector, u32_t index, void* element)
     memcpy(element, vector->data + index * vector->element_size, vector->element_size);
 }
 
+// Copies the data from the element over the existing element at index
+void slim_vector_assign(SlimVector vector, u32_t index, void* element)
+{
+    assert(vector != NULL);
+    assert(element != NULL);
+    assert(index < vector->size);
+    memcpy(vector->data + index * vector->element_size, element, vector->element_size);
+}
+
 u32_t slim_vector_size(SlimVector vector)
 {
     assert(vector != NULL);
     return vector->size;
-}
\ No newline at end of file
+}
+
+// Grows or shrinks the vector to size elements, new elements are zeroed
+void slim_vector_resize(SlimVector vector, u32_t size)
+{
+    assert(vector != NULL);
+    if (size > vector->capacity) {
+        vector->capacity = size;
+        vector->data = realloc(vector->data, vector->capacity * vector->element_size);
+    }
+    if (size > vector->size) {
+        memset(vector->data + vector->size * vector->element_size, 0, (size - vector->size) * vector->element_size);
+    }
+    vector->size = size;
+}
+
+// Arenas --------------------------------------------------------------------------------------------------------------
+#define SLIM_ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+#define SLIM_ARENA_ALIGNMENT 8
+
+typedef struct SlimArenaChunk {
+    struct SlimArenaChunk* next;
+    u32_t size;
+    u32_t used;
+    u8_t data[];
+} SlimArenaChunk;
+
+struct SlimArena {
+    SlimArenaChunk* chunks; // Most recent chunk first, only the head is allocated from
+    u32_t chunk_size;
+};
+
+SlimArena slim_arena_create(u32_t chunk_size)
+{
+    SlimArena arena = malloc(sizeof(struct SlimArena));
+    arena->chunks = NULL;
+    arena->chunk_size = chunk_size != 0 ? chunk_size : SLIM_ARENA_DEFAULT_CHUNK_SIZE;
+    return arena;
+}
+
+void slim_arena_destroy(SlimArena arena)
+{
+    if (arena == NULL) return;
+
+    SlimArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL) {
+        SlimArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    free(arena);
+}
+
+// Returns 8 byte aligned memory that stays valid until the arena is destroyed, or NULL when out of memory
+void* slim_arena_allocate(SlimArena arena, u32_t size)
+{
+    assert(arena != NULL);
+
+    u32_t aligned = (size + SLIM_ARENA_ALIGNMENT - 1) & ~(u32_t)(SLIM_ARENA_ALIGNMENT - 1);
+    if (aligned < size) return NULL;
+
+    SlimArenaChunk* head = arena->chunks;
+    if (head != NULL && head->size - head->used >= aligned) {
+        void* memory = head->data + head->used;
+        head->used += aligned;
+        return memory;
+    }
+
+    // Oversized requests get a chunk of their own behind the head, so the space left in the head is not wasted
+    u32_t chunk_size = aligned > arena->chunk_size ? aligned : arena->chunk_size;
+    SlimArenaChunk* chunk = malloc(sizeof(SlimArenaChunk) + chunk_size);
+    if (chunk == NULL) return NULL;
+
+    chunk->size = chunk_size;
+    chunk->used = aligned;
+
+    if (head != NULL && aligned > arena->chunk_size) {
+        chunk->next = head->next;
+        head->next = chunk;
+    } else {
+        chunk->next = head;
+        arena->chunks = chunk;
+    }
+
+    return chunk->data;
+}
+
+// Copies length bytes of data and appends a null terminator
+char* slim_arena_copy_string(SlimArena arena, const char* data, u32_t length)
+{
+    char* copy = slim_arena_allocate(arena, length + 1);
+    if (copy == NULL) return NULL;
+
+    memcpy(copy, data, length);
+    copy[length] = '\0';
+    return copy;
+}
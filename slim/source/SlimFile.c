@@ -3,6 +3,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 SlimError slim_file_read(const char* filename, u8_t **data, u32_t *size) {
     FILE *file = fopen(filename, "rb");
 
@@ -21,4 +26,58 @@ SlimError slim_file_read(const char* filename, u8_t **data, u32_t *size) {
     fclose(file);
 
     return SL_ERROR_NONE;
+}
+
+SlimError slim_file_write(const char* filename, const u8_t* data, u32_t size) {
+    char temporary[4096];
+    if (snprintf(temporary, sizeof(temporary), "%s.%d.tmp", filename, (int)getpid()) >= (int)sizeof(temporary)) {
+        return SLIM_ERROR;
+    }
+
+    FILE *file = fopen(temporary, "wb");
+
+    if (file == NULL) {
+        return SLIM_ERROR;
+    }
+
+    u32_t written = fwrite(data, 1, size, file);
+
+    if (fclose(file) != 0 || written != size || rename(temporary, filename) != 0) {
+        remove(temporary);
+        return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+
+SlimError slim_file_map(const char* filename, u8_t **data, u32_t *size) {
+    int descriptor = open(filename, O_RDONLY);
+
+    if (descriptor < 0) {
+        return SLIM_ERROR;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+        close(descriptor);
+        return SLIM_ERROR;
+    }
+
+    void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (mapping == MAP_FAILED) {
+        return SLIM_ERROR;
+    }
+
+    *data = mapping;
+    *size = status.st_size;
+
+    return SL_ERROR_NONE;
+}
+
+void slim_file_unmap(u8_t *data, u32_t size) {
+    if (data == NULL) return;
+
+    munmap(data, size);
 }
\ No newline at end of file
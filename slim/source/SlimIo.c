@@ -0,0 +1,463 @@
+#include <SlimIo.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define SLIM_IO_HAS_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#else
+#define SLIM_IO_HAS_URING 0
+#endif
+
+#define SLIM_IO_RING_ENTRIES 256
+#define SLIM_IO_WORKERS 4
+// ---------------------------------------------------------------------------------------------------------------------
+#if SLIM_IO_HAS_URING
+// The rings are shared with the kernel.  We own the submission tail and the completion head, the kernel the others.
+typedef struct SlimIoRing {
+    int descriptor;
+    u32_t in_flight;   // handed to the kernel and not yet completed
+    u32_t unsubmitted; // in the submission ring, but io_uring_enter did not take them yet
+
+    void* sq_ring;
+    size_t sq_ring_size;
+    u32_t sq_entries;
+    u32_t* sq_head;
+    u32_t* sq_tail;
+    u32_t* sq_mask;
+    u32_t* sq_array;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    void* cq_ring;
+    size_t cq_ring_size;
+    u32_t cq_entries;
+    u32_t* cq_head;
+    u32_t* cq_tail;
+    u32_t* cq_mask;
+    struct io_uring_cqe* cqes;
+} SlimIoRing;
+#endif
+
+struct SlimIo {
+    SlimIoBackend backend;
+    int event;     // eventfd, readable while there is something to reap
+    u32_t pending; // submitted and not yet reaped
+
+    // Submitted and not yet flushed
+    SlimIoRequest* queued_head;
+    SlimIoRequest* queued_tail;
+
+#if SLIM_IO_HAS_URING
+    SlimIoRing ring;
+#endif
+
+    // The thread backend.  Flushed requests wait in the work queue for a worker, finished ones in the done list.
+    pthread_t workers[SLIM_IO_WORKERS];
+    u32_t worker_count;
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+    SlimIoRequest* work_head;
+    SlimIoRequest* work_tail;
+    SlimIoRequest* done;
+    u8_t stopping;
+};
+// Internal Functions --------------------------------------------------------------------------------------------------
+static void ___slim_io_append(SlimIoRequest** head, SlimIoRequest** tail, SlimIoRequest* request)
+{
+    request->next = NULL;
+    if (*tail != NULL) {
+        (*tail)->next = request;
+    } else {
+        *head = request;
+    }
+    *tail = request;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_io_signal(SlimIo io)
+{
+    u64_t one = 1;
+    ssize_t written = write(io->event, &one, sizeof(one));
+    (void)written;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_io_clear(SlimIo io)
+{
+    u64_t count;
+    ssize_t got = read(io->event, &count, sizeof(count));
+    (void)got;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_io_execute(SlimIoRequest* request)
+{
+    ssize_t result = -1;
+    errno = EINVAL;
+
+    switch (request->operation) {
+    case SLIM_IO_OPEN: result = open(request->path, request->flags, request->mode); break;
+    case SLIM_IO_READ:
+        if (request->offset == (u64_t)-1) {
+            result = read(request->descriptor, request->buffer, request->size);
+        } else {
+            result = pread(request->descriptor, request->buffer, request->size, (off_t)request->offset);
+        }
+        break;
+    case SLIM_IO_WRITE:
+        if (request->offset == (u64_t)-1) {
+            result = write(request->descriptor, request->buffer, request->size);
+        } else {
+            result = pwrite(request->descriptor, request->buffer, request->size, (off_t)request->offset);
+        }
+        break;
+    case SLIM_IO_CLOSE: result = close(request->descriptor); break;
+    }
+
+    request->result = result < 0 ? -(s64_t)errno : (s64_t)result;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void* ___slim_io_worker(void* argument)
+{
+    SlimIo io = argument;
+
+    pthread_mutex_lock(&io->lock);
+    for (;;) {
+        while (io->work_head == NULL && !io->stopping) pthread_cond_wait(&io->available, &io->lock);
+        if (io->work_head == NULL) break;
+
+        SlimIoRequest* request = io->work_head;
+        io->work_head = request->next;
+        if (io->work_head == NULL) io->work_tail = NULL;
+
+        pthread_mutex_unlock(&io->lock);
+        ___slim_io_execute(request);
+        pthread_mutex_lock(&io->lock);
+
+        request->next = io->done;
+        io->done = request;
+        ___slim_io_signal(io);
+    }
+    pthread_mutex_unlock(&io->lock);
+
+    return NULL;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_io_threads_create(SlimIo io)
+{
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_cond_init(&io->available, NULL);
+
+    for (u32_t i = 0; i < SLIM_IO_WORKERS; i++) {
+        if (pthread_create(&io->workers[i], NULL, ___slim_io_worker, io) != 0) break;
+        io->worker_count++;
+    }
+
+    return io->worker_count > 0 ? SL_ERROR_NONE : SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#if SLIM_IO_HAS_URING
+static SlimError ___slim_io_uring_create(SlimIo io)
+{
+    SlimIoRing* ring = &io->ring;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring->descriptor = (int)syscall(__NR_io_uring_setup, SLIM_IO_RING_ENTRIES, &params);
+    if (ring->descriptor < 0) return SLIM_ERROR;
+
+    // Reads and writes at the file position need 5.6, which also brought OPENAT and CLOSE
+    u32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+    if ((params.features & required) != required) return SLIM_ERROR;
+
+    ring->sq_entries = params.sq_entries;
+    ring->cq_entries = params.cq_entries;
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32_t);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+    ring->cq_ring_size = 0;
+
+    // With a single mmap both rings live in the same mapping
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor,
+                         IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        return SLIM_ERROR;
+    }
+    ring->cq_ring = ring->sq_ring;
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor,
+                      IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        return SLIM_ERROR;
+    }
+
+    u8_t* sq = ring->sq_ring;
+    ring->sq_head = (u32_t*)(sq + params.sq_off.head);
+    ring->sq_tail = (u32_t*)(sq + params.sq_off.tail);
+    ring->sq_mask = (u32_t*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (u32_t*)(sq + params.sq_off.array);
+
+    u8_t* cq = ring->cq_ring;
+    ring->cq_head = (u32_t*)(cq + params.cq_off.head);
+    ring->cq_tail = (u32_t*)(cq + params.cq_off.tail);
+    ring->cq_mask = (u32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    // Completions signal the eventfd, so the engine can be watched like any other descriptor
+    if (syscall(__NR_io_uring_register, ring->descriptor, IORING_REGISTER_EVENTFD, &io->event, 1) != 0) {
+        return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_io_uring_destroy(SlimIo io)
+{
+    SlimIoRing* ring = &io->ring;
+    if (ring->sqes != NULL) munmap(ring->sqes, ring->sqes_size);
+    if (ring->sq_ring != NULL) munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->descriptor >= 0) close(ring->descriptor);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_io_uring_prepare(struct io_uring_sqe* sqe, SlimIoRequest* request)
+{
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (u64_t)(uintptr_t)request;
+
+    switch (request->operation) {
+    case SLIM_IO_OPEN:
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (u64_t)(uintptr_t)request->path;
+        sqe->len = request->mode;
+        sqe->open_flags = (u32_t)request->flags;
+        break;
+    case SLIM_IO_READ:
+    case SLIM_IO_WRITE:
+        sqe->opcode = request->operation == SLIM_IO_READ ? IORING_OP_READ : IORING_OP_WRITE;
+        sqe->fd = request->descriptor;
+        sqe->addr = (u64_t)(uintptr_t)request->buffer;
+        sqe->len = request->size;
+        sqe->off = request->offset;
+        break;
+    case SLIM_IO_CLOSE:
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = request->descriptor;
+        break;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_io_uring_flush(SlimIo io)
+{
+    SlimIoRing* ring = &io->ring;
+
+    // Never put more in flight than the completion ring holds
+    u32_t tail = *ring->sq_tail;
+    while (io->queued_head != NULL && ring->in_flight < ring->cq_entries &&
+           tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) < ring->sq_entries) {
+        SlimIoRequest* request = io->queued_head;
+        io->queued_head = request->next;
+        if (io->queued_head == NULL) io->queued_tail = NULL;
+
+        u32_t index = tail & *ring->sq_mask;
+        ___slim_io_uring_prepare(&ring->sqes[index], request);
+        ring->sq_array[index] = index;
+        tail++;
+
+        ring->in_flight++;
+        ring->unsubmitted++;
+    }
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+    while (ring->unsubmitted > 0) {
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->descriptor, ring->unsubmitted, 0, 0, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            // Out of kernel resources, whatever is left goes with the next flush
+            if (errno == EAGAIN || errno == EBUSY) return SL_ERROR_NONE;
+            return SLIM_ERROR;
+        }
+        ring->unsubmitted -= (u32_t)submitted;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static u32_t ___slim_io_uring_reap(SlimIo io, SlimIoRequest** completed, u32_t capacity)
+{
+    SlimIoRing* ring = &io->ring;
+
+    u32_t count = 0;
+    u32_t head = *ring->cq_head;
+    u32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && count < capacity) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        SlimIoRequest* request = (SlimIoRequest*)(uintptr_t)cqe->user_data;
+        request->result = cqe->res;
+        completed[count++] = request;
+        head++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    ring->in_flight -= count;
+    return count;
+}
+#endif
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_io_create(SlimIoBackend backend, SlimIo* io)
+{
+    const char* forced = getenv("SLIM_IO_BACKEND");
+    if (backend == SLIM_IO_BACKEND_AUTO && forced != NULL && strcmp(forced, "threads") == 0) {
+        backend = SLIM_IO_BACKEND_THREADS;
+    }
+
+    SlimIo created = calloc(1, sizeof(struct SlimIo));
+    if (created == NULL) return SLIM_ERROR;
+
+    created->event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (created->event < 0) {
+        free(created);
+        return SLIM_ERROR;
+    }
+
+    SlimError error = SLIM_ERROR;
+
+#if SLIM_IO_HAS_URING
+    created->ring.descriptor = -1;
+    if (backend != SLIM_IO_BACKEND_THREADS) {
+        error = ___slim_io_uring_create(created);
+        if (error == SL_ERROR_NONE) {
+            created->backend = SLIM_IO_BACKEND_URING;
+        } else {
+            ___slim_io_uring_destroy(created);
+            memset(&created->ring, 0, sizeof(created->ring));
+            created->ring.descriptor = -1;
+        }
+    }
+#endif
+
+    if (error != SL_ERROR_NONE && backend != SLIM_IO_BACKEND_URING) {
+        error = ___slim_io_threads_create(created);
+        created->backend = SLIM_IO_BACKEND_THREADS;
+    }
+
+    if (error != SL_ERROR_NONE) {
+        slim_io_destroy(created);
+        return error;
+    }
+
+    *io = created;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_io_destroy(SlimIo io)
+{
+    if (io == NULL) return;
+
+    SlimIoRequest* discarded[SLIM_IO_RING_ENTRIES];
+
+#if SLIM_IO_HAS_URING
+    if (io->backend == SLIM_IO_BACKEND_URING) {
+        while (io->queued_head != NULL || io->ring.in_flight > 0) {
+            if (___slim_io_uring_flush(io) != SL_ERROR_NONE) break;
+            syscall(__NR_io_uring_enter, io->ring.descriptor, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            ___slim_io_uring_reap(io, discarded, SLIM_IO_RING_ENTRIES);
+        }
+    }
+    ___slim_io_uring_destroy(io);
+#endif
+
+    if (io->worker_count > 0) {
+        // The workers drain the queue before they look at stopping
+        slim_io_flush(io);
+        pthread_mutex_lock(&io->lock);
+        io->stopping = 1;
+        pthread_cond_broadcast(&io->available);
+        pthread_mutex_unlock(&io->lock);
+
+        for (u32_t i = 0; i < io->worker_count; i++) pthread_join(io->workers[i], NULL);
+        pthread_mutex_destroy(&io->lock);
+        pthread_cond_destroy(&io->available);
+    }
+
+    close(io->event);
+    free(io);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimIoBackend slim_io_get_backend(SlimIo io) { return io->backend; }
+
+s32_t slim_io_get_descriptor(SlimIo io) { return io->event; }
+
+u32_t slim_io_get_count_pending(SlimIo io) { return io->pending; }
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_io_submit(SlimIo io, SlimIoRequest* request)
+{
+    ___slim_io_append(&io->queued_head, &io->queued_tail, request);
+    io->pending++;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_io_flush(SlimIo io)
+{
+    if (io->queued_head == NULL) return SL_ERROR_NONE;
+
+#if SLIM_IO_HAS_URING
+    if (io->backend == SLIM_IO_BACKEND_URING) return ___slim_io_uring_flush(io);
+#endif
+
+    pthread_mutex_lock(&io->lock);
+    if (io->work_tail != NULL) {
+        io->work_tail->next = io->queued_head;
+    } else {
+        io->work_head = io->queued_head;
+    }
+    io->work_tail = io->queued_tail;
+    pthread_cond_broadcast(&io->available);
+    pthread_mutex_unlock(&io->lock);
+
+    io->queued_head = NULL;
+    io->queued_tail = NULL;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u32_t slim_io_reap(SlimIo io, SlimIoRequest** completed, u32_t capacity)
+{
+    ___slim_io_clear(io);
+
+    u32_t count = 0;
+    u8_t more = 0;
+
+#if SLIM_IO_HAS_URING
+    if (io->backend == SLIM_IO_BACKEND_URING) {
+        count = ___slim_io_uring_reap(io, completed, capacity);
+        more = *io->ring.cq_head != __atomic_load_n(io->ring.cq_tail, __ATOMIC_ACQUIRE);
+    }
+#endif
+
+    if (io->backend == SLIM_IO_BACKEND_THREADS) {
+        pthread_mutex_lock(&io->lock);
+        while (io->done != NULL && count < capacity) {
+            completed[count++] = io->done;
+            io->done = io->done->next;
+        }
+        more = io->done != NULL;
+        pthread_mutex_unlock(&io->lock);
+    }
+
+    // Whatever did not fit keeps the descriptor readable
+    if (more) ___slim_io_signal(io);
+
+    io->pending -= count;
+    slim_io_flush(io);
+    return count;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -1,5 +1,6 @@
 #include <SlimLog.h>
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -13,8 +14,7 @@ struct SlimLogContext {
 // ---------------------------------------------------------------------------------------------------------------------
 SlimLogContext slim_log_create(const char* output_path, u8_t writes_stdout)
 {
-    SlimLogContext slim_log_context = malloc(sizeof(SlimLogContext));
-    slim_log_context = malloc(sizeof(SlimLogContext));
+    SlimLogContext slim_log_context = malloc(sizeof(struct SlimLogContext));
     slim_log_context->output_path = output_path;
     slim_log_context->buffer_index = 0;
     slim_log_context->writes_stdout = writes_stdout;
@@ -44,11 +44,25 @@ void slim_log_printf(SlimLogContext log, const char* format, ...)
         return;
     }
 
+    // A machine now runs many instructions between the flushes of its host, so a message that does not fit flushes the
+    // buffer first instead of running past it.  Messages longer than the whole buffer are cut short.
     va_list args;
     va_start(args, format);
-    log->buffer_index += vsprintf(log->buffer + log->buffer_index, format, args);
+    u32_t space = SLIM_LOG_BUFFER_SIZE - log->buffer_index;
+    s32_t length = vsnprintf(log->buffer + log->buffer_index, space, format, args);
     va_end(args);
 
+    if (length >= 0 && (u32_t)length >= space && log->buffer_index > 0) {
+        slim_log_flush(log);
+        va_start(args, format);
+        length = vsnprintf(log->buffer, SLIM_LOG_BUFFER_SIZE, format, args);
+        va_end(args);
+    }
+    if (length > 0) {
+        u32_t written = log->buffer_index + (u32_t)length;
+        log->buffer_index = written < SLIM_LOG_BUFFER_SIZE ? written : SLIM_LOG_BUFFER_SIZE - 1;
+    }
+
     if (log->writes_stdout) {
         va_list args;
         va_start(args, format);
@@ -56,7 +70,7 @@ void slim_log_printf(SlimLogContext log, const char* format, ...)
         va_end(args);
     }
 
-    if (log->buffer_index > SLIM_LOG_BUFFER_SIZE) {
+    if (log->buffer_index >= SLIM_LOG_BUFFER_SIZE - 1) {
         slim_log_flush(log);
     }
 }
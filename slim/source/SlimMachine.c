@@ -1,21 +1,35 @@
 #include <SlimLog.h>
 #include <SlimMachine.h>
+#include <SlimProfile.h>
+#include <SlimRegister.h>
+#include <SlimThread.h>
+#include <SlimTrace.h>
 
+#include <math.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
-#define SLIM_MACHINE_OPERAND_STACK_SIZE 8
-#define SLIM_MACHINE_CALL_STACK_SIZE 8
+#define SLIM_MACHINE_OPERAND_STACK_SIZE 256
+#define SLIM_MACHINE_CALL_STACK_SIZE 64
 #define SLIM_MACHINE_REGISTERS 4
-#define SLIM_MACHINE_MEMORY_SIZE 16
+#define SLIM_MACHINE_MEMORY_SIZE 4096
 // ---------------------------------------------------------------------------------------------------------------------
-struct SlimMachineFlags {
-    u16_t interrupt : 1; // raised by the bytecode when an interrupt or native function is called
-    u16_t error : 1;     // raised by the bytecode when an error occurs
-    u16_t halt : 1;      // raised by the bytecode when the program is finished
-};
-
+// A frame owns the operand stack from its base pointer upwards.  The first size slots are its locals, addressed by
+// LOADL/STOREL, and everything above them is the frame's working stack.  A call takes the arguments from the top of
+// the caller's stack as the callee's first locals, so they sit at the base pointer and the other locals are zeroed
+// above them.  A function may also consume its arguments like any other values on the stack.  RET cuts the stack back
+// to the return pointer, or leaves it lower when the frame popped below that, and puts the top of the frame there as
+// the result.  The return pointer is the base pointer of the frame as it was first called and stays put across tail
+// calls.
 struct SlimMachineStackFrame {
     u32_t instruction_pointer;
+    u32_t return_pointer;
+    u32_t base_pointer;
     u32_t size;
 };
 
@@ -27,7 +41,7 @@ struct SlimMachineBlock {
 };
 
 struct SlimMachineState {
-    SlimMachineFlags flags;
+    SlimMachineTrap trap;
 
     // We will use a 32-bit address space which is realistically too large.  In order to access the full 32-bits,
     // we will need to implement a page table.  For now, this is entirely ignored.
@@ -35,34 +49,106 @@ struct SlimMachineState {
     u32_t call_stack_pointer;
     u32_t instruction_pointer;
 
+    // Charged at backward jumps by the instructions the jump repeats and at calls by one, so a loop pays for its body
+    // once per iteration.  Running dry raises the yield flag, and the budget is what refuelling restores.
+    s64_t fuel;
+    u64_t fuel_budget; // 0 for unmetered
+    u64_t retired;     // Instructions run so far, brought up to date whenever the dispatch loop is left
+
     // We will use an unsigned 64-bit value to stand in for all values.  It is up to the user to ensure type safety.
     u64_t operand_stack[SLIM_MACHINE_OPERAND_STACK_SIZE];           // The actual values are stored here
     SlimMachineStackFrame call_stack[SLIM_MACHINE_CALL_STACK_SIZE]; // The size of the current call is stored here
     u64_t registers[SLIM_MACHINE_REGISTERS];
 
     SlimMachineBlock* blocks;
-    u64_t memory[SLIM_MACHINE_MEMORY_SIZE];
+    u64_t* memory;
+
+    // Stores outside [writable_start, writable_end) fail.  A PARFOR child shares its parent's memory, but may only
+    // write its own slice of the output, and has no blocks to allocate from.
+    u32_t writable_start;
+    u32_t writable_end;
+    SlimMachineState parent;
+
+    // Set by slim_machine_park, what the machine waits for before the platform runs it again
+    SlimMachineParking parking;
+
+    // Created by the first console native the machine calls
+    SlimConsoleBuffer console;
 
     u8_t* bytecode;
     u32_t bytecode_size;
 
+    // The table being executed, routines use it to resolve constant and string table indices
+    SlimBytecodeTable bytecode_table;
+
     SlimLogContext* log_context;
+
+    // Which interpreter runs the machine, fixed at creation
+    SlimMachineVariant variant;
+    SlimProfile profile;  // PROFILING only
+    u64_t* opcode_counts; // The profile's, kept here so the dispatch loop reaches them directly
 };
 // ---------------------------------------------------------------------------------------------------------------------
 #define slim_machine_except(machine, error)                                                                            \
     {                                                                                                                  \
         if (error != SL_ERROR_NONE) {                                                                                  \
-            machine->flags.error = 1;                                                                                  \
+            ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, error);                                             \
             return;                                                                                                    \
         }                                                                                                              \
     }
+// ---------------------------------------------------------------------------------------------------------------------
+static inline void ___slim_machine_fuel_charge(SlimMachineState machine, u32_t cost)
+{
+    machine->fuel -= cost;
+    if (__builtin_expect(machine->fuel <= 0, 0)) {
+        ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_YIELD, SL_ERROR_NONE);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Every jump of both execution modes goes through here.  The instruction pointer is already past the jump, so a
+// backward jump repeats exactly the instructions between its target and itself.
+static inline void ___slim_machine_jump(SlimMachineState machine, u32_t address)
+{
+    if (address < machine->instruction_pointer) {
+        ___slim_machine_fuel_charge(machine, machine->instruction_pointer - address);
+    }
+    machine->instruction_pointer = address;
+}
 // External API --------------------------------------------------------------------------------------------------------
 SlimMachineState slim_machine_create(SlimLogContext* log_context)
 {
-    SlimMachineState machine = malloc(sizeof(SlimMachineState));
+    u8_t has_log = log_context != NULL && *log_context != NULL;
+    return slim_machine_create_variant(log_context, has_log ? SLIM_MACHINE_VARIANT_TRACING : SLIM_MACHINE_VARIANT_FAST);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimMachineState slim_machine_create_variant(SlimLogContext* log_context, SlimMachineVariant variant)
+{
+    if (variant >= SLIM_MACHINE_VARIANT_COUNT) return NULL;
+
+    SlimMachineState machine = malloc(sizeof(struct SlimMachineState));
+    machine->variant = variant;
+    machine->profile = NULL;
+    machine->opcode_counts = NULL;
+    if (variant == SLIM_MACHINE_VARIANT_PROFILING) {
+        if (slim_profile_create(&machine->profile) != SL_ERROR_NONE) {
+            free(machine);
+            return NULL;
+        }
+        machine->opcode_counts = slim_profile_get_opcode_counts(machine->profile);
+    }
     machine->bytecode = NULL;
     machine->bytecode_size = 0;
+    machine->bytecode_table = NULL;
     machine->blocks = slim_machine_block_create(0, SLIM_MACHINE_MEMORY_SIZE);
+    machine->memory = malloc(SLIM_MACHINE_MEMORY_SIZE * sizeof(u64_t));
+    machine->writable_start = 0;
+    machine->writable_end = SLIM_MACHINE_MEMORY_SIZE;
+    machine->parent = NULL;
+    memset(&machine->parking, 0, sizeof(machine->parking));
+    machine->parking.descriptor = -1;
+    machine->console = NULL;
+    machine->fuel = INT64_MAX;
+    machine->fuel_budget = 0;
     machine->log_context = log_context;
 
     slim_machine_reset(machine);
@@ -81,7 +167,10 @@ void slim_machine_destroy(SlimMachineState machine)
     }
 
     slim_machine_block_destroy(machine->blocks);
+    slim_console_buffer_destroy(machine->console);
 
+    slim_profile_destroy(machine->profile);
+    free(machine->memory);
     free(machine);
     machine = NULL;
 }
@@ -94,6 +183,8 @@ void slim_machine_reset(SlimMachineState machine)
 
     for (u32_t i = 0; i < SLIM_MACHINE_CALL_STACK_SIZE; i++) {
         machine->call_stack[i].instruction_pointer = 0;
+        machine->call_stack[i].return_pointer = 0;
+        machine->call_stack[i].base_pointer = 0;
         machine->call_stack[i].size = 0;
     }
 
@@ -105,31 +196,398 @@ void slim_machine_reset(SlimMachineState machine)
         machine->memory[i] = 0;
     }
 
-    // Reset Flags
-    machine->flags.interrupt = 0;
-    machine->flags.error = 0;
-    machine->flags.halt = 0;
+    // Reset the trap
+    machine->trap = (SlimMachineTrap){SLIM_MACHINE_TRAP_NONE, SL_ERROR_NONE, 0, 0};
 
     // Reset Pointers
     machine->operand_stack_pointer = 0;
     machine->call_stack_pointer = 0;
     machine->instruction_pointer = 0;
+    machine->retired = 0;
 
     // Reset Blocks
     slim_machine_block_destroy(machine->blocks);
     machine->blocks = slim_machine_block_create(0, SLIM_MACHINE_MEMORY_SIZE);
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void slim_machine_step(SlimMachineState machine, SlimBytecodeTable bytecode_table)
+// Opcode Tables -------------------------------------------------------------------------------------------------------
+// Bytes that are no opcode decode to NULL, which execute turns into an error
+static const SlimMachineRoutine ___slim_machine_routines[256] = {
+#define SLIM_OPCODE(name, value, routine, operand) [value] = slim_machine_routine_##routine,
+#include <SlimOpcodeTable.h>
+#undef SLIM_OPCODE
+};
+
+static const char* const ___slim_machine_opcode_names[256] = {
+#define SLIM_OPCODE(name, value, routine, operand) [value] = #name,
+#include <SlimOpcodeTable.h>
+#undef SLIM_OPCODE
+};
+// Instrumentation -----------------------------------------------------------------------------------------------------
+// Both are out of line so the instrumented loops stay as tight as the fast one around them
+__attribute__((noinline)) static void
+___slim_machine_trace(SlimMachineState machine, u32_t address, SlimMachineInstruction instruction, u8_t is_register)
+{
+    slim_log_using_context(machine->log_context);
+
+    // Register opcodes have no names of their own
+    const char* name = is_register ? NULL : slim_machine_opcode_name(instruction.opcode);
+    if (name != NULL) {
+        slim_log_info("[TRACE]\t\t0x%x\t%s 0x%x 0x%x\n", address, name, instruction.arg1, instruction.arg2);
+    } else {
+        slim_log_info("[TRACE]\t\t0x%x\t0x%x 0x%x 0x%x\n", address, instruction.opcode, instruction.arg1,
+                      instruction.arg2);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// The invariants every instruction must leave intact.  Most are only checked where a routine depends on them, so a
+// broken one can go unnoticed for a while and fail far from its cause.  CHECKED traps right after the instruction that
+// broke it instead.  In register mode the operand stack pointer is only brought up to date now and then, so it is left
+// alone there.
+__attribute__((noinline)) static void ___slim_machine_check(SlimMachineState machine, u8_t is_register)
+{
+    slim_log_using_context(machine->log_context);
+
+    const char* broken = NULL;
+    if (machine->call_stack_pointer >= SLIM_MACHINE_CALL_STACK_SIZE) {
+        broken = "call stack pointer out of range";
+    } else {
+        SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+        if (frame->return_pointer > frame->base_pointer) {
+            broken = "frame returns above its base";
+        } else if ((u64_t)frame->base_pointer + frame->size > SLIM_MACHINE_OPERAND_STACK_SIZE) {
+            broken = "frame locals out of range";
+        } else if (!is_register && machine->operand_stack_pointer > SLIM_MACHINE_OPERAND_STACK_SIZE) {
+            broken = "operand stack pointer out of range";
+        } else if (!is_register && machine->operand_stack_pointer < frame->base_pointer) {
+            broken = "frame popped below its base";
+        }
+    }
+
+    // The blocks cover the memory from start to end without gaps or overlaps
+    u32_t covered = 0;
+    for (SlimMachineBlock* block = machine->blocks; broken == NULL && block != NULL; block = block->next) {
+        if (block->start != covered || block->end <= block->start) broken = "memory blocks out of order";
+        covered = block->end;
+    }
+    if (broken == NULL && machine->blocks != NULL && covered != SLIM_MACHINE_MEMORY_SIZE) {
+        broken = "memory blocks do not cover the memory";
+    }
+
+    if (broken != NULL) {
+        slim_log_error("[CHECK]\t\t%s\n", broken);
+        ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, SLIM_ERROR);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Follows the call stack into the profile.  A call or return shows up as the call stack pointer moving, a tail call as
+// it staying where it was on a TAILCALL that did not fail.
+static inline void ___slim_machine_profile(SlimMachineState machine, u32_t depth, u8_t tailcall)
+{
+    if (machine->call_stack_pointer > depth) {
+        slim_profile_enter(machine->profile, machine->instruction_pointer);
+    } else if (machine->call_stack_pointer < depth) {
+        slim_profile_leave(machine->profile);
+    } else if (tailcall && machine->trap.kind != SLIM_MACHINE_TRAP_ERROR) {
+        slim_profile_replace(machine->profile, machine->instruction_pointer);
+    }
+}
+// Dispatch Loops ------------------------------------------------------------------------------------------------------
+// Every interpreter variant is this loop, specialised by a constant variant the compiler folds away.  The FAST variant
+// is left with nothing but fetch, dispatch and the test for a trap.
+__attribute__((always_inline)) static inline void ___slim_machine_dispatch(
+    SlimMachineState machine, SlimBytecodeTable bytecode_table, const u8_t single, const SlimMachineVariant variant)
+{
+    machine->trap.kind = SLIM_MACHINE_TRAP_NONE;
+    machine->bytecode_table = bytecode_table;
+
+    if (variant == SLIM_MACHINE_VARIANT_PROFILING) slim_profile_resume(machine->profile);
+
+    u32_t address;
+    u32_t depth;
+    u64_t retired = 0;
+    SlimMachineInstruction instruction;
+    do {
+        retired++;
+        address = machine->instruction_pointer;
+        depth = machine->call_stack_pointer;
+        instruction = ___slim_machine_fetch(machine, bytecode_table);
+        if (variant == SLIM_MACHINE_VARIANT_TRACING) ___slim_machine_trace(machine, address, instruction, 0);
+        if (variant == SLIM_MACHINE_VARIANT_PROFILING) machine->opcode_counts[instruction.opcode]++;
+        ___slim_machine_execute(machine, ___slim_machine_decode(machine, instruction), instruction);
+        if (variant == SLIM_MACHINE_VARIANT_CHECKED) ___slim_machine_check(machine, 0);
+        if (variant == SLIM_MACHINE_VARIANT_PROFILING) {
+            ___slim_machine_profile(machine, depth, instruction.opcode == SL_OPCODE_TAILCALL);
+        }
+    } while (!single && machine->trap.kind == SLIM_MACHINE_TRAP_NONE);
+
+    if (variant == SLIM_MACHINE_VARIANT_PROFILING) slim_profile_pause(machine->profile);
+
+    // Where it trapped is only worked out once the loop is left, and so is the count of instructions run
+    machine->retired += retired;
+    machine->trap.instruction_pointer = address;
+    machine->trap.opcode = instruction.opcode;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Used to template float arithmetic on registers
+#define ___slim_machine_register_float(destination, a, b, expression)                                                  \
+    {                                                                                                                  \
+        double x = *((double*)&(a));                                                                                   \
+        double y = *((double*)&(b));                                                                                   \
+        double result_double = expression;                                                                             \
+        destination = *((u64_t*)&result_double);                                                                       \
+    }
+// ---------------------------------------------------------------------------------------------------------------------
+// Used to template compare-and-branch on registers
+#define ___slim_machine_register_branch(a, b, type, operation)                                                         \
+    {                                                                                                                  \
+        if (*((type*)&(a)) operation *((type*)&(b))) ___slim_machine_jump(machine, instruction.arg2);                  \
+    }
+// ---------------------------------------------------------------------------------------------------------------------
+// Executes one instruction of a program produced by slim_register_program_translate and returns its opcode.  The
+// instruction pointer counts register instructions and the registers are the current frame's slice of the operand
+// stack, which is only brought up to date at the instructions that leave the frame or hand the stack to someone else.
+__attribute__((always_inline)) static inline u8_t ___slim_machine_register_execute(
+    SlimMachineState machine, SlimRegisterProgram program, const SlimMachineVariant variant)
+{
+    slim_log_using_context(machine->log_context);
+
+    SlimMachineInstruction instruction;
+    SlimError error = slim_register_program_lookup_instruction(program, machine->instruction_pointer, &instruction);
+    if (error != SL_ERROR_NONE) {
+        slim_log_error("[FETCH]\t\tInvalid instruction pointer 0x%x\n", machine->instruction_pointer);
+        ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, error);
+        return 0;
+    }
+
+    if (variant == SLIM_MACHINE_VARIANT_TRACING) {
+        ___slim_machine_trace(machine, machine->instruction_pointer, instruction, 1);
+    }
+    if (variant == SLIM_MACHINE_VARIANT_PROFILING) machine->opcode_counts[instruction.opcode]++;
+    machine->instruction_pointer++;
+
+    SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+    u64_t* registers = &machine->operand_stack[frame->base_pointer];
+    s16_t destination = (s16_t)(instruction.arg1 & 0xFFFF);
+    s16_t source = (s16_t)(instruction.arg1 >> 16);
+    s16_t other = (s16_t)(instruction.arg2 & 0xFFFF);
+    u64_t swap;
+
+    switch (instruction.opcode) {
+    case SL_REGISTER_OPCODE_ENTER:
+        // Every register the function uses is checked once here instead of on every access
+        if ((s64_t)frame->base_pointer + destination < 0 ||
+            (s64_t)frame->base_pointer + source > SLIM_MACHINE_OPERAND_STACK_SIZE) {
+            error = SLIM_ERROR;
+        }
+        break;
+    case SL_REGISTER_OPCODE_HALT:
+        machine->operand_stack_pointer = frame->base_pointer + destination;
+        slim_machine_routine_halt(machine, instruction);
+        break;
+    case SL_REGISTER_OPCODE_MOV: registers[destination] = registers[source]; break;
+    case SL_REGISTER_OPCODE_MOVI: registers[destination] = instruction.arg2; break;
+    case SL_REGISTER_OPCODE_MOVIH:
+        registers[destination] = (registers[destination] & 0xFFFFFFFF) | (u64_t)instruction.arg2 << 32;
+        break;
+    case SL_REGISTER_OPCODE_SWAP:
+        swap = registers[destination];
+        registers[destination] = registers[source];
+        registers[source] = swap;
+        break;
+    case SL_REGISTER_OPCODE_ROT:
+        swap = registers[destination];
+        registers[destination] = registers[destination + 1];
+        registers[destination + 1] = registers[destination + 2];
+        registers[destination + 2] = swap;
+        break;
+    case SL_REGISTER_OPCODE_ADD: registers[destination] = registers[source] + registers[other]; break;
+    case SL_REGISTER_OPCODE_SUB: registers[destination] = registers[source] - registers[other]; break;
+    case SL_REGISTER_OPCODE_MUL: registers[destination] = registers[source] * registers[other]; break;
+    case SL_REGISTER_OPCODE_DIV: registers[destination] = registers[source] / registers[other]; break;
+    case SL_REGISTER_OPCODE_MOD: registers[destination] = registers[source] % registers[other]; break;
+    case SL_REGISTER_OPCODE_ADDF:
+        ___slim_machine_register_float(registers[destination], registers[source], registers[other], x + y);
+        break;
+    case SL_REGISTER_OPCODE_SUBF:
+        ___slim_machine_register_float(registers[destination], registers[source], registers[other], x - y);
+        break;
+    case SL_REGISTER_OPCODE_MULF:
+        ___slim_machine_register_float(registers[destination], registers[source], registers[other], x * y);
+        break;
+    case SL_REGISTER_OPCODE_DIVF:
+        ___slim_machine_register_float(registers[destination], registers[source], registers[other], x / y);
+        break;
+    case SL_REGISTER_OPCODE_MODF:
+        ___slim_machine_register_float(registers[destination], registers[source], registers[other], fmod(x, y));
+        break;
+    case SL_REGISTER_OPCODE_ADDI: registers[destination] = registers[source] + instruction.arg2; break;
+    case SL_REGISTER_OPCODE_SUBI: registers[destination] = registers[source] - instruction.arg2; break;
+    case SL_REGISTER_OPCODE_MULI: registers[destination] = registers[source] * instruction.arg2; break;
+    case SL_REGISTER_OPCODE_JMP: ___slim_machine_jump(machine, instruction.arg2); break;
+    case SL_REGISTER_OPCODE_JNE:
+        if (registers[destination] != 0) ___slim_machine_jump(machine, instruction.arg2);
+        break;
+    case SL_REGISTER_OPCODE_JE:
+        if (registers[destination] == 0) ___slim_machine_jump(machine, instruction.arg2);
+        break;
+    case SL_REGISTER_OPCODE_JLT:
+        ___slim_machine_register_branch(registers[destination], registers[source], s64_t, <);
+        break;
+    case SL_REGISTER_OPCODE_JLE:
+        ___slim_machine_register_branch(registers[destination], registers[source], s64_t, <=);
+        break;
+    case SL_REGISTER_OPCODE_JGT:
+        ___slim_machine_register_branch(registers[destination], registers[source], s64_t, >);
+        break;
+    case SL_REGISTER_OPCODE_JGE:
+        ___slim_machine_register_branch(registers[destination], registers[source], s64_t, >=);
+        break;
+    case SL_REGISTER_OPCODE_JLTU:
+        ___slim_machine_register_branch(registers[destination], registers[source], u64_t, <);
+        break;
+    case SL_REGISTER_OPCODE_JLEU:
+        ___slim_machine_register_branch(registers[destination], registers[source], u64_t, <=);
+        break;
+    case SL_REGISTER_OPCODE_JGTU:
+        ___slim_machine_register_branch(registers[destination], registers[source], u64_t, >);
+        break;
+    case SL_REGISTER_OPCODE_JGEU:
+        ___slim_machine_register_branch(registers[destination], registers[source], u64_t, >=);
+        break;
+    case SL_REGISTER_OPCODE_JLTF:
+        ___slim_machine_register_branch(registers[destination], registers[source], double, <);
+        break;
+    case SL_REGISTER_OPCODE_JLEF:
+        ___slim_machine_register_branch(registers[destination], registers[source], double, <=);
+        break;
+    case SL_REGISTER_OPCODE_JGTF:
+        ___slim_machine_register_branch(registers[destination], registers[source], double, >);
+        break;
+    case SL_REGISTER_OPCODE_JGEF:
+        ___slim_machine_register_branch(registers[destination], registers[source], double, >=);
+        break;
+    case SL_REGISTER_OPCODE_DJNZ:
+        if (--registers[destination] != 0) ___slim_machine_jump(machine, instruction.arg2);
+        break;
+    case SL_REGISTER_OPCODE_CALL:
+        // The translator has already laid out every local of the callee below DEPTH, arguments first
+        machine->operand_stack_pointer = frame->base_pointer + destination;
+        error = ___slim_machine_function_call(machine, instruction.arg2, (u16_t)source, (u16_t)source);
+        break;
+    case SL_REGISTER_OPCODE_RET:
+        machine->operand_stack_pointer = frame->base_pointer + destination;
+        error = ___slim_machine_function_ret(machine);
+        break;
+    case SL_REGISTER_OPCODE_CALLN:
+        machine->operand_stack_pointer = frame->base_pointer + destination;
+        slim_machine_routine_calln(machine, instruction);
+        break;
+    case SL_REGISTER_OPCODE_TAILCALL:
+        machine->operand_stack_pointer = frame->base_pointer + destination;
+        error = ___slim_machine_function_tailcall(machine, instruction.arg2, (u16_t)source, (u16_t)source);
+        break;
+    default:
+        slim_log_error("[EXECUTE]\tInvalid register instruction 0x%x\n", instruction.opcode);
+        error = SLIM_ERROR;
+        break;
+    }
+
+    if (error != SL_ERROR_NONE) {
+        ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, error);
+    }
+    if (variant == SLIM_MACHINE_VARIANT_CHECKED) ___slim_machine_check(machine, 1);
+    return instruction.opcode;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+__attribute__((always_inline)) static inline void ___slim_machine_register_dispatch(
+    SlimMachineState machine, SlimRegisterProgram program, const u8_t single, const SlimMachineVariant variant)
 {
-    // Reset any flags
-    machine->flags.interrupt = 0;
-    machine->flags.error = 0;
-    machine->flags.halt = 0;
+    machine->trap.kind = SLIM_MACHINE_TRAP_NONE;
+    machine->bytecode_table = slim_register_program_get_table(program);
+
+    if (variant == SLIM_MACHINE_VARIANT_PROFILING) slim_profile_resume(machine->profile);
+
+    u32_t address;
+    u32_t depth;
+    u64_t retired = 0;
+    u8_t opcode;
+    do {
+        retired++;
+        address = machine->instruction_pointer;
+        depth = machine->call_stack_pointer;
+        opcode = ___slim_machine_register_execute(machine, program, variant);
+        if (variant == SLIM_MACHINE_VARIANT_PROFILING) {
+            ___slim_machine_profile(machine, depth, opcode == SL_REGISTER_OPCODE_TAILCALL);
+        }
+    } while (!single && machine->trap.kind == SLIM_MACHINE_TRAP_NONE);
+
+    if (variant == SLIM_MACHINE_VARIANT_PROFILING) slim_profile_pause(machine->profile);
 
-    SlimMachineInstruction instruction = ___slim_machine_fetch(machine, bytecode_table);
-    SlimMachineRoutine routine = ___slim_machine_decode(machine, instruction);
-    ___slim_machine_execute(machine, routine, instruction);
+    machine->retired += retired;
+    machine->trap.instruction_pointer = address;
+    machine->trap.opcode = opcode;
+}
+// Interpreter Variants ------------------------------------------------------------------------------------------------
+// Each variant gets its own copy of both dispatch loops, running and single-stepping
+typedef void (*___SlimMachineDispatch)(SlimMachineState machine, SlimBytecodeTable bytecode_table);
+typedef void (*___SlimMachineRegisterDispatch)(SlimMachineState machine, SlimRegisterProgram program);
+
+#define ___SLIM_MACHINE_VARIANT_DISPATCHERS(variant, name)                                                             \
+    static void ___slim_machine_run_##name(SlimMachineState machine, SlimBytecodeTable bytecode_table)                 \
+    {                                                                                                                  \
+        ___slim_machine_dispatch(machine, bytecode_table, 0, SLIM_MACHINE_VARIANT_##variant);                          \
+    }                                                                                                                  \
+    static void ___slim_machine_step_##name(SlimMachineState machine, SlimBytecodeTable bytecode_table)                \
+    {                                                                                                                  \
+        ___slim_machine_dispatch(machine, bytecode_table, 1, SLIM_MACHINE_VARIANT_##variant);                          \
+    }                                                                                                                  \
+    static void ___slim_machine_register_run_##name(SlimMachineState machine, SlimRegisterProgram program)             \
+    {                                                                                                                  \
+        ___slim_machine_register_dispatch(machine, program, 0, SLIM_MACHINE_VARIANT_##variant);                        \
+    }                                                                                                                  \
+    static void ___slim_machine_register_step_##name(SlimMachineState machine, SlimRegisterProgram program)            \
+    {                                                                                                                  \
+        ___slim_machine_register_dispatch(machine, program, 1, SLIM_MACHINE_VARIANT_##variant);                        \
+    }
+SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_DISPATCHERS)
+#undef ___SLIM_MACHINE_VARIANT_DISPATCHERS
+
+#define ___SLIM_MACHINE_VARIANT_ENTRY(variant, name) [SLIM_MACHINE_VARIANT_##variant] = ___slim_machine_run_##name,
+static const ___SlimMachineDispatch ___slim_machine_runs[] = {SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_ENTRY)};
+#undef ___SLIM_MACHINE_VARIANT_ENTRY
+#define ___SLIM_MACHINE_VARIANT_ENTRY(variant, name) [SLIM_MACHINE_VARIANT_##variant] = ___slim_machine_step_##name,
+static const ___SlimMachineDispatch ___slim_machine_steps[] = {SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_ENTRY)};
+#undef ___SLIM_MACHINE_VARIANT_ENTRY
+#define ___SLIM_MACHINE_VARIANT_ENTRY(variant, name)                                                                   \
+    [SLIM_MACHINE_VARIANT_##variant] = ___slim_machine_register_run_##name,
+static const ___SlimMachineRegisterDispatch ___slim_machine_register_runs[] = {
+    SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_ENTRY)};
+#undef ___SLIM_MACHINE_VARIANT_ENTRY
+#define ___SLIM_MACHINE_VARIANT_ENTRY(variant, name)                                                                   \
+    [SLIM_MACHINE_VARIANT_##variant] = ___slim_machine_register_step_##name,
+static const ___SlimMachineRegisterDispatch ___slim_machine_register_steps[] = {
+    SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_ENTRY)};
+#undef ___SLIM_MACHINE_VARIANT_ENTRY
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_run(SlimMachineState machine, SlimBytecodeTable bytecode_table)
+{
+    ___slim_machine_runs[machine->variant](machine, bytecode_table);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_step(SlimMachineState machine, SlimBytecodeTable bytecode_table)
+{
+    ___slim_machine_steps[machine->variant](machine, bytecode_table);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_register_run(SlimMachineState machine, SlimRegisterProgram program)
+{
+    ___slim_machine_register_runs[machine->variant](machine, program);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_register_step(SlimMachineState machine, SlimRegisterProgram program)
+{
+    ___slim_machine_register_steps[machine->variant](machine, program);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_load(SlimMachineState machine, u8_t* data, u32_t size)
@@ -138,18 +596,121 @@ void slim_machine_load(SlimMachineState machine, u8_t* data, u32_t size)
     machine->bytecode_size = size;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void slim_machine_get_flags(SlimMachineState machine, SlimMachineFlags* flags)
+void slim_machine_get_trap(SlimMachineState machine, SlimMachineTrap* trap) { *trap = machine->trap; }
+// ---------------------------------------------------------------------------------------------------------------------
+const char* slim_machine_opcode_name(u8_t opcode) { return ___slim_machine_opcode_names[opcode]; }
+// ---------------------------------------------------------------------------------------------------------------------
+const u64_t* slim_machine_get_opcode_counts(SlimMachineState machine) { return machine->opcode_counts; }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimProfile slim_machine_get_profile(SlimMachineState machine) { return machine->profile; }
+// ---------------------------------------------------------------------------------------------------------------------
+u64_t slim_machine_get_retired(SlimMachineState machine) { return machine->retired; }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimMachineVariant slim_machine_get_variant(SlimMachineState machine) { return machine->variant; }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_machine_variant_parse(const char* name, SlimMachineVariant* variant)
+{
+#define ___SLIM_MACHINE_VARIANT_PARSE(candidate, candidate_name)                                                       \
+    if (strcmp(name, #candidate_name) == 0) {                                                                          \
+        *variant = SLIM_MACHINE_VARIANT_##candidate;                                                                   \
+        return SL_ERROR_NONE;                                                                                          \
+    }
+    SLIM_MACHINE_VARIANTS(___SLIM_MACHINE_VARIANT_PARSE)
+#undef ___SLIM_MACHINE_VARIANT_PARSE
+
+    return SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_machine_flag_get_error(SlimMachineState machine) { return machine->trap.kind == SLIM_MACHINE_TRAP_ERROR; }
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_machine_flag_get_interrupt(SlimMachineState machine)
+{
+    return machine->trap.kind == SLIM_MACHINE_TRAP_INTERRUPT;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_machine_flag_get_halt(SlimMachineState machine) { return machine->trap.kind == SLIM_MACHINE_TRAP_HALT; }
+
+u8_t slim_machine_flag_get_park(SlimMachineState machine) { return machine->trap.kind == SLIM_MACHINE_TRAP_PARK; }
+
+u8_t slim_machine_flag_get_yield(SlimMachineState machine) { return machine->trap.kind == SLIM_MACHINE_TRAP_YIELD; }
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_set_fuel(SlimMachineState machine, u64_t budget)
+{
+    machine->fuel_budget = budget > INT64_MAX ? INT64_MAX : budget;
+    slim_machine_refuel(machine);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_refuel(SlimMachineState machine)
+{
+    machine->fuel = machine->fuel_budget == 0 ? INT64_MAX : (s64_t)machine->fuel_budget;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+s64_t slim_machine_get_fuel(SlimMachineState machine) { return machine->fuel; }
+// ---------------------------------------------------------------------------------------------------------------------
+// Takes the machine out of the running until the platform has dealt with what it parked for
+void slim_machine_park(SlimMachineState machine, SlimMachineParking parking)
+{
+    // CALLN is a single instruction in both execution modes, so stepping back one lands on it again
+    if (parking.retry) machine->instruction_pointer--;
+    machine->parking = parking;
+    // The machine is trapped on the CALLN while its native runs, parking replaces that trap
+    machine->trap.kind = SLIM_MACHINE_TRAP_PARK;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_get_parking(SlimMachineState machine, SlimMachineParking* parking) { *parking = machine->parking; }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_machine_memory(SlimMachineState machine, u64_t address, u64_t length, u8_t writable, u64_t** words)
 {
-    flags->interrupt = machine->flags.interrupt;
-    flags->error = machine->flags.error;
-    flags->halt = machine->flags.halt;
+    SlimError error = writable ? ___slim_machine_memory_writable(machine, address, length)
+                               : ___slim_machine_memory_range(address, length);
+    if (error != SL_ERROR_NONE) return error;
+
+    *words = machine->memory + address;
+    return SL_ERROR_NONE;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-u8_t slim_machine_flag_get_error(SlimMachineState machine) { return machine->flags.error; }
+SlimError slim_machine_console(SlimMachineState machine, SlimConsoleBuffer* console)
+{
+    if (machine->console == NULL) {
+        SlimError error = slim_console_buffer_create(&machine->console);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    *console = machine->console;
+    return SL_ERROR_NONE;
+}
 // ---------------------------------------------------------------------------------------------------------------------
-u8_t slim_machine_flag_get_interrupt(SlimMachineState machine) { return machine->flags.interrupt; }
+SlimError slim_machine_lookup_string(SlimMachineState machine, u64_t handle, const char** string)
+{
+    if (machine->bytecode_table == NULL) return SLIM_ERROR;
+
+    char* found;
+    SlimError error = slim_bytecode_table_lookup_string(machine->bytecode_table, handle, &found);
+    if (error != SL_ERROR_NONE) return error;
+
+    *string = found;
+    return SL_ERROR_NONE;
+}
 // ---------------------------------------------------------------------------------------------------------------------
-u8_t slim_machine_flag_get_halt(SlimMachineState machine) { return machine->flags.halt; }
+// Starts execution at address with the locals of the entry section reserved in the root frame
+SlimError slim_machine_enter(SlimMachineState machine, u32_t address, u32_t local_count)
+{
+    if (machine->call_stack_pointer != 0 || machine->operand_stack_pointer != 0) return SLIM_ERROR;
+    if (local_count > SLIM_MACHINE_OPERAND_STACK_SIZE) return SLIM_ERROR;
+
+    machine->call_stack[0].return_pointer = 0;
+    machine->call_stack[0].base_pointer = 0;
+    machine->call_stack[0].size = local_count;
+    machine->operand_stack_pointer = local_count;
+    machine->instruction_pointer = address;
+
+    if (machine->profile != NULL) {
+        slim_profile_close(machine->profile);
+        slim_profile_enter(machine->profile, address);
+    }
+
+    return SL_ERROR_NONE;
+}
 // ---------------------------------------------------------------------------------------------------------------------
 SlimError slim_machine_push(SlimMachineState machine, u64_t value)
 {
@@ -162,81 +723,456 @@ SlimError slim_machine_pop(SlimMachineState machine, u64_t* value)
 }
 // ---------------------------------------------------------------------------------------------------------------------
 SlimError slim_machine_pop(SlimMachineState machine, u64_t* value);
-// Internal Routines ---------------------------------------------------------------------------------------------------
-// TODO: slim_machine_step has now been parameterized over SlimMachineInstruction, so we can remove this
-SlimMachineInstruction ___slim_machine_fetch(SlimMachineState machine, SlimBytecodeTable bytecode_table)
+// Vector Kernels ------------------------------------------------------------------------------------------------------
+// The vector opcodes hand a whole array to a kernel per dispatch.  Every kernel set computes exactly what the scalar
+// loops do: float sums and dot products accumulate in four interleaved lanes that are combined as (0 + 2) + (1 + 3)
+// before the tail is added in order, products are rounded before they are added except in VFMAF, which is fused
+// everywhere.  Only minimum and maximum may differ between sets, and only in which NaN or signed zero they return.
+// Operations without a matching instruction, like 64-bit integer multiplication, use the scalar loop in every set.
+
+enum SlimMachineVectorOperation {
+    SLIM_MACHINE_VECTOR_ADD = 0,
+    SLIM_MACHINE_VECTOR_SUB = 1,
+    SLIM_MACHINE_VECTOR_MUL = 2,
+    SLIM_MACHINE_VECTOR_FMA = 3,
+    SLIM_MACHINE_VECTOR_DOT = 4,
+    SLIM_MACHINE_VECTOR_SUM = 5,
+    SLIM_MACHINE_VECTOR_MIN = 6,
+    SLIM_MACHINE_VECTOR_MAX = 7,
+};
+
+typedef struct SlimMachineVectorKernels {
+    const char* name;
+    void (*map_integer)(u8_t operation, u64_t* destination, const u64_t* a, const u64_t* b, u32_t length);
+    void (*map_float)(u8_t operation, double* destination, const double* a, const double* b, u32_t length);
+    u64_t (*reduce_integer)(u8_t operation, const u64_t* a, const u64_t* b, u32_t length);
+    double (*reduce_float)(u8_t operation, const double* a, const double* b, u32_t length);
+} SlimMachineVectorKernels;
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_machine_vector_map_integer_scalar(
+    u8_t operation, u64_t* destination, const u64_t* a, const u64_t* b, u32_t length)
 {
-    slim_log_using_context(machine->log_context);
-    slim_todo();
-    SlimMachineInstruction instruction;
-    // instruction.opcode = machine->bytecode[machine->instruction_pointer];
+    switch (operation) {
+    case SLIM_MACHINE_VECTOR_ADD:
+        for (u32_t i = 0; i < length; i++) destination[i] = a[i] + b[i];
+        break;
+    case SLIM_MACHINE_VECTOR_SUB:
+        for (u32_t i = 0; i < length; i++) destination[i] = a[i] - b[i];
+        break;
+    case SLIM_MACHINE_VECTOR_MUL:
+        for (u32_t i = 0; i < length; i++) destination[i] = a[i] * b[i];
+        break;
+    case SLIM_MACHINE_VECTOR_FMA:
+        for (u32_t i = 0; i < length; i++) destination[i] += a[i] * b[i];
+        break;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_machine_vector_map_float_scalar(
+    u8_t operation, double* destination, const double* a, const double* b, u32_t length)
+{
+    switch (operation) {
+    case SLIM_MACHINE_VECTOR_ADD:
+        for (u32_t i = 0; i < length; i++) destination[i] = a[i] + b[i];
+        break;
+    case SLIM_MACHINE_VECTOR_SUB:
+        for (u32_t i = 0; i < length; i++) destination[i] = a[i] - b[i];
+        break;
+    case SLIM_MACHINE_VECTOR_MUL:
+        for (u32_t i = 0; i < length; i++) destination[i] = a[i] * b[i];
+        break;
+    case SLIM_MACHINE_VECTOR_FMA:
+        for (u32_t i = 0; i < length; i++) destination[i] = fma(a[i], b[i], destination[i]);
+        break;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Reduces a[start..length) onto result, the tail loop shared by every set
+u64_t ___slim_machine_vector_reduce_integer_tail(
+    u8_t operation, const u64_t* a, const u64_t* b, u32_t start, u32_t length, u64_t result)
+{
+    for (u32_t i = start; i < length; i++) {
+        switch (operation) {
+        case SLIM_MACHINE_VECTOR_DOT: result += a[i] * b[i]; break;
+        case SLIM_MACHINE_VECTOR_SUM: result += a[i]; break;
+        case SLIM_MACHINE_VECTOR_MIN: result = (s64_t)a[i] < (s64_t)result ? a[i] : result; break;
+        case SLIM_MACHINE_VECTOR_MAX: result = (s64_t)a[i] > (s64_t)result ? a[i] : result; break;
+        }
+    }
+
+    return result;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+double ___slim_machine_vector_reduce_float_tail(
+    u8_t operation, const double* a, const double* b, u32_t start, u32_t length, double result)
+{
+    for (u32_t i = start; i < length; i++) {
+        switch (operation) {
+        case SLIM_MACHINE_VECTOR_DOT: result += a[i] * b[i]; break;
+        case SLIM_MACHINE_VECTOR_SUM: result += a[i]; break;
+        case SLIM_MACHINE_VECTOR_MIN: result = a[i] < result ? a[i] : result; break;
+        case SLIM_MACHINE_VECTOR_MAX: result = a[i] > result ? a[i] : result; break;
+        }
+    }
+
+    return result;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Minimum and maximum start from the first element, so the caller must not pass an empty array for them
+u64_t ___slim_machine_vector_reduce_integer_scalar(u8_t operation, const u64_t* a, const u64_t* b, u32_t length)
+{
+    if (operation == SLIM_MACHINE_VECTOR_MIN || operation == SLIM_MACHINE_VECTOR_MAX) {
+        return ___slim_machine_vector_reduce_integer_tail(operation, a, b, 1, length, a[0]);
+    }
+
+    // Integer addition wraps and is associative, so the order does not matter here
+    return ___slim_machine_vector_reduce_integer_tail(operation, a, b, 0, length, 0);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+double ___slim_machine_vector_reduce_float_scalar(u8_t operation, const double* a, const double* b, u32_t length)
+{
+    if (operation == SLIM_MACHINE_VECTOR_MIN || operation == SLIM_MACHINE_VECTOR_MAX) {
+        return ___slim_machine_vector_reduce_float_tail(operation, a, b, 1, length, a[0]);
+    }
+
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    u32_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        for (u32_t lane = 0; lane < 4; lane++) {
+            double value = a[i + lane];
+            if (operation == SLIM_MACHINE_VECTOR_DOT) {
+                value *= b[i + lane];
+            }
+            lanes[lane] += value;
+        }
+    }
+
+    double result = (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+    return ___slim_machine_vector_reduce_float_tail(operation, a, b, i, length, result);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static const SlimMachineVectorKernels SLIM_MACHINE_VECTOR_SCALAR = {
+    "scalar",
+    ___slim_machine_vector_map_integer_scalar,
+    ___slim_machine_vector_map_float_scalar,
+    ___slim_machine_vector_reduce_integer_scalar,
+    ___slim_machine_vector_reduce_float_scalar,
+};
+
+#if defined(__x86_64__)
+// ---------------------------------------------------------------------------------------------------------------------
+// SSE2 is part of x86-64, so these need no check.  Two registers of two doubles make up the four float lanes.
+void ___slim_machine_vector_map_integer_sse2(
+    u8_t operation, u64_t* destination, const u64_t* a, const u64_t* b, u32_t length)
+{
+    if (operation != SLIM_MACHINE_VECTOR_ADD && operation != SLIM_MACHINE_VECTOR_SUB) {
+        ___slim_machine_vector_map_integer_scalar(operation, destination, a, b, length);
+        return;
+    }
+
+    u32_t i = 0;
+    for (; i + 2 <= length; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i z = operation == SLIM_MACHINE_VECTOR_ADD ? _mm_add_epi64(x, y) : _mm_sub_epi64(x, y);
+        _mm_storeu_si128((__m128i*)(destination + i), z);
+    }
+
+    ___slim_machine_vector_map_integer_scalar(operation, destination + i, a + i, b + i, length - i);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_machine_vector_map_float_sse2(
+    u8_t operation, double* destination, const double* a, const double* b, u32_t length)
+{
+    if (operation == SLIM_MACHINE_VECTOR_FMA) {
+        ___slim_machine_vector_map_float_scalar(operation, destination, a, b, length);
+        return;
+    }
+
+    u32_t i = 0;
+    for (; i + 2 <= length; i += 2) {
+        __m128d x = _mm_loadu_pd(a + i);
+        __m128d y = _mm_loadu_pd(b + i);
+        __m128d z;
+        switch (operation) {
+        case SLIM_MACHINE_VECTOR_ADD: z = _mm_add_pd(x, y); break;
+        case SLIM_MACHINE_VECTOR_SUB: z = _mm_sub_pd(x, y); break;
+        default: z = _mm_mul_pd(x, y); break;
+        }
+        _mm_storeu_pd(destination + i, z);
+    }
+
+    ___slim_machine_vector_map_float_scalar(operation, destination + i, a + i, b + i, length - i);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u64_t ___slim_machine_vector_reduce_integer_sse2(u8_t operation, const u64_t* a, const u64_t* b, u32_t length)
+{
+    // SSE2 has neither 64-bit multiplication nor 64-bit comparison
+    if (operation != SLIM_MACHINE_VECTOR_SUM) {
+        return ___slim_machine_vector_reduce_integer_scalar(operation, a, b, length);
+    }
+
+    __m128i sum = _mm_setzero_si128();
+    u32_t i = 0;
+    for (; i + 2 <= length; i += 2) {
+        sum = _mm_add_epi64(sum, _mm_loadu_si128((const __m128i*)(a + i)));
+    }
 
-    // // Read in the next 4 bytes as the first argument
-    // u32_t arg1 = 0;
-    // for (int i = 0; i < 4; i++) {
-    //     arg1 |= machine->bytecode[machine->instruction_pointer + 1 + i] << (i * 8);
-    // }
+    u64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, sum);
+    return ___slim_machine_vector_reduce_integer_tail(operation, a, b, i, length, lanes[0] + lanes[1]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+double ___slim_machine_vector_reduce_float_sse2(u8_t operation, const double* a, const double* b, u32_t length)
+{
+    if (operation == SLIM_MACHINE_VECTOR_MIN || operation == SLIM_MACHINE_VECTOR_MAX) {
+        if (length < 2) {
+            return ___slim_machine_vector_reduce_float_scalar(operation, a, b, length);
+        }
+
+        __m128d extreme = _mm_loadu_pd(a);
+        u32_t i = 2;
+        for (; i + 2 <= length; i += 2) {
+            __m128d x = _mm_loadu_pd(a + i);
+            extreme = operation == SLIM_MACHINE_VECTOR_MIN ? _mm_min_pd(x, extreme) : _mm_max_pd(x, extreme);
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, extreme);
+        double result = ___slim_machine_vector_reduce_float_tail(operation, lanes, NULL, 1, 2, lanes[0]);
+        return ___slim_machine_vector_reduce_float_tail(operation, a, b, i, length, result);
+    }
+
+    __m128d low = _mm_setzero_pd();
+    __m128d high = _mm_setzero_pd();
+    u32_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128d x = _mm_loadu_pd(a + i);
+        __m128d y = _mm_loadu_pd(a + i + 2);
+        if (operation == SLIM_MACHINE_VECTOR_DOT) {
+            x = _mm_mul_pd(x, _mm_loadu_pd(b + i));
+            y = _mm_mul_pd(y, _mm_loadu_pd(b + i + 2));
+        }
+        low = _mm_add_pd(low, x);
+        high = _mm_add_pd(high, y);
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+    return ___slim_machine_vector_reduce_float_tail(operation, a, b, i, length, lanes[0] + lanes[1]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// The AVX2 set also uses FMA3, every CPU with AVX2 has it but it is checked separately all the same
+__attribute__((target("avx2"))) void ___slim_machine_vector_map_integer_avx2(
+    u8_t operation, u64_t* destination, const u64_t* a, const u64_t* b, u32_t length)
+{
+    if (operation != SLIM_MACHINE_VECTOR_ADD && operation != SLIM_MACHINE_VECTOR_SUB) {
+        ___slim_machine_vector_map_integer_scalar(operation, destination, a, b, length);
+        return;
+    }
+
+    u32_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i z = operation == SLIM_MACHINE_VECTOR_ADD ? _mm256_add_epi64(x, y) : _mm256_sub_epi64(x, y);
+        _mm256_storeu_si256((__m256i*)(destination + i), z);
+    }
+
+    ___slim_machine_vector_map_integer_scalar(operation, destination + i, a + i, b + i, length - i);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+__attribute__((target("avx2,fma"))) void ___slim_machine_vector_map_float_avx2(
+    u8_t operation, double* destination, const double* a, const double* b, u32_t length)
+{
+    u32_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        __m256d y = _mm256_loadu_pd(b + i);
+        __m256d z;
+        switch (operation) {
+        case SLIM_MACHINE_VECTOR_ADD: z = _mm256_add_pd(x, y); break;
+        case SLIM_MACHINE_VECTOR_SUB: z = _mm256_sub_pd(x, y); break;
+        case SLIM_MACHINE_VECTOR_MUL: z = _mm256_mul_pd(x, y); break;
+        default: z = _mm256_fmadd_pd(x, y, _mm256_loadu_pd(destination + i)); break;
+        }
+        _mm256_storeu_pd(destination + i, z);
+    }
+
+    ___slim_machine_vector_map_float_scalar(operation, destination + i, a + i, b + i, length - i);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+__attribute__((target("avx2"))) u64_t ___slim_machine_vector_reduce_integer_avx2(
+    u8_t operation, const u64_t* a, const u64_t* b, u32_t length)
+{
+    // There is no 64-bit multiplication below AVX-512
+    if (operation == SLIM_MACHINE_VECTOR_DOT || length < 4) {
+        return ___slim_machine_vector_reduce_integer_scalar(operation, a, b, length);
+    }
+
+    u32_t i = 0;
+    __m256i result = _mm256_setzero_si256();
+    if (operation == SLIM_MACHINE_VECTOR_SUM) {
+        for (; i + 4 <= length; i += 4) {
+            result = _mm256_add_epi64(result, _mm256_loadu_si256((const __m256i*)(a + i)));
+        }
+    } else {
+        result = _mm256_loadu_si256((const __m256i*)a);
+        for (i = 4; i + 4 <= length; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+            __m256i greater = _mm256_cmpgt_epi64(x, result);
+            __m256i pick = operation == SLIM_MACHINE_VECTOR_MAX ? greater : _mm256_cmpgt_epi64(result, x);
+            result = _mm256_blendv_epi8(result, x, pick);
+        }
+    }
+
+    u64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, result);
+    u64_t combined = ___slim_machine_vector_reduce_integer_tail(operation, lanes, NULL, 1, 4, lanes[0]);
+    return ___slim_machine_vector_reduce_integer_tail(operation, a, b, i, length, combined);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+__attribute__((target("avx2"))) double ___slim_machine_vector_reduce_float_avx2(
+    u8_t operation, const double* a, const double* b, u32_t length)
+{
+    u32_t i = 0;
+    __m256d result = _mm256_setzero_pd();
+    if (operation == SLIM_MACHINE_VECTOR_MIN || operation == SLIM_MACHINE_VECTOR_MAX) {
+        if (length < 4) {
+            return ___slim_machine_vector_reduce_float_scalar(operation, a, b, length);
+        }
+
+        result = _mm256_loadu_pd(a);
+        for (i = 4; i + 4 <= length; i += 4) {
+            __m256d x = _mm256_loadu_pd(a + i);
+            result = operation == SLIM_MACHINE_VECTOR_MIN ? _mm256_min_pd(x, result) : _mm256_max_pd(x, result);
+        }
+
+        double lanes[4];
+        _mm256_storeu_pd(lanes, result);
+        double combined = ___slim_machine_vector_reduce_float_tail(operation, lanes, NULL, 1, 4, lanes[0]);
+        return ___slim_machine_vector_reduce_float_tail(operation, a, b, i, length, combined);
+    }
+
+    for (; i + 4 <= length; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        if (operation == SLIM_MACHINE_VECTOR_DOT) {
+            x = _mm256_mul_pd(x, _mm256_loadu_pd(b + i));
+        }
+        result = _mm256_add_pd(result, x);
+    }
+
+    double lanes[2];
+    __m128d halves = _mm_add_pd(_mm256_castpd256_pd128(result), _mm256_extractf128_pd(result, 1));
+    _mm_storeu_pd(lanes, halves);
+    return ___slim_machine_vector_reduce_float_tail(operation, a, b, i, length, lanes[0] + lanes[1]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static const SlimMachineVectorKernels SLIM_MACHINE_VECTOR_SSE2 = {
+    "sse2",
+    ___slim_machine_vector_map_integer_sse2,
+    ___slim_machine_vector_map_float_sse2,
+    ___slim_machine_vector_reduce_integer_sse2,
+    ___slim_machine_vector_reduce_float_sse2,
+};
+
+static const SlimMachineVectorKernels SLIM_MACHINE_VECTOR_AVX2 = {
+    "avx2",
+    ___slim_machine_vector_map_integer_avx2,
+    ___slim_machine_vector_map_float_avx2,
+    ___slim_machine_vector_reduce_integer_avx2,
+    ___slim_machine_vector_reduce_float_avx2,
+};
+#endif
+// ---------------------------------------------------------------------------------------------------------------------
+// Machines on several threads (PARFOR children among them) may be the first to look, so the pointer is only ever
+// accessed atomically.  Detection only fills it in while it is still empty, so it never undoes an explicit selection.
+static const SlimMachineVectorKernels* ___slim_machine_vector_kernels = NULL;
+
+void ___slim_machine_vector_kernels_set(const SlimMachineVectorKernels* kernels)
+{
+    __atomic_store_n(&___slim_machine_vector_kernels, kernels, __ATOMIC_RELEASE);
+}
+
+const SlimMachineVectorKernels* ___slim_machine_vector_kernels_get()
+{
+    const SlimMachineVectorKernels* selected = __atomic_load_n(&___slim_machine_vector_kernels, __ATOMIC_ACQUIRE);
+    if (selected == NULL) {
+        const SlimMachineVectorKernels* kernels = &SLIM_MACHINE_VECTOR_SCALAR;
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            kernels = &SLIM_MACHINE_VECTOR_AVX2;
+        } else {
+            kernels = &SLIM_MACHINE_VECTOR_SSE2;
+        }
+#endif
+        // On failure selected receives whatever another first caller or an explicit selection stored meanwhile
+        if (__atomic_compare_exchange_n(
+                &___slim_machine_vector_kernels, &selected, kernels, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            selected = kernels;
+        }
+    }
+
+    return selected;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_vector_select(const char* name)
+{
+    if (strcmp(name, SLIM_MACHINE_VECTOR_SCALAR.name) == 0) {
+        ___slim_machine_vector_kernels_set(&SLIM_MACHINE_VECTOR_SCALAR);
+        return SL_ERROR_NONE;
+    }
 
-    // // TODO: This is a hack to get around endianness issues, replace with detection and conversion
-    // // Reverse the bits
-    // arg1 = ((arg1 & 0x000000FF) << 24) | ((arg1 & 0x0000FF00) << 8) | ((arg1 & 0x00FF0000) >> 8) |
-    //        ((arg1 & 0xFF000000) >> 24);
+#if defined(__x86_64__)
+    if (strcmp(name, SLIM_MACHINE_VECTOR_SSE2.name) == 0) {
+        ___slim_machine_vector_kernels_set(&SLIM_MACHINE_VECTOR_SSE2);
+        return SL_ERROR_NONE;
+    }
+
+    __builtin_cpu_init();
+    if (strcmp(name, SLIM_MACHINE_VECTOR_AVX2.name) == 0 && __builtin_cpu_supports("avx2") &&
+        __builtin_cpu_supports("fma")) {
+        ___slim_machine_vector_kernels_set(&SLIM_MACHINE_VECTOR_AVX2);
+        return SL_ERROR_NONE;
+    }
+#endif
 
-    // // Read in the next 4 bytes as the second argument
-    // u32_t arg2 = 0;
-    // for (int i = 0; i < 4; i++) {
-    //     arg2 |= machine->bytecode[machine->instruction_pointer + 5 + i] << (i * 8);
-    // }
+    return SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+const char* ___slim_machine_vector_selected()
+{
+    return ___slim_machine_vector_kernels_get()->name;
+}
+// Internal Routines ---------------------------------------------------------------------------------------------------
+SlimMachineInstruction ___slim_machine_fetch(SlimMachineState machine, SlimBytecodeTable bytecode_table)
+{
+    slim_log_using_context(machine->log_context);
 
-    // // TODO: This is a hack to get around endianness issues, replace with detection and conversion
-    // // Reverse the bits
-    // arg2 = ((arg2 & 0x000000FF) << 24) | ((arg2 & 0x0000FF00) << 8) | ((arg2 & 0x00FF0000) >> 8) |
-    //        ((arg2 & 0xFF000000) >> 24);
+    SlimMachineInstruction instruction = {SL_OPCODE_NOOP, 0, 0};
+    SlimBytecodeInstruction encoded;
 
-    // instruction.arg1 = arg1;
-    // instruction.arg2 = arg2;
+    // The loader has already expanded the compact encoding, so the instruction pointer is a plain index
+    SlimError error = slim_bytecode_table_lookup_instruction(bytecode_table, machine->instruction_pointer, &encoded);
+    if (error != SL_ERROR_NONE) {
+        slim_log_error("[FETCH]\t\tInvalid instruction pointer 0x%x\n", machine->instruction_pointer);
+        ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, error);
+        return instruction;
+    }
 
-    // slim_log_info("[FETCH]\t\t0x%x 0x%x 0x%x\n", instruction.opcode, instruction.arg1, instruction.arg2);
+    // Only LOADI carries a full 64-bit operand, which is split across both arguments.  Every other operand fits in arg2.
+    instruction.opcode = encoded.opcode;
+    instruction.arg1 = (u32_t)(encoded.operand >> 32);
+    instruction.arg2 = (u32_t)encoded.operand;
 
-    // machine->instruction_pointer += 9;
+    machine->instruction_pointer++;
     return instruction;
 }
 // ---------------------------------------------------------------------------------------------------------------------
 SlimMachineRoutine ___slim_machine_decode(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    switch (instruction.opcode) {
-    case SL_OPCODE_NOOP: return slim_machine_routine_nop; break;
-    case SL_OPCODE_HALT: return slim_machine_routine_halt; break;
-    case SL_OPCODE_LOADI: return slim_machine_routine_loadi; break;
-    case SL_OPCODE_LOADR: return slim_machine_routine_loadr; break;
-    case SL_OPCODE_LOADM: return slim_machine_routine_loadm; break;
-    case SL_OPCODE_DROP: return slim_machine_routine_drop; break;
-    case SL_OPCODE_STORER: return slim_machine_routine_storer; break;
-    case SL_OPCODE_STOREM: return slim_machine_routine_storem; break;
-    case SL_OPCODE_DUP: return slim_machine_routine_dup; break;
-    case SL_OPCODE_SWAP: return slim_machine_routine_swap; break;
-    case SL_OPCODE_ROT: return slim_machine_routine_rot; break;
-    case SL_OPCODE_ADD: return slim_machine_routine_add; break;
-    case SL_OPCODE_SUB: return slim_machine_routine_sub; break;
-    case SL_OPCODE_MUL: return slim_machine_routine_mul; break;
-    case SL_OPCODE_DIV: return slim_machine_routine_div; break;
-    case SL_OPCODE_MOD: return slim_machine_routine_mod; break;
-    case SL_OPCODE_ADDF: return slim_machine_routine_addf; break;
-    case SL_OPCODE_SUBF: return slim_machine_routine_subf; break;
-    case SL_OPCODE_MULF: return slim_machine_routine_mulf; break;
-    case SL_OPCODE_DIVF: return slim_machine_routine_divf; break;
-    case SL_OPCODE_MODF: return slim_machine_routine_modf; break;
-    case SL_OPCODE_ALLOC: return slim_machine_routine_alloc; break;
-    case SL_OPCODE_FREE: return slim_machine_routine_free; break;
-    case SL_OPCODE_JMP: return slim_machine_routine_jmp; break;
-    case SL_OPCODE_JNE: return slim_machine_routine_jne; break;
-    case SL_OPCODE_JE: return slim_machine_routine_je; break;
-    case SL_OPCODE_CALL: return slim_machine_routine_call; break;
-    case SL_OPCODE_RET: return slim_machine_routine_ret; break;
-    case SL_OPCODE_CALLN: return slim_machine_routine_calln; break;
-    case SL_OPCODE_CAST: return slim_machine_routine_cast; break;
-    default: return NULL; break;
-    }
+    return ___slim_machine_routines[instruction.opcode];
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void ___slim_machine_execute(SlimMachineState machine, SlimMachineRoutine routine, SlimMachineInstruction instruction)
@@ -247,22 +1183,25 @@ void ___slim_machine_execute(SlimMachineState machine, SlimMachineRoutine routin
         routine(machine, instruction);
     } else {
         slim_log_error("[EXECUTE]\tInvalid instruction 0x%x\n", instruction.opcode);
-        machine->flags.error = 1;
+        ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, SLIM_ERROR);
     }
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void ___slim_machine_flag_error_raise(SlimMachineState machine) { machine->flags.error = 1; }
+// Every way out of the dispatch loops comes through here, so it is kept out of line and away from the hot code.  An
+// error replaces whatever else the instruction trapped for, otherwise the first trap stands.
+__attribute__((noinline, cold)) void
+___slim_machine_trap(SlimMachineState machine, SlimMachineTrapKind kind, SlimError error)
+{
+    if (kind != SLIM_MACHINE_TRAP_ERROR && machine->trap.kind != SLIM_MACHINE_TRAP_NONE) return;
+
+    machine->trap.kind = kind;
+    machine->trap.error = error;
+}
 // ---------------------------------------------------------------------------------------------------------------------
 SlimError ___slim_machine_bytecode_jump(SlimMachineState machine, u32_t address)
 {
-    slim_log_using_context(machine->log_context);
-
-    if (address >= machine->bytecode_size) {
-        slim_log_error("[JUMP]\t\tInvalid address 0x%x\n", address);
-        return SLIM_ERROR;
-    }
-
-    machine->instruction_pointer = address;
+    // Addresses are instruction indices, an out of range address is caught by the next fetch
+    ___slim_machine_jump(machine, address);
 
     return SL_ERROR_NONE;
 }
@@ -329,6 +1268,10 @@ SlimError ___slim_machine_memory_read(SlimMachineState machine, u32_t address, u
     u64_t value;
     SlimError error;
 
+    if (___slim_machine_memory_range((u64_t)address + offset, 1) != SL_ERROR_NONE) {
+        return SLIM_ERROR;
+    }
+
     u64_t* ptr = (u64_t*)(machine->memory + address + offset);
     value = *ptr;
 
@@ -350,6 +1293,10 @@ SlimError ___slim_machine_memory_write(SlimMachineState machine, u32_t address,
         return error;
     }
 
+    if (___slim_machine_memory_writable(machine, (u64_t)address + offset, 1) != SL_ERROR_NONE) {
+        return SLIM_ERROR;
+    }
+
     u64_t* ptr = (u64_t*)(machine->memory + address + offset);
     *ptr = value;
 
@@ -396,45 +1343,411 @@ SlimError ___slim_machine_memory_free(SlimMachineState machine, u32_t address)
         block = block->next;
     }
 
-    return SLIM_ERROR;
+    return SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Checks that length words from address lie inside memory
+SlimError ___slim_machine_memory_range(u64_t address, u64_t length)
+{
+    if (length > SLIM_MACHINE_MEMORY_SIZE || address > SLIM_MACHINE_MEMORY_SIZE - length) {
+        return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Checks that length words from address lie inside the part of memory this machine may store to
+SlimError ___slim_machine_memory_writable(SlimMachineState machine, u64_t address, u64_t length)
+{
+    if (___slim_machine_memory_range(address, length) != SL_ERROR_NONE) {
+        return SLIM_ERROR;
+    }
+
+    if (address < machine->writable_start || address + length > machine->writable_end) {
+        return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// The bulk memory operations check their whole range once and leave the work to the C library
+SlimError ___slim_machine_memory_copy(SlimMachineState machine, u64_t destination, u64_t source, u64_t length)
+{
+    if (___slim_machine_memory_writable(machine, destination, length) != SL_ERROR_NONE) return SLIM_ERROR;
+    if (___slim_machine_memory_range(source, length) != SL_ERROR_NONE) return SLIM_ERROR;
+
+    memmove(machine->memory + destination, machine->memory + source, length * sizeof(u64_t));
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_memory_fill(SlimMachineState machine, u64_t destination, u64_t value, u64_t length)
+{
+    if (___slim_machine_memory_writable(machine, destination, length) != SL_ERROR_NONE) return SLIM_ERROR;
+
+    // memset only repeats a byte, which covers zero and -1, the usual fill values
+    u64_t repeated = (value & 0xFF) * 0x0101010101010101ULL;
+    if (value == repeated) {
+        memset(machine->memory + destination, (int)(value & 0xFF), length * sizeof(u64_t));
+        return SL_ERROR_NONE;
+    }
+
+    u64_t* words = machine->memory + destination;
+    for (u64_t i = 0; i < length; i++) {
+        words[i] = value;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Orders the ranges by their first differing word as unsigned integers.  memcmp finds whether they differ, but on a
+// little-endian host its byte order is not the word order, so the differing word is compared on its own.
+SlimError ___slim_machine_memory_compare(SlimMachineState machine, u64_t a, u64_t b, u64_t length, s64_t* result)
+{
+    if (___slim_machine_memory_range(a, length) != SL_ERROR_NONE) return SLIM_ERROR;
+    if (___slim_machine_memory_range(b, length) != SL_ERROR_NONE) return SLIM_ERROR;
+
+    const u64_t* x = machine->memory + a;
+    const u64_t* y = machine->memory + b;
+
+    *result = 0;
+    if (memcmp(x, y, length * sizeof(u64_t)) == 0) {
+        return SL_ERROR_NONE;
+    }
+
+    for (u64_t i = 0; i < length; i++) {
+        if (x[i] != y[i]) {
+            *result = x[i] < y[i] ? -1 : 1;
+            break;
+        }
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Runs one of the vector opcodes.  The destination may be one of the sources, but must not overlap them otherwise,
+// since the kernels read and write several elements at a time.
+SlimError ___slim_machine_memory_vector(SlimMachineState machine, u8_t opcode)
+{
+    u8_t operation = (opcode - SL_OPCODE_VADD) % 8;
+    u8_t is_float = opcode >= SL_OPCODE_VADDF;
+    u8_t has_b = operation <= SLIM_MACHINE_VECTOR_DOT;
+    u8_t has_destination = operation <= SLIM_MACHINE_VECTOR_FMA;
+
+    u64_t length = 0;
+    u64_t a = 0;
+    u64_t b = 0;
+    u64_t destination = 0;
+    SlimError error;
+
+    error = ___slim_machine_operand_pop(machine, &length);
+    if (error != SL_ERROR_NONE) return error;
+
+    if (has_b) {
+        error = ___slim_machine_operand_pop(machine, &b);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    error = ___slim_machine_operand_pop(machine, &a);
+    if (error != SL_ERROR_NONE) return error;
+
+    if (has_destination) {
+        error = ___slim_machine_operand_pop(machine, &destination);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    if (___slim_machine_memory_range(a, length) != SL_ERROR_NONE) return SLIM_ERROR;
+    if (___slim_machine_memory_range(b, length) != SL_ERROR_NONE) return SLIM_ERROR;
+    if (___slim_machine_memory_range(destination, length) != SL_ERROR_NONE) return SLIM_ERROR;
+
+    const SlimMachineVectorKernels* kernels = ___slim_machine_vector_kernels_get();
+    u64_t* memory = machine->memory;
+
+    if (has_destination) {
+        if (___slim_machine_memory_writable(machine, destination, length) != SL_ERROR_NONE) return SLIM_ERROR;
+        if (destination != a && destination < a + length && a < destination + length) return SLIM_ERROR;
+        if (destination != b && destination < b + length && b < destination + length) return SLIM_ERROR;
+
+        if (is_float) {
+            kernels->map_float(operation, (double*)(memory + destination), (const double*)(memory + a),
+                               (const double*)(memory + b), (u32_t)length);
+        } else {
+            kernels->map_integer(operation, memory + destination, memory + a, memory + b, (u32_t)length);
+        }
+
+        return SL_ERROR_NONE;
+    }
+
+    // Minimum and maximum have no value for an empty array
+    if (length == 0 && (operation == SLIM_MACHINE_VECTOR_MIN || operation == SLIM_MACHINE_VECTOR_MAX)) {
+        return SLIM_ERROR;
+    }
+
+    u64_t result;
+    if (is_float) {
+        double result_double =
+            kernels->reduce_float(operation, (const double*)(memory + a), (const double*)(memory + b), (u32_t)length);
+        result = *((u64_t*)&result_double);
+    } else {
+        result = kernels->reduce_integer(operation, memory + a, memory + b, (u32_t)length);
+    }
+
+    return ___slim_machine_operand_push(machine, result);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_local_load(SlimMachineState machine, u32_t slot)
+{
+    SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+    if (slot >= frame->size) {
+        return SLIM_ERROR;
+    }
+
+    return ___slim_machine_operand_push(machine, machine->operand_stack[frame->base_pointer + slot]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_local_store(SlimMachineState machine, u32_t slot)
+{
+    SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+    if (slot >= frame->size) {
+        return SLIM_ERROR;
+    }
+
+    // Locals live below the working stack, so popping one of them is a stack underflow
+    if (machine->operand_stack_pointer <= frame->base_pointer + frame->size) {
+        return SLIM_ERROR;
+    }
+
+    u64_t value;
+    SlimError error = ___slim_machine_operand_pop(machine, &value);
+    if (error != SL_ERROR_NONE) {
+        return error;
+    }
+
+    machine->operand_stack[frame->base_pointer + slot] = value;
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_local_decrement(SlimMachineState machine, u32_t slot, u64_t* value)
+{
+    SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+    if (slot >= frame->size) {
+        return SLIM_ERROR;
+    }
+
+    *value = --machine->operand_stack[frame->base_pointer + slot];
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_function_call(
+    SlimMachineState machine, u32_t address, u32_t local_count, u32_t argument_count)
+{
+    if (machine->call_stack_pointer + 1 >= SLIM_MACHINE_CALL_STACK_SIZE) {
+        return SLIM_ERROR;
+    }
+
+    // The arguments on top of the caller's stack become the first locals, the rest are zeroed above them
+    if (argument_count > local_count || argument_count > machine->operand_stack_pointer) {
+        return SLIM_ERROR;
+    }
+
+    u32_t base_pointer = machine->operand_stack_pointer - argument_count;
+    if (local_count > SLIM_MACHINE_OPERAND_STACK_SIZE - base_pointer) {
+        return SLIM_ERROR;
+    }
+
+    SlimMachineStackFrame* frame = &machine->call_stack[++machine->call_stack_pointer];
+    frame->instruction_pointer = machine->instruction_pointer;
+    frame->return_pointer = base_pointer;
+    frame->base_pointer = base_pointer;
+    frame->size = local_count;
+
+    memset(&machine->operand_stack[base_pointer + argument_count], 0, (local_count - argument_count) * sizeof(u64_t));
+    machine->operand_stack_pointer = base_pointer + local_count;
+
+    ___slim_machine_fuel_charge(machine, 1);
+    machine->instruction_pointer = address;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_function_tailcall(
+    SlimMachineState machine, u32_t address, u32_t local_count, u32_t argument_count)
+{
+    SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+
+    // The arguments on top of the stack replace the current frame and whatever lay below it since the frame was first
+    // called.  The return address is kept, so the callee returns straight to our caller.
+    if (argument_count > local_count || machine->operand_stack_pointer < frame->return_pointer + argument_count) {
+        return SLIM_ERROR;
+    }
+
+    u32_t base_pointer = frame->return_pointer;
+    if (local_count > SLIM_MACHINE_OPERAND_STACK_SIZE - base_pointer) {
+        return SLIM_ERROR;
+    }
+
+    u32_t argument_start = machine->operand_stack_pointer - argument_count;
+    memmove(&machine->operand_stack[base_pointer], &machine->operand_stack[argument_start],
+            argument_count * sizeof(u64_t));
+
+    frame->base_pointer = base_pointer;
+    frame->size = local_count;
+
+    memset(&machine->operand_stack[base_pointer + argument_count], 0, (local_count - argument_count) * sizeof(u64_t));
+    machine->operand_stack_pointer = base_pointer + local_count;
+
+    ___slim_machine_fuel_charge(machine, 1);
+    machine->instruction_pointer = address;
+    return SL_ERROR_NONE;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-SlimError ___slim_machine_function_call(SlimMachineState machine, u32_t address)
+SlimError ___slim_machine_function_ret(SlimMachineState machine)
 {
-    machine->call_stack_pointer++;
-    if (machine->call_stack_pointer >= SLIM_MACHINE_CALL_STACK_SIZE) {
+    if (machine->call_stack_pointer == 0) {
         return SLIM_ERROR;
     }
 
-    machine->call_stack[machine->call_stack_pointer].instruction_pointer = machine->instruction_pointer;
-    machine->call_stack[machine->call_stack_pointer].size = 0;
-    machine->instruction_pointer = address;
+    SlimMachineStackFrame* frame = &machine->call_stack[machine->call_stack_pointer];
+
+    // The whole frame is discarded at once, and the top of whatever is left in it is the return value.  A frame that
+    // popped below its return pointer has nothing left, and the stack stays where it is rather than growing back over
+    // stale slots.
+    u32_t stack_pointer = machine->operand_stack_pointer;
+    if (stack_pointer > frame->return_pointer) {
+        machine->operand_stack[frame->return_pointer] = machine->operand_stack[stack_pointer - 1];
+        stack_pointer = frame->return_pointer + 1;
+    }
+    machine->operand_stack_pointer = stack_pointer;
+
+    machine->instruction_pointer = frame->instruction_pointer;
+    machine->call_stack_pointer--;
+
     return SL_ERROR_NONE;
 }
+// Parallel For --------------------------------------------------------------------------------------------------------
+// PARFOR splits [begin, end) into chunks and runs the function once per chunk, each in a child machine on the shared
+// thread pool.  A child starts with an empty stack and the function's locals, slots 0 and 1 holding the first and one
+// past the last index of its chunk.  It ends when the function returns, and fails on an error, a halt or a native
+// call, since natives belong to the platform's thread.  Chunks only store to their own output words, output + i for
+// every index i of the chunk, so they can neither race nor see each other's results.
+typedef struct SlimMachineParallelJob {
+    SlimMachineState parent;
+    SlimBytecodeTable table;
+    u32_t address;
+    u32_t local_count;
+    u64_t output;
+    u64_t begin;
+    u64_t end;
+    u32_t chunk_count;
+    u8_t failed;
+} SlimMachineParallelJob;
+
+static SlimLogContext SLIM_MACHINE_SILENT_LOG = NULL;
 // ---------------------------------------------------------------------------------------------------------------------
-SlimError ___slim_machine_function_ret(SlimMachineState machine)
+void ___slim_machine_parallel_chunk(void* argument, u32_t index)
 {
-    u32_t ret_address = machine->call_stack[machine->call_stack_pointer].instruction_pointer;
-    u16_t count = machine->call_stack[machine->call_stack_pointer].size;
-    machine->call_stack[machine->call_stack_pointer].instruction_pointer = 0;
-    machine->call_stack[machine->call_stack_pointer].size = 0;
+    SlimMachineParallelJob* job = argument;
 
-    machine->call_stack_pointer--;
-    if (machine->call_stack_pointer < 0) {
-        return SLIM_ERROR;
-    }
+    u64_t count = job->end - job->begin;
+    u64_t first = job->begin + count * index / job->chunk_count;
+    u64_t last = job->begin + count * (index + 1) / job->chunk_count;
 
-    machine->instruction_pointer = ret_address;
+    // Only the parts of the machine the child reads before writing are set up, the stacks are far larger than a chunk
+    // needs.  Children log nowhere, the parent's log is not safe to share between threads.
+    SlimMachineState child = malloc(sizeof(struct SlimMachineState));
+    if (child == NULL) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
-    for (u16_t i = 0; i < count; i++) {
-        u64_t value;
-        SlimError error = ___slim_machine_operand_pop(machine, &value);
-        if (error != SL_ERROR_NONE) {
-            return error;
+    child->trap = (SlimMachineTrap){SLIM_MACHINE_TRAP_NONE, SL_ERROR_NONE, 0, 0};
+    child->operand_stack_pointer = 0;
+    child->call_stack_pointer = 0;
+    child->instruction_pointer = 0;
+    memset(&child->call_stack[0], 0, sizeof(SlimMachineStackFrame));
+    memset(child->registers, 0, sizeof(child->registers));
+    child->blocks = NULL;
+    child->memory = job->parent->memory;
+    child->writable_start = (u32_t)(job->output + first);
+    child->writable_end = (u32_t)(job->output + last);
+    child->parent = job->parent;
+    memset(&child->parking, 0, sizeof(child->parking));
+    child->parking.descriptor = -1;
+    child->fuel = INT64_MAX;
+    child->fuel_budget = 0;
+    child->retired = 0;
+    child->console = NULL;
+    child->bytecode = NULL;
+    child->bytecode_size = 0;
+    child->bytecode_table = job->table;
+    child->log_context = &SLIM_MACHINE_SILENT_LOG;
+    // Children have nowhere to trace to and no counters of their own, only checking carries over
+    child->variant = job->parent->variant == SLIM_MACHINE_VARIANT_CHECKED ? SLIM_MACHINE_VARIANT_CHECKED
+                                                                          : SLIM_MACHINE_VARIANT_FAST;
+    child->profile = NULL;
+    child->opcode_counts = NULL;
+
+    SLIM_TRACE_BEGIN("parfor", first);
+    // The chunk's bounds are passed like the arguments of a call
+    child->operand_stack[0] = first;
+    child->operand_stack[1] = last;
+    child->operand_stack_pointer = 2;
+    SlimError error = ___slim_machine_function_call(child, job->address, job->local_count, 2);
+
+    while (error == SL_ERROR_NONE && child->call_stack_pointer > 0) {
+        slim_machine_step(child, job->table);
+        if (child->trap.kind != SLIM_MACHINE_TRAP_NONE) {
+            error = SLIM_ERROR;
         }
     }
 
-    return SL_ERROR_NONE;
+    SLIM_TRACE_END("parfor", first);
+    free(child);
+
+    if (error != SL_ERROR_NONE) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_machine_parallel_for(
+    SlimMachineState machine, u32_t address, u32_t local_count, u64_t output, u64_t begin, u64_t end)
+{
+    // Children cannot fork again, the pool must not run a job from one of its own tasks
+    if (machine->parent != NULL) return SLIM_ERROR;
+
+    if (local_count < 2 || begin > end) return SLIM_ERROR;
+    if (output > SLIM_MACHINE_MEMORY_SIZE || end > SLIM_MACHINE_MEMORY_SIZE) return SLIM_ERROR;
+    if (___slim_machine_memory_writable(machine, output + begin, end - begin) != SL_ERROR_NONE) return SLIM_ERROR;
+
+    if (begin == end) return SL_ERROR_NONE;
+
+    // Lookups decode sections on demand, which children on several threads must not do at once.  Once every section
+    // is decoded the table is only read.
+    SlimError error = slim_bytecode_table_prepare(machine->bytecode_table, 1);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimThreadPool pool = slim_thread_pool_shared();
+    if (pool == NULL) return SLIM_ERROR;
+
+    // A few chunks per thread even out functions whose cost varies with the index
+    u64_t chunk_count = (u64_t)(slim_thread_pool_get_count_workers(pool) + 1) * 4;
+    if (chunk_count > end - begin) chunk_count = end - begin;
+
+    SlimMachineParallelJob job = {
+        .parent = machine,
+        .table = machine->bytecode_table,
+        .address = address,
+        .local_count = local_count,
+        .output = output,
+        .begin = begin,
+        .end = end,
+        .chunk_count = (u32_t)chunk_count,
+        .failed = 0,
+    };
+    slim_thread_pool_run(pool, job.chunk_count, ___slim_machine_parallel_chunk, &job);
+
+    return job.failed ? SLIM_ERROR : SL_ERROR_NONE;
 }
 // Block Management ----------------------------------------------------------------------------------------------------
 SlimMachineBlock* slim_machine_block_create(u32_t start, u32_t end)
@@ -515,7 +1828,7 @@ SlimError slim_machine_block_merge(SlimMachineBlock* block)
 #define slim_machine_except(machine, thrownError)                                                                      \
     {                                                                                                                  \
         if (thrownError != SL_ERROR_NONE) {                                                                            \
-            ___slim_machine_flag_error_raise(machine);                                                                 \
+            ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_ERROR, thrownError);                                       \
             return;                                                                                                    \
         }                                                                                                              \
     }
@@ -550,29 +1863,36 @@ SlimError slim_machine_block_merge(SlimMachineBlock* block)
     error = ___slim_machine_operand_push(machine, result);                                                             \
     slim_machine_except(machine, error);
 // ---------------------------------------------------------------------------------------------------------------------
+// Used to template compare-and-branch operations, the operands are reinterpreted as type before comparing
+#define ___slim_routine_branch_compare(type, operation)                                                                \
+    u64_t a;                                                                                                           \
+    u64_t b;                                                                                                           \
+    SlimError error;                                                                                                   \
+    error = ___slim_machine_operand_pop(machine, &b);                                                                  \
+    slim_machine_except(machine, error);                                                                               \
+    error = ___slim_machine_operand_pop(machine, &a);                                                                  \
+    slim_machine_except(machine, error);                                                                               \
+    if (*((type*)&a) operation *((type*)&b)) {                                                                         \
+        error = ___slim_machine_bytecode_jump(machine, instruction.arg2);                                              \
+        slim_machine_except(machine, error);                                                                           \
+    }
+// ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_nop(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-    slim_log_info("[ROUTINE]\tNOP\n");
     return;
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_halt(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-    slim_log_info("[ROUTINE]\tHALT\n");
-    ___slim_machine_flag_error_raise(machine);
+    ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_HALT, SL_ERROR_NONE);
     return;
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_loadi(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
     SlimError error;
 
     u64_t value = (u64_t)instruction.arg1 << 32 | instruction.arg2;
-    slim_log_info("[ROUTINE]\tLOADI 0x%x\n", value);
 
     error = ___slim_machine_operand_push(machine, value);
 
@@ -585,11 +1905,7 @@ void slim_machine_routine_loadi(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_loadr(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tLOADR %d\n", instruction.arg1);
-
-    u32_t index = instruction.arg1;
+    u32_t index = instruction.arg2;
 
     SlimError error = ___slim_machine_register_load(machine, index);
     slim_machine_except(machine, error);
@@ -599,13 +1915,8 @@ void slim_machine_routine_loadr(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_loadm(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tLOADM %d, %d\n", instruction.arg1, instruction.arg2);
-
     u64_t address = 0;
-    // TODO: Which arg is it?
-    u32_t offset = instruction.arg1;
+    u32_t offset = instruction.arg2;
     SlimError error;
 
     error = ___slim_machine_operand_pop(machine, &address);
@@ -619,11 +1930,8 @@ void slim_machine_routine_loadm(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_drop(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tDROP\n");
-
-    SlimError error = ___slim_machine_operand_pop(machine, NULL);
+    u64_t value;
+    SlimError error = ___slim_machine_operand_pop(machine, &value);
     slim_machine_except(machine, error);
 
     return;
@@ -631,11 +1939,7 @@ void slim_machine_routine_drop(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_storer(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tSTORER %d\n", instruction.arg1);
-
-    u32_t index = instruction.arg1;
+    u32_t index = instruction.arg2;
     SlimError error;
 
     error = ___slim_machine_register_store(machine, index);
@@ -646,10 +1950,6 @@ void slim_machine_routine_storer(SlimMachineState machine, SlimMachineInstructio
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_storem(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tSTOREM %d\n", instruction.arg1);
-
     u64_t address;
     u64_t offset;
     SlimError error;
@@ -657,20 +1957,60 @@ void slim_machine_routine_storem(SlimMachineState machine, SlimMachineInstructio
     error = ___slim_machine_operand_pop(machine, &address);
     slim_machine_except(machine, error);
 
+    offset = instruction.arg2;
+    error = ___slim_machine_memory_write(machine, address, offset);
     slim_machine_except(machine, error);
 
-    offset = instruction.arg1;
-    error = ___slim_machine_memory_write(machine, address, offset);
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_loadk(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    u64_t value;
+    SlimError error;
+
+    error = slim_bytecode_table_lookup_constant(machine->bytecode_table, instruction.arg2, &value);
+    slim_machine_except(machine, error);
+
+    error = ___slim_machine_operand_push(machine, value);
+    slim_machine_except(machine, error);
 
     return;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void slim_machine_routine_dup(SlimMachineState machine, SlimMachineInstruction instruction)
+void slim_machine_routine_loads(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
+    // Strings are interned, so the index itself serves as the handle and compares equal iff the strings do
+    SlimError error = SL_ERROR_NONE;
+    if (instruction.arg2 >= slim_bytecode_table_get_count_strings(machine->bytecode_table)) {
+        error = SLIM_ERROR;
+    }
+    slim_machine_except(machine, error);
+
+    error = ___slim_machine_operand_push(machine, instruction.arg2);
+    slim_machine_except(machine, error);
+
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_loadl(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    SlimError error = ___slim_machine_local_load(machine, instruction.arg2);
+    slim_machine_except(machine, error);
 
-    slim_log_info("[ROUTINE]\tDUP\n");
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_storel(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    SlimError error = ___slim_machine_local_store(machine, instruction.arg2);
+    slim_machine_except(machine, error);
 
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_dup(SlimMachineState machine, SlimMachineInstruction instruction)
+{
     u64_t value;
     SlimError error;
 
@@ -688,10 +2028,6 @@ void slim_machine_routine_dup(SlimMachineState machine, SlimMachineInstruction i
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_swap(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tSWAP\n");
-
     u64_t a;
     u64_t b;
     SlimError error;
@@ -713,10 +2049,6 @@ void slim_machine_routine_swap(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_rot(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tROT\n");
-
     u64_t a;
     u64_t b;
     u64_t c;
@@ -745,82 +2077,51 @@ void slim_machine_routine_rot(SlimMachineState machine, SlimMachineInstruction i
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_add(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tADD\n");
     ___slim_routine_binary_integer(+);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_sub(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tSUB\n");
     ___slim_routine_binary_integer(-);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_mul(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tMUL\n");
     ___slim_routine_binary_integer(*);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_div(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tDIV\n");
     ___slim_routine_binary_integer(/);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_mod(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tMOD\n");
     ___slim_routine_binary_integer(%);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_addf(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tADDF\n");
     ___slim_routine_binary_float(+);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_subf(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tSUBF\n");
     ___slim_routine_binary_float(-);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_mulf(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tMULF\n");
     ___slim_routine_binary_float(*);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_divf(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tDIVF\n");
     ___slim_routine_binary_float(/);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_modf(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tMODF\n");
-
     u64_t a;
     u64_t b;
     SlimError error;
@@ -842,11 +2143,7 @@ void slim_machine_routine_modf(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_alloc(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tALLOC %d\n", instruction.arg1);
-
-    u32_t size = instruction.arg1;
+    u32_t size = instruction.arg2;
     SlimError error;
 
     u32_t address;
@@ -862,22 +2159,78 @@ void slim_machine_routine_alloc(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_free(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
+    SlimError error = ___slim_machine_memory_free(machine, instruction.arg1);
+    slim_machine_except(machine, error);
+
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_memcopy(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    u64_t length;
+    u64_t source;
+    u64_t destination;
+    SlimError error;
 
-    slim_log_info("[ROUTINE]\tFREE %d\n", instruction.arg1);
+    error = ___slim_machine_operand_pop(machine, &length);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &source);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &destination);
+    slim_machine_except(machine, error);
 
-    SlimError error = ___slim_machine_memory_free(machine, instruction.arg1);
+    error = ___slim_machine_memory_copy(machine, destination, source, length);
     slim_machine_except(machine, error);
 
     return;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void slim_machine_routine_jmp(SlimMachineState machine, SlimMachineInstruction instruction)
+void slim_machine_routine_memfill(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
+    u64_t length;
+    u64_t value;
+    u64_t destination;
+    SlimError error;
+
+    error = ___slim_machine_operand_pop(machine, &length);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &value);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &destination);
+    slim_machine_except(machine, error);
+
+    error = ___slim_machine_memory_fill(machine, destination, value, length);
+    slim_machine_except(machine, error);
+
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_memcmp(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    u64_t length;
+    u64_t b;
+    u64_t a;
+    s64_t result;
+    SlimError error;
+
+    error = ___slim_machine_operand_pop(machine, &length);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &b);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &a);
+    slim_machine_except(machine, error);
+
+    error = ___slim_machine_memory_compare(machine, a, b, length, &result);
+    slim_machine_except(machine, error);
 
-    slim_log_info("[ROUTINE]\tJUMP %d\n", instruction.arg2);
+    error = ___slim_machine_operand_push(machine, (u64_t)result);
+    slim_machine_except(machine, error);
 
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jmp(SlimMachineState machine, SlimMachineInstruction instruction)
+{
     u32_t address = instruction.arg2;
     SlimError error = ___slim_machine_bytecode_jump(machine, address);
     slim_machine_except(machine, error);
@@ -887,16 +2240,12 @@ void slim_machine_routine_jmp(SlimMachineState machine, SlimMachineInstruction i
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_jne(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tJNE %d\n", instruction.arg1);
-
     u64_t value;
     SlimError error = ___slim_machine_operand_pop(machine, &value);
     slim_machine_except(machine, error);
 
     if (value != 0) {
-        error = ___slim_machine_bytecode_jump(machine, instruction.arg1);
+        error = ___slim_machine_bytecode_jump(machine, instruction.arg2);
         slim_machine_except(machine, error);
     }
 
@@ -905,30 +2254,98 @@ void slim_machine_routine_jne(SlimMachineState machine, SlimMachineInstruction i
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_je(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tJE %d\n", instruction.arg1);
-
     u64_t value;
     SlimError error = ___slim_machine_operand_pop(machine, &value);
     slim_machine_except(machine, error);
 
     if (value == 0) {
-        error = ___slim_machine_bytecode_jump(machine, instruction.arg1);
+        error = ___slim_machine_bytecode_jump(machine, instruction.arg2);
         slim_machine_except(machine, error);
     }
 
     return;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void slim_machine_routine_call(SlimMachineState machine, SlimMachineInstruction instruction)
+void slim_machine_routine_jlt(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
+    ___slim_routine_branch_compare(s64_t, <);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jle(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(s64_t, <=);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jgt(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(s64_t, >);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jge(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(s64_t, >=);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jltu(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(u64_t, <);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jleu(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(u64_t, <=);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jgtu(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(u64_t, >);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jgeu(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(u64_t, >=);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jltf(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(double, <);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jlef(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(double, <=);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jgtf(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(double, >);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_jgef(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    ___slim_routine_branch_compare(double, >=);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_djnz(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    u64_t value;
+    SlimError error = ___slim_machine_local_decrement(machine, instruction.arg1, &value);
+    slim_machine_except(machine, error);
 
-    slim_log_info("[ROUTINE]\tCALL %x\n", instruction.arg2);
+    if (value != 0) {
+        error = ___slim_machine_bytecode_jump(machine, instruction.arg2);
+        slim_machine_except(machine, error);
+    }
 
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_call(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    // The loader packs the callee's local count into the low half of arg1 and its argument count into the high half
     u32_t address = instruction.arg2;
-    SlimError error = ___slim_machine_function_call(machine, address);
+    SlimError error =
+        ___slim_machine_function_call(machine, address, instruction.arg1 & 0xFFFF, instruction.arg1 >> 16);
     slim_machine_except(machine, error);
 
     return;
@@ -936,29 +2353,52 @@ void slim_machine_routine_call(SlimMachineState machine, SlimMachineInstruction
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_machine_routine_ret(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
-
-    slim_log_info("[ROUTINE]\tRET\n");
-
     SlimError error = ___slim_machine_function_ret(machine);
     slim_machine_except(machine, error);
 
     return;
 }
 // ---------------------------------------------------------------------------------------------------------------------
-void slim_machine_routine_calln(SlimMachineState machine, SlimMachineInstruction instruction)
+void slim_machine_routine_tailcall(SlimMachineState machine, SlimMachineInstruction instruction)
 {
-    slim_log_using_context(machine->log_context);
+    u32_t address = instruction.arg2;
+    SlimError error =
+        ___slim_machine_function_tailcall(machine, address, instruction.arg1 & 0xFFFF, instruction.arg1 >> 16);
+    slim_machine_except(machine, error);
+
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_parfor(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    u64_t end;
+    u64_t begin;
+    u64_t output;
+    SlimError error;
+
+    error = ___slim_machine_operand_pop(machine, &end);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &begin);
+    slim_machine_except(machine, error);
+    error = ___slim_machine_operand_pop(machine, &output);
+    slim_machine_except(machine, error);
 
-    slim_log_info("[ROUTINE]\tCALLN %x\n", instruction.arg2);
+    // Like CALL, the loader packs the function's local count into the low half of arg1
+    error = ___slim_machine_parallel_for(machine, instruction.arg2, instruction.arg1 & 0xFFFF, output, begin, end);
+    slim_machine_except(machine, error);
 
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_calln(SlimMachineState machine, SlimMachineInstruction instruction)
+{
     // We need to signal an interrupt to the platform and push the identifier of the function to call
     // The platform will then call the function and push the result back to the machine
 
     SlimError error = ___slim_machine_operand_push(machine, instruction.arg2);
     slim_machine_except(machine, error);
 
-    ___slim_machine_flag_error_raise(machine);
+    ___slim_machine_trap(machine, SLIM_MACHINE_TRAP_INTERRUPT, SL_ERROR_NONE);
 
     return;
 }
@@ -967,14 +2407,13 @@ void slim_machine_routine_cast(SlimMachineState machine, SlimMachineInstruction
 {
     slim_log_using_context(machine->log_context);
 
-    slim_log_info("[ROUTINE]\tCAST %d\n", instruction.arg1);
-
     u64_t original_value;
     SlimError error = ___slim_machine_operand_pop(machine, &original_value);
     slim_machine_except(machine, error);
 
-    SlimRuntimeCastArg original_type = (SlimRuntimeCastArg)instruction.arg1;
-    SlimRuntimeCastArg new_type = (SlimRuntimeCastArg)instruction.arg2;
+    // The operand packs the original type in the high byte and the new type in the low byte
+    SlimRuntimeCastArg original_type = (SlimRuntimeCastArg)((instruction.arg2 >> 8) & 0xFF);
+    SlimRuntimeCastArg new_type = (SlimRuntimeCastArg)(instruction.arg2 & 0xFF);
 
     u64_t new_value;
 
@@ -989,6 +2428,17 @@ void slim_machine_routine_cast(SlimMachineState machine, SlimMachineInstruction
         slim_machine_except(machine, SLIM_ERROR);
     }
 
+    error = ___slim_machine_operand_push(machine, new_value);
+    slim_machine_except(machine, error);
+
+    return;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_machine_routine_vector(SlimMachineState machine, SlimMachineInstruction instruction)
+{
+    SlimError error = ___slim_machine_memory_vector(machine, instruction.opcode);
+    slim_machine_except(machine, error);
+
     return;
 }
-// ---------------------------------------------------------------------------------------------------------------------
\ No newline at end of file
+// ---------------------------------------------------------------------------------------------------------------------
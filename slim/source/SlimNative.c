@@ -1,6 +1,422 @@
+#include <SlimChannel.h>
+#include <SlimConsole.h>
+#include <SlimData.h>
 #include <SlimNative.h>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+// ---------------------------------------------------------------------------------------------------------------------
+typedef struct SlimNativeEntry {
+    char* identifier;
+    SlimNativeFunction function;
+} SlimNativeEntry;
 
+SLIM_VECTOR_DECLARE(SlimNativeTable, SlimNativeEntry, 16)
 
+static SlimNativeTable ___slim_native_table = {NULL, 0, 0, {{0}}};
+static u32_t ___slim_native_users = 0;
+static pthread_mutex_t ___slim_native_lock = PTHREAD_MUTEX_INITIALIZER;
+// Built-in Natives ----------------------------------------------------------------------------------------------------
+static void ___slim_native_channel_wait_send(void* channel) { slim_channel_wait_send(channel); }
+static void ___slim_native_channel_wait_recv(void* channel) { slim_channel_wait_recv(channel); }
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_channel_create(SlimMachineState machine)
+{
+    u64_t capacity, kind, handle;
+    SlimError error = slim_machine_pop(machine, &capacity);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &kind);
+    if (error != SL_ERROR_NONE) return error;
+    if (kind > SLIM_CHANNEL_MPMC || capacity > 0xFFFFFFFF) return SLIM_ERROR;
+
+    SlimChannel channel;
+    error = slim_channel_create((SlimChannelKind)kind, (u32_t)capacity, &channel);
+    if (error != SL_ERROR_NONE) return error;
+
+    error = slim_channel_table_insert(channel, &handle);
+    if (error != SL_ERROR_NONE) {
+        slim_channel_destroy(channel);
+        return error;
+    }
+
+    return slim_machine_push(machine, handle);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_channel_send(SlimMachineState machine)
+{
+    u64_t value, handle;
+    SlimError error = slim_machine_pop(machine, &value);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &handle);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimChannel channel;
+    error = slim_channel_table_lookup(handle, &channel);
+    if (error != SL_ERROR_NONE) return error;
+
+    if (slim_channel_try_send(channel, value)) return SL_ERROR_NONE;
+
+    // Full, put the arguments back for the retry
+    slim_native_retry_after(machine, ___slim_native_channel_wait_send, channel);
+    error = slim_machine_push(machine, handle);
+    if (error != SL_ERROR_NONE) return error;
+    return slim_machine_push(machine, value);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_channel_recv(SlimMachineState machine)
+{
+    u64_t handle, value;
+    SlimError error = slim_machine_pop(machine, &handle);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimChannel channel;
+    error = slim_channel_table_lookup(handle, &channel);
+    if (error != SL_ERROR_NONE) return error;
+
+    if (slim_channel_try_recv(channel, &value)) return slim_machine_push(machine, value);
+
+    slim_native_retry_after(machine, ___slim_native_channel_wait_recv, channel);
+    return slim_machine_push(machine, handle);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_channel_try_recv(SlimMachineState machine)
+{
+    u64_t handle, value = 0;
+    SlimError error = slim_machine_pop(machine, &handle);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimChannel channel;
+    error = slim_channel_table_lookup(handle, &channel);
+    if (error != SL_ERROR_NONE) return error;
+
+    u8_t received = slim_channel_try_recv(channel, &value);
+    error = slim_machine_push(machine, value);
+    if (error != SL_ERROR_NONE) return error;
+    return slim_machine_push(machine, received);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_sleep(SlimMachineState machine)
+{
+    u64_t milliseconds;
+    SlimError error = slim_machine_pop(machine, &milliseconds);
+    if (error != SL_ERROR_NONE) return error;
+
+    if (milliseconds > 0) slim_native_resume_at(machine, slim_native_clock() + milliseconds * 1000000);
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_file_await(SlimMachineState machine, SlimIoRequest request)
+{
+    // The platform frees the request once it has pushed the result
+    SlimIoRequest* pending = malloc(sizeof(SlimIoRequest));
+    if (pending == NULL) return SLIM_ERROR;
+
+    *pending = request;
+    slim_native_await_io(machine, pending);
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_file_open(SlimMachineState machine)
+{
+    static const s32_t flags[] = {
+        O_RDONLY,
+        O_WRONLY | O_CREAT | O_TRUNC,
+        O_RDWR | O_CREAT,
+        O_WRONLY | O_CREAT | O_APPEND,
+    };
+
+    u64_t mode, path;
+    SlimError error = slim_machine_pop(machine, &mode);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &path);
+    if (error != SL_ERROR_NONE) return error;
+    if (mode >= sizeof(flags) / sizeof(flags[0])) return SLIM_ERROR;
+
+    SlimIoRequest request = {SLIM_IO_OPEN, -1, NULL, flags[mode] | O_CLOEXEC, 0644, NULL, 0, 0, 0, NULL, NULL};
+    error = slim_machine_lookup_string(machine, path, &request.path);
+    if (error != SL_ERROR_NONE) return error;
+
+    return ___slim_native_file_await(machine, request);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_file_transfer(SlimMachineState machine, SlimIoOperation operation)
+{
+    // Bytes are packed eight to a word in host order, so SIZE bytes span (SIZE + 7) / 8 words from ADDRESS
+    u64_t size, address, descriptor;
+    SlimError error = slim_machine_pop(machine, &size);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &address);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &descriptor);
+    if (error != SL_ERROR_NONE) return error;
+    if (size > 0xFFFFFFFF || descriptor > 0x7FFFFFFF) return SLIM_ERROR;
+
+    u64_t* words;
+    error = slim_machine_memory(machine, address, (size + 7) / 8, operation == SLIM_IO_READ, &words);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimIoRequest request = {operation, (s32_t)descriptor, NULL, 0, 0, words, (u32_t)size, (u64_t)-1, 0, NULL, NULL};
+    return ___slim_native_file_await(machine, request);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_file_read(SlimMachineState machine)
+{
+    return ___slim_native_file_transfer(machine, SLIM_IO_READ);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_file_write(SlimMachineState machine)
+{
+    return ___slim_native_file_transfer(machine, SLIM_IO_WRITE);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_file_close(SlimMachineState machine)
+{
+    u64_t descriptor;
+    SlimError error = slim_machine_pop(machine, &descriptor);
+    if (error != SL_ERROR_NONE) return error;
+    if (descriptor > 0x7FFFFFFF) return SLIM_ERROR;
+
+    SlimIoRequest request = {SLIM_IO_CLOSE, (s32_t)descriptor, NULL, 0, 0, NULL, 0, 0, 0, NULL, NULL};
+    return ___slim_native_file_await(machine, request);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_native_console_wait(void* argument)
+{
+    struct pollfd readable = {slim_console_get_input(), POLLIN, 0};
+    poll(&readable, 1, -1);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_stdputch(SlimMachineState machine)
+{
+    u64_t character;
+    SlimError error = slim_machine_pop(machine, &character);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimConsoleBuffer console;
+    error = slim_machine_console(machine, &console);
+    if (error != SL_ERROR_NONE) return error;
+
+    u8_t byte = (u8_t)character;
+    return slim_console_write(console, &byte, 1);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_stdputstr(SlimMachineState machine)
+{
+    // One character per word, as stdputch takes them
+    u64_t length, address;
+    SlimError error = slim_machine_pop(machine, &length);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &address);
+    if (error != SL_ERROR_NONE) return error;
+
+    u64_t* words;
+    error = slim_machine_memory(machine, address, length, 0, &words);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimConsoleBuffer console;
+    error = slim_machine_console(machine, &console);
+    if (error != SL_ERROR_NONE) return error;
+
+    u8_t bytes[256];
+    for (u64_t i = 0; error == SL_ERROR_NONE && i < length; i += sizeof(bytes)) {
+        u32_t count = length - i < sizeof(bytes) ? (u32_t)(length - i) : (u32_t)sizeof(bytes);
+        for (u32_t j = 0; j < count; j++) bytes[j] = (u8_t)words[i + j];
+        error = slim_console_write(console, bytes, count);
+    }
+
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_stdputbuf(SlimMachineState machine)
+{
+    // Bytes packed eight to a word, as file_write takes them
+    u64_t size, address;
+    SlimError error = slim_machine_pop(machine, &size);
+    if (error != SL_ERROR_NONE) return error;
+    error = slim_machine_pop(machine, &address);
+    if (error != SL_ERROR_NONE) return error;
+    if (size > 0xFFFFFFFF) return SLIM_ERROR;
+
+    u64_t* words;
+    error = slim_machine_memory(machine, address, (size + 7) / 8, 0, &words);
+    if (error != SL_ERROR_NONE) return error;
+
+    SlimConsoleBuffer console;
+    error = slim_machine_console(machine, &console);
+    if (error != SL_ERROR_NONE) return error;
+
+    return slim_console_write(console, words, (u32_t)size);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_stdflush(SlimMachineState machine)
+{
+    SlimConsoleBuffer console;
+    SlimError error = slim_machine_console(machine, &console);
+    if (error != SL_ERROR_NONE) return error;
+
+    return slim_console_flush(console);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_stdgetch(SlimMachineState machine)
+{
+    // A prompt has to be out before the machine waits for the answer
+    SlimError error = ___slim_native_stdflush(machine);
+    if (error != SL_ERROR_NONE) return error;
+
+    s32_t byte;
+    if (!slim_console_try_read(&byte)) {
+        struct pollfd readable = {slim_console_get_input(), POLLIN, 0};
+        if (poll(&readable, 1, 0) == 0) {
+            slim_native_retry_after(machine, ___slim_native_console_wait, NULL);
+            return SL_ERROR_NONE;
+        }
+
+        error = slim_console_fill();
+        if (error != SL_ERROR_NONE) return error;
+        if (!slim_console_try_read(&byte)) {
+            slim_native_retry_after(machine, ___slim_native_console_wait, NULL);
+            return SL_ERROR_NONE;
+        }
+    }
+
+    return slim_machine_push(machine, (u64_t)(s64_t)byte);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static const struct {
+    const char* identifier;
+    SlimNativeFunction function;
+} SLIM_NATIVE_BUILTINS[] = {
+    {"channel_create", ___slim_native_channel_create},
+    {"channel_send", ___slim_native_channel_send},
+    {"channel_recv", ___slim_native_channel_recv},
+    {"channel_try_recv", ___slim_native_channel_try_recv},
+    {"sleep", ___slim_native_sleep},
+    {"file_open", ___slim_native_file_open},
+    {"file_read", ___slim_native_file_read},
+    {"file_write", ___slim_native_file_write},
+    {"file_close", ___slim_native_file_close},
+    {"stdputch", ___slim_native_stdputch},
+    {"stdputstr", ___slim_native_stdputstr},
+    {"stdputbuf", ___slim_native_stdputbuf},
+    {"stdflush", ___slim_native_stdflush},
+    {"stdgetch", ___slim_native_stdgetch},
+};
+// Internal Functions --------------------------------------------------------------------------------------------------
+static SlimNativeEntry* ___slim_native_find(const char* identifier)
+{
+    for (u32_t i = 0; i < ___slim_native_table.size; i++) {
+        if (strcmp(___slim_native_table.data[i].identifier, identifier) == 0) return &___slim_native_table.data[i];
+    }
+
+    return NULL;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimError ___slim_native_register(const char* identifier, SlimNativeFunction function)
+{
+    SlimNativeEntry* entry = ___slim_native_find(identifier);
+    if (entry != NULL) {
+        entry->function = function;
+        return SL_ERROR_NONE;
+    }
+
+    if (___slim_native_table.data == NULL) SlimNativeTable_init(&___slim_native_table);
+
+    SlimError error = SlimNativeTable_grow(&___slim_native_table, 1);
+    if (error != SL_ERROR_NONE) return error;
+
+    char* copy = strdup(identifier);
+    if (copy == NULL) return SLIM_ERROR;
+
+    SlimNativeEntry created = {copy, function};
+    ___slim_native_table.data[___slim_native_table.size++] = created;
+    return SL_ERROR_NONE;
+}
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_native_init()
+{
+    pthread_mutex_lock(&___slim_native_lock);
+
+    SlimError error = SL_ERROR_NONE;
+    if (___slim_native_users++ == 0) {
+        u32_t count = sizeof(SLIM_NATIVE_BUILTINS) / sizeof(SLIM_NATIVE_BUILTINS[0]);
+        for (u32_t i = 0; error == SL_ERROR_NONE && i < count; i++) {
+            error = ___slim_native_register(SLIM_NATIVE_BUILTINS[i].identifier, SLIM_NATIVE_BUILTINS[i].function);
+        }
+    }
+
+    pthread_mutex_unlock(&___slim_native_lock);
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_native_close()
+{
+    pthread_mutex_lock(&___slim_native_lock);
+
+    if (___slim_native_users > 0 && --___slim_native_users == 0) {
+        for (u32_t i = 0; i < ___slim_native_table.size; i++) free(___slim_native_table.data[i].identifier);
+        if (___slim_native_table.data != NULL) SlimNativeTable_free(&___slim_native_table);
+        ___slim_native_table.data = NULL;
+
+        slim_channel_table_clear();
+    }
+
+    pthread_mutex_unlock(&___slim_native_lock);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_native_register(const char* identifier, SlimNativeFunction function)
+{
+    if (identifier == NULL || function == NULL) return SLIM_ERROR;
+
+    pthread_mutex_lock(&___slim_native_lock);
+    SlimError error = ___slim_native_register(identifier, function);
+    pthread_mutex_unlock(&___slim_native_lock);
+
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_native_lookup(const char* identifier, SlimNativeFunction* function)
+{
+    pthread_mutex_lock(&___slim_native_lock);
+    SlimNativeEntry* entry = ___slim_native_find(identifier);
+    if (entry != NULL) *function = entry->function;
+    pthread_mutex_unlock(&___slim_native_lock);
+
+    return entry != NULL ? SL_ERROR_NONE : SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_native_retry_when_ready(SlimMachineState machine, s32_t descriptor, u32_t events)
+{
+    SlimMachineParking parking = {1, NULL, NULL, descriptor, events, 0, NULL};
+    slim_machine_park(machine, parking);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_native_retry_after(SlimMachineState machine, SlimMachineWait wait, void* argument)
+{
+    SlimMachineParking parking = {1, wait, argument, -1, 0, 0, NULL};
+    slim_machine_park(machine, parking);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_native_resume_at(SlimMachineState machine, u64_t deadline)
+{
+    SlimMachineParking parking = {0, NULL, NULL, -1, 0, deadline, NULL};
+    slim_machine_park(machine, parking);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_native_await_io(SlimMachineState machine, SlimIoRequest* request)
+{
+    SlimMachineParking parking = {0, NULL, NULL, -1, 0, 0, request};
+    slim_machine_park(machine, parking);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u64_t slim_native_clock()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64_t)now.tv_sec * 1000000000 + (u64_t)now.tv_nsec;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,153 @@
+#include <SlimPerf.h>
+
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SLIM_PERF_GROUP_COUNT 3
+// ---------------------------------------------------------------------------------------------------------------------
+typedef struct SlimPerfEvent {
+    const char* name;
+    u32_t type;
+    u64_t config;
+    u32_t group;
+} SlimPerfEvent;
+
+#define ___SLIM_PERF_CACHE(cache, result)                                                                              \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | ((u64_t)(result) << 16))
+
+// The core events fit the fixed and general purpose counters of any PMU, the cache events get a group of their own
+static const SlimPerfEvent ___slim_perf_events[SLIM_PERF_COUNTER_COUNT] = {
+    [SLIM_PERF_TASK_CLOCK] = {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, 0},
+    [SLIM_PERF_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1},
+    [SLIM_PERF_INSTRUCTIONS] = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 1},
+    [SLIM_PERF_BRANCHES] = {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, 1},
+    [SLIM_PERF_BRANCH_MISSES] = {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 1},
+    [SLIM_PERF_L1D_MISSES] = {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+        ___SLIM_PERF_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS), 2},
+    [SLIM_PERF_LLC_MISSES] = {"LLC-load-misses", PERF_TYPE_HW_CACHE,
+        ___SLIM_PERF_CACHE(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS), 2},
+};
+
+struct SlimPerf {
+    s32_t descriptors[SLIM_PERF_COUNTER_COUNT]; // -1 for counters that are not available
+    s32_t leaders[SLIM_PERF_GROUP_COUNT];       // The first counter of each group that opened, -1 for empty groups
+};
+// Internal Functions --------------------------------------------------------------------------------------------------
+static s32_t ___slim_perf_open(const SlimPerfEvent* event, s32_t leader)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = event->type;
+    attributes.config = event->config;
+    attributes.disabled = leader < 0; // Members follow their leader
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (s32_t)syscall(SYS_perf_event_open, &attributes, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+}
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_perf_create(SlimPerf* perf)
+{
+    SlimPerf created = malloc(sizeof(struct SlimPerf));
+    if (created == NULL) return SLIM_ERROR;
+
+    for (u32_t i = 0; i < SLIM_PERF_GROUP_COUNT; i++) created->leaders[i] = -1;
+
+    u8_t available = 0;
+    for (u32_t i = 0; i < SLIM_PERF_COUNTER_COUNT; i++) {
+        const SlimPerfEvent* event = &___slim_perf_events[i];
+        created->descriptors[i] = ___slim_perf_open(event, created->leaders[event->group]);
+        if (created->descriptors[i] < 0) continue;
+
+        if (created->leaders[event->group] < 0) created->leaders[event->group] = created->descriptors[i];
+        available = 1;
+    }
+
+    if (!available) {
+        free(created);
+        return SLIM_ERROR;
+    }
+
+    *perf = created;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_perf_destroy(SlimPerf perf)
+{
+    if (perf == NULL) return;
+
+    for (u32_t i = 0; i < SLIM_PERF_COUNTER_COUNT; i++) {
+        if (perf->descriptors[i] >= 0) close(perf->descriptors[i]);
+    }
+    free(perf);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+const char* slim_perf_counter_name(SlimPerfCounter counter) { return ___slim_perf_events[counter].name; }
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_perf_get_available(SlimPerf perf, SlimPerfCounter counter) { return perf->descriptors[counter] >= 0; }
+// ---------------------------------------------------------------------------------------------------------------------
+u64_t slim_perf_get_value(SlimPerf perf, SlimPerfCounter counter)
+{
+    if (perf->descriptors[counter] < 0) return 0;
+
+    u64_t values[3]; // value, time enabled, time running
+    if (read(perf->descriptors[counter], values, sizeof(values)) != sizeof(values)) return 0;
+
+    if (values[2] == 0) return 0;
+    if (values[2] < values[1]) return (u64_t)((double)values[0] * values[1] / values[2]);
+    return values[0];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_perf_start(SlimPerf perf)
+{
+    for (u32_t i = 0; i < SLIM_PERF_GROUP_COUNT; i++) {
+        if (perf->leaders[i] >= 0) ioctl(perf->leaders[i], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_perf_stop(SlimPerf perf)
+{
+    for (u32_t i = 0; i < SLIM_PERF_GROUP_COUNT; i++) {
+        if (perf->leaders[i] >= 0) ioctl(perf->leaders[i], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_perf_write_report(SlimPerf perf, u64_t vm_instructions, FILE* file)
+{
+    u64_t values[SLIM_PERF_COUNTER_COUNT];
+    for (u32_t i = 0; i < SLIM_PERF_COUNTER_COUNT; i++) values[i] = slim_perf_get_value(perf, i);
+
+    fprintf(file, "%llu VM instructions\n\n", (unsigned long long)vm_instructions);
+    fprintf(file, "%-24s %20s %14s\n", "counter", "total", "per VM instr");
+    for (u32_t i = 0; i < SLIM_PERF_COUNTER_COUNT; i++) {
+        if (!slim_perf_get_available(perf, i)) {
+            fprintf(file, "%-24s %20s\n", ___slim_perf_events[i].name, "not available");
+            continue;
+        }
+        fprintf(file, "%-24s %20llu %14.3f\n", ___slim_perf_events[i].name, (unsigned long long)values[i],
+            vm_instructions > 0 ? (double)values[i] / vm_instructions : 0.0);
+    }
+
+    // Ratios are only given when both of their counters were available and counted anything
+    fprintf(file, "\n");
+    if (values[SLIM_PERF_CYCLES] > 0 && values[SLIM_PERF_INSTRUCTIONS] > 0) {
+        fprintf(file, "%-24s %20.3f\n", "IPC", (double)values[SLIM_PERF_INSTRUCTIONS] / values[SLIM_PERF_CYCLES]);
+    }
+    if (values[SLIM_PERF_BRANCHES] > 0 && slim_perf_get_available(perf, SLIM_PERF_BRANCH_MISSES)) {
+        fprintf(file, "%-24s %19.3f%%\n", "branch miss rate",
+            100.0 * values[SLIM_PERF_BRANCH_MISSES] / values[SLIM_PERF_BRANCHES]);
+    }
+    if (values[SLIM_PERF_TASK_CLOCK] > 0 && vm_instructions > 0) {
+        fprintf(file, "%-24s %20.3f\n", "VM instructions per us",
+            1000.0 * vm_instructions / values[SLIM_PERF_TASK_CLOCK]);
+    }
+
+    return ferror(file) ? SLIM_ERROR : SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -1,14 +1,77 @@
 #include <SlimBytecode.h>
+#include <SlimData.h>
+#include <SlimIo.h>
 #include <SlimLog.h>
 #include <SlimMachine.h>
+#include <SlimNative.h>
+#include <SlimPerf.h>
 #include <SlimPlatform.h>
+#include <SlimProfile.h>
+#include <SlimRegister.h>
+#include <SlimTrace.h>
 
+#include <errno.h>
+#include <poll.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#define SLIM_PLATFORM_EVENT_BATCH 64
+#define SLIM_PLATFORM_POLL_INTERVAL 64 // schedules between reactor checks while machines are ready
+#define SLIM_PLATFORM_WAIT_SLICE 1     // milliseconds between retries of blocking waits that cannot block the host
+#define SLIM_PLATFORM_FUEL 65536       // default fuel of every machine, see slim_machine_set_fuel
 // ---------------------------------------------------------------------------------------------------------------------
-struct SlimPlatform {
+// Every machine of the platform is a task.  A task is either running, in the ready queue, parked on the reactor or on a
+// blocking wait, or finished.  next links it into whichever queue or list it is in.
+struct SlimPlatformTask {
     SlimMachineState machine;
+    SlimPlatformTask* next;
+    u32_t index; // in the order the tasks were spawned
+    u8_t finished;
+};
+
+typedef struct SlimPlatformTimer {
+    u64_t deadline;
+    SlimPlatformTask* task;
+} SlimPlatformTimer;
+
+SLIM_VECTOR_DECLARE(SlimPlatformTaskVector, SlimPlatformTask*, 4)
+SLIM_VECTOR_DECLARE(SlimPlatformTimerHeap, SlimPlatformTimer, 8)
+
+struct SlimPlatform {
     SlimBytecodeTable bytecode_table;
+    SlimRegisterProgram register_program; // NULL while running in stack mode
     SlimLogContext log_context;
+    u32_t entry_local_count;
+
+    // The image's natives by index, NULL for names nothing is registered under
+    SlimNativeFunction* natives;
+    u32_t native_count;
+    u8_t natives_open;
+
+    SlimPlatformTaskVector tasks;
+    SlimPlatformTask* current; // NULL between machines
+    SlimPlatformTask* ready_head;
+    SlimPlatformTask* ready_tail;
+    SlimPlatformTask* waiting; // parked on a blocking wait, retried when nothing else can run
+    u32_t live;
+    u32_t schedules;
+    u64_t fuel; // given to every machine spawned from now on
+    SlimMachineVariant variant;
+    const char* profile_prefix; // NULL unless SLIM_PROFILE is set
+    SlimPerf perf;              // NULL unless SLIM_PERF is set and any counter could be opened
+    const char* perf_path;
+
+    // The reactor.  Descriptors are watched by epoll one-shot, timers sleep in a heap ordered by deadline.
+    int epoll;
+    u32_t watched;
+    SlimPlatformTimerHeap timers;
+
+    // File requests are queued on the I/O engine and submitted in one batch whenever the ready queue runs dry, or
+    // every so often while it does not.  The engine is created by the first request, and its descriptor sits in the
+    // reactor with a NULL task.
+    SlimIo io;
 };
 // ---------------------------------------------------------------------------------------------------------------------
 SlimPlatform slim_platform_create(int argc, char** argv)
@@ -22,18 +85,135 @@ SlimPlatform slim_platform_create(int argc, char** argv)
 
     platform->log_context = slim_log_create(argv[2], 1);
 
-    platform->machine = slim_machine_create(&platform->log_context);
+    slim_log_using_context(&platform->log_context);
 
-    platform->bytecode_table = slim_bytecode_table_create();
+    platform->bytecode_table = NULL;
+    platform->register_program = NULL;
+    platform->entry_local_count = 0;
+    platform->natives = NULL;
+    platform->native_count = 0;
+    platform->natives_open = 0;
+    SlimPlatformTaskVector_init(&platform->tasks);
+    platform->current = NULL;
+    platform->ready_head = NULL;
+    platform->ready_tail = NULL;
+    platform->waiting = NULL;
+    platform->live = 0;
+    platform->schedules = 0;
+    platform->fuel = SLIM_PLATFORM_FUEL;
+    platform->variant = SLIM_MACHINE_VARIANT_TRACING;
+    platform->profile_prefix = NULL;
+    platform->perf = NULL;
+    platform->perf_path = NULL;
+    platform->epoll = epoll_create1(EPOLL_CLOEXEC);
+    platform->watched = 0;
+    SlimPlatformTimerHeap_init(&platform->timers);
+    platform->io = NULL;
 
-    // TODO: Load bytecode tables
+    if (platform->epoll < 0) {
+        slim_log_error("[PLATFORM]\tFailed to create the reactor\n");
+        slim_platform_destroy(platform);
+        return NULL;
+    }
+
+    // SLIM_TRACE records a timeline of the platform into the file it names, from loading the image on
+    const char* trace = getenv("SLIM_TRACE");
+    if (trace != NULL && slim_trace_open(trace) != SL_ERROR_NONE) {
+        slim_log_warn("[PLATFORM]\tTrace events are compiled out, build with SLIM_TRACE_EVENTS to record them\n");
+    }
+
+    SlimError error = slim_bytecode_file_load(argv[1], &platform->bytecode_table);
+    if (error != SL_ERROR_NONE) {
+        slim_log_error("[PLATFORM]\tFailed to load bytecode '%s'\n", argv[1]);
+        slim_platform_destroy(platform);
+        return NULL;
+    }
+
+    error = ___slim_platform_bind_natives(platform);
+    if (error != SL_ERROR_NONE) {
+        slim_log_error("[PLATFORM]\tFailed to set up the native table\n");
+        slim_platform_destroy(platform);
+        return NULL;
+    }
+
+    // Execution starts at address 0, if a section begins there its locals make up the root frame
+    SlimBytecodeSection entry;
+    if (slim_bytecode_table_lookup_section(platform->bytecode_table, 0, &entry) == SL_ERROR_NONE && entry.address == 0) {
+        platform->entry_local_count = entry.local_count;
+    }
+
+    // SLIM_FUEL sets how much a machine may run before the others get their turn, 0 lets it run until it parks
+    const char* fuel = getenv("SLIM_FUEL");
+    if (fuel != NULL) platform->fuel = strtoull(fuel, NULL, 10);
+
+    // SLIM_INTERPRETER picks the interpreter every machine runs on, machines trace to the log unless told otherwise
+    const char* interpreter = getenv("SLIM_INTERPRETER");
+    if (interpreter != NULL && slim_machine_variant_parse(interpreter, &platform->variant) != SL_ERROR_NONE) {
+        slim_log_warn("[PLATFORM]\tUnknown interpreter '%s', tracing instead\n", interpreter);
+    }
+
+    // SLIM_PROFILE profiles every machine and names the files their profiles are written to when they halt
+    platform->profile_prefix = getenv("SLIM_PROFILE");
+    if (platform->profile_prefix != NULL) platform->variant = SLIM_MACHINE_VARIANT_PROFILING;
+
+    // SLIM_PERF counts hardware events while machines run and names the file they are reported to, - for stderr
+    platform->perf_path = getenv("SLIM_PERF");
+    if (platform->perf_path != NULL && slim_perf_create(&platform->perf) != SL_ERROR_NONE) {
+        slim_log_warn("[PLATFORM]\tPerformance counters are unavailable, running without them\n");
+        platform->perf = NULL;
+    } else if (platform->perf != NULL && !slim_perf_get_available(platform->perf, SLIM_PERF_CYCLES)) {
+        slim_log_warn("[PLATFORM]\tHardware counters are unavailable, only counting what the kernel can\n");
+    }
+
+    // SLIM_REGISTER_MODE runs the image as register code, images the translator cannot handle stay in stack mode
+    const char* register_mode = getenv("SLIM_REGISTER_MODE");
+    if (register_mode != NULL && strtoul(register_mode, NULL, 10) != 0) {
+        error = slim_register_program_translate(platform->bytecode_table, platform->entry_local_count,
+                                                &platform->register_program);
+        if (error != SL_ERROR_NONE) {
+            slim_log_warn("[PLATFORM]\tFailed to translate to register code, running in stack mode\n");
+            platform->register_program = NULL;
+        }
+    }
+
+    error = slim_platform_spawn(platform);
+    if (error != SL_ERROR_NONE) {
+        slim_log_error("[PLATFORM]\tFailed to reserve %u locals for the entry section\n", platform->entry_local_count);
+        slim_platform_destroy(platform);
+        return NULL;
+    }
 
-    slim_log_using_context(&platform->log_context);
     slim_log_info("[PLATFORM]\tPlatform created\n");
 
     return platform;
 }
 // ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_platform_spawn(SlimPlatform platform)
+{
+    SlimPlatformTask* task = malloc(sizeof(SlimPlatformTask));
+    if (task == NULL) return SLIM_ERROR;
+
+    task->machine = slim_machine_create_variant(&platform->log_context, platform->variant);
+    task->next = NULL;
+    task->index = platform->tasks.size;
+    task->finished = 0;
+    slim_machine_set_fuel(task->machine, platform->fuel);
+
+    SlimError error = slim_machine_enter(task->machine, 0, platform->entry_local_count);
+    if (error == SL_ERROR_NONE) error = SlimPlatformTaskVector_append(&platform->tasks, task);
+    if (error != SL_ERROR_NONE) {
+        slim_machine_destroy(task->machine);
+        free(task);
+        return error;
+    }
+
+    platform->live++;
+    ___slim_platform_ready(platform, task);
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_platform_set_fuel(SlimPlatform platform, u64_t budget) { platform->fuel = budget; }
+// ---------------------------------------------------------------------------------------------------------------------
 SlimPlatformReturnCode slim_platform_update(SlimPlatform platform)
 {
     slim_log_using_context(&platform->log_context);
@@ -41,49 +221,165 @@ SlimPlatformReturnCode slim_platform_update(SlimPlatform platform)
 
     SlimPlatformReturnCode return_code = SLIM_PLATFORM_CONTINUE;
 
-    return_code = ___slim_platform_handle_flags(platform);
-    if (return_code != SLIM_PLATFORM_CONTINUE) {
-        return return_code;
+    if (platform->current == NULL) {
+        return_code = ___slim_platform_schedule(platform);
+        if (return_code != SLIM_PLATFORM_CONTINUE || platform->current == NULL) {
+            return return_code;
+        }
+    }
+
+    // The machine runs until it traps, which is the only time the platform has anything to do
+    SLIM_TRACE_BEGIN("run", platform->current->index);
+    if (platform->perf != NULL) slim_perf_start(platform->perf);
+    if (platform->register_program != NULL) {
+        slim_machine_register_run(platform->current->machine, platform->register_program);
+    } else {
+        slim_machine_run(platform->current->machine, platform->bytecode_table);
     }
+    if (platform->perf != NULL) slim_perf_stop(platform->perf);
+    SLIM_TRACE_END("run", platform->current->index);
 
-    return_code = ___slim_platform_handle_interrupts(platform);
+    return_code = ___slim_platform_handle_flags(platform);
     if (return_code != SLIM_PLATFORM_CONTINUE) {
         return return_code;
     }
 
-    slim_machine_step(platform->machine, platform->bytecode_table);
-
-    return return_code;
+    return ___slim_platform_handle_interrupts(platform);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 void slim_platform_destroy(SlimPlatform platform)
 {
+    if (platform == NULL) return;
+
+    // Persist whatever was prepared during this run so the next invocation can skip it
+    const char* cache_directory = slim_bytecode_cache_directory();
+    if (platform->bytecode_table != NULL && cache_directory != NULL) {
+        slim_bytecode_cache_store(cache_directory, platform->bytecode_table);
+    }
+
+    // Requests still in flight write into the machines, so they have to complete first
+    if (platform->io != NULL) {
+        slim_io_flush(platform->io);
+        while (slim_io_get_count_pending(platform->io) > 0) {
+            struct pollfd readable = {slim_io_get_descriptor(platform->io), POLLIN, 0};
+            poll(&readable, 1, -1);
+
+            SlimIoRequest* completed[SLIM_PLATFORM_EVENT_BATCH];
+            u32_t count = slim_io_reap(platform->io, completed, SLIM_PLATFORM_EVENT_BATCH);
+            for (u32_t i = 0; i < count; i++) free(completed[i]);
+        }
+        slim_io_destroy(platform->io);
+    }
+
+    if (platform->perf != NULL) ___slim_platform_write_perf(platform);
+    slim_perf_destroy(platform->perf);
+
+    for (u32_t i = 0; i < platform->tasks.size; i++) {
+        slim_machine_destroy(platform->tasks.data[i]->machine);
+        free(platform->tasks.data[i]);
+    }
+    SlimPlatformTaskVector_free(&platform->tasks);
+    SlimPlatformTimerHeap_free(&platform->timers);
+    if (platform->epoll >= 0) close(platform->epoll);
+
     slim_log_destroy(platform->log_context);
-    slim_machine_destroy(platform->machine);
-    // TODO: Integrate cleanup of the bytecode and natives
+    slim_register_program_destroy(platform->register_program);
+    slim_bytecode_table_destroy(platform->bytecode_table);
+    free(platform->natives);
+    if (platform->natives_open) slim_native_close();
+    free(platform);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 SlimPlatformReturnCode ___slim_platform_handle_flags(SlimPlatform platform)
 {
-    // First handle any flags set during the last update and react accordingly
-    // For now, the platform is not resposible for clearing/resetting the flags
+    // First handle whatever the machine trapped for during the last update and react accordingly.  The machine clears
+    // the trap itself the next time it runs.
     slim_log_using_context(&platform->log_context);
 
-    u8_t error_flag = slim_machine_flag_get_error(platform->machine);
-    if (error_flag) {
-        slim_log_error("[UPDATE]\tRuntime error encountered, terminating platform\n");
+    SlimMachineState machine = platform->current->machine;
+
+    SlimMachineTrap trap;
+    slim_machine_get_trap(machine, &trap);
+    if (trap.kind == SLIM_MACHINE_TRAP_ERROR) {
+        slim_log_error("[UPDATE]\tRuntime error %d at 0x%x in opcode 0x%x, terminating platform\n", trap.error,
+                       trap.instruction_pointer, trap.opcode);
         return SLIM_PLATFORM_ERROR;
     }
 
-    u8_t halt_flag = slim_machine_flag_get_halt(platform->machine);
-    if (halt_flag) {
-        slim_log_info("[UPDATE]\tMachine halted, terminating platform\n");
-        return SLIM_PLATFORM_EXIT;
+    if (trap.kind == SLIM_MACHINE_TRAP_HALT) {
+        SLIM_TRACE_INSTANT("halt", platform->current->index);
+        if (platform->profile_prefix != NULL) ___slim_platform_write_profile(platform, platform->current);
+        platform->current->finished = 1;
+        platform->current = NULL;
+        platform->live--;
+
+        if (platform->live == 0) {
+            slim_log_info("[UPDATE]\tMachine halted, terminating platform\n");
+            return SLIM_PLATFORM_EXIT;
+        }
+        slim_log_info("[UPDATE]\tMachine halted, %u still running\n", platform->live);
+        return SLIM_PLATFORM_CONTINUE;
+    }
+
+    // Out of fuel, the machine goes to the back of the ready queue and picks up where it left off
+    if (trap.kind == SLIM_MACHINE_TRAP_YIELD) {
+        SLIM_TRACE_INSTANT("yield", platform->current->index);
+        slim_machine_refuel(machine);
+        ___slim_platform_ready(platform, platform->current);
+        platform->current = NULL;
     }
 
     return SLIM_PLATFORM_CONTINUE;
 }
 // ---------------------------------------------------------------------------------------------------------------------
+// Writes <prefix>-<task>.txt with the report and <prefix>-<task>.folded with the folded stacks of the task's machine
+void ___slim_platform_write_profile(SlimPlatform platform, SlimPlatformTask* task)
+{
+    slim_log_using_context(&platform->log_context);
+
+    SlimProfile profile = slim_machine_get_profile(task->machine);
+    if (profile == NULL) return;
+
+    static const char* extensions[] = {"txt", "folded"};
+    for (u32_t i = 0; i < 2; i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s-%u.%s", platform->profile_prefix, task->index, extensions[i]);
+
+        FILE* file = fopen(path, "w");
+        SlimError error = SLIM_ERROR;
+        if (file != NULL && i == 0) {
+            error = slim_profile_write_report(profile, platform->bytecode_table, platform->register_program, file);
+        } else if (file != NULL) {
+            error = slim_profile_write_folded(profile, platform->bytecode_table, platform->register_program, file);
+        }
+        if (file != NULL && fclose(file) != 0) error = SLIM_ERROR;
+
+        if (error != SL_ERROR_NONE) {
+            slim_log_warn("[PLATFORM]\tFailed to write the profile '%s'\n", path);
+        } else {
+            slim_log_info("[PLATFORM]\tProfile written to '%s'\n", path);
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Reports the counters of the whole run, normalised by the instructions all machines ran between them
+void ___slim_platform_write_perf(SlimPlatform platform)
+{
+    slim_log_using_context(&platform->log_context);
+
+    u64_t retired = 0;
+    for (u32_t i = 0; i < platform->tasks.size; i++) {
+        retired += slim_machine_get_retired(platform->tasks.data[i]->machine);
+    }
+
+    u8_t to_stderr = strcmp(platform->perf_path, "-") == 0;
+    FILE* file = to_stderr ? stderr : fopen(platform->perf_path, "w");
+    SlimError error = file != NULL ? slim_perf_write_report(platform->perf, retired, file) : SLIM_ERROR;
+    if (file != NULL && !to_stderr && fclose(file) != 0) error = SLIM_ERROR;
+
+    if (error != SL_ERROR_NONE) slim_log_warn("[PLATFORM]\tFailed to write the counters '%s'\n", platform->perf_path);
+}
+// ---------------------------------------------------------------------------------------------------------------------
 SlimPlatformReturnCode ___slim_platform_handle_interrupts(SlimPlatform platform)
 {
     // Handle interrupt at the level of the platform.  This is because interrupts can cause an error, which would
@@ -92,29 +388,273 @@ SlimPlatformReturnCode ___slim_platform_handle_interrupts(SlimPlatform platform)
     // Let's make the platform handle it for better control flow.
     slim_log_using_context(&platform->log_context);
 
-    u8_t interrupt_flag = slim_machine_flag_get_interrupt(platform->machine);
-    if (interrupt_flag) {
-        SlimError error = SL_ERROR_NONE;
+    if (platform->current == NULL) return SLIM_PLATFORM_CONTINUE;
+    SlimMachineState machine = platform->current->machine;
 
-        // TODO: Pop native function identifier from stack
+    u8_t interrupt_flag = slim_machine_flag_get_interrupt(machine);
+    if (interrupt_flag) {
+        u64_t index = 0;
+        SlimError error = slim_machine_pop(machine, &index);
         if (error != SL_ERROR_NONE) {
             slim_log_error("[INTERRUPT]\tFailed to pop native function identifier from stack\n");
             return SLIM_PLATFORM_ERROR;
         }
 
-        // TODO: Retrieve native function
-        if (error != SL_ERROR_NONE) {
-            slim_log_error("[INTERRUPT]\tFailed to retrieve native function\n");
+        SlimNativeFunction function = index < platform->native_count ? platform->natives[index] : NULL;
+        if (function == NULL) {
+            slim_log_error("[INTERRUPT]\tFailed to retrieve native function 0x%llx\n", index);
             return SLIM_PLATFORM_ERROR;
         }
 
-        // TODO: Execute native function
+        SLIM_TRACE_BEGIN("native", index);
+        error = function(machine);
+        SLIM_TRACE_END("native", index);
         if (error != SL_ERROR_NONE) {
             slim_log_error("[INTERRUPT]\tNative function returned error: %d\n", error);
             return SLIM_PLATFORM_ERROR;
         }
+
+        // The native is pending, the machine sits out until the reason it parked for is gone
+        if (slim_machine_flag_get_park(machine)) {
+            slim_log_info("[INTERRUPT]\tMachine parked in native 0x%llx\n", index);
+            SLIM_TRACE_INSTANT("park", platform->current->index);
+            error = ___slim_platform_park(platform, platform->current);
+            platform->current = NULL;
+            if (error != SL_ERROR_NONE) {
+                slim_log_error("[INTERRUPT]\tFailed to park the machine\n");
+                return SLIM_PLATFORM_ERROR;
+            }
+        }
+    }
+
+    return SLIM_PLATFORM_CONTINUE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_platform_bind_natives(SlimPlatform platform)
+{
+    // Names are resolved once here, so a native call is an index into the table
+    slim_log_using_context(&platform->log_context);
+
+    SlimError error = slim_native_init();
+    platform->natives_open = 1;
+    if (error != SL_ERROR_NONE) return error;
+
+    u32_t count = slim_bytecode_table_get_count_natives(platform->bytecode_table);
+    if (count == 0) return SL_ERROR_NONE;
+
+    platform->natives = calloc(count, sizeof(SlimNativeFunction));
+    if (platform->natives == NULL) return SLIM_ERROR;
+    platform->native_count = count;
+
+    for (u32_t i = 0; i < count; i++) {
+        char* identifier;
+        error = slim_bytecode_table_lookup_native(platform->bytecode_table, i, &identifier);
+        if (error != SL_ERROR_NONE) return error;
+
+        if (slim_native_lookup(identifier, &platform->natives[i]) != SL_ERROR_NONE) {
+            slim_log_warn("[PLATFORM]\tNo native registered as '%s'\n", identifier);
+            platform->natives[i] = NULL;
+        }
+    }
+
+    return SL_ERROR_NONE;
+}
+// Scheduling ----------------------------------------------------------------------------------------------------------
+void ___slim_platform_ready(SlimPlatform platform, SlimPlatformTask* task)
+{
+    task->next = NULL;
+    if (platform->ready_tail != NULL) {
+        platform->ready_tail->next = task;
+    } else {
+        platform->ready_head = task;
+    }
+    platform->ready_tail = task;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_platform_retry_waiting(SlimPlatform platform)
+{
+    // The retried natives check their channels again, and park again if nothing changed
+    SlimPlatformTask* task = platform->waiting;
+    platform->waiting = NULL;
+    while (task != NULL) {
+        SlimPlatformTask* next = task->next;
+        ___slim_platform_ready(platform, task);
+        task = next;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_platform_park(SlimPlatform platform, SlimPlatformTask* task)
+{
+    SlimMachineParking parking;
+    slim_machine_get_parking(task->machine, &parking);
+
+    if (parking.descriptor >= 0) {
+        struct epoll_event event;
+        event.events = parking.events | EPOLLONESHOT;
+        event.data.ptr = task;
+        if (epoll_ctl(platform->epoll, EPOLL_CTL_ADD, parking.descriptor, &event) != 0) return SLIM_ERROR;
+        platform->watched++;
+    } else if (parking.deadline != 0) {
+        SlimPlatformTimer timer = {parking.deadline, task};
+        if (SlimPlatformTimerHeap_append(&platform->timers, timer) != SL_ERROR_NONE) return SLIM_ERROR;
+
+        SlimPlatformTimer* heap = platform->timers.data;
+        for (u32_t i = platform->timers.size - 1; i > 0 && heap[(i - 1) / 2].deadline > heap[i].deadline;) {
+            SlimPlatformTimer swap = heap[i];
+            heap[i] = heap[(i - 1) / 2];
+            heap[(i - 1) / 2] = swap;
+            i = (i - 1) / 2;
+        }
+    } else if (parking.request != NULL) {
+        if (platform->io == NULL) {
+            if (slim_io_create(SLIM_IO_BACKEND_AUTO, &platform->io) != SL_ERROR_NONE) {
+                platform->io = NULL;
+                free(parking.request);
+                return SLIM_ERROR;
+            }
+
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = NULL;
+            if (epoll_ctl(platform->epoll, EPOLL_CTL_ADD, slim_io_get_descriptor(platform->io), &event) != 0) {
+                free(parking.request);
+                return SLIM_ERROR;
+            }
+        }
+
+        parking.request->user = task;
+        slim_io_submit(platform->io, parking.request);
+    } else if (parking.wait != NULL) {
+        task->next = platform->waiting;
+        platform->waiting = task;
+    } else {
+        ___slim_platform_ready(platform, task);
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_platform_poll(SlimPlatform platform, s32_t timeout)
+{
+    // Waits up to timeout milliseconds for the reactor (-1 for no limit) and readies every machine it woke
+    if (platform->timers.size > 0) {
+        u64_t now = slim_native_clock();
+        u64_t deadline = platform->timers.data[0].deadline;
+        s32_t until = deadline <= now ? 0 : (s32_t)((deadline - now + 999999) / 1000000);
+        if (timeout < 0 || until < timeout) timeout = until;
+    }
+
+    if (___slim_platform_reactor_busy(platform) || timeout != 0) {
+        struct epoll_event events[SLIM_PLATFORM_EVENT_BATCH];
+        SLIM_TRACE_BEGIN("poll", (u32_t)timeout);
+        int count = epoll_wait(platform->epoll, events, SLIM_PLATFORM_EVENT_BATCH, timeout);
+        SLIM_TRACE_END("poll", count < 0 ? 0 : count);
+        if (count < 0 && errno != EINTR) return SLIM_ERROR;
+
+        for (int i = 0; i < count; i++) {
+            SlimPlatformTask* task = events[i].data.ptr;
+            if (task == NULL) {
+                if (___slim_platform_reap_io(platform) != SL_ERROR_NONE) return SLIM_ERROR;
+                continue;
+            }
+
+            SlimMachineParking parking;
+            slim_machine_get_parking(task->machine, &parking);
+
+            epoll_ctl(platform->epoll, EPOLL_CTL_DEL, parking.descriptor, NULL);
+            platform->watched--;
+            ___slim_platform_ready(platform, task);
+        }
+    }
+
+    // Pop every timer that is due off the heap
+    u64_t now = slim_native_clock();
+    SlimPlatformTimer* heap = platform->timers.data;
+    while (platform->timers.size > 0 && heap[0].deadline <= now) {
+        ___slim_platform_ready(platform, heap[0].task);
+
+        u32_t size = --platform->timers.size;
+        heap[0] = heap[size];
+        for (u32_t i = 0;;) {
+            u32_t smallest = i;
+            if (2 * i + 1 < size && heap[2 * i + 1].deadline < heap[smallest].deadline) smallest = 2 * i + 1;
+            if (2 * i + 2 < size && heap[2 * i + 2].deadline < heap[smallest].deadline) smallest = 2 * i + 2;
+            if (smallest == i) break;
+
+            SlimPlatformTimer swap = heap[i];
+            heap[i] = heap[smallest];
+            heap[smallest] = swap;
+            i = smallest;
+        }
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_platform_reap_io(SlimPlatform platform)
+{
+    // Every completed request finishes the native that parked its machine, so its result goes on the stack
+    SlimError error = SL_ERROR_NONE;
+
+    SlimIoRequest* completed[SLIM_PLATFORM_EVENT_BATCH];
+    u32_t count = slim_io_reap(platform->io, completed, SLIM_PLATFORM_EVENT_BATCH);
+    for (u32_t i = 0; i < count; i++) {
+        SlimPlatformTask* task = completed[i]->user;
+        if (slim_machine_push(task->machine, (u64_t)completed[i]->result) != SL_ERROR_NONE) error = SLIM_ERROR;
+        free(completed[i]);
+        ___slim_platform_ready(platform, task);
+    }
+
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t ___slim_platform_reactor_busy(SlimPlatform platform)
+{
+    u8_t io_pending = platform->io != NULL && slim_io_get_count_pending(platform->io) > 0;
+    return platform->watched > 0 || platform->timers.size > 0 || io_pending;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimPlatformReturnCode ___slim_platform_schedule(SlimPlatform platform)
+{
+    // Picks the next machine to run.  Ready machines go first, and the reactor is only checked between them now and
+    // then, so that machines woken by it are not starved.  With nothing ready the host blocks in the reactor, or in
+    // the wait of a parked machine when it is the only one and the reactor has nothing to watch.  Several waiting
+    // machines are retried every slice instead.
+    slim_log_using_context(&platform->log_context);
+
+    u8_t reactor_busy = ___slim_platform_reactor_busy(platform);
+    if (platform->ready_head != NULL && ++platform->schedules % SLIM_PLATFORM_POLL_INTERVAL == 0) {
+        if (platform->io != NULL && slim_io_flush(platform->io) != SL_ERROR_NONE) return SLIM_PLATFORM_ERROR;
+        if (reactor_busy && ___slim_platform_poll(platform, 0) != SL_ERROR_NONE) return SLIM_PLATFORM_ERROR;
+        ___slim_platform_retry_waiting(platform);
+    }
+
+    while (platform->ready_head == NULL) {
+        if (platform->io != NULL && slim_io_flush(platform->io) != SL_ERROR_NONE) return SLIM_PLATFORM_ERROR;
+        reactor_busy = ___slim_platform_reactor_busy(platform);
+
+        // Blocking in a wait is only safe for the sole waiter, anything else could miss the others becoming ready
+        if (platform->waiting != NULL && platform->waiting->next == NULL && !reactor_busy) {
+            SlimMachineParking parking;
+            slim_machine_get_parking(platform->waiting->machine, &parking);
+            parking.wait(parking.argument);
+            ___slim_platform_retry_waiting(platform);
+        } else if (platform->waiting != NULL) {
+            if (___slim_platform_poll(platform, SLIM_PLATFORM_WAIT_SLICE) != SL_ERROR_NONE) return SLIM_PLATFORM_ERROR;
+            ___slim_platform_retry_waiting(platform);
+        } else if (reactor_busy) {
+            if (___slim_platform_poll(platform, -1) != SL_ERROR_NONE) return SLIM_PLATFORM_ERROR;
+        } else {
+            slim_log_error("[SCHEDULE]\tEvery machine is parked with nothing left to wake it\n");
+            return SLIM_PLATFORM_ERROR;
+        }
     }
 
+    platform->current = platform->ready_head;
+    platform->ready_head = platform->current->next;
+    if (platform->ready_head == NULL) platform->ready_tail = NULL;
+    platform->current->next = NULL;
+
     return SLIM_PLATFORM_CONTINUE;
 }
-// ---------------------------------------------------------------------------------------------------------------------
\ No newline at end of file
+// ---------------------------------------------------------------------------------------------------------------------
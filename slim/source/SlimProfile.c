@@ -0,0 +1,352 @@
+#include <SlimData.h>
+#include <SlimMachine.h>
+#include <SlimProfile.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#define SLIM_PROFILE_NONE 0xFFFFFFFF
+// ---------------------------------------------------------------------------------------------------------------------
+// One node of the calling context tree per distinct path of calls from the root.  Node 0 is the root itself and
+// stands for no function.  Nodes refer to each other by index, since the vector moves when it grows.
+typedef struct SlimProfileNode {
+    u32_t address;
+    u32_t function; // Index into functions
+    u32_t parent;
+    u32_t first_child;
+    u32_t next_sibling;
+    u64_t calls;
+    u64_t inclusive;
+    u64_t exclusive;
+} SlimProfileNode;
+
+// The totals of a function over all the contexts it was called in.  Inclusive time is only added once the outermost
+// of its activations leaves, so recursion does not count the same time twice.
+typedef struct SlimProfileFunction {
+    u32_t address;
+    u32_t active;
+    u64_t calls;
+    u64_t inclusive;
+    u64_t exclusive;
+} SlimProfileFunction;
+
+typedef struct SlimProfileFrame {
+    u32_t node;
+    u64_t start;
+    u64_t children; // Time spent in the functions it called
+} SlimProfileFrame;
+
+SLIM_VECTOR_DECLARE(SlimProfileNodeVector, SlimProfileNode, 16)
+SLIM_VECTOR_DECLARE(SlimProfileFunctionVector, SlimProfileFunction, 16)
+
+struct SlimProfile {
+    u64_t opcode_counts[256];
+
+    SlimProfileNodeVector nodes;
+    SlimProfileFunctionVector functions;
+
+    SlimProfileFrame frames[SLIM_PROFILE_DEPTH];
+    u32_t depth;
+    u32_t overflow; // Frames entered past SLIM_PROFILE_DEPTH that have not left yet
+
+    // The virtual clock, which only advances while the machine runs
+    u64_t elapsed;
+    u64_t resumed_at;
+    u8_t running;
+};
+// Internal Functions --------------------------------------------------------------------------------------------------
+static inline u64_t ___slim_profile_clock()
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64_t)now.tv_sec * 1000000000ull + (u64_t)now.tv_nsec;
+#endif
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static inline u64_t ___slim_profile_now(SlimProfile profile)
+{
+    if (!profile->running) return profile->elapsed;
+    return profile->elapsed + (___slim_profile_clock() - profile->resumed_at);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static u32_t ___slim_profile_find_function(SlimProfile profile, u32_t address)
+{
+    for (u32_t i = 0; i < profile->functions.size; i++) {
+        if (profile->functions.data[i].address == address) return i;
+    }
+
+    if (SlimProfileFunctionVector_grow(&profile->functions, 1) != SL_ERROR_NONE) return SLIM_PROFILE_NONE;
+
+    profile->functions.data[profile->functions.size] = (SlimProfileFunction){address, 0, 0, 0, 0};
+    return profile->functions.size++;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Only called when a call reaches a context for the first time, every later call finds it among the parent's children
+static u32_t ___slim_profile_find_child(SlimProfile profile, u32_t parent, u32_t address)
+{
+    u32_t child = profile->nodes.data[parent].first_child;
+    while (child != SLIM_PROFILE_NONE) {
+        if (profile->nodes.data[child].address == address) return child;
+        child = profile->nodes.data[child].next_sibling;
+    }
+
+    u32_t function = ___slim_profile_find_function(profile, address);
+    if (function == SLIM_PROFILE_NONE) return SLIM_PROFILE_NONE;
+    if (SlimProfileNodeVector_grow(&profile->nodes, 1) != SL_ERROR_NONE) return SLIM_PROFILE_NONE;
+
+    child = profile->nodes.size++;
+    profile->nodes.data[child] = (SlimProfileNode){
+        address, function, parent, SLIM_PROFILE_NONE, profile->nodes.data[parent].first_child, 0, 0, 0};
+    profile->nodes.data[parent].first_child = child;
+    return child;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Names a function after the exported symbol of the section starting at its address, or after the section itself
+static void ___slim_profile_name(
+    SlimBytecodeTable table, SlimRegisterProgram program, u32_t address, char* name, u32_t size)
+{
+    u32_t section_count = table != NULL ? slim_bytecode_table_get_count_sections(table) : 0;
+    u32_t match = SLIM_PROFILE_NONE;
+
+    for (u32_t i = 0; i < section_count && match == SLIM_PROFILE_NONE; i++) {
+        SlimBytecodeSection section;
+        if (slim_bytecode_table_lookup_section(table, i, &section) != SL_ERROR_NONE) continue;
+
+        u32_t start = section.address;
+        if (program != NULL && slim_register_program_map_address(program, section.address, &start) != SL_ERROR_NONE) {
+            continue;
+        }
+        if (start == address) match = i;
+    }
+
+    if (match == SLIM_PROFILE_NONE) {
+        snprintf(name, size, "0x%x", address);
+        return;
+    }
+
+    for (u32_t slot = 0; slot < slim_bytecode_table_get_count_symbols(table); slot++) {
+        SlimBytecodeSymbol symbol;
+        if (slim_bytecode_table_lookup_symbol_slot(table, slot, &symbol) != SL_ERROR_NONE) continue;
+
+        if (symbol.kind == SLIM_BYTECODE_SYMBOL_SECTION && symbol.index == match) {
+            snprintf(name, size, "%.*s", (int)symbol.length, symbol.name);
+            return;
+        }
+    }
+
+    snprintf(name, size, "section_%u", match);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static int ___slim_profile_compare_functions(const void* a, const void* b)
+{
+    u64_t x = ((const SlimProfileFunction*)a)->exclusive;
+    u64_t y = ((const SlimProfileFunction*)b)->exclusive;
+    return (x < y) - (x > y);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static int ___slim_profile_compare_opcodes(const void* a, const void* b)
+{
+    u64_t x = ((const u64_t*)a)[0];
+    u64_t y = ((const u64_t*)b)[0];
+    return (x < y) - (x > y);
+}
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_profile_create(SlimProfile* profile)
+{
+    SlimProfile created = calloc(1, sizeof(struct SlimProfile));
+    if (created == NULL) return SLIM_ERROR;
+
+    SlimProfileNodeVector_init(&created->nodes);
+    SlimProfileFunctionVector_init(&created->functions);
+
+    created->nodes.data[0] = (SlimProfileNode){
+        SLIM_PROFILE_NONE, SLIM_PROFILE_NONE, SLIM_PROFILE_NONE, SLIM_PROFILE_NONE, SLIM_PROFILE_NONE, 0, 0, 0};
+    created->nodes.size = 1;
+
+    *profile = created;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_destroy(SlimProfile profile)
+{
+    if (profile == NULL) return;
+
+    SlimProfileNodeVector_free(&profile->nodes);
+    SlimProfileFunctionVector_free(&profile->functions);
+    free(profile);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u64_t* slim_profile_get_opcode_counts(SlimProfile profile) { return profile->opcode_counts; }
+// ---------------------------------------------------------------------------------------------------------------------
+const char* slim_profile_get_unit()
+{
+#if defined(__x86_64__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_resume(SlimProfile profile)
+{
+    if (profile->running) return;
+
+    profile->resumed_at = ___slim_profile_clock();
+    profile->running = 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_pause(SlimProfile profile)
+{
+    if (!profile->running) return;
+
+    profile->elapsed += ___slim_profile_clock() - profile->resumed_at;
+    profile->running = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_enter(SlimProfile profile, u32_t address)
+{
+    u32_t parent = profile->depth > 0 ? profile->frames[profile->depth - 1].node : 0;
+    u32_t node = SLIM_PROFILE_NONE;
+    if (profile->depth < SLIM_PROFILE_DEPTH) node = ___slim_profile_find_child(profile, parent, address);
+
+    // Past the tracked depth, or out of memory, the call stays part of its caller
+    if (node == SLIM_PROFILE_NONE) {
+        profile->overflow++;
+        return;
+    }
+
+    SlimProfileNode* entered = &profile->nodes.data[node];
+    SlimProfileFunction* function = &profile->functions.data[entered->function];
+    entered->calls++;
+    function->calls++;
+    function->active++;
+
+    profile->frames[profile->depth++] = (SlimProfileFrame){node, ___slim_profile_now(profile), 0};
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_leave(SlimProfile profile)
+{
+    if (profile->overflow > 0) {
+        profile->overflow--;
+        return;
+    }
+    if (profile->depth == 0) return;
+
+    SlimProfileFrame* frame = &profile->frames[--profile->depth];
+    SlimProfileNode* node = &profile->nodes.data[frame->node];
+    SlimProfileFunction* function = &profile->functions.data[node->function];
+
+    u64_t inclusive = ___slim_profile_now(profile) - frame->start;
+    u64_t exclusive = inclusive - frame->children;
+    node->inclusive += inclusive;
+    node->exclusive += exclusive;
+    function->exclusive += exclusive;
+    if (--function->active == 0) function->inclusive += inclusive;
+
+    if (profile->depth > 0) profile->frames[profile->depth - 1].children += inclusive;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_replace(SlimProfile profile, u32_t address)
+{
+    // A tail call past the tracked depth replaces a frame that was never tracked
+    if (profile->overflow > 0) return;
+
+    slim_profile_leave(profile);
+    slim_profile_enter(profile, address);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_profile_close(SlimProfile profile)
+{
+    while (profile->depth > 0 || profile->overflow > 0) slim_profile_leave(profile);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_profile_write_report(
+    SlimProfile profile, SlimBytecodeTable table, SlimRegisterProgram program, FILE* file)
+{
+    slim_profile_close(profile);
+
+    u64_t total = profile->elapsed;
+    u64_t instructions = 0;
+    for (u32_t i = 0; i < 256; i++) instructions += profile->opcode_counts[i];
+
+    SlimProfileFunction* functions = malloc((profile->functions.size + 1) * sizeof(SlimProfileFunction));
+    u64_t(*opcodes)[2] = malloc(256 * sizeof(*opcodes));
+    if (functions == NULL || opcodes == NULL) {
+        free(functions);
+        free(opcodes);
+        return SLIM_ERROR;
+    }
+
+    const char* unit = slim_profile_get_unit();
+    fprintf(file, "%llu %s, %llu instructions\n\n", (unsigned long long)total, unit, (unsigned long long)instructions);
+
+    memcpy(functions, profile->functions.data, profile->functions.size * sizeof(SlimProfileFunction));
+    qsort(functions, profile->functions.size, sizeof(SlimProfileFunction), ___slim_profile_compare_functions);
+
+    fprintf(file, "%12s %20s %20s %7s  %s\n", "calls", "inclusive", "exclusive", "%", "function");
+    for (u32_t i = 0; i < profile->functions.size; i++) {
+        char name[64];
+        ___slim_profile_name(table, program, functions[i].address, name, sizeof(name));
+        fprintf(file, "%12llu %20llu %20llu %6.2f%%  %s\n", (unsigned long long)functions[i].calls,
+            (unsigned long long)functions[i].inclusive, (unsigned long long)functions[i].exclusive,
+            total > 0 ? 100.0 * functions[i].exclusive / total : 0.0, name);
+    }
+
+    u32_t opcode_count = 0;
+    for (u32_t i = 0; i < 256; i++) {
+        if (profile->opcode_counts[i] == 0) continue;
+        opcodes[opcode_count][0] = profile->opcode_counts[i];
+        opcodes[opcode_count][1] = i;
+        opcode_count++;
+    }
+    qsort(opcodes, opcode_count, sizeof(*opcodes), ___slim_profile_compare_opcodes);
+
+    // Register programs have opcodes of their own, which have no mnemonics here
+    fprintf(file, "\n%20s %7s  %s\n", "count", "%", "opcode");
+    for (u32_t i = 0; i < opcode_count; i++) {
+        u8_t opcode = (u8_t)opcodes[i][1];
+        const char* name = program == NULL ? slim_machine_opcode_name(opcode) : NULL;
+        fprintf(file, "%20llu %6.2f%%  ", (unsigned long long)opcodes[i][0], 100.0 * opcodes[i][0] / instructions);
+        if (name != NULL) {
+            fprintf(file, "%s\n", name);
+        } else {
+            fprintf(file, "0x%02x\n", opcode);
+        }
+    }
+
+    free(functions);
+    free(opcodes);
+    return ferror(file) ? SLIM_ERROR : SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_profile_write_folded(
+    SlimProfile profile, SlimBytecodeTable table, SlimRegisterProgram program, FILE* file)
+{
+    slim_profile_close(profile);
+
+    for (u32_t i = 1; i < profile->nodes.size; i++) {
+        if (profile->nodes.data[i].exclusive == 0) continue;
+
+        u32_t path[SLIM_PROFILE_DEPTH];
+        u32_t length = 0;
+        for (u32_t node = i; node != 0; node = profile->nodes.data[node].parent) path[length++] = node;
+
+        while (length > 0) {
+            char name[64];
+            ___slim_profile_name(table, program, profile->nodes.data[path[--length]].address, name, sizeof(name));
+            fprintf(file, length > 0 ? "%s;" : "%s", name);
+        }
+        fprintf(file, " %llu\n", (unsigned long long)profile->nodes.data[i].exclusive);
+    }
+
+    return ferror(file) ? SLIM_ERROR : SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
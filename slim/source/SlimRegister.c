@@ -0,0 +1,920 @@
+#include <SlimData.h>
+#include <SlimRegister.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SLIM_REGISTER_UNREACHED (-0x7FFFFFFF - 1)
+#define SLIM_REGISTER_NO_ADDRESS 0xFFFFFFFF
+#define SLIM_REGISTER_MIN (-0x8000)
+#define SLIM_REGISTER_MAX 0x7FFF
+// ---------------------------------------------------------------------------------------------------------------------
+typedef struct SlimRegisterFunction {
+    u32_t address;
+    u32_t local_count;
+    u32_t argument_count;
+    s32_t arity;   // Number of values a return leaves for the caller, -1 until a return has been seen
+    s32_t minimum; // Lowest register the function touches
+    s32_t maximum; // One past the highest register the function touches
+} SlimRegisterFunction;
+
+typedef struct SlimRegisterPath {
+    u32_t address;
+    s32_t depth;
+} SlimRegisterPath;
+
+// A value on the virtual stack, either already in its canonical register, a copy of another register, or an immediate
+typedef enum SlimRegisterValueKind {
+    SLIM_REGISTER_VALUE_CANONICAL = 0,
+    SLIM_REGISTER_VALUE_REGISTER = 1,
+    SLIM_REGISTER_VALUE_IMMEDIATE = 2,
+} SlimRegisterValueKind;
+
+typedef struct SlimRegisterValue {
+    u8_t kind;
+    s32_t source;    // Register holding the value, for SLIM_REGISTER_VALUE_REGISTER
+    u32_t immediate; // Zero-extended value, for SLIM_REGISTER_VALUE_IMMEDIATE
+} SlimRegisterValue;
+
+SLIM_VECTOR_DECLARE(SlimRegisterInstructionVector, SlimMachineInstruction, 16)
+SLIM_VECTOR_DECLARE(SlimRegisterAddressVector, u32_t, 16)
+SLIM_VECTOR_DECLARE(SlimRegisterFunctionVector, SlimRegisterFunction, 8)
+SLIM_VECTOR_DECLARE(SlimRegisterPathVector, SlimRegisterPath, 16)
+
+struct SlimRegisterProgram {
+    SlimRegisterInstructionVector instructions;
+    SlimRegisterAddressVector addresses; // Register address of every stack address, or SLIM_REGISTER_NO_ADDRESS
+    SlimBytecodeTable table;             // The table the program was translated from, natives resolve strings in it
+};
+
+typedef struct SlimRegisterTranslator {
+    SlimBytecodeTable table;
+    SlimRegisterProgram program;
+    u32_t count; // Number of stack instructions
+
+    // Analysis, indexed by stack address
+    s32_t* depths;        // Stack depth before the instruction, relative to the base pointer
+    u32_t* local_counts;  // Local count of the frame executing the instruction
+    u32_t* visitors;      // Function that last walked the instruction, plus one
+    u32_t* functions_at;  // Function starting at the instruction, plus one
+    u8_t* jump_targets;   // Whether some jump lands on the instruction
+    SlimRegisterFunctionVector functions;
+    SlimRegisterPathVector paths;
+
+    // Emission
+    SlimRegisterValue* values; // Virtual stack, indexed by register
+    s32_t depth;
+    u32_t local_count;
+    u32_t last_index;    // Index of the last instruction that wrote last_register by itself
+    s32_t last_register;
+} SlimRegisterTranslator;
+// ---------------------------------------------------------------------------------------------------------------------
+u32_t ___slim_register_pack(s32_t low, s32_t high) { return (u32_t)(u16_t)low | (u32_t)(u16_t)high << 16; }
+// ---------------------------------------------------------------------------------------------------------------------
+// The loader packs the callee's frame shape above the address of CALL, TAILCALL and PARFOR, see SlimBytecode.h
+u32_t ___slim_register_local_count(SlimBytecodeInstruction instruction) { return (instruction.operand >> 32) & 0xFFFF; }
+
+u32_t ___slim_register_argument_count(SlimBytecodeInstruction instruction) { return instruction.operand >> 48; }
+// Analysis ------------------------------------------------------------------------------------------------------------
+// Number of values an instruction reads from the stack and leaves on it.  Calls and returns depend on the callee and
+// are handled by the walk itself.  Opcodes without a register translation fail.
+SlimError ___slim_register_stack_effect(u8_t opcode, s32_t* pops, s32_t* pushes)
+{
+    *pops = 0;
+    *pushes = 0;
+
+    switch (opcode) {
+    case SL_OPCODE_NOOP:
+    case SL_OPCODE_HALT:
+    case SL_OPCODE_JMP:
+    case SL_OPCODE_CALL:
+    case SL_OPCODE_RET:
+    case SL_OPCODE_TAILCALL:
+    case SL_OPCODE_DJNZ: break;
+    case SL_OPCODE_LOADI:
+    case SL_OPCODE_LOADK:
+    case SL_OPCODE_LOADS:
+    case SL_OPCODE_LOADL:
+    case SL_OPCODE_CALLN: *pushes = 1; break;
+    case SL_OPCODE_STOREL:
+    case SL_OPCODE_DROP:
+    case SL_OPCODE_JNE:
+    case SL_OPCODE_JE: *pops = 1; break;
+    case SL_OPCODE_JLT:
+    case SL_OPCODE_JLE:
+    case SL_OPCODE_JGT:
+    case SL_OPCODE_JGE:
+    case SL_OPCODE_JLTU:
+    case SL_OPCODE_JLEU:
+    case SL_OPCODE_JGTU:
+    case SL_OPCODE_JGEU:
+    case SL_OPCODE_JLTF:
+    case SL_OPCODE_JLEF:
+    case SL_OPCODE_JGTF:
+    case SL_OPCODE_JGEF: *pops = 2; break;
+    case SL_OPCODE_DUP: *pops = 1, *pushes = 2; break;
+    case SL_OPCODE_SWAP: *pops = 2, *pushes = 2; break;
+    case SL_OPCODE_ROT: *pops = 3, *pushes = 3; break;
+    case SL_OPCODE_ADD:
+    case SL_OPCODE_SUB:
+    case SL_OPCODE_MUL:
+    case SL_OPCODE_DIV:
+    case SL_OPCODE_MOD:
+    case SL_OPCODE_ADDF:
+    case SL_OPCODE_SUBF:
+    case SL_OPCODE_MULF:
+    case SL_OPCODE_DIVF:
+    case SL_OPCODE_MODF: *pops = 2, *pushes = 1; break;
+    default: return SLIM_ERROR;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_function_find(SlimRegisterTranslator* translator, u32_t address, u32_t local_count,
+                                         u32_t argument_count, u32_t* index)
+{
+    if (address >= translator->count) return SLIM_ERROR;
+
+    if (translator->functions_at[address] != 0) {
+        *index = translator->functions_at[address] - 1;
+        SlimRegisterFunction* function = &translator->functions.data[*index];
+        u8_t same = function->local_count == local_count && function->argument_count == argument_count;
+        return same ? SL_ERROR_NONE : SLIM_ERROR;
+    }
+
+    SlimRegisterFunction* function = SlimRegisterFunctionVector_push(&translator->functions);
+    if (function == NULL) return SLIM_ERROR;
+
+    function->address = address;
+    function->local_count = local_count;
+    function->argument_count = argument_count;
+    function->arity = -1;
+    function->minimum = 0;
+    function->maximum = local_count;
+
+    *index = translator->functions.size - 1;
+    translator->functions_at[address] = *index + 1;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_function_return(SlimRegisterTranslator* translator, u32_t index, s32_t arity, u8_t* changed)
+{
+    SlimRegisterFunction* function = &translator->functions.data[index];
+    if (function->arity == -1) {
+        function->arity = arity;
+        *changed = 1;
+    }
+
+    return function->arity == arity ? SL_ERROR_NONE : SLIM_ERROR;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Follows every path through one function, recording the stack depth before each instruction.  A path that calls a
+// function whose arity is not known yet stops there and clears complete, it is walked again on the next pass.
+SlimError ___slim_register_walk(SlimRegisterTranslator* translator, u32_t index, u8_t* complete, u8_t* changed)
+{
+    u32_t local_count = translator->functions.data[index].local_count;
+    s32_t minimum = 0;
+    s32_t maximum = local_count;
+
+    translator->paths.size = 0;
+    SlimRegisterPath start = {translator->functions.data[index].address, local_count};
+    if (SlimRegisterPathVector_append(&translator->paths, start) != SL_ERROR_NONE) return SLIM_ERROR;
+
+    while (translator->paths.size > 0) {
+        SlimRegisterPath path = translator->paths.data[--translator->paths.size];
+        u32_t address = path.address;
+        s32_t depth = path.depth;
+
+        // Running off the end fails the fetch in either mode, so the path simply stops there
+        while (address < translator->count) {
+            if (translator->depths[address] != SLIM_REGISTER_UNREACHED) {
+                if (translator->depths[address] != depth) return SLIM_ERROR;
+                if (translator->local_counts[address] != local_count) return SLIM_ERROR;
+                if (translator->visitors[address] == index + 1) break;
+            }
+
+            translator->depths[address] = depth;
+            translator->local_counts[address] = local_count;
+            translator->visitors[address] = index + 1;
+
+            SlimBytecodeInstruction instruction;
+            SlimError error = slim_bytecode_table_lookup_instruction(translator->table, address, &instruction);
+            if (error != SL_ERROR_NONE) return error;
+
+            s32_t pops, pushes;
+            error = ___slim_register_stack_effect(instruction.opcode, &pops, &pushes);
+            if (error != SL_ERROR_NONE) return error;
+
+            u32_t next = address + 1;
+            u8_t stop = 0;
+            u32_t callee;
+
+            switch (instruction.opcode) {
+            case SL_OPCODE_LOADL:
+                if (instruction.operand >= local_count) return SLIM_ERROR;
+                break;
+            case SL_OPCODE_STOREL:
+                // The stack mode refuses to pop a local into a local, so there is nothing to translate it into
+                if (instruction.operand >= local_count || depth <= (s32_t)local_count) return SLIM_ERROR;
+                break;
+            case SL_OPCODE_JMP: next = (u32_t)instruction.operand; break;
+            case SL_OPCODE_DJNZ:
+                if ((instruction.operand >> 32) >= local_count) return SLIM_ERROR;
+                // Fall through, DJNZ branches like any other conditional jump
+            case SL_OPCODE_JNE:
+            case SL_OPCODE_JE:
+            case SL_OPCODE_JLT:
+            case SL_OPCODE_JLE:
+            case SL_OPCODE_JGT:
+            case SL_OPCODE_JGE:
+            case SL_OPCODE_JLTU:
+            case SL_OPCODE_JLEU:
+            case SL_OPCODE_JGTU:
+            case SL_OPCODE_JGEU:
+            case SL_OPCODE_JLTF:
+            case SL_OPCODE_JLEF:
+            case SL_OPCODE_JGTF:
+            case SL_OPCODE_JGEF: {
+                SlimRegisterPath branch = {(u32_t)instruction.operand, depth - pops};
+                if (SlimRegisterPathVector_append(&translator->paths, branch) != SL_ERROR_NONE) return SLIM_ERROR;
+                break;
+            }
+            case SL_OPCODE_CALL:
+            case SL_OPCODE_TAILCALL: {
+                u32_t callee_local_count = ___slim_register_local_count(instruction);
+                pops = ___slim_register_argument_count(instruction);
+                error = ___slim_register_function_find(
+                    translator, (u32_t)instruction.operand, callee_local_count, pops, &callee);
+                if (error != SL_ERROR_NONE) return error;
+
+                // The caller lays out every local of the callee before the call, above the arguments
+                s32_t frame_top = depth - pops + (s32_t)callee_local_count;
+                if (frame_top >= SLIM_REGISTER_MAX) return SLIM_ERROR;
+                maximum = frame_top > maximum ? frame_top : maximum;
+
+                stop = 1;
+                if (translator->functions.data[callee].arity == -1) {
+                    *complete = 0;
+                } else if (instruction.opcode == SL_OPCODE_CALL) {
+                    pushes = translator->functions.data[callee].arity;
+                    stop = 0;
+                } else {
+                    // A tail call returns whatever the callee returns
+                    error = ___slim_register_function_return(
+                        translator, index, translator->functions.data[callee].arity, changed);
+                    if (error != SL_ERROR_NONE) return error;
+                }
+                break;
+            }
+            case SL_OPCODE_RET:
+                // Whatever is left in the frame returns its top value, a frame popped below its base has no fixed
+                // effect on the caller's depth
+                if (depth < 0) return SLIM_ERROR;
+                error = ___slim_register_function_return(translator, index, depth > 0, changed);
+                if (error != SL_ERROR_NONE) return error;
+                stop = 1;
+                break;
+            case SL_OPCODE_HALT: stop = 1; break;
+            default: break;
+            }
+
+            s32_t bottom = depth - pops;
+            depth = bottom + pushes;
+            if (bottom < SLIM_REGISTER_MIN || depth >= SLIM_REGISTER_MAX) return SLIM_ERROR;
+            minimum = bottom < minimum ? bottom : minimum;
+            maximum = depth > maximum ? depth : maximum;
+
+            if (stop) break;
+            address = next;
+        }
+    }
+
+    translator->functions.data[index].minimum = minimum;
+    translator->functions.data[index].maximum = maximum;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Walks every function until the arity of every call is known.  Arities only ever go from unknown to known, so a pass
+// that learns nothing new means some call never returns on any path and the image cannot be translated.
+SlimError ___slim_register_analyze(SlimRegisterTranslator* translator, u32_t entry_local_count)
+{
+    u32_t entry;
+    SlimError error = ___slim_register_function_find(translator, 0, entry_local_count, 0, &entry);
+    if (error != SL_ERROR_NONE) return error;
+
+    for (;;) {
+        for (u32_t i = 0; i < translator->count; i++) {
+            translator->depths[i] = SLIM_REGISTER_UNREACHED;
+            translator->visitors[i] = 0;
+        }
+
+        u8_t complete = 1;
+        u8_t changed = 0;
+
+        // Functions discovered during the pass are appended and walked in the same pass
+        for (u32_t i = 0; i < translator->functions.size; i++) {
+            error = ___slim_register_walk(translator, i, &complete, &changed);
+            if (error != SL_ERROR_NONE) return error;
+        }
+
+        if (complete) return SL_ERROR_NONE;
+        if (!changed) return SLIM_ERROR;
+    }
+}
+// Emission ------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_emit(SlimRegisterTranslator* translator, u8_t opcode, u32_t arg1, u32_t arg2)
+{
+    SlimMachineInstruction* instruction = SlimRegisterInstructionVector_push(&translator->program->instructions);
+    if (instruction == NULL) return SLIM_ERROR;
+
+    instruction->opcode = opcode;
+    instruction->arg1 = arg1;
+    instruction->arg2 = arg2;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_emit_constant(SlimRegisterTranslator* translator, s32_t destination, u64_t value)
+{
+    SlimError error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_MOVI, (u16_t)destination, (u32_t)value);
+    if (error != SL_ERROR_NONE || (value >> 32) == 0) return error;
+
+    return ___slim_register_emit(translator, SL_REGISTER_OPCODE_MOVIH, (u16_t)destination, (u32_t)(value >> 32));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_emit_value(SlimRegisterTranslator* translator, s32_t destination, SlimRegisterValue value)
+{
+    switch (value.kind) {
+    case SLIM_REGISTER_VALUE_IMMEDIATE: return ___slim_register_emit_constant(translator, destination, value.immediate);
+    case SLIM_REGISTER_VALUE_REGISTER:
+        if (value.source == destination) return SL_ERROR_NONE;
+        return ___slim_register_emit(
+            translator, SL_REGISTER_OPCODE_MOV, ___slim_register_pack(destination, value.source), 0);
+    default: return SL_ERROR_NONE;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimRegisterValue ___slim_register_value(SlimRegisterTranslator* translator, s32_t position)
+{
+    SlimRegisterValue canonical = {SLIM_REGISTER_VALUE_CANONICAL, position, 0};
+    return position < (s32_t)translator->local_count ? canonical : translator->values[position];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void ___slim_register_canonicalize(SlimRegisterTranslator* translator, s32_t position)
+{
+    if (position >= (s32_t)translator->local_count) translator->values[position].kind = SLIM_REGISTER_VALUE_CANONICAL;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Registers below the local count are always canonical, so every virtual value is a copy of a local, a copy of a
+// canonical stack register below it, or an immediate.  That keeps materializing a value from ever clobbering a register
+// some other virtual value still reads.
+SlimError ___slim_register_materialize(SlimRegisterTranslator* translator, s32_t position)
+{
+    SlimRegisterValue value = translator->values[position];
+    translator->values[position].kind = SLIM_REGISTER_VALUE_CANONICAL;
+    return ___slim_register_emit_value(translator, position, value);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Materializes every value on the virtual stack that still reads a register about to be overwritten
+SlimError ___slim_register_release(SlimRegisterTranslator* translator, s32_t reg)
+{
+    for (s32_t position = translator->local_count; position < translator->depth; position++) {
+        SlimRegisterValue* value = &translator->values[position];
+        if (position != reg && value->kind == SLIM_REGISTER_VALUE_REGISTER && value->source == reg) {
+            SlimError error = ___slim_register_materialize(translator, position);
+            if (error != SL_ERROR_NONE) return error;
+        }
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_flush(SlimRegisterTranslator* translator)
+{
+    for (s32_t position = translator->local_count; position < translator->depth; position++) {
+        SlimError error = ___slim_register_materialize(translator, position);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_push(SlimRegisterTranslator* translator, SlimRegisterValue value)
+{
+    s32_t position = translator->depth++;
+    if (value.kind == SLIM_REGISTER_VALUE_REGISTER && value.source == position) {
+        value.kind = SLIM_REGISTER_VALUE_CANONICAL;
+    }
+
+    if (position >= (s32_t)translator->local_count) {
+        translator->values[position] = value;
+        return SL_ERROR_NONE;
+    }
+
+    // Pushing into the locals overwrites one, and those stay canonical
+    translator->depth--;
+    SlimError error = ___slim_register_release(translator, position);
+    translator->depth++;
+    if (error != SL_ERROR_NONE) return error;
+
+    return ___slim_register_emit_value(translator, position, value);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_push_constant(SlimRegisterTranslator* translator, u64_t constant)
+{
+    SlimRegisterValue value = {SLIM_REGISTER_VALUE_IMMEDIATE, 0, (u32_t)constant};
+    if ((constant >> 32) == 0) return ___slim_register_push(translator, value);
+
+    s32_t position = translator->depth;
+    SlimError error = ___slim_register_release(translator, position);
+    if (error != SL_ERROR_NONE) return error;
+
+    translator->depth++;
+    ___slim_register_canonicalize(translator, position);
+    return ___slim_register_emit_constant(translator, position, constant);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_translate_binary(SlimRegisterTranslator* translator, u8_t opcode)
+{
+    s32_t destination = translator->depth - 2;
+    SlimRegisterValue a = ___slim_register_value(translator, destination);
+    SlimRegisterValue b = ___slim_register_value(translator, destination + 1);
+
+    u8_t integer = opcode >= SL_OPCODE_ADD && opcode <= SL_OPCODE_MOD;
+    u8_t commutative = opcode == SL_OPCODE_ADD || opcode == SL_OPCODE_MUL;
+    u8_t has_immediate = commutative || opcode == SL_OPCODE_SUB;
+
+    // Immediates on both sides fold away entirely, except for a division by zero which is left to fault at run time
+    u8_t a_immediate = a.kind == SLIM_REGISTER_VALUE_IMMEDIATE;
+    u8_t b_immediate = b.kind == SLIM_REGISTER_VALUE_IMMEDIATE;
+    if (integer && a_immediate && b_immediate && !(b.immediate == 0 && opcode >= SL_OPCODE_DIV)) {
+        u64_t x = a.immediate;
+        u64_t y = b.immediate;
+        u64_t result = 0;
+        switch (opcode) {
+        case SL_OPCODE_ADD: result = x + y; break;
+        case SL_OPCODE_SUB: result = x - y; break;
+        case SL_OPCODE_MUL: result = x * y; break;
+        case SL_OPCODE_DIV: result = x / y; break;
+        case SL_OPCODE_MOD: result = x % y; break;
+        }
+
+        translator->depth = destination;
+        return ___slim_register_push_constant(translator, result);
+    }
+
+    s32_t a_register = destination;
+    s32_t b_register = destination + 1;
+    SlimError error;
+
+    if (a_immediate && !b_immediate && commutative) {
+        SlimRegisterValue swapped = a;
+        a = b;
+        b = swapped;
+        a_register = destination + 1;
+        b_register = destination;
+    } else if (a_immediate) {
+        error = ___slim_register_materialize(translator, a_register);
+        if (error != SL_ERROR_NONE) return error;
+        a.kind = SLIM_REGISTER_VALUE_CANONICAL;
+    }
+
+    u8_t immediate = b.kind == SLIM_REGISTER_VALUE_IMMEDIATE && has_immediate;
+    if (b.kind == SLIM_REGISTER_VALUE_IMMEDIATE && !immediate) {
+        error = ___slim_register_materialize(translator, b_register);
+        if (error != SL_ERROR_NONE) return error;
+        b.kind = SLIM_REGISTER_VALUE_CANONICAL;
+    }
+
+    s32_t x = a.kind == SLIM_REGISTER_VALUE_REGISTER ? a.source : a_register;
+    s32_t y = b.kind == SLIM_REGISTER_VALUE_REGISTER ? b.source : b_register;
+
+    // Both operands are consumed before the destination is written
+    translator->depth = destination;
+    error = ___slim_register_release(translator, destination);
+    if (error != SL_ERROR_NONE) return error;
+
+    u8_t register_opcode = opcode - SL_OPCODE_ADD + SL_REGISTER_OPCODE_ADD;
+    if (immediate) {
+        register_opcode = opcode - SL_OPCODE_ADD + SL_REGISTER_OPCODE_ADDI;
+    }
+
+    error = ___slim_register_emit(translator, register_opcode, ___slim_register_pack(destination, x),
+                                  immediate ? b.immediate : (u16_t)y);
+    if (error != SL_ERROR_NONE) return error;
+
+    ___slim_register_canonicalize(translator, destination);
+    translator->depth = destination + 1;
+    translator->last_index = translator->program->instructions.size - 1;
+    translator->last_register = destination;
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_translate_storel(SlimRegisterTranslator* translator, s32_t slot)
+{
+    s32_t top = translator->depth - 1;
+    SlimRegisterValue value = ___slim_register_value(translator, top);
+    translator->depth = top;
+
+    if (value.kind == SLIM_REGISTER_VALUE_REGISTER && value.source == slot) return SL_ERROR_NONE;
+
+    // When the value was just computed into its stack register, the instruction can write the local directly, as long
+    // as nothing else on the virtual stack still needs the local's old value
+    u8_t readers = 0;
+    for (s32_t position = translator->local_count; position < translator->depth; position++) {
+        SlimRegisterValue* other = &translator->values[position];
+        readers |= other->kind == SLIM_REGISTER_VALUE_REGISTER && other->source == slot;
+    }
+
+    if (value.kind == SLIM_REGISTER_VALUE_CANONICAL && translator->last_register == top && !readers &&
+        translator->last_index + 1 == translator->program->instructions.size) {
+        SlimMachineInstruction* last = &translator->program->instructions.data[translator->last_index];
+        last->arg1 = (last->arg1 & 0xFFFF0000) | (u16_t)slot;
+        translator->last_register = SLIM_REGISTER_UNREACHED;
+        return SL_ERROR_NONE;
+    }
+
+    SlimError error = ___slim_register_release(translator, slot);
+    if (error != SL_ERROR_NONE) return error;
+
+    if (value.kind == SLIM_REGISTER_VALUE_CANONICAL) {
+        value.kind = SLIM_REGISTER_VALUE_REGISTER;
+        value.source = top;
+    }
+
+    return ___slim_register_emit_value(translator, slot, value);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// SWAP and ROT shuffle canonical registers, copies would only ever be shuffled into cycles
+SlimError ___slim_register_translate_shuffle(SlimRegisterTranslator* translator, u8_t opcode)
+{
+    s32_t count = opcode == SL_OPCODE_SWAP ? 2 : 3;
+    s32_t base = translator->depth - count;
+
+    for (s32_t position = base; position < translator->depth; position++) {
+        if (position < (s32_t)translator->local_count) continue;
+
+        SlimError error = ___slim_register_materialize(translator, position);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    for (s32_t position = base; position < base + count; position++) {
+        s32_t depth = translator->depth;
+        translator->depth = base;
+        SlimError error = ___slim_register_release(translator, position);
+        translator->depth = depth;
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    if (opcode == SL_OPCODE_SWAP) {
+        return ___slim_register_emit(translator, SL_REGISTER_OPCODE_SWAP, ___slim_register_pack(base, base + 1), 0);
+    }
+    return ___slim_register_emit(translator, SL_REGISTER_OPCODE_ROT, (u16_t)base, 0);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Compare-and-branch has no immediate form, both operands are read from registers
+SlimError ___slim_register_translate_compare(SlimRegisterTranslator* translator, SlimBytecodeInstruction instruction)
+{
+    s32_t base = translator->depth - 2;
+    s32_t sources[2];
+
+    for (s32_t i = 0; i < 2; i++) {
+        SlimRegisterValue value = ___slim_register_value(translator, base + i);
+        if (value.kind == SLIM_REGISTER_VALUE_IMMEDIATE) {
+            SlimError error = ___slim_register_materialize(translator, base + i);
+            if (error != SL_ERROR_NONE) return error;
+            value.kind = SLIM_REGISTER_VALUE_CANONICAL;
+        }
+        sources[i] = value.kind == SLIM_REGISTER_VALUE_REGISTER ? value.source : base + i;
+    }
+
+    translator->depth = base;
+    SlimError error = ___slim_register_flush(translator);
+    if (error != SL_ERROR_NONE) return error;
+
+    u8_t opcode = instruction.opcode - SL_OPCODE_JLT + SL_REGISTER_OPCODE_JLT;
+    return ___slim_register_emit(
+        translator, opcode, ___slim_register_pack(sources[0], sources[1]), (u32_t)instruction.operand);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+// Translates one reachable instruction, setting falls_through when execution can continue at the next address
+SlimError ___slim_register_translate_instruction(
+    SlimRegisterTranslator* translator, SlimBytecodeInstruction instruction, u8_t* falls_through)
+{
+    SlimError error = SL_ERROR_NONE;
+    u32_t callee;
+    *falls_through = 1;
+
+    switch (instruction.opcode) {
+    case SL_OPCODE_NOOP: break;
+    case SL_OPCODE_LOADI: error = ___slim_register_push_constant(translator, instruction.operand); break;
+    case SL_OPCODE_LOADK: {
+        u64_t constant;
+        error = slim_bytecode_table_lookup_constant(translator->table, instruction.operand, &constant);
+        if (error == SL_ERROR_NONE) error = ___slim_register_push_constant(translator, constant);
+        break;
+    }
+    case SL_OPCODE_LOADS:
+        if (instruction.operand >= slim_bytecode_table_get_count_strings(translator->table)) return SLIM_ERROR;
+        error = ___slim_register_push_constant(translator, instruction.operand);
+        break;
+    case SL_OPCODE_LOADL: {
+        SlimRegisterValue value = {SLIM_REGISTER_VALUE_REGISTER, (s32_t)instruction.operand, 0};
+        error = ___slim_register_push(translator, value);
+        break;
+    }
+    case SL_OPCODE_STOREL: error = ___slim_register_translate_storel(translator, (s32_t)instruction.operand); break;
+    case SL_OPCODE_DROP: translator->depth--; break;
+    case SL_OPCODE_DUP: {
+        s32_t top = translator->depth - 1;
+        SlimRegisterValue value = ___slim_register_value(translator, top);
+        if (value.kind == SLIM_REGISTER_VALUE_CANONICAL) {
+            value.kind = SLIM_REGISTER_VALUE_REGISTER;
+            value.source = top;
+        }
+        error = ___slim_register_push(translator, value);
+        break;
+    }
+    case SL_OPCODE_SWAP:
+    case SL_OPCODE_ROT: error = ___slim_register_translate_shuffle(translator, instruction.opcode); break;
+    case SL_OPCODE_ADD:
+    case SL_OPCODE_SUB:
+    case SL_OPCODE_MUL:
+    case SL_OPCODE_DIV:
+    case SL_OPCODE_MOD:
+    case SL_OPCODE_ADDF:
+    case SL_OPCODE_SUBF:
+    case SL_OPCODE_MULF:
+    case SL_OPCODE_DIVF:
+    case SL_OPCODE_MODF: error = ___slim_register_translate_binary(translator, instruction.opcode); break;
+    case SL_OPCODE_JMP:
+        error = ___slim_register_flush(translator);
+        if (error == SL_ERROR_NONE) {
+            error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_JMP, 0, (u32_t)instruction.operand);
+        }
+        *falls_through = 0;
+        break;
+    case SL_OPCODE_JNE:
+    case SL_OPCODE_JE: {
+        s32_t top = translator->depth - 1;
+        SlimRegisterValue value = ___slim_register_value(translator, top);
+        translator->depth = top;
+
+        error = ___slim_register_flush(translator);
+        if (error != SL_ERROR_NONE) return error;
+
+        // A constant condition is decided here, either as a plain jump or as nothing at all
+        if (value.kind == SLIM_REGISTER_VALUE_IMMEDIATE) {
+            if ((value.immediate == 0) == (instruction.opcode == SL_OPCODE_JE)) {
+                error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_JMP, 0, (u32_t)instruction.operand);
+                *falls_through = 0;
+            }
+            break;
+        }
+
+        s32_t condition = value.kind == SLIM_REGISTER_VALUE_REGISTER ? value.source : top;
+        u8_t opcode = instruction.opcode == SL_OPCODE_JE ? SL_REGISTER_OPCODE_JE : SL_REGISTER_OPCODE_JNE;
+        error = ___slim_register_emit(translator, opcode, (u16_t)condition, (u32_t)instruction.operand);
+        break;
+    }
+    case SL_OPCODE_JLT:
+    case SL_OPCODE_JLE:
+    case SL_OPCODE_JGT:
+    case SL_OPCODE_JGE:
+    case SL_OPCODE_JLTU:
+    case SL_OPCODE_JLEU:
+    case SL_OPCODE_JGTU:
+    case SL_OPCODE_JGEU:
+    case SL_OPCODE_JLTF:
+    case SL_OPCODE_JLEF:
+    case SL_OPCODE_JGTF:
+    case SL_OPCODE_JGEF: error = ___slim_register_translate_compare(translator, instruction); break;
+    case SL_OPCODE_DJNZ:
+        error = ___slim_register_flush(translator);
+        if (error == SL_ERROR_NONE) {
+            error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_DJNZ, (u16_t)(instruction.operand >> 32),
+                                          (u32_t)instruction.operand);
+        }
+        break;
+    case SL_OPCODE_CALL:
+    case SL_OPCODE_TAILCALL: {
+        error = ___slim_register_flush(translator);
+        if (error != SL_ERROR_NONE) return error;
+
+        // The arguments are already in place as the callee's first locals, the others are zeroed right above them
+        u32_t local_count = ___slim_register_local_count(instruction);
+        u32_t argument_count = ___slim_register_argument_count(instruction);
+        s32_t base = translator->depth - (s32_t)argument_count;
+        for (s32_t position = translator->depth; position < base + (s32_t)local_count; position++) {
+            error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_MOVI, (u16_t)position, 0);
+            if (error != SL_ERROR_NONE) return error;
+        }
+
+        u8_t opcode = instruction.opcode == SL_OPCODE_CALL ? SL_REGISTER_OPCODE_CALL : SL_REGISTER_OPCODE_TAILCALL;
+        error = ___slim_register_emit(translator, opcode, ___slim_register_pack(base + local_count, local_count),
+                                      (u32_t)instruction.operand);
+        if (error != SL_ERROR_NONE) return error;
+
+        if (instruction.opcode == SL_OPCODE_TAILCALL) {
+            *falls_through = 0;
+            break;
+        }
+
+        error = ___slim_register_function_find(
+            translator, (u32_t)instruction.operand, local_count, argument_count, &callee);
+        if (error != SL_ERROR_NONE) return error;
+
+        translator->depth = base;
+        for (s32_t i = 0; i < translator->functions.data[callee].arity; i++) {
+            ___slim_register_canonicalize(translator, translator->depth++);
+        }
+        break;
+    }
+    case SL_OPCODE_CALLN:
+        error = ___slim_register_flush(translator);
+        if (error != SL_ERROR_NONE) return error;
+
+        error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_CALLN, (u16_t)translator->depth,
+                                      (u32_t)instruction.operand);
+        ___slim_register_canonicalize(translator, translator->depth++);
+        break;
+    case SL_OPCODE_RET:
+    case SL_OPCODE_HALT: {
+        error = ___slim_register_flush(translator);
+        if (error != SL_ERROR_NONE) return error;
+
+        u8_t opcode = instruction.opcode == SL_OPCODE_RET ? SL_REGISTER_OPCODE_RET : SL_REGISTER_OPCODE_HALT;
+        error = ___slim_register_emit(translator, opcode, (u16_t)translator->depth, (u32_t)instruction.operand);
+        *falls_through = 0;
+        break;
+    }
+    default: return SLIM_ERROR;
+    }
+
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError ___slim_register_generate(SlimRegisterTranslator* translator)
+{
+    SlimError error = SlimRegisterAddressVector_resize(&translator->program->addresses, translator->count);
+    if (error != SL_ERROR_NONE) return error;
+
+    // Blocks start at function entries and jump targets, the virtual stack is canonical at every block boundary
+    for (u32_t address = 0; address < translator->count; address++) {
+        translator->program->addresses.data[address] = SLIM_REGISTER_NO_ADDRESS;
+        if (translator->depths[address] == SLIM_REGISTER_UNREACHED) continue;
+
+        SlimBytecodeInstruction instruction;
+        slim_bytecode_table_lookup_instruction(translator->table, address, &instruction);
+        // Every opcode from JMP up to DJNZ is a jump, with the target in the low half of the operand
+        if (instruction.opcode >= SL_OPCODE_JMP && instruction.opcode <= SL_OPCODE_DJNZ) {
+            if ((u32_t)instruction.operand >= translator->count) return SLIM_ERROR;
+            translator->jump_targets[(u32_t)instruction.operand] = 1;
+        }
+    }
+
+    u8_t falls_through = 0;
+    for (u32_t address = 0; address < translator->count; address++) {
+        if (translator->depths[address] == SLIM_REGISTER_UNREACHED) {
+            falls_through = 0;
+            continue;
+        }
+
+        u32_t function = translator->functions_at[address];
+        if (!falls_through || function != 0 || translator->jump_targets[address]) {
+            if (falls_through) {
+                error = ___slim_register_flush(translator);
+                if (error != SL_ERROR_NONE) return error;
+            }
+
+            translator->depth = translator->depths[address];
+            translator->local_count = translator->local_counts[address];
+            for (s32_t position = translator->local_count; position < translator->depth; position++) {
+                translator->values[position].kind = SLIM_REGISTER_VALUE_CANONICAL;
+            }
+        } else if (translator->depth != translator->depths[address]) {
+            return SLIM_ERROR;
+        }
+
+        translator->program->addresses.data[address] = translator->program->instructions.size;
+
+        if (function != 0) {
+            SlimRegisterFunction* entry = &translator->functions.data[function - 1];
+            error = ___slim_register_emit(translator, SL_REGISTER_OPCODE_ENTER,
+                                          ___slim_register_pack(entry->minimum, entry->maximum), 0);
+            if (error != SL_ERROR_NONE) return error;
+        }
+
+        SlimBytecodeInstruction instruction;
+        slim_bytecode_table_lookup_instruction(translator->table, address, &instruction);
+        error = ___slim_register_translate_instruction(translator, instruction, &falls_through);
+        if (error != SL_ERROR_NONE) return error;
+    }
+
+    // Jumps and calls were emitted with stack addresses
+    for (u32_t i = 0; i < translator->program->instructions.size; i++) {
+        SlimMachineInstruction* instruction = &translator->program->instructions.data[i];
+        u8_t opcode = instruction->opcode;
+        u8_t jump = opcode >= SL_REGISTER_OPCODE_JMP && opcode <= SL_REGISTER_OPCODE_DJNZ;
+        if (jump || opcode == SL_REGISTER_OPCODE_CALL || opcode == SL_REGISTER_OPCODE_TAILCALL) {
+            instruction->arg2 = translator->program->addresses.data[instruction->arg2];
+            if (instruction->arg2 == SLIM_REGISTER_NO_ADDRESS) return SLIM_ERROR;
+        }
+    }
+
+    return SL_ERROR_NONE;
+}
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_register_program_translate(SlimBytecodeTable table, u32_t entry_local_count,
+                                          SlimRegisterProgram* program)
+{
+    SlimRegisterTranslator translator;
+    memset(&translator, 0, sizeof(translator));
+    translator.table = table;
+    translator.count = slim_bytecode_table_get_count_instrs(table);
+    translator.last_register = SLIM_REGISTER_UNREACHED;
+    SlimRegisterFunctionVector_init(&translator.functions);
+    SlimRegisterPathVector_init(&translator.paths);
+
+    SlimError error = SLIM_ERROR;
+    u32_t count = translator.count > 0 ? translator.count : 1;
+    translator.program = malloc(sizeof(struct SlimRegisterProgram));
+    translator.depths = malloc(count * sizeof(s32_t));
+    translator.local_counts = malloc(count * sizeof(u32_t));
+    translator.visitors = malloc(count * sizeof(u32_t));
+    translator.functions_at = calloc(count, sizeof(u32_t));
+    translator.jump_targets = calloc(count, sizeof(u8_t));
+    if (translator.program == NULL || translator.depths == NULL || translator.local_counts == NULL ||
+        translator.visitors == NULL || translator.functions_at == NULL || translator.jump_targets == NULL) {
+        goto exit;
+    }
+
+    SlimRegisterInstructionVector_init(&translator.program->instructions);
+    SlimRegisterAddressVector_init(&translator.program->addresses);
+    translator.program->table = table;
+    if (translator.count == 0) goto exit;
+
+    error = ___slim_register_analyze(&translator, entry_local_count);
+    if (error != SL_ERROR_NONE) goto exit;
+
+    // The virtual stack only ever holds registers from 0 up to the highest one any function touches
+    s32_t maximum = 1;
+    for (u32_t i = 0; i < translator.functions.size; i++) {
+        maximum = translator.functions.data[i].maximum > maximum ? translator.functions.data[i].maximum : maximum;
+    }
+
+    error = SLIM_ERROR;
+    translator.values = calloc(maximum + 1, sizeof(SlimRegisterValue));
+    if (translator.values == NULL) goto exit;
+
+    error = ___slim_register_generate(&translator);
+
+exit:
+    if (error == SL_ERROR_NONE) {
+        *program = translator.program;
+    } else {
+        slim_register_program_destroy(translator.program);
+    }
+
+    SlimRegisterFunctionVector_free(&translator.functions);
+    SlimRegisterPathVector_free(&translator.paths);
+    free(translator.depths);
+    free(translator.local_counts);
+    free(translator.visitors);
+    free(translator.functions_at);
+    free(translator.jump_targets);
+    free(translator.values);
+    return error;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_register_program_destroy(SlimRegisterProgram program)
+{
+    if (program == NULL) return;
+
+    SlimRegisterInstructionVector_free(&program->instructions);
+    SlimRegisterAddressVector_free(&program->addresses);
+    free(program);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u32_t slim_register_program_get_count_instrs(SlimRegisterProgram program) { return program->instructions.size; }
+
+SlimBytecodeTable slim_register_program_get_table(SlimRegisterProgram program) { return program->table; }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_register_program_lookup_instruction(SlimRegisterProgram program, u32_t address,
+                                                   SlimMachineInstruction* instruction)
+{
+    if (address >= program->instructions.size) return SLIM_ERROR;
+
+    *instruction = program->instructions.data[address];
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_register_program_map_address(SlimRegisterProgram program, u32_t address, u32_t* register_address)
+{
+    if (address >= program->addresses.size) return SLIM_ERROR;
+    if (program->addresses.data[address] == SLIM_REGISTER_NO_ADDRESS) return SLIM_ERROR;
+
+    *register_address = program->addresses.data[address];
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,164 @@
+#include <SlimThread.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct SlimThreadPool {
+    pthread_t* threads;
+    u32_t worker_count;
+
+    pthread_mutex_t submit; // Held for a whole job, so jobs from several threads run one after the other
+    pthread_mutex_t lock;   // Guards everything below
+    pthread_cond_t wake;    // Signalled when a job is posted or the pool shuts down
+    pthread_cond_t done;    // Signalled when the last worker leaves a job
+
+    SlimThreadTask task;
+    void* argument;
+    u32_t task_count;
+    u32_t next_task;
+    u32_t active_workers; // Workers that have not yet left the current job
+    u64_t generation;     // Bumped for every job, workers compare it against the last one they took part in
+    u8_t stop;
+};
+// ---------------------------------------------------------------------------------------------------------------------
+// Takes task indices until the job runs dry.  Called with the lock held and returns with it held.
+void ___slim_thread_pool_drain(SlimThreadPool pool)
+{
+    while (pool->next_task < pool->task_count) {
+        u32_t index = pool->next_task++;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool->task(pool->argument, index);
+        pthread_mutex_lock(&pool->lock);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void* ___slim_thread_pool_worker(void* argument)
+{
+    SlimThreadPool pool = argument;
+    u64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+
+        if (pool->stop) break;
+        seen = pool->generation;
+
+        ___slim_thread_pool_drain(pool);
+
+        if (--pool->active_workers == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimThreadPool slim_thread_pool_create(u32_t worker_count)
+{
+    SlimThreadPool pool = calloc(1, sizeof(struct SlimThreadPool));
+    if (pool == NULL) return NULL;
+
+    pthread_mutex_init(&pool->submit, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->threads = calloc(worker_count > 0 ? worker_count : 1, sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        slim_thread_pool_destroy(pool);
+        return NULL;
+    }
+
+    // A pool that could only start some of its threads still works, the caller picks up the slack
+    for (u32_t i = 0; i < worker_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, ___slim_thread_pool_worker, pool) != 0) break;
+        pool->worker_count++;
+    }
+
+    return pool;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_thread_pool_destroy(SlimThreadPool pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (u32_t i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit);
+
+    free(pool->threads);
+    free(pool);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_thread_pool_run(SlimThreadPool pool, u32_t task_count, SlimThreadTask task, void* argument)
+{
+    if (task_count == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->submit);
+    pthread_mutex_lock(&pool->lock);
+
+    pool->task = task;
+    pool->argument = argument;
+    pool->task_count = task_count;
+    pool->next_task = 0;
+    pool->active_workers = pool->worker_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+
+    ___slim_thread_pool_drain(pool);
+
+    // Every worker has to check out, even one that woke too late to find a task, before the job can be replaced
+    while (pool->active_workers > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->submit);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u32_t slim_thread_pool_get_count_workers(SlimThreadPool pool)
+{
+    return pool->worker_count;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static SlimThreadPool ___slim_thread_pool_shared = NULL;
+static pthread_once_t ___slim_thread_pool_shared_once = PTHREAD_ONCE_INIT;
+
+void ___slim_thread_pool_shared_create()
+{
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    const char* threads = getenv("SLIM_THREADS");
+    if (threads != NULL && threads[0] != '\0') {
+        thread_count = strtol(threads, NULL, 10);
+    }
+
+    if (thread_count < 1) thread_count = 1;
+    ___slim_thread_pool_shared = slim_thread_pool_create((u32_t)thread_count - 1);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimThreadPool slim_thread_pool_shared()
+{
+    pthread_once(&___slim_thread_pool_shared_once, ___slim_thread_pool_shared_create);
+    return ___slim_thread_pool_shared;
+}
@@ -0,0 +1,127 @@
+#include <SlimTrace.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t ___slim_trace_enabled = 0;
+__thread SlimTraceBuffer* ___slim_trace_buffer = NULL;
+
+// Every buffer ever created, they live until the process exits so the exporter can still read them
+static pthread_mutex_t ___slim_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static SlimTraceBuffer* ___slim_trace_buffers = NULL;
+static const char* ___slim_trace_path = NULL;
+
+// Clock readings taken when recording starts and when it is exported, which convert timestamps into microseconds
+static u64_t ___slim_trace_origin = 0;
+static u64_t ___slim_trace_origin_ns = 0;
+// Internal Functions --------------------------------------------------------------------------------------------------
+static u64_t ___slim_trace_wall_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64_t)now.tv_sec * 1000000000ull + (u64_t)now.tv_nsec;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+static void ___slim_trace_export_at_exit()
+{
+    FILE* file = fopen(___slim_trace_path, "w");
+    if (file == NULL) return;
+
+    slim_trace_export(file);
+    fclose(file);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+SlimTraceBuffer* ___slim_trace_buffer_create()
+{
+    SlimTraceBuffer* buffer = malloc(sizeof(SlimTraceBuffer));
+    if (buffer == NULL) return NULL;
+
+    buffer->count = 0;
+    buffer->thread = (s32_t)syscall(SYS_gettid);
+
+    pthread_mutex_lock(&___slim_trace_lock);
+    buffer->next = ___slim_trace_buffers;
+    ___slim_trace_buffers = buffer;
+    pthread_mutex_unlock(&___slim_trace_lock);
+
+    ___slim_trace_buffer = buffer;
+    return buffer;
+}
+// External API --------------------------------------------------------------------------------------------------------
+SlimError slim_trace_open(const char* path)
+{
+    if (!SLIM_TRACE_EVENTS || path == NULL) return SLIM_ERROR;
+
+    pthread_mutex_lock(&___slim_trace_lock);
+    u8_t first = ___slim_trace_path == NULL;
+    if (first) ___slim_trace_path = path;
+    pthread_mutex_unlock(&___slim_trace_lock);
+
+    // Only the first trace opened is exported, every later platform records into it
+    if (first) atexit(___slim_trace_export_at_exit);
+
+    slim_trace_set_enabled(1);
+    return SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+void slim_trace_set_enabled(u8_t enabled)
+{
+    pthread_mutex_lock(&___slim_trace_lock);
+    if (enabled && ___slim_trace_origin_ns == 0) {
+        ___slim_trace_origin = ___slim_trace_clock();
+        ___slim_trace_origin_ns = ___slim_trace_wall_ns();
+    }
+    pthread_mutex_unlock(&___slim_trace_lock);
+
+    __atomic_store_n(&___slim_trace_enabled, enabled != 0, __ATOMIC_RELAXED);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+u8_t slim_trace_get_enabled() { return __atomic_load_n(&___slim_trace_enabled, __ATOMIC_RELAXED); }
+// ---------------------------------------------------------------------------------------------------------------------
+SlimError slim_trace_export(FILE* file)
+{
+    pthread_mutex_lock(&___slim_trace_lock);
+
+    // Clock ticks per nanosecond since recording started, 1 when the clock counts nanoseconds already
+    double ticks_per_ns = 1.0;
+    u64_t elapsed_ns = ___slim_trace_wall_ns() - ___slim_trace_origin_ns;
+    if (___slim_trace_origin_ns != 0 && elapsed_ns > 0) {
+        ticks_per_ns = (double)(___slim_trace_clock() - ___slim_trace_origin) / elapsed_ns;
+    }
+    if (ticks_per_ns <= 0.0) ticks_per_ns = 1.0;
+
+    s32_t process = (s32_t)getpid();
+    u8_t first = 1;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    for (SlimTraceBuffer* buffer = ___slim_trace_buffers; buffer != NULL; buffer = buffer->next) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"slim %d\"}}",
+            first ? "" : ",\n", process, buffer->thread, buffer->thread);
+        first = 0;
+
+        u64_t count = __atomic_load_n(&buffer->count, __ATOMIC_ACQUIRE);
+        u64_t start = count > SLIM_TRACE_BUFFER_EVENTS ? count - SLIM_TRACE_BUFFER_EVENTS : 0;
+        for (u64_t i = start; i < count; i++) {
+            SlimTraceEvent* event = &buffer->events[i & (SLIM_TRACE_BUFFER_EVENTS - 1)];
+
+            // Events recorded before the clock origin was taken have nothing to be placed against
+            if (event->timestamp < ___slim_trace_origin) continue;
+            double microseconds = (double)(event->timestamp - ___slim_trace_origin) / ticks_per_ns / 1000.0;
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d", event->name,
+                event->phase, microseconds, process, buffer->thread);
+            if (event->phase == 'i') fprintf(file, ",\"s\":\"t\"");
+            fprintf(file, ",\"args\":{\"value\":%llu}}", (unsigned long long)event->argument);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    pthread_mutex_unlock(&___slim_trace_lock);
+    return ferror(file) ? SLIM_ERROR : SL_ERROR_NONE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -1,10 +1,28 @@
 #include <SlimPlatform.h>
 #include <SlimBytecode.h>
+#include <SlimChannel.h>
+#include <SlimConsole.h>
 #include <SlimData.h>
 #include <SlimFile.h>
+#include <SlimIo.h>
+#include <SlimMachine.h>
+#include <SlimNative.h>
+#include <SlimPerf.h>
+#include <SlimProfile.h>
+#include <SlimRegister.h>
+#include <SlimTrace.h>
 
 #include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+SLIM_VECTOR_DECLARE(TestU32Vector, u32_t, 4)
 
 void testSlimArray()
 {
@@ -34,6 +52,58 @@ void testSlimArray()
     slim_vector_destroy(vector, NULL);
 }
 
+void testSlimTypedVector()
+{
+    TestU32Vector vector;
+    TestU32Vector_init(&vector);
+
+    // The first elements stay in the inline buffer
+    for (u32_t i = 0; i < 4; i++) {
+        assert(TestU32Vector_append(&vector, i) == SL_ERROR_NONE);
+    }
+    assert(vector.data == vector.inline_data);
+
+    // Spilling to the heap keeps the existing elements
+    u32_t bulk[] = {4, 5, 6, 7, 8};
+    assert(TestU32Vector_append_many(&vector, bulk, 5) == SL_ERROR_NONE);
+    assert(vector.data != vector.inline_data);
+    assert(TestU32Vector_size(&vector) == 9);
+    for (u32_t i = 0; i < 9; i++) {
+        assert(*TestU32Vector_at(&vector, i) == i);
+    }
+
+    *TestU32Vector_at(&vector, 0) = 42;
+    assert(vector.data[0] == 42);
+
+    assert(TestU32Vector_resize(&vector, 12) == SL_ERROR_NONE);
+    assert(vector.data[11] == 0);
+    assert(TestU32Vector_reserve(&vector, 100) == SL_ERROR_NONE);
+    assert(vector.capacity >= 100 && vector.size == 12);
+
+    TestU32Vector_free(&vector);
+    assert(vector.size == 0 && vector.data == vector.inline_data);
+}
+
+void testSlimArena()
+{
+    SlimArena arena = slim_arena_create(64);
+
+    char* first = slim_arena_copy_string(arena, "native", 6);
+    char* second = slim_arena_copy_string(arena, "another", 7);
+    assert(strcmp(first, "native") == 0);
+    assert(strcmp(second, "another") == 0);
+    assert(((u64_t)second & 7) == 0);
+
+    // Larger than a chunk, and allocation carries on in the original chunk afterwards
+    u8_t* large = slim_arena_allocate(arena, 1000);
+    memset(large, 0xAB, 1000);
+    char* third = slim_arena_copy_string(arena, "x", 1);
+    assert(third == second + 8);
+    assert(strcmp(first, "native") == 0);
+
+    slim_arena_destroy(arena);
+}
+
 void testFileLoading()
 {
     // TODO: IMPLEMENT FILE LOADING TEST
@@ -41,21 +111,32 @@ void testFileLoading()
 
 void testBytecode()
 {
-    const u8_t BYTECODE_SIZE = 32 + 8;
     // clang-format off
-    u8_t file_data[BYTECODE_SIZE] = {
+    u8_t file_data[] = {
         0x00, 0x00, 0x00, 0x20, // header_size
         0x00, 0x00, 0x00, 0x08, // native_size
-        0x00, 0x00, 0x00, 0x00, // string_size
-        0x00, 0x00, 0x00, 0x00, // constant_size
-        0x00, 0x00, 0x00, 0x00, // instruction_size
-        0x00, 0x00, 0x00, 0x00, // padding
+        0x00, 0x00, 0x00, 0x09, // string_size
+        0x00, 0x00, 0x00, 0x08, // constant_size
+        0x00, 0x00, 0x00, 0x0D, // instruction_size
+        0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
         0x00, 0x00, 0x00, 0x00, // padding
         0x00, 0x00, 0x00, 0x00, // padding
 
         0x00, 0x06, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x00, // native: 0    'a'
+
+        0x00, 0x02, 0x68, 0x69,                         // string: 0    'hi'
+        0x00, 0x03, 0x68, 0x65, 0x79,                   // string: 1    'hey'
+
+        0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // constant: 0  2.0
+
+        0x10, 0xAC, 0x02,                               // loadi 300 (varint)
+        0x30,                                           // add
+        0x50, 0x00, 0x00, 0x00, 0x00,                   // jmp 0 (u32)
+        0x01, 0x00,                                     // halt 0 (u8)
+        0x16, 0x00,                                     // loadk 0 (varint)
     };
     // clang-format on
+    const u32_t BYTECODE_SIZE = sizeof(file_data);
 
     SlimBytecodeData bytecode = slim_bytecode_data_create(file_data, BYTECODE_SIZE);
 
@@ -107,6 +188,38 @@ void testBytecode()
     printf("string length: %d\n", strlen(string));
     printf("string: %s\n", string);
 
+    assert(slim_bytecode_table_get_count_instrs(table) == 5);
+
+    SlimBytecodeInstruction instruction;
+    error = slim_bytecode_table_lookup_instruction(table, 0, &instruction);
+    assert(error == SL_ERROR_NONE);
+    assert(instruction.opcode == 0x10 && instruction.operand == 300);
+
+    error = slim_bytecode_table_lookup_instruction(table, 2, &instruction);
+    assert(error == SL_ERROR_NONE);
+    assert(instruction.opcode == 0x50 && instruction.operand == 0);
+
+    error = slim_bytecode_table_lookup_instruction(table, 4, &instruction);
+    assert(error == SL_ERROR_NONE);
+    assert(instruction.opcode == 0x16 && instruction.operand == 0);
+
+    error = slim_bytecode_table_lookup_instruction(table, 5, &instruction);
+    assert(error != SL_ERROR_NONE);
+
+    u64_t constant;
+    error = slim_bytecode_table_lookup_constant(table, instruction.operand, &constant);
+    assert(error == SL_ERROR_NONE);
+    assert(constant == 0x4000000000000000);
+
+    SlimBytecodeString hi, hey;
+    assert(slim_bytecode_table_get_count_strings(table) == 2);
+    slim_bytecode_table_lookup_string_entry(table, 0, &hi);
+    slim_bytecode_table_lookup_string_entry(table, 1, &hey);
+    assert(hi.length == 2 && strcmp(hi.data, "hi") == 0);
+    assert(hey.length == 3 && strcmp(hey.data, "hey") == 0);
+    assert(hi.hash == slim_bytecode_hash("hi", 2));
+    assert(!slim_bytecode_string_equal(&hi, &hey));
+
 exit:
     slim_bytecode_data_destroy(bytecode);
     slim_bytecode_table_destroy(table);
@@ -114,6 +227,2119 @@ exit:
     return;
 }
 
+// clang-format off
+u8_t SECTIONED_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x05, // instruction_size
+    0x00, 0x00, 0x00, 0x30, // section_size
+    0x00, 0x00, 0x00, 0x00, // padding
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, // section: 0   address 0, 2 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, //              bytes [0, 4)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //              no locals
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, // section: 1   address 2, 1 instruction
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01, //              bytes [4, 5)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //              no locals
+
+    0x10, 0x01,                                     // loadi 1
+    0x01, 0x00,                                     // halt 0
+    0xEE,                                           // invalid opcode, only detected once section 1 is used
+};
+// clang-format on
+
+void testBytecodeSections()
+{
+    SlimBytecodeData bytecode = slim_bytecode_data_create(SECTIONED_BYTECODE, sizeof(SECTIONED_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+
+    SlimError error = slim_bytecode_table_load_data(table, bytecode);
+    assert(error == SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_sections(table) == 2);
+    assert(slim_bytecode_table_get_count_instrs(table) == 3);
+
+    SlimBytecodeSection section;
+    slim_bytecode_table_lookup_section(table, 0, &section);
+    assert(section.loaded == 0);
+
+    SlimBytecodeInstruction instruction;
+    error = slim_bytecode_table_lookup_instruction(table, 1, &instruction);
+    assert(error == SL_ERROR_NONE);
+    assert(instruction.opcode == 0x01);
+
+    slim_bytecode_table_lookup_section(table, 0, &section);
+    assert(section.loaded == 1);
+    slim_bytecode_table_lookup_section(table, 1, &section);
+    assert(section.loaded == 0);
+
+    error = slim_bytecode_table_lookup_instruction(table, 2, &instruction);
+    assert(error != SL_ERROR_NONE);
+
+    slim_bytecode_data_destroy(bytecode);
+    slim_bytecode_table_destroy(table);
+}
+
+void testBytecodeParallel()
+{
+    // 64 sections, each "loadi <index>; halt 0", so every chunk of the instruction table is distinguishable
+    const u32_t sections = 64;
+    u32_t size = 32 + sections * 24 + sections * 4;
+    u8_t* image = calloc(size, 1);
+
+    image[3] = 32;
+    image[18] = ((sections * 4) >> 8) & 0xFF;
+    image[19] = (sections * 4) & 0xFF;
+    image[22] = ((sections * 24) >> 8) & 0xFF;
+    image[23] = (sections * 24) & 0xFF;
+
+    for (u32_t i = 0; i < sections; i++) {
+        u8_t* entry = image + 32 + i * 24;
+        u8_t* code = image + 32 + sections * 24 + i * 4;
+        entry[3] = i * 2;
+        entry[7] = 2;
+        entry[10] = ((i * 4) >> 8) & 0xFF;
+        entry[11] = (i * 4) & 0xFF;
+        entry[15] = 4;
+        code[0] = 0x10;
+        code[1] = i;
+        code[2] = 0x01;
+        code[3] = 0x00;
+    }
+
+    SlimBytecodeData bytecode = slim_bytecode_data_create(image, size);
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data_parallel(table, bytecode, 4) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_instrs(table) == sections * 2);
+
+    for (u32_t i = 0; i < sections; i++) {
+        SlimBytecodeSection section;
+        SlimBytecodeInstruction instruction;
+        slim_bytecode_table_lookup_section(table, i, &section);
+        assert(section.loaded == 1);
+        slim_bytecode_table_lookup_instruction(table, i * 2, &instruction);
+        assert(instruction.opcode == 0x10 && instruction.operand == i);
+    }
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    free(image);
+
+    // A bad section anywhere fails the whole load
+    bytecode = slim_bytecode_data_create(SECTIONED_BYTECODE, sizeof(SECTIONED_BYTECODE));
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data_parallel(table, bytecode, 0) != SL_ERROR_NONE);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+}
+
+// clang-format off
+// Natives std.print (0) and std.read (3), sections main, helper and util with only main and util exported, as written
+// by SlapImageWriter
+u8_t SYMBOL_BYTECODE[] = {
+    // header
+    0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x48,
+    0x00, 0x00, 0x00, 0x59, 0x00, 0x00, 0x00, 0x00,
+    // natives
+    0x00, 0x09, 0x73, 0x74, 0x64, 0x2E, 0x70, 0x72, 0x69, 0x6E, 0x74, 0x00,
+    0x08, 0x73, 0x74, 0x64, 0x2E, 0x72, 0x65, 0x61, 0x64,
+    // sections
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // symbols: seed, bucket count, symbol count, displacement
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x04,
+    0x00, 0x00, 0x00, 0x04,
+    // symbols: entries
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x0C, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x15, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00, 0x02,
+    // symbols: names
+    0x6D, 0x61, 0x69, 0x6E, 0x73, 0x74, 0x64, 0x2E, 0x72, 0x65, 0x61, 0x64,
+    0x73, 0x74, 0x64, 0x2E, 0x70, 0x72, 0x69, 0x6E, 0x74, 0x75, 0x74, 0x69,
+    0x6C,
+    // instructions
+    0x01, 0x00, 0x00, 0x00,
+};
+// clang-format on
+
+void testBytecodeSymbols()
+{
+    SlimBytecodeData bytecode = slim_bytecode_data_create(SYMBOL_BYTECODE, sizeof(SYMBOL_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    SlimBytecodeSymbol symbol;
+
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_symbols(table) == 4);
+
+    assert(slim_bytecode_table_lookup_symbol(table, "std.read", 8, &symbol) == SL_ERROR_NONE);
+    assert(symbol.kind == SLIM_BYTECODE_SYMBOL_NATIVE && symbol.index == 3);
+    assert(slim_bytecode_table_lookup_symbol(table, "std.print", 9, &symbol) == SL_ERROR_NONE);
+    assert(symbol.kind == SLIM_BYTECODE_SYMBOL_NATIVE && symbol.index == 0);
+    assert(slim_bytecode_table_lookup_symbol(table, "util", 4, &symbol) == SL_ERROR_NONE);
+    assert(symbol.kind == SLIM_BYTECODE_SYMBOL_SECTION && symbol.index == 2);
+    assert(slim_bytecode_table_lookup_symbol(table, "main", 4, &symbol) == SL_ERROR_NONE);
+    assert(symbol.kind == SLIM_BYTECODE_SYMBOL_SECTION && symbol.index == 0);
+
+    // Unexported sections and unknown names are rejected
+    assert(slim_bytecode_table_lookup_symbol(table, "helper", 6, &symbol) != SL_ERROR_NONE);
+    assert(slim_bytecode_table_lookup_symbol(table, "mai", 3, &symbol) != SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+}
+
+// clang-format off
+// main (1 local) calls square (2 locals, the first its argument) with 5 and keeps the result in its local
+u8_t FRAME_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x1D, // instruction_size
+    0x00, 0x00, 0x00, 0x30, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, // section: main    address 0, 5 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, //                  bytes [0, 15)
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, //                  1 local
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x06, // section: square  address 5, 6 instructions
+    0x00, 0x00, 0x00, 0x0F, 0x00, 0x00, 0x00, 0x0E, //                  bytes [15, 29)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, //                  x as argument, x * x
+
+    0x10, 0x05,                                     // loadi 5
+    0x60, 0x00, 0x00, 0x00, 0x05,                   // call square
+    0x19, 0x00, 0x00,                               // storel 0
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x01, 0x00,                                     // halt 0
+
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x32,                                           // mul
+    0x19, 0x00, 0x01,                               // storel 1
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x61,                                           // ret
+};
+// clang-format on
+
+void testMachineFrames()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(FRAME_BYTECODE, sizeof(FRAME_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    SlimBytecodeSection section;
+    assert(slim_bytecode_table_lookup_section(table, 0, &section) == SL_ERROR_NONE);
+    assert(slim_machine_enter(machine, section.address, section.local_count) == SL_ERROR_NONE);
+
+    // Everything up to, but not including, the final halt
+    for (u32_t i = 0; i < 10; i++) {
+        slim_machine_step(machine, table);
+        slim_log_flush(log_context);
+        assert(!slim_machine_flag_get_error(machine));
+    }
+
+    // RET discards the callee frame, argument included, and leaves its result where the argument was
+    u64_t value;
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 25);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 25);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+// main calls count with 1000, count decrements and tail calls itself until it reaches zero
+u8_t TAILCALL_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x1B, // instruction_size
+    0x00, 0x00, 0x00, 0x48, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, // section: main    address 0, 3 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, //                  bytes [0, 10)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //                  no locals
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x07, // section: count   address 3, 7 instructions
+    0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x10, //                  bytes [10, 26)
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, //                  n as argument
+    0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x01, // section: done    address 10, 1 instruction
+    0x00, 0x00, 0x00, 0x1A, 0x00, 0x00, 0x00, 0x01, //                  bytes [26, 27)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //                  no locals
+
+    0x10, 0xE8, 0x07,                               // loadi 1000
+    0x60, 0x00, 0x00, 0x00, 0x03,                   // call count
+    0x01, 0x00,                                     // halt 0
+
+    0x20,                                           // dup
+    0x52, 0x00, 0x00, 0x00, 0x0A,                   // je done
+    0x10, 0x01,                                     // loadi 1
+    0x31,                                           // sub
+    0x20,                                           // dup
+    0x63, 0x00, 0x00, 0x00, 0x03,                   // tailcall count
+    0x61,                                           // ret
+
+    0x61,                                           // ret
+};
+// clang-format on
+
+void testMachineTailCall()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(TAILCALL_BYTECODE, sizeof(TAILCALL_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+
+    // 1000 levels would overflow both stacks as plain calls, every tail call has to reuse the frame
+    u32_t steps = 2 + 1000 * 6 + 3;
+    for (u32_t i = 0; i < steps; i++) {
+        slim_machine_step(machine, table);
+        slim_log_flush(log_context);
+        assert(!slim_machine_flag_get_error(machine));
+    }
+
+    // Every tail call replaces the argument, the last one reaches zero and returns it to main
+    u64_t value;
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+// main passes 2 and 3 to add, which consumes both of its arguments
+u8_t ARGUMENT_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x0D, // instruction_size
+    0x00, 0x00, 0x00, 0x30, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, // section: main    address 0, 4 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0B, //                  bytes [0, 11)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //                  no locals
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02, // section: add     address 4, 2 instructions
+    0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x02, //                  bytes [11, 13)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, //                  both arguments
+
+    0x10, 0x02,                                     // loadi 2
+    0x10, 0x03,                                     // loadi 3
+    0x60, 0x00, 0x00, 0x00, 0x04,                   // call add
+    0x01, 0x00,                                     // halt 0
+
+    0x30,                                           // add
+    0x61,                                           // ret
+};
+// clang-format on
+
+void testMachineArguments()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(ARGUMENT_BYTECODE, sizeof(ARGUMENT_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    // The arguments are the callee's locals, popping them stays inside its frame and RET leaves only the result
+    u64_t value;
+    for (u32_t variant = 0; variant < SLIM_MACHINE_VARIANT_COUNT; variant++) {
+        SlimMachineState machine = slim_machine_create_variant(&log_context, variant);
+        assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+        slim_machine_run(machine, table);
+        slim_log_flush(log_context);
+        assert(slim_machine_flag_get_halt(machine) && !slim_machine_flag_get_error(machine));
+
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 5);
+        assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+        slim_machine_destroy(machine);
+    }
+
+    SlimRegisterProgram program = NULL;
+    assert(slim_register_program_translate(table, 0, &program) == SL_ERROR_NONE);
+
+    SlimMachineState machine = slim_machine_create(&log_context);
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    while (!slim_machine_flag_get_halt(machine)) {
+        slim_machine_register_step(machine, program);
+        slim_log_flush(log_context);
+        assert(!slim_machine_flag_get_error(machine));
+    }
+
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 5);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    slim_machine_destroy(machine);
+    slim_register_program_destroy(program);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+
+    // A call into the middle of add would take on add's frame shape, so decoding the caller rejects it
+    SlimBytecodeInstruction instruction;
+    ARGUMENT_BYTECODE[sizeof(ARGUMENT_BYTECODE) - 5] = 0x05;
+    bytecode = slim_bytecode_data_create(ARGUMENT_BYTECODE, sizeof(ARGUMENT_BYTECODE));
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_lookup_instruction(table, 0, &instruction) != SL_ERROR_NONE);
+    ARGUMENT_BYTECODE[sizeof(ARGUMENT_BYTECODE) - 5] = 0x04;
+
+    // Both loads were decoded before the call was rejected, neither may be handed out afterwards
+    assert(slim_bytecode_table_lookup_instruction(table, 0, &instruction) != SL_ERROR_NONE);
+    assert(slim_bytecode_table_lookup_instruction(table, 1, &instruction) != SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t REGISTER_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x37, // instruction_size
+    0x00, 0x00, 0x00, 0x60, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, // section: main    address 0, 4 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, //                  bytes [0, 10)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, //                  sum, i
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x0B, // section: loop    address 4, 11 instructions
+    0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x20, //                  bytes [10, 42)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, //                  same frame as main
+    0x00, 0x00, 0x00, 0x0F, 0x00, 0x00, 0x00, 0x03, // section: done    address 15, 3 instructions
+    0x00, 0x00, 0x00, 0x2A, 0x00, 0x00, 0x00, 0x0A, //                  bytes [42, 52)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, //                  same frame as main
+    0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x03, // section: square  address 18, 3 instructions
+    0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 0x03, //                  bytes [52, 55)
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, //                  its argument
+
+    0x10, 0x00,                                     // loadi 0
+    0x19, 0x00, 0x00,                               // storel 0
+    0x10, 0x64,                                     // loadi 100
+    0x19, 0x00, 0x01,                               // storel 1
+
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x52, 0x00, 0x00, 0x00, 0x0F,                   // je done
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x30,                                           // add
+    0x19, 0x00, 0x00,                               // storel 0
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x10, 0x01,                                     // loadi 1
+    0x31,                                           // sub
+    0x19, 0x00, 0x01,                               // storel 1
+    0x50, 0x00, 0x00, 0x00, 0x04,                   // jmp loop
+
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x60, 0x00, 0x00, 0x00, 0x12,                   // call square
+    0x01, 0x00,                                     // halt 0
+
+    0x20,                                           // dup
+    0x32,                                           // mul
+    0x61,                                           // ret
+};
+// clang-format on
+
+void testMachineRegisterMode()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(REGISTER_BYTECODE, sizeof(REGISTER_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    SlimRegisterProgram program = NULL;
+    assert(slim_register_program_translate(table, 2, &program) == SL_ERROR_NONE);
+    assert(slim_register_program_get_count_instrs(program) < slim_bytecode_table_get_count_instrs(table));
+
+    // Both modes step to the halt and must leave the same stack behind
+    u32_t stack_steps = 0;
+    assert(slim_machine_enter(machine, 0, 2) == SL_ERROR_NONE);
+    while (!slim_machine_flag_get_halt(machine)) {
+        slim_machine_step(machine, table);
+        slim_log_flush(log_context);
+        assert(!slim_machine_flag_get_error(machine));
+        stack_steps++;
+    }
+
+    u64_t value;
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 25502500);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 5050);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    u32_t register_steps = 0;
+    slim_machine_reset(machine);
+    assert(slim_machine_enter(machine, 0, 2) == SL_ERROR_NONE);
+    while (!slim_machine_flag_get_halt(machine)) {
+        slim_machine_register_step(machine, program);
+        slim_log_flush(log_context);
+        assert(!slim_machine_flag_get_error(machine));
+        register_steps++;
+    }
+
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 25502500);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 5050);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+    assert(register_steps < stack_steps);
+
+    // Every reachable stack address has a register counterpart, the entry lines up with the root frame
+    u32_t address;
+    assert(slim_register_program_map_address(program, 0, &address) == SL_ERROR_NONE && address == 0);
+    assert(slim_register_program_map_address(program, 18, &address) == SL_ERROR_NONE);
+    assert(slim_register_program_map_address(program, 21, &address) != SL_ERROR_NONE);
+
+    slim_register_program_destroy(program);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t BRANCH_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x4F, // instruction_size
+    0x00, 0x00, 0x00, 0x18, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1D, // section: main    address 0, 29 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4F, //                  bytes [0, 79)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, //                  sum, n
+
+    0x10, 0x0A,                                     // loadi 10
+    0x19, 0x00, 0x01,                               // storel 1
+
+    0x18, 0x00, 0x00,                               // loop: loadl 0
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x30,                                           // add
+    0x19, 0x00, 0x00,                               // storel 0
+    0x5F, 0x81, 0x80, 0x08,                         // djnz 1 loop
+
+    0x10, 0x00,                                     // loadi 0
+    0x10, 0x01,                                     // loadi 1
+    0x31,                                           // sub
+    0x19, 0x00, 0x01,                               // storel 1
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x10, 0x01,                                     // loadi 1
+    0x53, 0x00, 0x00, 0x00, 0x10,                   // jlt signed
+
+    0x10, 0x01,                                     // fail: loadi 1
+    0x01, 0x00,                                     // halt 0
+
+    0x18, 0x00, 0x01,                               // signed: loadl 1
+    0x10, 0x01,                                     // loadi 1
+    0x57, 0x00, 0x00, 0x00, 0x0E,                   // jltu fail
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x10, 0x01,                                     // loadi 1
+    0x5E, 0x00, 0x00, 0x00, 0x0E,                   // jgef fail
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x02,                                     // loadi 2
+    0x5B, 0x00, 0x00, 0x00, 0x1B,                   // jltf done
+    0x10, 0x01,                                     // loadi 1
+    0x01, 0x00,                                     // halt 0
+
+    0x18, 0x00, 0x00,                               // done: loadl 0
+    0x01, 0x00,                                     // halt 0
+};
+// clang-format on
+
+void testMachineBranches()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(BRANCH_BYTECODE, sizeof(BRANCH_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    SlimBytecodeInstruction instruction;
+    assert(slim_bytecode_table_lookup_instruction(table, 6, &instruction) == SL_ERROR_NONE);
+    assert(instruction.opcode == SL_OPCODE_DJNZ && instruction.operand == ((u64_t)1 << 32 | 2));
+
+    SlimRegisterProgram program = NULL;
+    assert(slim_register_program_translate(table, 2, &program) == SL_ERROR_NONE);
+
+    // -1 is below 1 as a signed integer, above it as an unsigned one, and a NaN as a float.  A wrong branch halts with
+    // 1 on top instead of the sum.
+    for (u32_t mode = 0; mode < 2; mode++) {
+        u32_t steps = 0;
+        slim_machine_reset(machine);
+        assert(slim_machine_enter(machine, 0, 2) == SL_ERROR_NONE);
+        while (!slim_machine_flag_get_halt(machine)) {
+            if (mode == 0) {
+                slim_machine_step(machine, table);
+            } else {
+                slim_machine_register_step(machine, program);
+            }
+            slim_log_flush(log_context);
+            assert(!slim_machine_flag_get_error(machine));
+            steps++;
+        }
+
+        u64_t value;
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 55);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == (u64_t)-1);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 55);
+        assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+        // Ten iterations of four body instructions and a single DJNZ for the loop itself
+        if (mode == 0) assert(steps == 2 + 10 * 5 + 18);
+    }
+
+    slim_register_program_destroy(program);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t PARFOR_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x4E, // instruction_size
+    0x00, 0x00, 0x00, 0x48, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0B, // section: main    address 0, 11 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x19, //                  bytes [0, 25)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //                  no locals
+    0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x11, // section: square  address 11, 17 instructions
+    0x00, 0x00, 0x00, 0x19, 0x00, 0x00, 0x00, 0x2D, //                  bytes [25, 70)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, //                  i, last as arguments
+    0x00, 0x00, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x04, // section: stray   address 28, 4 instructions
+    0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00, 0x08, //                  bytes [70, 78)
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, //                  first, last as arguments
+
+    0x10, 0x03,                                     // loadi 3
+    0x10, 0x00,                                     // loadi 0
+    0x15, 0x00, 0x00,                               // storem 0
+    0x10, 0x64,                                     // loadi 100
+    0x10, 0x00,                                     // loadi 0
+    0x10, 0x40,                                     // loadi 64
+    0x64, 0x00, 0x00, 0x00, 0x0B,                   // parfor square
+    0x10, 0x64,                                     // loadi 100
+    0x10, 0x40,                                     // loadi 64
+    0x85,                                           // vsum
+    0x01, 0x00,                                     // halt 0
+
+    0x18, 0x00, 0x00,                               // loop: loadl 0
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x56, 0x00, 0x00, 0x00, 0x1B,                   // jge done
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x32,                                           // mul
+    0x10, 0x00,                                     // loadi 0
+    0x12, 0x00, 0x00,                               // loadm 0
+    0x30,                                           // add
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x15, 0x00, 0x64,                               // storem 100
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x10, 0x01,                                     // loadi 1
+    0x30,                                           // add
+    0x19, 0x00, 0x00,                               // storel 0
+    0x50, 0x00, 0x00, 0x00, 0x0B,                   // jmp loop
+    0x61,                                           // done: ret
+
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x00,                                     // loadi 0
+    0x15, 0x00, 0x00,                               // storem 0
+    0x61,                                           // ret
+};
+// clang-format on
+
+void testMachineParallelFor()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(PARFOR_BYTECODE, sizeof(PARFOR_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    // Every chunk writes i * i + 3 to word 100 + i, reading the 3 from word 0 of the parent
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    slim_machine_run(machine, table);
+    slim_log_flush(log_context);
+    assert(slim_machine_flag_get_halt(machine));
+
+    u64_t value;
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 63 * 64 * 127 / 6 + 64 * 3);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    // A chunk storing outside its own output words fails the whole PARFOR, and so does an output past the end
+    assert(___slim_machine_parallel_for(machine, 28, 2, 100, 0, 8) != SL_ERROR_NONE);
+    assert(___slim_machine_parallel_for(machine, 11, 2, 4090, 0, 8) != SL_ERROR_NONE);
+    assert(___slim_machine_parallel_for(machine, 11, 2, 100, 8, 8) == SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t MEMORY_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x3D, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x07,                                     // loadi 7
+    0x10, 0x05,                                     // loadi 5
+    0x43,                                           // memfill
+    0x10, 0x0A,                                     // loadi 10
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x05,                                     // loadi 5
+    0x42,                                           // memcopy
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x0A,                                     // loadi 10
+    0x10, 0x05,                                     // loadi 5
+    0x44,                                           // memcmp
+    0x10, 0x0C,                                     // loadi 12
+    0x10, 0x00,                                     // loadi 0
+    0x10, 0x01,                                     // loadi 1
+    0x43,                                           // memfill
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x0A,                                     // loadi 10
+    0x10, 0x05,                                     // loadi 5
+    0x44,                                           // memcmp
+    0x10, 0x0A,                                     // loadi 10
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x05,                                     // loadi 5
+    0x44,                                           // memcmp
+    0x10, 0x0B,                                     // loadi 11
+    0x10, 0x0A,                                     // loadi 10
+    0x10, 0x04,                                     // loadi 4
+    0x42,                                           // memcopy
+    0x10, 0x0D,                                     // loadi 13
+    0x12, 0x00, 0x00,                               // loadm 0
+    0x10, 0x0E,                                     // loadi 14
+    0x12, 0x00, 0x00,                               // loadm 0
+    0x01, 0x00,                                     // halt 0
+};
+// clang-format on
+
+void testMachineMemory()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(MEMORY_BYTECODE, sizeof(MEMORY_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    slim_machine_run(machine, table);
+    slim_log_flush(log_context);
+    assert(slim_machine_flag_get_halt(machine));
+
+    // The last copy overlaps its source by three words and moves the cleared word 12 up to 13
+    u64_t value;
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 7);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == (u64_t)-1);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 1);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    // Words are ordered as unsigned integers, not by their bytes in memory
+    s64_t result;
+    assert(___slim_machine_memory_fill(machine, 100, 0x0100, 1) == SL_ERROR_NONE);
+    assert(___slim_machine_memory_fill(machine, 101, 0x0001, 1) == SL_ERROR_NONE);
+    assert(___slim_machine_memory_compare(machine, 100, 101, 1, &result) == SL_ERROR_NONE && result == 1);
+
+    // The whole range is checked before anything is touched
+    assert(___slim_machine_memory_fill(machine, 4090, 1, 10) != SL_ERROR_NONE);
+    assert(___slim_machine_memory_copy(machine, 0, 4090, 10) != SL_ERROR_NONE);
+    assert(___slim_machine_memory_compare(machine, 0, (u64_t)-1, 2, &result) != SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t VECTOR_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x08, // constant_size
+    0x00, 0x00, 0x00, 0x6D, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x3F, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // constant: 0  1.0
+
+    0x10, 0x0A,                                     // loadi 10
+    0x19, 0x00, 0x00,                               // storel 0
+    0x18, 0x00, 0x01,                               // loop: loadl 1
+    0x16, 0x00,                                     // loadk 0
+    0x35,                                           // addf
+    0x19, 0x00, 0x01,                               // storel 1
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x15, 0x00, 0x00,                               // storem 0
+    0x18, 0x00, 0x01,                               // loadl 1
+    0x18, 0x00, 0x00,                               // loadl 0
+    0x15, 0x00, 0x14,                               // storem 20
+    0x5F, 0x80, 0x80, 0x08,                         // djnz 0 loop
+    0x10, 0x29,                                     // loadi 41
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x0A,                                     // loadi 10
+    0x80,                                           // vadd
+    0x10, 0x29,                                     // loadi 41
+    0x10, 0x0A,                                     // loadi 10
+    0x85,                                           // vsum
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x0A,                                     // loadi 10
+    0x84,                                           // vdot
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x0A,                                     // loadi 10
+    0x86,                                           // vmin
+    0x10, 0x01,                                     // loadi 1
+    0x10, 0x0A,                                     // loadi 10
+    0x87,                                           // vmax
+    0x10, 0x29,                                     // loadi 41
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x0A,                                     // loadi 10
+    0x89,                                           // vsubf
+    0x10, 0x29,                                     // loadi 41
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x0A,                                     // loadi 10
+    0x8B,                                           // vfmaf
+    0x10, 0x29,                                     // loadi 41
+    0x10, 0x0A,                                     // loadi 10
+    0x8D,                                           // vsumf
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x0A,                                     // loadi 10
+    0x8C,                                           // vdotf
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x0A,                                     // loadi 10
+    0x8F,                                           // vmaxf
+    0x10, 0x15,                                     // loadi 21
+    0x10, 0x0A,                                     // loadi 10
+    0x8E,                                           // vminf
+    0x01, 0x00,                                     // halt 0
+};
+// clang-format on
+
+void testMachineVector()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(VECTOR_BYTECODE, sizeof(VECTOR_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    // The register mode does not implement the vector opcodes
+    SlimRegisterProgram program = NULL;
+    assert(slim_register_program_translate(table, 2, &program) != SL_ERROR_NONE);
+
+    // The loop fills words 1 to 10 with the integers 10 down to 1 and words 21 to 30 with the floats 10.0 down to 1.0.
+    // Ten elements leave a tail after the full registers of every kernel set, and all of them must agree exactly.
+    const char* selected = ___slim_machine_vector_selected();
+    const char* KERNELS[] = {"scalar", "sse2", "avx2"};
+    for (u32_t k = 0; k < sizeof(KERNELS) / sizeof(KERNELS[0]); k++) {
+        if (___slim_machine_vector_select(KERNELS[k]) != SL_ERROR_NONE) continue;
+
+        slim_machine_reset(machine);
+        assert(slim_machine_enter(machine, 0, 2) == SL_ERROR_NONE);
+        slim_machine_run(machine, table);
+        slim_log_flush(log_context);
+        assert(slim_machine_flag_get_halt(machine));
+
+        u64_t value;
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && *((double*)&value) == 1.0);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && *((double*)&value) == 10.0);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && *((double*)&value) == 385.0);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && *((double*)&value) == 385.0);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 10);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 1);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 385);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 110);
+
+        // Then the locals, x and the exhausted counter
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && *((double*)&value) == 10.0);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+        assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+    }
+    assert(___slim_machine_vector_select(selected) == SL_ERROR_NONE);
+
+    // Ranges past the end of memory, empty minimums and a destination overlapping a source are rejected
+    slim_machine_reset(machine);
+    slim_machine_push(machine, 4090);
+    slim_machine_push(machine, 10);
+    assert(___slim_machine_memory_vector(machine, SL_OPCODE_VSUM) != SL_ERROR_NONE);
+    slim_machine_push(machine, 1);
+    slim_machine_push(machine, 0);
+    assert(___slim_machine_memory_vector(machine, SL_OPCODE_VMINF) != SL_ERROR_NONE);
+    slim_machine_push(machine, 2);
+    slim_machine_push(machine, 1);
+    slim_machine_push(machine, 1);
+    slim_machine_push(machine, 10);
+    assert(___slim_machine_memory_vector(machine, SL_OPCODE_VADD) != SL_ERROR_NONE);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t STRING_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x05, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x02, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x03, 'a', 'b', 'c',                      // string: 0
+
+    0x01, 0x00,                                     // halt 0
+};
+// clang-format on
+
+// Points the cached entry of "abc" past the end of the stored strings
+void testBytecodeCacheCorrupt(const char* directory)
+{
+    DIR* listing = opendir(directory);
+    assert(listing != NULL);
+
+    char path[4096] = {0};
+    struct dirent* entry;
+    while ((entry = readdir(listing)) != NULL) {
+        if (entry->d_name[0] != '.') snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    }
+    closedir(listing);
+
+    u8_t bytes[4096];
+    FILE* file = fopen(path, "r+b");
+    assert(file != NULL);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+
+    u32_t cached[3] = {0, 3, slim_bytecode_hash("abc", 3)};
+    u8_t found = 0;
+    for (size_t i = 0; i + sizeof(cached) <= size; i += sizeof(u32_t)) {
+        if (memcmp(bytes + i, cached, sizeof(cached)) != 0) continue;
+
+        cached[1] = 1000;
+        fseek(file, i, SEEK_SET);
+        fwrite(cached, sizeof(cached), 1, file);
+        found = 1;
+        break;
+    }
+    fclose(file);
+    assert(found);
+}
+
+void testBytecodeCacheRemove(const char* directory)
+{
+    DIR* listing = opendir(directory);
+    assert(listing != NULL);
+
+    char path[4096];
+    struct dirent* entry;
+    while ((entry = readdir(listing)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        assert(unlink(path) == 0);
+    }
+    closedir(listing);
+    assert(rmdir(directory) == 0);
+}
+
+// Platforms store their prepared table in the cache when destroyed, the tests keep that out of the developer's cache
+char* testCacheDisable()
+{
+    const char* previous = getenv("SLIM_CACHE_DIR");
+    char* saved = previous != NULL ? strdup(previous) : NULL;
+    setenv("SLIM_CACHE_DIR", "", 1);
+    return saved;
+}
+
+void testCacheRestore(char* saved)
+{
+    if (saved != NULL) {
+        setenv("SLIM_CACHE_DIR", saved, 1);
+    } else {
+        unsetenv("SLIM_CACHE_DIR");
+    }
+    free(saved);
+}
+
+void testBytecodeCache()
+{
+    char directory[] = "/tmp/slim-cache-XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    SlimBytecodeData bytecode = slim_bytecode_data_create(SECTIONED_BYTECODE, sizeof(SECTIONED_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    SlimBytecodeInstruction instruction;
+    SlimBytecodeSection section;
+
+    // Nothing has been stored yet
+    assert(slim_bytecode_cache_load(directory, bytecode, table) != SL_ERROR_NONE);
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_lookup_instruction(table, 0, &instruction) == SL_ERROR_NONE);
+    assert(slim_bytecode_cache_store(directory, table) == SL_ERROR_NONE);
+    slim_bytecode_table_destroy(table);
+
+    // A hit restores the snapshot, including which sections were already decoded
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_cache_load(directory, bytecode, table) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_instrs(table) == 3);
+    slim_bytecode_table_lookup_section(table, 0, &section);
+    assert(section.loaded == 1);
+    slim_bytecode_table_lookup_section(table, 1, &section);
+    assert(section.loaded == 0);
+    assert(slim_bytecode_table_lookup_instruction(table, 1, &instruction) == SL_ERROR_NONE);
+    assert(instruction.opcode == 0x01);
+    assert(slim_bytecode_table_lookup_instruction(table, 2, &instruction) != SL_ERROR_NONE);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+
+    // Different image bytes miss
+    SECTIONED_BYTECODE[sizeof(SECTIONED_BYTECODE) - 1] = 0x00;
+    bytecode = slim_bytecode_data_create(SECTIONED_BYTECODE, sizeof(SECTIONED_BYTECODE));
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_cache_load(directory, bytecode, table) != SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_instrs(table) == 0);
+    SECTIONED_BYTECODE[sizeof(SECTIONED_BYTECODE) - 1] = 0xEE;
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+
+    // A corrupt entry is rejected before anything reaches the table, so the regular load that follows fills it once
+    char strings[] = "/tmp/slim-cache-XXXXXX";
+    assert(mkdtemp(strings) != NULL);
+    bytecode = slim_bytecode_data_create(STRING_BYTECODE, sizeof(STRING_BYTECODE));
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_bytecode_cache_store(strings, table) == SL_ERROR_NONE);
+    slim_bytecode_table_destroy(table);
+    testBytecodeCacheCorrupt(strings);
+
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_cache_load(strings, bytecode, table) != SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_strings(table) == 0);
+    assert(slim_bytecode_table_get_count_instrs(table) == 0);
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_get_count_strings(table) == 1);
+    assert(slim_bytecode_table_get_count_instrs(table) == 1);
+
+    char* string;
+    assert(slim_bytecode_table_lookup_string(table, 0, &string) == SL_ERROR_NONE);
+    assert(strcmp(string, "abc") == 0);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    testBytecodeCacheRemove(directory);
+    testBytecodeCacheRemove(strings);
+
+    // Once every section is decoded, preparing again decodes nothing and leaves nothing new to store
+    char prepared[] = "/tmp/slim-cache-XXXXXX";
+    char unchanged[] = "/tmp/slim-cache-XXXXXX";
+    assert(mkdtemp(prepared) != NULL && mkdtemp(unchanged) != NULL);
+    bytecode = slim_bytecode_data_create(ARGUMENT_BYTECODE, sizeof(ARGUMENT_BYTECODE));
+    table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+    assert(slim_bytecode_table_prepare(table, 2) == SL_ERROR_NONE);
+    assert(slim_bytecode_cache_store(prepared, table) == SL_ERROR_NONE);
+
+    assert(slim_bytecode_table_prepare(table, 2) == SL_ERROR_NONE);
+    assert(slim_bytecode_cache_store(unchanged, table) == SL_ERROR_NONE);
+    assert(rmdir(unchanged) == 0);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    testBytecodeCacheRemove(prepared);
+}
+
+#define TEST_CHANNEL_COUNT 100000
+#define TEST_CHANNEL_SENDERS 4
+
+void* testChannelSender(void* argument)
+{
+    SlimChannel channel = argument;
+    for (u64_t i = 1; i <= TEST_CHANNEL_COUNT; i++) {
+        while (!slim_channel_try_send(channel, i)) slim_channel_wait_send(channel);
+    }
+    return NULL;
+}
+
+void testChannels()
+{
+    SlimChannel channel;
+    u64_t value;
+
+    // Capacities round up to a power of two, and values come out in the order they went in
+    assert(slim_channel_create(SLIM_CHANNEL_SPSC, 0, &channel) != SL_ERROR_NONE);
+    for (u32_t kind = SLIM_CHANNEL_SPSC; kind <= SLIM_CHANNEL_MPMC; kind++) {
+        assert(slim_channel_create((SlimChannelKind)kind, 3, &channel) == SL_ERROR_NONE);
+        assert(slim_channel_get_capacity(channel) == 4);
+        assert(slim_channel_try_recv(channel, &value) == 0);
+        for (u64_t round = 0; round < 3; round++) {
+            for (u64_t i = 0; i < 4; i++) assert(slim_channel_try_send(channel, round * 10 + i) == 1);
+            assert(slim_channel_try_send(channel, 99) == 0);
+            for (u64_t i = 0; i < 4; i++) assert(slim_channel_try_recv(channel, &value) == 1 && value == round * 10 + i);
+            assert(slim_channel_try_recv(channel, &value) == 0);
+        }
+        slim_channel_destroy(channel);
+    }
+
+    // A small channel between threads makes both sides sleep and wake each other many times
+    pthread_t threads[TEST_CHANNEL_SENDERS];
+    assert(slim_channel_create(SLIM_CHANNEL_SPSC, 8, &channel) == SL_ERROR_NONE);
+    pthread_create(&threads[0], NULL, testChannelSender, channel);
+    for (u64_t i = 1; i <= TEST_CHANNEL_COUNT; i++) {
+        while (!slim_channel_try_recv(channel, &value)) slim_channel_wait_recv(channel);
+        assert(value == i);
+    }
+    pthread_join(threads[0], NULL);
+    slim_channel_destroy(channel);
+
+    // Every sender's values arrive exactly once and in that sender's order, so the sum comes out exact
+    assert(slim_channel_create(SLIM_CHANNEL_MPMC, 16, &channel) == SL_ERROR_NONE);
+    for (u32_t i = 0; i < TEST_CHANNEL_SENDERS; i++) pthread_create(&threads[i], NULL, testChannelSender, channel);
+    u64_t sum = 0;
+    for (u64_t i = 0; i < (u64_t)TEST_CHANNEL_SENDERS * TEST_CHANNEL_COUNT; i++) {
+        while (!slim_channel_try_recv(channel, &value)) slim_channel_wait_recv(channel);
+        sum += value;
+    }
+    for (u32_t i = 0; i < TEST_CHANNEL_SENDERS; i++) pthread_join(threads[i], NULL);
+    assert(sum == (u64_t)TEST_CHANNEL_SENDERS * TEST_CHANNEL_COUNT * (TEST_CHANNEL_COUNT + 1) / 2);
+    slim_channel_destroy(channel);
+}
+
+void testNativeChannels()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimNativeFunction create, send, recv, try_recv;
+    u64_t handle, value;
+
+    assert(slim_native_init() == SL_ERROR_NONE);
+    assert(slim_native_lookup("channel_create", &create) == SL_ERROR_NONE);
+    assert(slim_native_lookup("channel_send", &send) == SL_ERROR_NONE);
+    assert(slim_native_lookup("channel_recv", &recv) == SL_ERROR_NONE);
+    assert(slim_native_lookup("channel_try_recv", &try_recv) == SL_ERROR_NONE);
+    assert(slim_native_lookup("channel_close", &create) != SL_ERROR_NONE);
+
+    assert(slim_machine_enter(machine, 1, 0) == SL_ERROR_NONE);
+    slim_machine_push(machine, SLIM_CHANNEL_MPMC);
+    slim_machine_push(machine, 1);
+    assert(create(machine) == SL_ERROR_NONE);
+    assert(slim_machine_pop(machine, &handle) == SL_ERROR_NONE && handle != 0);
+
+    // An empty channel answers try_recv with a zero flag
+    slim_machine_push(machine, handle);
+    assert(try_recv(machine) == SL_ERROR_NONE);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 0);
+
+    // recv on the empty channel parks the machine with its argument back on the stack
+    slim_machine_push(machine, handle);
+    assert(recv(machine) == SL_ERROR_NONE);
+    assert(slim_machine_flag_get_park(machine));
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == handle);
+
+    for (u64_t i = 0; i < 2; i++) {
+        slim_machine_push(machine, handle);
+        slim_machine_push(machine, 42 + i);
+        assert(send(machine) == SL_ERROR_NONE);
+    }
+
+    // The smallest channel holds two words, so a third send parks until recv makes room
+    slim_machine_push(machine, handle);
+    slim_machine_push(machine, 44);
+    assert(send(machine) == SL_ERROR_NONE);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 44);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == handle);
+
+    slim_machine_push(machine, handle);
+    assert(recv(machine) == SL_ERROR_NONE);
+    assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE && value == 42);
+    assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+
+    // Unknown handles are errors, not parks
+    slim_machine_push(machine, handle + 1);
+    assert(recv(machine) != SL_ERROR_NONE);
+
+    slim_native_close();
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+u8_t REACTOR_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x1F, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x10, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x05, 's', 'l', 'e', 'e', 'p',                                // native: 0
+    0x00, 0x09, 't', 'e', 's', 't', '_', 'r', 'e', 'a', 'd',            // native: 1
+    0x00, 0x0B, 't', 'e', 's', 't', '_', 'r', 'e', 'c', 'o', 'r', 'd',  // native: 2
+
+    0x10, 0x05,                                     // loop: loadi 5
+    0x62, 0x00, 0x00,                               // calln sleep
+    0x62, 0x00, 0x01,                               // calln test_read
+    0x62, 0x00, 0x02,                               // calln test_record
+    0x50, 0x00, 0x00, 0x00, 0x00,                   // jmp loop
+};
+// clang-format on
+
+#define TEST_REACTOR_MACHINES 3
+
+SlimMachineState TEST_REACTOR_MACHINE[TEST_REACTOR_MACHINES];
+int TEST_REACTOR_PIPE[TEST_REACTOR_MACHINES][2];
+u64_t TEST_REACTOR_RECORD[TEST_REACTOR_MACHINES];
+u32_t TEST_REACTOR_RECORDED = 0;
+
+u32_t testReactorIndex(SlimMachineState machine)
+{
+    for (u32_t i = 0; i < TEST_REACTOR_MACHINES; i++) {
+        if (TEST_REACTOR_MACHINE[i] == NULL) TEST_REACTOR_MACHINE[i] = machine;
+        if (TEST_REACTOR_MACHINE[i] == machine) return i;
+    }
+    assert(0);
+    return 0;
+}
+
+SlimError testReactorRead(SlimMachineState machine)
+{
+    u32_t index = testReactorIndex(machine);
+    u8_t byte;
+    if (read(TEST_REACTOR_PIPE[index][0], &byte, 1) == 1) return slim_machine_push(machine, byte);
+    if (errno != EAGAIN) return SLIM_ERROR;
+
+    slim_native_retry_when_ready(machine, TEST_REACTOR_PIPE[index][0], EPOLLIN);
+    return SL_ERROR_NONE;
+}
+
+SlimError testReactorRecord(SlimMachineState machine)
+{
+    u32_t index = testReactorIndex(machine);
+    SlimError error = slim_machine_pop(machine, &TEST_REACTOR_RECORD[index]);
+    TEST_REACTOR_RECORDED++;
+    return error;
+}
+
+void* testReactorWriter(void* argument)
+{
+    usleep(20000);
+    for (u32_t i = 0; i < TEST_REACTOR_MACHINES; i++) {
+        u8_t byte = 'a' + i;
+        assert(write(TEST_REACTOR_PIPE[i][1], &byte, 1) == 1);
+    }
+    return NULL;
+}
+
+void testPlatformReactor()
+{
+    char path[] = "/tmp/slim-reactor-XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0 && write(file, REACTOR_BYTECODE, sizeof(REACTOR_BYTECODE)) == sizeof(REACTOR_BYTECODE));
+    close(file);
+
+    for (u32_t i = 0; i < TEST_REACTOR_MACHINES; i++) {
+        assert(pipe(TEST_REACTOR_PIPE[i]) == 0);
+        fcntl(TEST_REACTOR_PIPE[i][0], F_SETFL, O_NONBLOCK);
+    }
+
+    // Holding the native table open keeps the test natives registered across the platform's own init and close
+    assert(slim_native_init() == SL_ERROR_NONE);
+    assert(slim_native_register("test_read", testReactorRead) == SL_ERROR_NONE);
+    assert(slim_native_register("test_record", testReactorRecord) == SL_ERROR_NONE);
+
+    char* cache = testCacheDisable();
+    char* argv[] = {"slim", path, "/dev/null"};
+    SlimPlatform platform = slim_platform_create(3, argv);
+    assert(platform != NULL);
+    for (u32_t i = 1; i < TEST_REACTOR_MACHINES; i++) assert(slim_platform_spawn(platform) == SL_ERROR_NONE);
+
+    // Every machine sleeps and then waits on its own pipe, all on this thread, until the writer gets to them
+    pthread_t writer;
+    pthread_create(&writer, NULL, testReactorWriter, NULL);
+    while (TEST_REACTOR_RECORDED < TEST_REACTOR_MACHINES) {
+        assert(slim_platform_update(platform) == SLIM_PLATFORM_CONTINUE);
+    }
+    pthread_join(writer, NULL);
+
+    for (u32_t i = 0; i < TEST_REACTOR_MACHINES; i++) {
+        assert(TEST_REACTOR_RECORD[i] == 'a' + i);
+        close(TEST_REACTOR_PIPE[i][0]);
+        close(TEST_REACTOR_PIPE[i][1]);
+    }
+
+    slim_platform_destroy(platform);
+    testCacheRestore(cache);
+    slim_native_close();
+    unlink(path);
+}
+
+// clang-format off
+u8_t WAIT_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x18, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x08, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x09, 't', 'e', 's', 't', '_', 'w', 'a', 'i', 't',            // native: 0
+    0x00, 0x0B, 't', 'e', 's', 't', '_', 'w', 'a', 'i', 't', 'e', 'd',  // native: 1
+
+    0x62, 0x00, 0x00,                               // calln test_wait
+    0x62, 0x00, 0x01,                               // calln test_waited
+    0x01, 0x00,                                     // halt 0
+};
+// clang-format on
+
+#define TEST_WAIT_MACHINES 2
+
+SlimMachineState TEST_WAIT_MACHINE[TEST_WAIT_MACHINES];
+SlimChannel TEST_WAIT_CHANNEL[TEST_WAIT_MACHINES];
+u64_t TEST_WAIT_RECORD[TEST_WAIT_MACHINES];
+u32_t TEST_WAIT_RECORDED = 0;
+
+u32_t testWaitIndex(SlimMachineState machine)
+{
+    for (u32_t i = 0; i < TEST_WAIT_MACHINES; i++) {
+        if (TEST_WAIT_MACHINE[i] == NULL) TEST_WAIT_MACHINE[i] = machine;
+        if (TEST_WAIT_MACHINE[i] == machine) return i;
+    }
+    assert(0);
+    return 0;
+}
+
+void testWaitRecv(void* channel) { slim_channel_wait_recv(channel); }
+
+SlimError testWait(SlimMachineState machine)
+{
+    SlimChannel channel = TEST_WAIT_CHANNEL[testWaitIndex(machine)];
+    u64_t value;
+    if (slim_channel_try_recv(channel, &value)) return slim_machine_push(machine, value);
+
+    slim_native_retry_after(machine, testWaitRecv, channel);
+    return SL_ERROR_NONE;
+}
+
+SlimError testWaited(SlimMachineState machine)
+{
+    SlimError error = slim_machine_pop(machine, &TEST_WAIT_RECORD[testWaitIndex(machine)]);
+    __atomic_add_fetch(&TEST_WAIT_RECORDED, 1, __ATOMIC_RELEASE);
+    return error;
+}
+
+void* testWaitSender(void* argument)
+{
+    // The first machine parked first, so it is not the one whose wait the platform would pick to block in
+    usleep(20000);
+    assert(slim_channel_try_send(TEST_WAIT_CHANNEL[0], 'a'));
+    while (__atomic_load_n(&TEST_WAIT_RECORDED, __ATOMIC_ACQUIRE) == 0) usleep(1000);
+    assert(slim_channel_try_send(TEST_WAIT_CHANNEL[1], 'b'));
+    return NULL;
+}
+
+void testPlatformWaiting()
+{
+    char path[] = "/tmp/slim-wait-XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0 && write(file, WAIT_BYTECODE, sizeof(WAIT_BYTECODE)) == sizeof(WAIT_BYTECODE));
+    close(file);
+
+    for (u32_t i = 0; i < TEST_WAIT_MACHINES; i++) {
+        assert(slim_channel_create(SLIM_CHANNEL_MPMC, 2, &TEST_WAIT_CHANNEL[i]) == SL_ERROR_NONE);
+    }
+
+    assert(slim_native_init() == SL_ERROR_NONE);
+    assert(slim_native_register("test_wait", testWait) == SL_ERROR_NONE);
+    assert(slim_native_register("test_waited", testWaited) == SL_ERROR_NONE);
+
+    char* cache = testCacheDisable();
+    char* argv[] = {"slim", path, "/dev/null"};
+    SlimPlatform platform = slim_platform_create(3, argv);
+    assert(platform != NULL);
+    assert(slim_platform_spawn(platform) == SL_ERROR_NONE);
+
+    // Both machines wait on channels of their own with the reactor idle, and only the first one's is sent to at first
+    pthread_t sender;
+    pthread_create(&sender, NULL, testWaitSender, NULL);
+    while (__atomic_load_n(&TEST_WAIT_RECORDED, __ATOMIC_ACQUIRE) < TEST_WAIT_MACHINES) {
+        assert(slim_platform_update(platform) == SLIM_PLATFORM_CONTINUE);
+    }
+    pthread_join(sender, NULL);
+
+    assert(TEST_WAIT_RECORD[0] == 'a' && TEST_WAIT_RECORD[1] == 'b');
+
+    slim_platform_destroy(platform);
+    testCacheRestore(cache);
+    slim_native_close();
+    for (u32_t i = 0; i < TEST_WAIT_MACHINES; i++) slim_channel_destroy(TEST_WAIT_CHANNEL[i]);
+    unlink(path);
+}
+
+#define TEST_IO_REQUESTS 8
+#define TEST_IO_BLOCK 4096
+
+void testIoWait(SlimIo io, SlimIoRequest** completed, u32_t count)
+{
+    assert(slim_io_flush(io) == SL_ERROR_NONE);
+
+    u32_t reaped = 0;
+    while (reaped < count) {
+        struct pollfd readable = {slim_io_get_descriptor(io), POLLIN, 0};
+        assert(poll(&readable, 1, 1000) == 1);
+        reaped += slim_io_reap(io, completed + reaped, count - reaped);
+    }
+    assert(slim_io_get_count_pending(io) == 0);
+}
+
+void testIoBackend(SlimIoBackend backend)
+{
+    SlimIo io;
+    assert(slim_io_create(backend, &io) == SL_ERROR_NONE);
+    assert(slim_io_get_backend(io) == backend);
+
+    char path[] = "/tmp/slim-io-XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0);
+    close(file);
+
+    // Open, then several writes and reads at their own offsets all outstanding at once
+    SlimIoRequest open_request = {SLIM_IO_OPEN, -1, path, O_RDWR | O_TRUNC, 0, NULL, 0, 0, 0, NULL, NULL};
+    SlimIoRequest* completed[TEST_IO_REQUESTS];
+    slim_io_submit(io, &open_request);
+    testIoWait(io, completed, 1);
+    assert(completed[0] == &open_request && open_request.result >= 0);
+    s32_t descriptor = (s32_t)open_request.result;
+
+    static u8_t written[TEST_IO_REQUESTS][TEST_IO_BLOCK];
+    static u8_t read_back[TEST_IO_REQUESTS][TEST_IO_BLOCK];
+    SlimIoRequest requests[TEST_IO_REQUESTS];
+    for (u32_t i = 0; i < TEST_IO_REQUESTS; i++) {
+        memset(written[i], 'a' + i, TEST_IO_BLOCK);
+        SlimIoRequest request = {SLIM_IO_WRITE, descriptor, NULL, 0, 0, written[i], TEST_IO_BLOCK,
+                                 (u64_t)i * TEST_IO_BLOCK, 0, NULL, NULL};
+        requests[i] = request;
+        slim_io_submit(io, &requests[i]);
+    }
+    assert(slim_io_get_count_pending(io) == TEST_IO_REQUESTS);
+    testIoWait(io, completed, TEST_IO_REQUESTS);
+    for (u32_t i = 0; i < TEST_IO_REQUESTS; i++) assert(requests[i].result == TEST_IO_BLOCK);
+
+    for (u32_t i = 0; i < TEST_IO_REQUESTS; i++) {
+        SlimIoRequest request = {SLIM_IO_READ, descriptor, NULL, 0, 0, read_back[i], TEST_IO_BLOCK,
+                                 (u64_t)i * TEST_IO_BLOCK, 0, NULL, NULL};
+        requests[i] = request;
+        slim_io_submit(io, &requests[i]);
+    }
+    testIoWait(io, completed, TEST_IO_REQUESTS);
+    for (u32_t i = 0; i < TEST_IO_REQUESTS; i++) assert(requests[i].result == TEST_IO_BLOCK);
+    assert(memcmp(written, read_back, sizeof(written)) == 0);
+
+    // Reads at the file position stop at the end of the file
+    u8_t tail[16];
+    SlimIoRequest eof = {SLIM_IO_READ, descriptor, NULL, 0, 0, tail, sizeof(tail), (u64_t)-1, 0, NULL, NULL};
+    lseek(descriptor, 0, SEEK_END);
+    slim_io_submit(io, &eof);
+    testIoWait(io, completed, 1);
+    assert(eof.result == 0);
+
+    SlimIoRequest close_request = {SLIM_IO_CLOSE, descriptor, NULL, 0, 0, NULL, 0, 0, 0, NULL, NULL};
+    slim_io_submit(io, &close_request);
+    testIoWait(io, completed, 1);
+    assert(close_request.result == 0);
+
+    // Failures come back as -errno
+    SlimIoRequest missing = {SLIM_IO_OPEN, -1, "/nonexistent/slim", O_RDONLY, 0, NULL, 0, 0, 0, NULL, NULL};
+    slim_io_submit(io, &missing);
+    testIoWait(io, completed, 1);
+    assert(missing.result == -ENOENT);
+
+    slim_io_destroy(io);
+    unlink(path);
+}
+
+void testIo()
+{
+    SlimIo io;
+    if (slim_io_create(SLIM_IO_BACKEND_URING, &io) == SL_ERROR_NONE) {
+        slim_io_destroy(io);
+        testIoBackend(SLIM_IO_BACKEND_URING);
+    }
+    testIoBackend(SLIM_IO_BACKEND_THREADS);
+}
+
+// clang-format off
+u8_t FILE_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x3B, // native_size
+    0x00, 0x00, 0x00, 0x15, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x4C, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x09, 'f', 'i', 'l', 'e', '_', 'o', 'p', 'e', 'n',            // native: 0
+    0x00, 0x09, 'f', 'i', 'l', 'e', '_', 'r', 'e', 'a', 'd',            // native: 1
+    0x00, 0x0A, 'f', 'i', 'l', 'e', '_', 'w', 'r', 'i', 't', 'e',       // native: 2
+    0x00, 0x0A, 'f', 'i', 'l', 'e', '_', 'c', 'l', 'o', 's', 'e',       // native: 3
+    0x00, 0x0B, 't', 'e', 's', 't', '_', 'r', 'e', 'c', 'o', 'r', 'd',  // native: 4
+
+    0x00, 0x13, '/', 't', 'm', 'p', '/', 's', 'l', 'i', 'm', '-', 'f', 'i', 'l', 'e', '-', 't', 'e', 's', 't',
+
+    0x10, 0x00,                                     // loadi 0
+    0x10, 0x41,                                     // loadi 'A'
+    0x10, 0x02,                                     // loadi 2
+    0x43,                                           // memfill
+
+    0x17, 0x00,                                     // loads path
+    0x10, 0x01,                                     // loadi 1 (write)
+    0x62, 0x00, 0x00,                               // calln file_open
+    0x20,                                           // dup
+    0x10, 0x00,                                     // loadi 0
+    0x10, 0x10,                                     // loadi 16
+    0x62, 0x00, 0x02,                               // calln file_write
+    0x62, 0x00, 0x04,                               // calln test_record
+    0x62, 0x00, 0x03,                               // calln file_close
+    0x62, 0x00, 0x04,                               // calln test_record
+
+    0x17, 0x00,                                     // loads path
+    0x10, 0x00,                                     // loadi 0 (read)
+    0x62, 0x00, 0x00,                               // calln file_open
+    0x20,                                           // dup
+    0x10, 0x08,                                     // loadi 8
+    0x10, 0x40,                                     // loadi 64
+    0x62, 0x00, 0x01,                               // calln file_read
+    0x62, 0x00, 0x04,                               // calln test_record
+    0x62, 0x00, 0x03,                               // calln file_close
+    0x62, 0x00, 0x04,                               // calln test_record
+
+    0x10, 0x08,                                     // loadi 8
+    0x12, 0x00, 0x00,                               // loadm 0
+    0x62, 0x00, 0x04,                               // calln test_record
+    0x10, 0x09,                                     // loadi 9
+    0x12, 0x00, 0x00,                               // loadm 0
+    0x62, 0x00, 0x04,                               // calln test_record
+
+    0x50, 0x00, 0x00, 0x00, 0x1E,                   // done: jmp done
+};
+// clang-format on
+
+#define TEST_FILE_RECORDS 6
+
+u64_t TEST_FILE_RECORD[TEST_FILE_RECORDS];
+u32_t TEST_FILE_RECORDED = 0;
+
+SlimError testFileRecord(SlimMachineState machine)
+{
+    assert(TEST_FILE_RECORDED < TEST_FILE_RECORDS);
+    return slim_machine_pop(machine, &TEST_FILE_RECORD[TEST_FILE_RECORDED++]);
+}
+
+void testPlatformFiles(const char* backend)
+{
+    char path[] = "/tmp/slim-files-XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0 && write(file, FILE_BYTECODE, sizeof(FILE_BYTECODE)) == sizeof(FILE_BYTECODE));
+    close(file);
+
+    if (backend != NULL) setenv("SLIM_IO_BACKEND", backend, 1);
+    assert(slim_native_init() == SL_ERROR_NONE);
+    assert(slim_native_register("test_record", testFileRecord) == SL_ERROR_NONE);
+
+    char* cache = testCacheDisable();
+    char* argv[] = {"slim", path, "/dev/null"};
+    SlimPlatform platform = slim_platform_create(3, argv);
+    assert(platform != NULL);
+
+    // Write two words of 'A' padded with zero bytes, then read the file back behind them
+    TEST_FILE_RECORDED = 0;
+    while (TEST_FILE_RECORDED < TEST_FILE_RECORDS) assert(slim_platform_update(platform) == SLIM_PLATFORM_CONTINUE);
+    u64_t expected[TEST_FILE_RECORDS] = {16, 0, 16, 0, 'A', 'A'};
+    assert(memcmp(TEST_FILE_RECORD, expected, sizeof(expected)) == 0);
+
+    slim_platform_destroy(platform);
+    testCacheRestore(cache);
+    slim_native_close();
+    if (backend != NULL) unsetenv("SLIM_IO_BACKEND");
+    unlink("/tmp/slim-file-test");
+    unlink(path);
+}
+
+void testConsoleExpect(int pipe, const char* expected)
+{
+    char data[256];
+    ssize_t count = read(pipe, data, sizeof(data));
+    if (expected[0] == '\0') {
+        assert(count < 0 && errno == EAGAIN);
+        return;
+    }
+    assert(count == (ssize_t)strlen(expected) && memcmp(data, expected, count) == 0);
+}
+
+void testConsole()
+{
+    int output[2], input[2];
+    assert(pipe(output) == 0 && pipe(input) == 0);
+    fcntl(output[0], F_SETFL, O_NONBLOCK);
+    slim_console_redirect(output[1], input[0]);
+    slim_console_set_interactive(0);
+
+    // Buffered machines only reach the descriptor when they flush, each in one piece
+    SlimConsoleBuffer a, b;
+    assert(slim_console_buffer_create(&a) == SL_ERROR_NONE);
+    assert(slim_console_buffer_create(&b) == SL_ERROR_NONE);
+    assert(slim_console_write(a, "ab", 2) == SL_ERROR_NONE);
+    assert(slim_console_write(b, "cd\n", 3) == SL_ERROR_NONE);
+    assert(slim_console_write(a, "e", 1) == SL_ERROR_NONE);
+    testConsoleExpect(output[0], "");
+    assert(slim_console_flush(b) == SL_ERROR_NONE);
+    testConsoleExpect(output[0], "cd\n");
+    slim_console_buffer_destroy(a);
+    testConsoleExpect(output[0], "abe");
+
+    // Interactive consoles flush at every newline
+    slim_console_set_interactive(1);
+    assert(slim_console_write(b, "x", 1) == SL_ERROR_NONE);
+    testConsoleExpect(output[0], "");
+    assert(slim_console_write(b, "\ny", 2) == SL_ERROR_NONE);
+    testConsoleExpect(output[0], "x\ny");
+    slim_console_set_interactive(0);
+
+    // The natives, on heap words and through the machine's own buffer
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimNativeFunction putch, putstr, putbuf, getch;
+    assert(slim_native_init() == SL_ERROR_NONE);
+    assert(slim_native_lookup("stdputch", &putch) == SL_ERROR_NONE);
+    assert(slim_native_lookup("stdputstr", &putstr) == SL_ERROR_NONE);
+    assert(slim_native_lookup("stdputbuf", &putbuf) == SL_ERROR_NONE);
+    assert(slim_native_lookup("stdgetch", &getch) == SL_ERROR_NONE);
+    assert(slim_machine_enter(machine, 1, 0) == SL_ERROR_NONE);
+
+    u64_t* words;
+    assert(slim_machine_memory(machine, 0, 3, 1, &words) == SL_ERROR_NONE);
+    words[0] = 'h';
+    words[1] = 'i';
+    memcpy(&words[2], " there", 6);
+
+    slim_machine_push(machine, 0);
+    slim_machine_push(machine, 2);
+    assert(putstr(machine) == SL_ERROR_NONE);
+    slim_machine_push(machine, 2);
+    slim_machine_push(machine, 6);
+    assert(putbuf(machine) == SL_ERROR_NONE);
+    slim_machine_push(machine, '\n');
+    assert(putch(machine) == SL_ERROR_NONE);
+    testConsoleExpect(output[0], "");
+
+    // Out of range heap arguments are errors
+    slim_machine_push(machine, 4095);
+    slim_machine_push(machine, 2);
+    assert(putstr(machine) != SL_ERROR_NONE);
+
+    // getch parks while there is no input, and flushes the prompt before it does
+    u64_t value;
+    assert(getch(machine) == SL_ERROR_NONE && slim_machine_flag_get_park(machine));
+    testConsoleExpect(output[0], "hi there\n");
+
+    assert(write(input[1], "ok", 2) == 2);
+    close(input[1]);
+    for (u32_t i = 0; i < 3; i++) {
+        assert(getch(machine) == SL_ERROR_NONE);
+        assert(slim_machine_pop(machine, &value) == SL_ERROR_NONE);
+        assert(value == (u64_t)(i < 2 ? "ok"[i] : -1));
+    }
+
+    slim_machine_destroy(machine);
+    slim_native_close();
+    slim_log_destroy(log_context);
+    slim_console_buffer_destroy(b);
+
+    slim_console_redirect(STDOUT_FILENO, STDIN_FILENO);
+    close(output[0]);
+    close(output[1]);
+    close(input[0]);
+}
+
+// clang-format off
+u8_t FUEL_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x0B, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x0B, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x09, 't', 'e', 's', 't', '_', 't', 'i', 'c', 'k',            // native: 0
+
+    0x10, 0x01,                                     // loop: loadi 1
+    0x13,                                           // drop
+    0x62, 0x00, 0x00,                               // calln test_tick
+    0x50, 0x00, 0x00, 0x00, 0x00,                   // jmp loop
+};
+// clang-format on
+
+#define TEST_FUEL_MACHINES 2
+
+SlimMachineState TEST_FUEL_MACHINE[TEST_FUEL_MACHINES];
+u64_t TEST_FUEL_TICKS[TEST_FUEL_MACHINES];
+
+SlimError testFuelTick(SlimMachineState machine)
+{
+    for (u32_t i = 0; i < TEST_FUEL_MACHINES; i++) {
+        if (TEST_FUEL_MACHINE[i] == NULL) TEST_FUEL_MACHINE[i] = machine;
+        if (TEST_FUEL_MACHINE[i] == machine) {
+            TEST_FUEL_TICKS[i]++;
+            return SL_ERROR_NONE;
+        }
+    }
+    return SLIM_ERROR;
+}
+
+void testMachineFuel()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(FUEL_BYTECODE, sizeof(FUEL_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    // Every jmp repeats four instructions, so a budget of 10 lasts three iterations and runs dry in the third jmp.
+    // The machine stops right after it with its state intact, and carries on once refuelled.
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    slim_machine_set_fuel(machine, 10);
+    for (u32_t round = 0; round < 2; round++) {
+        u32_t steps = 0;
+        do {
+            slim_machine_step(machine, table);
+            slim_log_flush(log_context);
+            assert(!slim_machine_flag_get_error(machine));
+            if (slim_machine_flag_get_interrupt(machine)) {
+                u64_t index;
+                assert(slim_machine_pop(machine, &index) == SL_ERROR_NONE && index == 0);
+            }
+            steps++;
+        } while (!slim_machine_flag_get_yield(machine));
+
+        assert(steps == 3 * 4 && slim_machine_get_fuel(machine) == -2);
+        u64_t value;
+        assert(slim_machine_pop(machine, &value) != SL_ERROR_NONE);
+        slim_machine_refuel(machine);
+        assert(slim_machine_get_fuel(machine) == 10);
+    }
+
+    // Unmetered machines never yield
+    slim_machine_set_fuel(machine, 0);
+    for (u32_t i = 0; i < 1000; i++) {
+        slim_machine_step(machine, table);
+        slim_log_flush(log_context);
+        if (slim_machine_flag_get_interrupt(machine)) slim_machine_pop(machine, &(u64_t){0});
+        assert(!slim_machine_flag_get_yield(machine));
+    }
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+u8_t testPlatformFuelRun(const char* fuel)
+{
+    char path[] = "/tmp/slim-fuel-XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0 && write(file, FUEL_BYTECODE, sizeof(FUEL_BYTECODE)) == sizeof(FUEL_BYTECODE));
+    close(file);
+
+    assert(slim_native_init() == SL_ERROR_NONE);
+    assert(slim_native_register("test_tick", testFuelTick) == SL_ERROR_NONE);
+    memset(TEST_FUEL_MACHINE, 0, sizeof(TEST_FUEL_MACHINE));
+    memset(TEST_FUEL_TICKS, 0, sizeof(TEST_FUEL_TICKS));
+
+    char* cache = testCacheDisable();
+    setenv("SLIM_FUEL", fuel, 1);
+    char* argv[] = {"slim", path, "/dev/null"};
+    SlimPlatform platform = slim_platform_create(3, argv);
+    unsetenv("SLIM_FUEL");
+    assert(platform != NULL);
+    for (u32_t i = 1; i < TEST_FUEL_MACHINES; i++) assert(slim_platform_spawn(platform) == SL_ERROR_NONE);
+
+    // Neither machine ever parks, so the second only gets to run if the first yields
+    for (u32_t i = 0; i < 10000; i++) assert(slim_platform_update(platform) == SLIM_PLATFORM_CONTINUE);
+    u8_t shared = TEST_FUEL_TICKS[0] > 100 && TEST_FUEL_TICKS[1] > 100;
+
+    slim_platform_destroy(platform);
+    testCacheRestore(cache);
+    slim_native_close();
+    unlink(path);
+    return shared;
+}
+
+void testPlatformFuel()
+{
+    assert(testPlatformFuelRun("40"));
+    assert(!testPlatformFuelRun("0"));
+}
+
+// clang-format off
+u8_t TRAP_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x06, // instruction_size
+    0x00, 0x00, 0x00, 0x00, // section_size (eagerly loaded)
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x10, 0x05,                                     // loadi 5
+    0x13,                                           // drop
+    0x13,                                           // drop, the stack is empty by now
+    0x01, 0x00,                                     // halt 0
+};
+// clang-format on
+
+void testMachineTrap()
+{
+    SlimLogContext log_context = slim_log_create("/dev/null", 0);
+    SlimMachineState machine = slim_machine_create(&log_context);
+    SlimBytecodeData bytecode = slim_bytecode_data_create(TRAP_BYTECODE, sizeof(TRAP_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    // The run stops at the second drop and records where, stepping up to it traps the same way
+    SlimMachineTrap trap;
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    slim_machine_run(machine, table);
+    slim_log_flush(log_context);
+    slim_machine_get_trap(machine, &trap);
+    assert(trap.kind == SLIM_MACHINE_TRAP_ERROR && trap.error == SLIM_ERROR);
+    assert(trap.instruction_pointer == 2 && trap.opcode == 0x13);
+
+    slim_machine_reset(machine);
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    for (u32_t i = 0; i < 2; i++) {
+        slim_machine_step(machine, table);
+        slim_machine_get_trap(machine, &trap);
+        assert(trap.kind == SLIM_MACHINE_TRAP_NONE && trap.instruction_pointer == i);
+    }
+    slim_machine_step(machine, table);
+    slim_log_flush(log_context);
+    assert(slim_machine_flag_get_error(machine) && !slim_machine_flag_get_halt(machine));
+
+    // With something left for the second drop the machine runs into the halt, which is not an error
+    slim_machine_reset(machine);
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    assert(slim_machine_push(machine, 0) == SL_ERROR_NONE);
+    slim_machine_run(machine, table);
+    slim_log_flush(log_context);
+    slim_machine_get_trap(machine, &trap);
+    assert(trap.kind == SLIM_MACHINE_TRAP_HALT && trap.instruction_pointer == 3 && trap.opcode == 0x01);
+
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+    slim_machine_destroy(machine);
+    slim_log_destroy(log_context);
+}
+
+// clang-format off
+// main calls drop with 5 on the stack, drop has no arguments and pops the caller's value anyway
+u8_t CHECK_BYTECODE[] = {
+    0x00, 0x00, 0x00, 0x20, // header_size
+    0x00, 0x00, 0x00, 0x00, // native_size
+    0x00, 0x00, 0x00, 0x00, // string_size
+    0x00, 0x00, 0x00, 0x00, // constant_size
+    0x00, 0x00, 0x00, 0x0B, // instruction_size
+    0x00, 0x00, 0x00, 0x30, // section_size
+    0x00, 0x00, 0x00, 0x00, // symbol_size
+    0x00, 0x00, 0x00, 0x00, // padding
+
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, // section: main    address 0, 3 instructions
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, //                  bytes [0, 9)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //                  no locals
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, // section: drop    address 3, 2 instructions
+    0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x02, //                  bytes [9, 11)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //                  no locals
+
+    0x10, 0x05,                                     // loadi 5
+    0x60, 0x00, 0x00, 0x00, 0x03,                   // call drop
+    0x01, 0x00,                                     // halt 0
+
+    0x13,                                           // drop
+    0x61,                                           // ret
+};
+// clang-format on
+
+void testMachineVariants()
+{
+    SlimBytecodeData bytecode = slim_bytecode_data_create(CHECK_BYTECODE, sizeof(CHECK_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    char path[] = "/tmp/slim-trace-XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0);
+    close(file);
+    SlimLogContext log_context = slim_log_create(path, 0);
+
+    // The drop reaches below the callee's frame into main's, which only the checked interpreter notices
+    SlimMachineTrapKind expected[SLIM_MACHINE_VARIANT_COUNT] = {
+        [SLIM_MACHINE_VARIANT_FAST] = SLIM_MACHINE_TRAP_HALT,
+        [SLIM_MACHINE_VARIANT_CHECKED] = SLIM_MACHINE_TRAP_ERROR,
+        [SLIM_MACHINE_VARIANT_TRACING] = SLIM_MACHINE_TRAP_HALT,
+        [SLIM_MACHINE_VARIANT_PROFILING] = SLIM_MACHINE_TRAP_HALT,
+    };
+    for (u32_t variant = 0; variant < SLIM_MACHINE_VARIANT_COUNT; variant++) {
+        SlimMachineState machine = slim_machine_create_variant(&log_context, variant);
+        assert(slim_machine_get_variant(machine) == variant);
+        assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+        slim_machine_run(machine, table);
+        slim_log_flush(log_context);
+
+        SlimMachineTrap trap;
+        slim_machine_get_trap(machine, &trap);
+        assert(trap.kind == expected[variant]);
+        if (variant == SLIM_MACHINE_VARIANT_CHECKED) assert(trap.instruction_pointer == 3);
+
+        const u64_t* counts = slim_machine_get_opcode_counts(machine);
+        if (variant == SLIM_MACHINE_VARIANT_PROFILING) {
+            assert(counts[SL_OPCODE_CALL] == 1 && counts[SL_OPCODE_DROP] == 1 && counts[SL_OPCODE_HALT] == 1);
+            assert(counts[SL_OPCODE_ADD] == 0);
+        } else {
+            assert(counts == NULL);
+        }
+        slim_machine_destroy(machine);
+    }
+
+    // The tracing run logged every instruction, and the checked one what it caught
+    char trace[4096];
+    FILE* log_file = fopen(path, "r");
+    size_t length = fread(trace, 1, sizeof(trace) - 1, log_file);
+    fclose(log_file);
+    trace[length] = 0;
+    assert(strstr(trace, "LOADI 0x0 0x5") != NULL && strstr(trace, "HALT") != NULL);
+    assert(strstr(trace, "[CHECK]") != NULL);
+
+    SlimMachineVariant variant;
+    assert(slim_machine_variant_parse("profiling", &variant) == SL_ERROR_NONE);
+    assert(variant == SLIM_MACHINE_VARIANT_PROFILING);
+    assert(slim_machine_variant_parse("turbo", &variant) != SL_ERROR_NONE);
+    assert(strcmp(slim_machine_opcode_name(SL_OPCODE_TAILCALL), "TAILCALL") == 0);
+    assert(slim_machine_opcode_name(0xFF) == NULL);
+
+    slim_log_destroy(log_context);
+    unlink(path);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+}
+
+// Reads back whatever was written to file, which has to fit into size bytes
+void testProfileRead(FILE* file, char* text, u32_t size)
+{
+    rewind(file);
+    size_t length = fread(text, 1, size - 1, file);
+    text[length] = 0;
+    fclose(file);
+}
+
+void testMachineProfile()
+{
+    SlimBytecodeData bytecode = slim_bytecode_data_create(TAILCALL_BYTECODE, sizeof(TAILCALL_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    SlimMachineState machine = slim_machine_create_variant(NULL, SLIM_MACHINE_VARIANT_PROFILING);
+    assert(slim_machine_enter(machine, 0, 0) == SL_ERROR_NONE);
+    slim_machine_run(machine, table);
+    assert(slim_machine_flag_get_halt(machine));
+
+    SlimProfile profile = slim_machine_get_profile(machine);
+    assert(profile != NULL && slim_machine_get_opcode_counts(machine) == slim_profile_get_opcode_counts(profile));
+
+    // main calls count once and count replaces itself a thousand times, which stays the one context below main
+    char text[4096];
+    FILE* file = tmpfile();
+    assert(slim_profile_write_folded(profile, table, NULL, file) == SL_ERROR_NONE);
+    testProfileRead(file, text, sizeof(text));
+
+    unsigned long long main_time = 0;
+    unsigned long long count_time = 0;
+    assert(sscanf(text, "section_0 %llu\nsection_0;section_1 %llu\n", &main_time, &count_time) == 2);
+    assert(count_time > 0 && strstr(text, "section_2") == NULL);
+
+    // count runs 1001 times and main only calls it, so count comes first.  The opcodes follow by count.
+    file = tmpfile();
+    assert(slim_profile_write_report(profile, table, NULL, file) == SL_ERROR_NONE);
+    testProfileRead(file, text, sizeof(text));
+
+    unsigned long long calls = 0;
+    unsigned long long inclusive = 0;
+    unsigned long long exclusive = 0;
+    char* line = strchr(strchr(strchr(text, '\n') + 1, '\n') + 1, '\n') + 1;
+    assert(sscanf(line, "%llu %llu %llu", &calls, &inclusive, &exclusive) == 3);
+    assert(calls == 1001 && inclusive == count_time && exclusive == count_time);
+    assert(strstr(line, "section_1\n") != NULL);
+    assert(strstr(text, "6006 instructions\n") != NULL && strstr(text, "DUP\n") != NULL);
+    assert(strstr(text, "DUP\n") < strstr(text, "TAILCALL\n") && strstr(text, "TAILCALL\n") < strstr(text, "HALT\n"));
+
+    slim_machine_destroy(machine);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+}
+
+void testPerf()
+{
+    // Counters are normalised by the instructions machines ran, which every variant counts
+    SlimBytecodeData bytecode = slim_bytecode_data_create(TRAP_BYTECODE, sizeof(TRAP_BYTECODE));
+    SlimBytecodeTable table = slim_bytecode_table_create();
+    assert(slim_bytecode_table_load_data(table, bytecode) == SL_ERROR_NONE);
+
+    SlimMachineState machine = slim_machine_create_variant(NULL, SLIM_MACHINE_VARIANT_FAST);
+    assert(slim_machine_enter(machine, 0, 1) == SL_ERROR_NONE);
+    slim_machine_step(machine, table);
+    assert(slim_machine_get_retired(machine) == 1);
+    slim_machine_run(machine, table);
+    assert(slim_machine_flag_get_halt(machine) && slim_machine_get_retired(machine) == 4);
+
+    slim_machine_destroy(machine);
+    slim_bytecode_table_destroy(table);
+    slim_bytecode_data_destroy(bytecode);
+
+    // Whatever the kernel lets us open, counters that are not there have to show up as such
+    SlimPerf perf;
+    if (slim_perf_create(&perf) != SL_ERROR_NONE) return;
+
+    volatile u64_t sum = 0;
+    slim_perf_start(perf);
+    for (u32_t i = 0; i < 1000000; i++) sum += i;
+    slim_perf_stop(perf);
+
+    u64_t before = slim_perf_get_value(perf, SLIM_PERF_TASK_CLOCK);
+    for (u32_t i = 0; i < 1000000; i++) sum += i;
+    assert(slim_perf_get_value(perf, SLIM_PERF_TASK_CLOCK) == before);
+    if (slim_perf_get_available(perf, SLIM_PERF_TASK_CLOCK)) assert(before > 0);
+
+    char text[4096];
+    FILE* file = tmpfile();
+    assert(slim_perf_write_report(perf, 1000000, file) == SL_ERROR_NONE);
+    testProfileRead(file, text, sizeof(text));
+    for (u32_t i = 0; i < SLIM_PERF_COUNTER_COUNT; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "\n%s ", slim_perf_counter_name(i));
+        char* line = strstr(text, name);
+        assert(line != NULL);
+
+        char* missing = strstr(line, "not available");
+        assert((missing != NULL && missing < strchr(line + 1, '\n')) == !slim_perf_get_available(perf, i));
+    }
+
+    slim_perf_destroy(perf);
+}
+
+#if SLIM_TRACE_EVENTS
+void* testTraceRecord(void* argument)
+{
+    (void)argument;
+    slim_trace_set_enabled(1);
+    SLIM_TRACE_BEGIN("test outer", 1);
+    SLIM_TRACE_INSTANT("test tick", 2);
+    SLIM_TRACE_END("test outer", 3);
+    slim_trace_set_enabled(0);
+    SLIM_TRACE_INSTANT("test dropped", 4);
+    return NULL;
+}
+#endif
+
+void testTrace()
+{
+    char text[4096];
+
+#if SLIM_TRACE_EVENTS
+    // A thread of its own gets the newest buffer, which is exported first, whatever SLIM_TRACE recorded before
+    u8_t enabled = slim_trace_get_enabled();
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, testTraceRecord, NULL) == 0);
+    pthread_join(thread, NULL);
+    slim_trace_set_enabled(enabled);
+
+    FILE* file = tmpfile();
+    assert(slim_trace_export(file) == SL_ERROR_NONE);
+    testProfileRead(file, text, sizeof(text));
+
+    char* begin = strstr(text, "{\"name\":\"test outer\",\"ph\":\"B\"");
+    char* tick = strstr(text, "{\"name\":\"test tick\",\"ph\":\"i\"");
+    char* end = strstr(text, "{\"name\":\"test outer\",\"ph\":\"E\"");
+    assert(begin != NULL && begin < tick && tick < end && strstr(text, "thread_name") < begin);
+    assert(strstr(end, "\"args\":{\"value\":3}") != NULL && strstr(text, "test dropped") == NULL);
+#else
+    // Compiled out, nothing can be opened and the export is an empty trace
+    assert(slim_trace_open("/dev/null") != SL_ERROR_NONE && !slim_trace_get_enabled());
+
+    FILE* file = tmpfile();
+    assert(slim_trace_export(file) == SL_ERROR_NONE);
+    testProfileRead(file, text, sizeof(text));
+    assert(strstr(text, "\"traceEvents\":[") != NULL && strstr(text, "\"ph\"") == NULL);
+#endif
+}
+
 void testPlatform(int argc, char** argv) {
     SlimPlatform platform = slim_platform_create(argc, argv);
     
@@ -123,8 +2349,37 @@ void testPlatform(int argc, char** argv) {
 int main(int argc, char** argv)
 {
     testSlimArray();
+    testSlimTypedVector();
+    testSlimArena();
     testFileLoading();
     testBytecode();
+    testBytecodeSections();
+    testBytecodeParallel();
+    testBytecodeSymbols();
+    testMachineFrames();
+    testMachineTailCall();
+    testMachineArguments();
+    testMachineRegisterMode();
+    testMachineBranches();
+    testMachineParallelFor();
+    testMachineMemory();
+    testMachineVector();
+    testChannels();
+    testNativeChannels();
+    testBytecodeCache();
+    testPlatformReactor();
+    testPlatformWaiting();
+    testIo();
+    testPlatformFiles(NULL);
+    testPlatformFiles("threads");
+    testConsole();
+    testMachineFuel();
+    testPlatformFuel();
+    testMachineTrap();
+    testMachineVariants();
+    testMachineProfile();
+    testPerf();
+    testTrace();
     testPlatform(argc, argv);
     return 0;
 }
\ No newline at end of file
@@ -7,4 +7,4 @@ echo "Running test.slim"
 if [ -f test.log ]; then
     rm test.log
 fi
-./bin/exe test.log ../test.slim
\ No newline at end of file
+./bin/exe ../test.slim test.log
\ No newline at end of file